@@ -4,5 +4,7 @@ CONFIG += ordered
 DESTDIR = ../bin
 
 SUBDIRS = sc_fm_filesystem \
+          sc_fm_btree \
+          sc_fm_pack \
           sc_fm_redis
 
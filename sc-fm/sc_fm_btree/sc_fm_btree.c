@@ -0,0 +1,1141 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+// database file could be larger than 2 GB, so file offsets are 64-bit on all platforms
+#define _FILE_OFFSET_BITS 64
+
+#include "sc_fm_engine_private.h"
+#include "sc_stream_private.h"
+#include "sc_stream_memory.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <memory.h>
+
+#ifdef WIN32
+#include <io.h>
+#define fsync _commit
+#define fseeko _fseeki64
+#else
+#include <unistd.h>
+#endif
+
+/* All data is stored in one database file (contents.db), that consists of fixed size pages.
+ * Two first pages contain meta information (root of B+tree, number of pages), they are written
+ * alternately, so the last valid one describes the last committed state. B+tree maps checksum to
+ * location of content and (checksum, sc-addr) to number of references. Tree pages are copied on
+ * the first change in transaction and written into free pages on commit, so committed tree never
+ * changes and database file is consistent after crash. Contents are stored in continuous page
+ * ranges out of tree and read from memory mapped file without copying.
+ */
+
+const gchar *db_file_name = "contents.db";
+
+#define SC_BTREE_PAGE_SIZE 4096
+#define SC_BTREE_META_PAGES 2
+#define SC_BTREE_SIGNATURE 0x45525442 // BTRE
+#define SC_BTREE_VERSION 1
+#define SC_BTREE_MAX_DIRTY_PAGES 4096 // number of changed pages, that cause commit
+
+#define SC_BTREE_KEY_LEN (2 + SC_MAX_CHECKSUM_LEN + 4) // kind, checksum length, checksum, sc-addr
+#define SC_BTREE_PREFIX_LEN (2 + SC_MAX_CHECKSUM_LEN)  // part of key without sc-addr
+#define SC_BTREE_VALUE_LEN 8
+#define SC_BTREE_LEAF_ENTRY (SC_BTREE_KEY_LEN + SC_BTREE_VALUE_LEN)
+#define SC_BTREE_BRANCH_ENTRY (SC_BTREE_KEY_LEN + 4)
+#define SC_BTREE_HEADER_LEN 8
+#define SC_BTREE_LEAF_MAX ((SC_BTREE_PAGE_SIZE - SC_BTREE_HEADER_LEN) / SC_BTREE_LEAF_ENTRY)
+#define SC_BTREE_BRANCH_MAX ((SC_BTREE_PAGE_SIZE - SC_BTREE_HEADER_LEN) / SC_BTREE_BRANCH_ENTRY)
+
+enum _sc_btree_key_kind
+{
+    SC_BTREE_KEY_CONTENT = 1,   // value: first page and size of content
+    SC_BTREE_KEY_ADDR = 2       // value: number of references
+};
+
+enum _sc_btree_page_type
+{
+    SC_BTREE_PAGE_LEAF = 1,
+    SC_BTREE_PAGE_BRANCH = 2
+};
+
+struct _sc_btree_meta
+{
+    sc_uint32 signature;
+    sc_uint32 version;
+    sc_uint64 txn;          // number of transaction
+    sc_uint32 root;         // root page of tree (0 - empty tree)
+    sc_uint32 page_count;   // number of used pages
+    sc_uint32 check;        // checksum of previous fields
+};
+
+struct _sc_btree_page_header
+{
+    sc_uint16 type;
+    sc_uint16 count;
+    sc_uint32 reserved;
+};
+
+struct _sc_btree_data
+{
+    gchar path[MAX_PATH_LENGTH + 1];
+    FILE *file;
+    GMappedFile *map;           // mapped database file, it is recreated when file grows
+    sc_uint64 map_size;
+
+    struct _sc_btree_meta meta; // last committed meta
+    sc_uint32 root;             // root of current transaction
+    sc_uint32 page_count;       // number of pages in current transaction
+    GHashTable *dirty;          // page number -> changed page buffer
+    GArray *free_pages;         // pages, that can be used
+    GArray *pending_pages;      // pages of committed tree, that can be used after commit
+
+    GMutex mutex;
+};
+
+//! Content, that is written now
+struct _sc_btree_write
+{
+    struct _sc_btree_data *data;
+    gchar path[MAX_PATH_LENGTH + 1];    // temporary file
+    FILE *file;
+    sc_uint32 size;
+    sc_bool temp;                       // checksum will be known on commit
+    sc_check_sum check_sum;
+};
+
+typedef struct _sc_btree_meta sc_btree_meta;
+typedef struct _sc_btree_page_header sc_btree_page_header;
+typedef struct _sc_btree_data sc_btree_data;
+typedef struct _sc_btree_write sc_btree_write;
+
+// --- keys and pages ---
+void _sc_btree_make_key(sc_uint8 kind, const sc_check_sum *check_sum, const sc_addr *addr, sc_uint8 *key)
+{
+    memset(key, 0, SC_BTREE_KEY_LEN);
+    key[0] = kind;
+    key[1] = check_sum->len;
+    memcpy(key + 2, check_sum->data, check_sum->len);
+
+    // big endian order keeps references grouped by checksum
+    if (addr != 0)
+    {
+        key[SC_BTREE_PREFIX_LEN] = (sc_uint8)(addr->seg >> 8);
+        key[SC_BTREE_PREFIX_LEN + 1] = (sc_uint8)(addr->seg & 0xff);
+        key[SC_BTREE_PREFIX_LEN + 2] = (sc_uint8)(addr->offset >> 8);
+        key[SC_BTREE_PREFIX_LEN + 3] = (sc_uint8)(addr->offset & 0xff);
+    }
+}
+
+void _sc_btree_key_addr(const sc_uint8 *key, sc_addr *addr)
+{
+    addr->seg = (sc_uint16)((key[SC_BTREE_PREFIX_LEN] << 8) | key[SC_BTREE_PREFIX_LEN + 1]);
+    addr->offset = (sc_uint16)((key[SC_BTREE_PREFIX_LEN + 2] << 8) | key[SC_BTREE_PREFIX_LEN + 3]);
+}
+
+#define PAGE_HEADER(page) ((sc_btree_page_header*)(page))
+#define LEAF_KEY(page, i) ((sc_uint8*)(page) + SC_BTREE_HEADER_LEN + (i) * SC_BTREE_LEAF_ENTRY)
+#define LEAF_VALUE(page, i) (LEAF_KEY(page, i) + SC_BTREE_KEY_LEN)
+#define BRANCH_KEY(page, i) ((sc_uint8*)(page) + SC_BTREE_HEADER_LEN + (i) * SC_BTREE_BRANCH_ENTRY)
+#define BRANCH_CHILD(page, i) (BRANCH_KEY(page, i) + SC_BTREE_KEY_LEN)
+
+sc_uint32 _sc_btree_get_child(const sc_uint8 *page, sc_uint16 i)
+{
+    sc_uint32 child;
+    memcpy(&child, BRANCH_CHILD(page, i), sizeof(child));
+    return child;
+}
+
+void _sc_btree_set_child(sc_uint8 *page, sc_uint16 i, sc_uint32 child)
+{
+    memcpy(BRANCH_CHILD(page, i), &child, sizeof(child));
+}
+
+sc_uint32 _sc_btree_meta_check(const sc_btree_meta *meta)
+{
+    const sc_uint8 *bytes = (const sc_uint8*)meta;
+    sc_uint32 hash = 2166136261u;
+    gsize i;
+
+    for (i = 0; i < (gsize)G_STRUCT_OFFSET(sc_btree_meta, check); ++i)
+        hash = (hash ^ bytes[i]) * 16777619u;
+
+    return hash;
+}
+
+//! Maps database file again, if requested part of it isn't mapped yet
+sc_bool _sc_btree_map(sc_btree_data *data, sc_uint64 size)
+{
+    GMappedFile *map = 0;
+
+    if (data->map != 0 && size <= data->map_size)
+        return SC_TRUE;
+
+    fflush(data->file);
+    map = g_mapped_file_new(data->path, FALSE, 0);
+    if (map == 0)
+        return SC_FALSE;
+
+    // streams keep references to old mapping
+    if (data->map != 0)
+        g_mapped_file_unref(data->map);
+
+    data->map = map;
+    data->map_size = g_mapped_file_get_length(map);
+
+    return (size <= data->map_size) ? SC_TRUE : SC_FALSE;
+}
+
+//! Returns page for reading
+const sc_uint8* _sc_btree_page(sc_btree_data *data, sc_uint32 page)
+{
+    const sc_uint8 *buffer = (const sc_uint8*)g_hash_table_lookup(data->dirty, GUINT_TO_POINTER(page));
+
+    if (buffer != 0)
+        return buffer;
+
+    if (_sc_btree_map(data, (sc_uint64)(page + 1) * SC_BTREE_PAGE_SIZE) == SC_FALSE)
+    {
+        g_critical("Page %u is out of database file", page);
+        return 0;
+    }
+
+    return (const sc_uint8*)g_mapped_file_get_contents(data->map) + (sc_uint64)page * SC_BTREE_PAGE_SIZE;
+}
+
+//! Allocates new changed page
+sc_uint32 _sc_btree_alloc_page(sc_btree_data *data, sc_uint8 **buffer)
+{
+    sc_uint32 page;
+
+    if (data->free_pages->len > 0)
+    {
+        page = g_array_index(data->free_pages, sc_uint32, data->free_pages->len - 1);
+        g_array_remove_index(data->free_pages, data->free_pages->len - 1);
+    }else
+        page = data->page_count++;
+
+    *buffer = g_new0(sc_uint8, SC_BTREE_PAGE_SIZE);
+    g_hash_table_insert(data->dirty, GUINT_TO_POINTER(page), *buffer);
+
+    return page;
+}
+
+void _sc_btree_free_page(sc_btree_data *data, sc_uint32 page)
+{
+    // page, that was allocated in this transaction, isn't used by committed tree
+    if (g_hash_table_remove(data->dirty, GUINT_TO_POINTER(page)) == TRUE)
+        g_array_append_val(data->free_pages, page);
+    else
+        g_array_append_val(data->pending_pages, page);
+}
+
+//! Returns page, that can be changed in current transaction. Number of page can be changed
+sc_uint32 _sc_btree_touch(sc_btree_data *data, sc_uint32 page, sc_uint8 **buffer)
+{
+    sc_uint32 new_page;
+    const sc_uint8 *old = 0;
+
+    *buffer = (sc_uint8*)g_hash_table_lookup(data->dirty, GUINT_TO_POINTER(page));
+    if (*buffer != 0)
+        return page;
+
+    old = _sc_btree_page(data, page);
+    new_page = _sc_btree_alloc_page(data, buffer);
+    memcpy(*buffer, old, SC_BTREE_PAGE_SIZE);
+    _sc_btree_free_page(data, page);
+
+    return new_page;
+}
+
+//! Returns position of the first key in leaf, that isn't less than specified one
+sc_uint16 _sc_btree_leaf_lower_bound(const sc_uint8 *page, const sc_uint8 *key)
+{
+    sc_uint16 low = 0, high = PAGE_HEADER(page)->count, mid;
+
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (memcmp(LEAF_KEY(page, mid), key, SC_BTREE_KEY_LEN) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+//! Returns index of child, that can contain specified key
+sc_uint16 _sc_btree_branch_find(const sc_uint8 *page, const sc_uint8 *key)
+{
+    sc_uint16 low = 1, high = PAGE_HEADER(page)->count, mid;
+
+    // key of the first child is ignored, it contains all keys less than key of the second one
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (memcmp(BRANCH_KEY(page, mid), key, SC_BTREE_KEY_LEN) <= 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low - 1;
+}
+
+// --- tree operations ---
+sc_bool _sc_btree_get(sc_btree_data *data, const sc_uint8 *key, sc_uint8 *value)
+{
+    sc_uint32 page_num = data->root;
+    const sc_uint8 *page = 0;
+    sc_uint16 pos;
+
+    while (page_num != 0)
+    {
+        page = _sc_btree_page(data, page_num);
+        if (page == 0)
+            return SC_FALSE;
+
+        if (PAGE_HEADER(page)->type == SC_BTREE_PAGE_BRANCH)
+        {
+            page_num = _sc_btree_get_child(page, _sc_btree_branch_find(page, key));
+            continue;
+        }
+
+        pos = _sc_btree_leaf_lower_bound(page, key);
+        if (pos < PAGE_HEADER(page)->count && memcmp(LEAF_KEY(page, pos), key, SC_BTREE_KEY_LEN) == 0)
+        {
+            memcpy(value, LEAF_VALUE(page, pos), SC_BTREE_VALUE_LEN);
+            return SC_TRUE;
+        }
+
+        return SC_FALSE;
+    }
+
+    return SC_FALSE;
+}
+
+/*! Inserts entry into node at specified position. When node is full, it's split and
+ * number of new right node is returned in \p split with its first key in \p split_key
+ */
+void _sc_btree_node_insert(sc_btree_data *data, sc_uint8 *page, sc_uint16 pos, const sc_uint8 *entry,
+                           gsize entry_len, sc_uint16 max, sc_uint32 *split, sc_uint8 *split_key)
+{
+    sc_btree_page_header *header = PAGE_HEADER(page);
+    sc_uint8 *right = 0, *target = page;
+    sc_uint16 left_count;
+
+    *split = 0;
+
+    if (header->count == max)
+    {
+        *split = _sc_btree_alloc_page(data, &right);
+        left_count = header->count / 2;
+
+        PAGE_HEADER(right)->type = header->type;
+        PAGE_HEADER(right)->count = header->count - left_count;
+        memcpy(right + SC_BTREE_HEADER_LEN, page + SC_BTREE_HEADER_LEN + left_count * entry_len, PAGE_HEADER(right)->count * entry_len);
+        header->count = left_count;
+
+        if (pos > left_count)
+        {
+            target = right;
+            pos -= left_count;
+        }
+    }
+
+    header = PAGE_HEADER(target);
+    memmove(target + SC_BTREE_HEADER_LEN + (pos + 1) * entry_len, target + SC_BTREE_HEADER_LEN + pos * entry_len, (header->count - pos) * entry_len);
+    memcpy(target + SC_BTREE_HEADER_LEN + pos * entry_len, entry, entry_len);
+    header->count++;
+
+    if (right != 0)
+        memcpy(split_key, right + SC_BTREE_HEADER_LEN, SC_BTREE_KEY_LEN);
+}
+
+//! Inserts or replaces leaf entry in subtree. Returns new number of subtree root
+sc_uint32 _sc_btree_insert_node(sc_btree_data *data, sc_uint32 page_num, const sc_uint8 *entry, sc_uint32 *split, sc_uint8 *split_key)
+{
+    sc_uint8 *page = 0;
+    sc_uint8 branch_entry[SC_BTREE_BRANCH_ENTRY];
+    sc_uint32 child, child_split = 0;
+    sc_uint16 pos;
+
+    page_num = _sc_btree_touch(data, page_num, &page);
+    *split = 0;
+
+    if (PAGE_HEADER(page)->type == SC_BTREE_PAGE_LEAF)
+    {
+        pos = _sc_btree_leaf_lower_bound(page, entry);
+        if (pos < PAGE_HEADER(page)->count && memcmp(LEAF_KEY(page, pos), entry, SC_BTREE_KEY_LEN) == 0)
+            memcpy(LEAF_VALUE(page, pos), entry + SC_BTREE_KEY_LEN, SC_BTREE_VALUE_LEN);
+        else
+            _sc_btree_node_insert(data, page, pos, entry, SC_BTREE_LEAF_ENTRY, SC_BTREE_LEAF_MAX, split, split_key);
+
+        return page_num;
+    }
+
+    pos = _sc_btree_branch_find(page, entry);
+    child = _sc_btree_insert_node(data, _sc_btree_get_child(page, pos), entry, &child_split, branch_entry);
+    _sc_btree_set_child(page, pos, child);
+
+    if (child_split != 0)
+    {
+        memcpy(branch_entry + SC_BTREE_KEY_LEN, &child_split, sizeof(child_split));
+        _sc_btree_node_insert(data, page, pos + 1, branch_entry, SC_BTREE_BRANCH_ENTRY, SC_BTREE_BRANCH_MAX, split, split_key);
+    }
+
+    return page_num;
+}
+
+void _sc_btree_put(sc_btree_data *data, const sc_uint8 *key, const sc_uint8 *value)
+{
+    sc_uint8 entry[SC_BTREE_LEAF_ENTRY], split_key[SC_BTREE_KEY_LEN];
+    sc_uint8 *page = 0;
+    sc_uint32 split = 0, old_root;
+
+    memcpy(entry, key, SC_BTREE_KEY_LEN);
+    memcpy(entry + SC_BTREE_KEY_LEN, value, SC_BTREE_VALUE_LEN);
+
+    if (data->root == 0)
+    {
+        data->root = _sc_btree_alloc_page(data, &page);
+        PAGE_HEADER(page)->type = SC_BTREE_PAGE_LEAF;
+        PAGE_HEADER(page)->count = 1;
+        memcpy(LEAF_KEY(page, 0), entry, SC_BTREE_LEAF_ENTRY);
+        return;
+    }
+
+    data->root = _sc_btree_insert_node(data, data->root, entry, &split, split_key);
+    if (split == 0)
+        return;
+
+    // tree grows up
+    old_root = data->root;
+    data->root = _sc_btree_alloc_page(data, &page);
+    PAGE_HEADER(page)->type = SC_BTREE_PAGE_BRANCH;
+    PAGE_HEADER(page)->count = 2;
+    _sc_btree_set_child(page, 0, old_root);
+    memcpy(BRANCH_KEY(page, 1), split_key, SC_BTREE_KEY_LEN);
+    _sc_btree_set_child(page, 1, split);
+}
+
+/*! Removes existing key from subtree. Returns new number of subtree root, \p empty is set,
+ * when subtree has no more entries (its root page is freed in this case)
+ */
+sc_uint32 _sc_btree_remove_node(sc_btree_data *data, sc_uint32 page_num, const sc_uint8 *key, sc_bool *empty)
+{
+    sc_uint8 *page = 0;
+    sc_btree_page_header *header = 0;
+    sc_uint32 child;
+    sc_uint16 pos;
+    sc_bool child_empty = SC_FALSE;
+
+    page_num = _sc_btree_touch(data, page_num, &page);
+    header = PAGE_HEADER(page);
+    *empty = SC_FALSE;
+
+    if (header->type == SC_BTREE_PAGE_LEAF)
+    {
+        pos = _sc_btree_leaf_lower_bound(page, key);
+        g_assert(pos < header->count);
+        memmove(LEAF_KEY(page, pos), LEAF_KEY(page, pos + 1), (header->count - pos - 1) * SC_BTREE_LEAF_ENTRY);
+        header->count--;
+    }else
+    {
+        pos = _sc_btree_branch_find(page, key);
+        child = _sc_btree_remove_node(data, _sc_btree_get_child(page, pos), key, &child_empty);
+
+        // nodes aren't merged, just empty ones are removed
+        if (child_empty == SC_TRUE)
+        {
+            memmove(BRANCH_KEY(page, pos), BRANCH_KEY(page, pos + 1), (header->count - pos - 1) * SC_BTREE_BRANCH_ENTRY);
+            header->count--;
+        }else
+            _sc_btree_set_child(page, pos, child);
+    }
+
+    if (header->count == 0)
+    {
+        _sc_btree_free_page(data, page_num);
+        *empty = SC_TRUE;
+        return 0;
+    }
+
+    return page_num;
+}
+
+sc_bool _sc_btree_remove(sc_btree_data *data, const sc_uint8 *key)
+{
+    sc_uint8 value[SC_BTREE_VALUE_LEN];
+    const sc_uint8 *page = 0;
+    sc_bool empty = SC_FALSE;
+    sc_uint32 old_root;
+
+    if (_sc_btree_get(data, key, value) == SC_FALSE)
+        return SC_FALSE;
+
+    data->root = _sc_btree_remove_node(data, data->root, key, &empty);
+
+    // remove root branches with one child
+    while (data->root != 0)
+    {
+        page = _sc_btree_page(data, data->root);
+        if (PAGE_HEADER(page)->type != SC_BTREE_PAGE_BRANCH || PAGE_HEADER(page)->count > 1)
+            break;
+
+        old_root = data->root;
+        data->root = _sc_btree_get_child(page, 0);
+        _sc_btree_free_page(data, old_root);
+    }
+
+    return SC_TRUE;
+}
+
+//! Appends sc-addrs from all keys with the same checksum as \p key to \p result
+void _sc_btree_scan_addrs(sc_btree_data *data, sc_uint32 page_num, const sc_uint8 *key, GArray *result)
+{
+    const sc_uint8 *page = _sc_btree_page(data, page_num);
+    sc_uint16 pos, count;
+    sc_addr addr;
+
+    if (page == 0)
+        return;
+
+    count = PAGE_HEADER(page)->count;
+
+    if (PAGE_HEADER(page)->type == SC_BTREE_PAGE_BRANCH)
+    {
+        for (pos = _sc_btree_branch_find(page, key); pos < count; ++pos)
+        {
+            if (pos > 0 && memcmp(BRANCH_KEY(page, pos), key, SC_BTREE_PREFIX_LEN) > 0)
+                break;
+            _sc_btree_scan_addrs(data, _sc_btree_get_child(page, pos), key, result);
+            // mapping can be changed by recursive call
+            page = _sc_btree_page(data, page_num);
+        }
+        return;
+    }
+
+    for (pos = _sc_btree_leaf_lower_bound(page, key); pos < count; ++pos)
+    {
+        if (memcmp(LEAF_KEY(page, pos), key, SC_BTREE_PREFIX_LEN) != 0)
+            break;
+        _sc_btree_key_addr(LEAF_KEY(page, pos), &addr);
+        g_array_append_val(result, addr);
+    }
+}
+
+//! Marks pages, that are used by subtree and contents referenced from it
+void _sc_btree_mark_used(sc_btree_data *data, sc_uint32 page_num, sc_uint8 *used)
+{
+    const sc_uint8 *page = _sc_btree_page(data, page_num);
+    sc_uint32 first, size, i;
+    sc_uint16 pos;
+
+    if (page == 0 || page_num >= data->page_count)
+        return;
+
+    used[page_num] = 1;
+
+    for (pos = 0; pos < PAGE_HEADER(page)->count; ++pos)
+    {
+        if (PAGE_HEADER(page)->type == SC_BTREE_PAGE_BRANCH)
+        {
+            _sc_btree_mark_used(data, _sc_btree_get_child(page, pos), used);
+            page = _sc_btree_page(data, page_num);
+            continue;
+        }
+
+        if (LEAF_KEY(page, pos)[0] != SC_BTREE_KEY_CONTENT)
+            continue;
+
+        memcpy(&first, LEAF_VALUE(page, pos), sizeof(first));
+        memcpy(&size, LEAF_VALUE(page, pos) + 4, sizeof(size));
+        for (i = 0; i < (size + SC_BTREE_PAGE_SIZE - 1) / SC_BTREE_PAGE_SIZE && first + i < data->page_count; ++i)
+            used[first + i] = 1;
+    }
+}
+
+//! Moves position of database file to start of specified page
+sc_bool _sc_btree_seek_page(FILE *file, sc_uint64 page)
+{
+    return fseeko(file, page * SC_BTREE_PAGE_SIZE, SEEK_SET) == 0 ? SC_TRUE : SC_FALSE;
+}
+
+// --- transactions ---
+sc_bool _sc_btree_write_meta(sc_btree_data *data, const sc_btree_meta *meta)
+{
+    sc_uint8 page[SC_BTREE_PAGE_SIZE];
+
+    memset(page, 0, sizeof(page));
+    memcpy(page, meta, sizeof(sc_btree_meta));
+
+    if (_sc_btree_seek_page(data->file, meta->txn % SC_BTREE_META_PAGES) == SC_FALSE ||
+        fwrite(page, sizeof(page), 1, data->file) != 1 ||
+        fflush(data->file) != 0 || fsync(fileno(data->file)) != 0)
+        return SC_FALSE;
+
+    return SC_TRUE;
+}
+
+//! Writes changed pages and switches meta to new tree
+sc_bool _sc_btree_commit(sc_btree_data *data)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+    sc_btree_meta meta;
+
+    if (g_hash_table_size(data->dirty) == 0 && data->root == data->meta.root && data->page_count == data->meta.page_count)
+        return SC_TRUE;
+
+    // new tree is written into pages, that aren't used by committed one
+    g_hash_table_iter_init(&iter, data->dirty);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        if (_sc_btree_seek_page(data->file, GPOINTER_TO_UINT(key)) == SC_FALSE ||
+            fwrite(value, SC_BTREE_PAGE_SIZE, 1, data->file) != 1)
+            return SC_FALSE;
+    }
+
+    if (fflush(data->file) != 0 || fsync(fileno(data->file)) != 0)
+        return SC_FALSE;
+
+    meta = data->meta;
+    meta.txn++;
+    meta.root = data->root;
+    meta.page_count = data->page_count;
+    meta.check = _sc_btree_meta_check(&meta);
+
+    if (_sc_btree_write_meta(data, &meta) == SC_FALSE)
+        return SC_FALSE;
+
+    data->meta = meta;
+    g_hash_table_remove_all(data->dirty);
+    g_array_append_vals(data->free_pages, data->pending_pages->data, data->pending_pages->len);
+    g_array_set_size(data->pending_pages, 0);
+
+    // reused pages could be mapped before they were written
+    if (data->map != 0)
+    {
+        g_mapped_file_unref(data->map);
+        data->map = 0;
+    }
+
+    return SC_TRUE;
+}
+
+sc_bool _sc_btree_commit_if_needed(sc_btree_data *data)
+{
+    if (g_hash_table_size(data->dirty) < SC_BTREE_MAX_DIRTY_PAGES)
+        return SC_TRUE;
+
+    return _sc_btree_commit(data);
+}
+
+sc_bool _sc_btree_meta_is_valid(const sc_btree_meta *meta)
+{
+    return (meta->signature == SC_BTREE_SIGNATURE && meta->version == SC_BTREE_VERSION &&
+            meta->check == _sc_btree_meta_check(meta) && meta->page_count >= SC_BTREE_META_PAGES) ? SC_TRUE : SC_FALSE;
+}
+
+void _sc_btree_close(sc_btree_data *data)
+{
+    if (data->map != 0)
+        g_mapped_file_unref(data->map);
+    if (data->file != 0)
+        fclose(data->file);
+
+    data->map = 0;
+    data->map_size = 0;
+    data->file = 0;
+
+    g_hash_table_remove_all(data->dirty);
+    g_array_set_size(data->free_pages, 0);
+    g_array_set_size(data->pending_pages, 0);
+}
+
+//! Opens database file (creates new one, if it doesn't exist) and loads last committed state
+sc_bool _sc_btree_open(sc_btree_data *data)
+{
+    const sc_btree_meta *metas[SC_BTREE_META_PAGES];
+    sc_btree_meta meta;
+    sc_uint8 *used = 0;
+    sc_uint32 i, page;
+
+    data->file = fopen(data->path, "r+b");
+    if (data->file == 0)
+    {
+        data->file = fopen(data->path, "w+b");
+        if (data->file == 0)
+            return SC_FALSE;
+
+        memset(&meta, 0, sizeof(meta));
+        meta.signature = SC_BTREE_SIGNATURE;
+        meta.version = SC_BTREE_VERSION;
+        meta.page_count = SC_BTREE_META_PAGES;
+        meta.check = _sc_btree_meta_check(&meta);
+
+        // second meta page stays invalid until the first commit
+        if (_sc_btree_write_meta(data, &meta) == SC_FALSE)
+            return SC_FALSE;
+        meta.txn = 1;
+        meta.check = 0;
+        if (_sc_btree_write_meta(data, &meta) == SC_FALSE)
+            return SC_FALSE;
+    }
+
+    if (_sc_btree_map(data, SC_BTREE_META_PAGES * SC_BTREE_PAGE_SIZE) == SC_FALSE)
+        return SC_FALSE;
+
+    // the last valid meta describes committed state
+    for (i = 0; i < SC_BTREE_META_PAGES; ++i)
+        metas[i] = (const sc_btree_meta*)(g_mapped_file_get_contents(data->map) + i * SC_BTREE_PAGE_SIZE);
+
+    if (_sc_btree_meta_is_valid(metas[0]) == SC_TRUE &&
+        (_sc_btree_meta_is_valid(metas[1]) == SC_FALSE || metas[0]->txn > metas[1]->txn))
+        data->meta = *metas[0];
+    else if (_sc_btree_meta_is_valid(metas[1]) == SC_TRUE)
+        data->meta = *metas[1];
+    else
+    {
+        g_critical("Database file %s is corrupted", data->path);
+        return SC_FALSE;
+    }
+
+    data->root = data->meta.root;
+    data->page_count = data->meta.page_count;
+
+    // pages, that aren't used by committed tree and contents, can be reused
+    used = g_new0(sc_uint8, data->page_count);
+    for (i = 0; i < SC_BTREE_META_PAGES; ++i)
+        used[i] = 1;
+    if (data->root != 0)
+        _sc_btree_mark_used(data, data->root, used);
+
+    for (i = data->page_count; i > SC_BTREE_META_PAGES; --i)
+    {
+        page = i - 1;
+        if (used[page] == 0)
+            g_array_append_val(data->free_pages, page);
+    }
+    g_free(used);
+
+    return SC_TRUE;
+}
+
+// --- writing ---
+sc_result sc_btree_stream_write(const sc_stream *stream, sc_char *data, sc_uint32 length, sc_uint32 *bytes_written)
+{
+    sc_btree_write *write = (sc_btree_write*)stream->handler;
+    g_assert(write != 0);
+
+    *bytes_written = fwrite(data, 1, length, write->file);
+    write->size += *bytes_written;
+
+    return (*bytes_written == length) ? SC_RESULT_OK : SC_RESULT_ERROR_IO;
+}
+
+sc_result sc_btree_stream_read(const sc_stream *stream, sc_char *data, sc_uint32 length, sc_uint32 *bytes_read)
+{
+    return SC_RESULT_ERROR;
+}
+
+sc_result sc_btree_stream_seek(const sc_stream *stream, sc_stream_seek_origin origin, sc_uint32 offset)
+{
+    return SC_RESULT_ERROR;
+}
+
+sc_result sc_btree_stream_tell(const sc_stream *stream, sc_uint32 *position)
+{
+    sc_btree_write *write = (sc_btree_write*)stream->handler;
+    g_assert(write != 0);
+
+    *position = write->size;
+    return SC_RESULT_OK;
+}
+
+sc_bool sc_btree_stream_eof(const sc_stream *stream)
+{
+    return SC_TRUE;
+}
+
+sc_result _sc_btree_content_commit(sc_btree_data *data, sc_btree_write *write, const sc_check_sum *check_sum);
+
+sc_result sc_btree_stream_free_handler(const sc_stream *stream)
+{
+    sc_btree_write *write = (sc_btree_write*)stream->handler;
+    g_assert(write != 0);
+
+    // content with known checksum is committed on stream close, temporary content - by engine commit
+    if (write->temp == SC_FALSE)
+        return _sc_btree_content_commit(write->data, write, &write->check_sum);
+
+    return SC_RESULT_OK;
+}
+
+sc_stream* _sc_btree_write_begin(sc_btree_data *data, const sc_check_sum *check_sum)
+{
+    static volatile gint write_counter = 0;
+    sc_btree_write *write = 0;
+    sc_stream *stream = 0;
+
+    // content is written into temporary file, so several contents can be written at one moment
+    write = g_new0(sc_btree_write, 1);
+    write->data = data;
+    g_snprintf(write->path, MAX_PATH_LENGTH, "%s.%d.tmp", data->path, g_atomic_int_add(&write_counter, 1));
+    write->file = fopen(write->path, "w+b");
+    if (write->file == 0)
+    {
+        g_critical("Can't create temporary file %s", write->path);
+        g_free(write);
+        return 0;
+    }
+
+    write->temp = (check_sum == 0) ? SC_TRUE : SC_FALSE;
+    if (check_sum != 0)
+        write->check_sum = *check_sum;
+
+    stream = g_new0(sc_stream, 1);
+    stream->flags = SC_STREAM_WRITE | SC_STREAM_TELL;
+    stream->handler = write;
+
+    stream->read_func = &sc_btree_stream_read;
+    stream->write_func = &sc_btree_stream_write;
+    stream->seek_func = &sc_btree_stream_seek;
+    stream->tell_func = &sc_btree_stream_tell;
+    stream->free_func = &sc_btree_stream_free_handler;
+    stream->eof_func = &sc_btree_stream_eof;
+
+    return stream;
+}
+
+//! Copies temporary file into continuous pages at the end of database file
+sc_bool _sc_btree_content_copy(sc_btree_data *data, sc_btree_write *write, sc_uint32 first_page)
+{
+    sc_char buffer[64 * 1024];
+    sc_uint32 copied = 0;
+    gsize n;
+
+    if (fflush(write->file) != 0 || fseek(write->file, 0, SEEK_SET) != 0 ||
+        _sc_btree_seek_page(data->file, first_page) == SC_FALSE)
+        return SC_FALSE;
+
+    while (copied < write->size)
+    {
+        n = fread(buffer, 1, MIN(sizeof(buffer), write->size - copied), write->file);
+        if (n == 0 || fwrite(buffer, 1, n, data->file) != n)
+            return SC_FALSE;
+        copied += n;
+    }
+
+    return fflush(data->file) == 0 ? SC_TRUE : SC_FALSE;
+}
+
+sc_result _sc_btree_content_commit(sc_btree_data *data, sc_btree_write *write, const sc_check_sum *check_sum)
+{
+    sc_uint8 key[SC_BTREE_KEY_LEN], value[SC_BTREE_VALUE_LEN];
+    sc_uint32 first_page;
+    sc_result result = SC_RESULT_OK;
+
+    g_mutex_lock(&data->mutex);
+
+    _sc_btree_make_key(SC_BTREE_KEY_CONTENT, check_sum != 0 ? check_sum : &write->check_sum, 0, key);
+
+    // the same content is already stored (or temporary content is discarded)
+    if (check_sum != 0 && _sc_btree_get(data, key, value) == SC_FALSE)
+    {
+        // contents aren't stored in free pages, because they have to be continuous
+        first_page = (write->size > 0) ? data->page_count : 0;
+        if (_sc_btree_content_copy(data, write, first_page) == SC_TRUE)
+        {
+            data->page_count += (write->size + SC_BTREE_PAGE_SIZE - 1) / SC_BTREE_PAGE_SIZE;
+
+            memcpy(value, &first_page, sizeof(first_page));
+            memcpy(value + 4, &write->size, sizeof(write->size));
+            _sc_btree_put(data, key, value);
+
+            if (_sc_btree_commit_if_needed(data) == SC_FALSE)
+                result = SC_RESULT_ERROR_IO;
+        }else
+            result = SC_RESULT_ERROR_IO;
+    }
+
+    g_mutex_unlock(&data->mutex);
+
+    fclose(write->file);
+    g_remove(write->path);
+    g_free(write);
+
+    return result;
+}
+
+// --- implementation of interface ---
+sc_result sc_btree_engine_create_stream(const sc_fm_engine *engine, const sc_check_sum *check_sum, sc_uint8 flags, sc_stream **stream)
+{
+    sc_btree_data *data = (sc_btree_data*)engine->storage_info;
+    sc_uint8 key[SC_BTREE_KEY_LEN], value[SC_BTREE_VALUE_LEN];
+    sc_uint32 first_page, size;
+    sc_uint64 offset;
+    sc_result result = SC_RESULT_ERROR_NOT_FOUND;
+
+    g_assert(data);
+    *stream = 0;
+
+    if (flags & SC_STREAM_WRITE)
+    {
+        *stream = _sc_btree_write_begin(data, check_sum);
+        return *stream != 0 ? SC_RESULT_OK : SC_RESULT_ERROR_IO;
+    }
+
+    _sc_btree_make_key(SC_BTREE_KEY_CONTENT, check_sum, 0, key);
+
+    g_mutex_lock(&data->mutex);
+    if (_sc_btree_get(data, key, value) == SC_TRUE)
+    {
+        memcpy(&first_page, value, sizeof(first_page));
+        memcpy(&size, value + 4, sizeof(size));
+        offset = (sc_uint64)first_page * SC_BTREE_PAGE_SIZE;
+
+        if (size == 0 || _sc_btree_map(data, offset + size) == SC_TRUE)
+            *stream = sc_stream_memory_new_mapped(size > 0 ? data->map : 0, offset, size);
+        result = (*stream != 0) ? SC_RESULT_OK : SC_RESULT_ERROR_IO;
+    }
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_btree_engine_create_temp_stream(const sc_fm_engine *engine, sc_stream **stream, void **temp_handle)
+{
+    sc_btree_data *data = (sc_btree_data*)engine->storage_info;
+    g_assert(data);
+
+    *stream = _sc_btree_write_begin(data, 0);
+    if (*stream == 0)
+        return SC_RESULT_ERROR_IO;
+
+    *temp_handle = (*stream)->handler;
+    return SC_RESULT_OK;
+}
+
+sc_result sc_btree_engine_commit_stream(const sc_fm_engine *engine, void *temp_handle, const sc_check_sum *check_sum)
+{
+    sc_btree_data *data = (sc_btree_data*)engine->storage_info;
+    g_assert(data);
+
+    return _sc_btree_content_commit(data, (sc_btree_write*)temp_handle, check_sum);
+}
+
+sc_result sc_btree_engine_addr_ref_append(const sc_fm_engine *engine, sc_addr addr, const sc_check_sum *check_sum)
+{
+    sc_btree_data *data = (sc_btree_data*)engine->storage_info;
+    sc_uint8 key[SC_BTREE_KEY_LEN], value[SC_BTREE_VALUE_LEN];
+    sc_uint32 refs = 0;
+    sc_result result = SC_RESULT_OK;
+
+    g_assert(data);
+
+    _sc_btree_make_key(SC_BTREE_KEY_ADDR, check_sum, &addr, key);
+
+    g_mutex_lock(&data->mutex);
+    if (_sc_btree_get(data, key, value) == SC_TRUE)
+        memcpy(&refs, value, sizeof(refs));
+    else
+        memset(value, 0, sizeof(value));
+
+    refs++;
+    memcpy(value, &refs, sizeof(refs));
+    _sc_btree_put(data, key, value);
+
+    if (_sc_btree_commit_if_needed(data) == SC_FALSE)
+        result = SC_RESULT_ERROR_IO;
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_btree_engine_addr_ref_remove(const sc_fm_engine *engine, sc_addr addr, const sc_check_sum *check_sum)
+{
+    sc_btree_data *data = (sc_btree_data*)engine->storage_info;
+    sc_uint8 key[SC_BTREE_KEY_LEN], value[SC_BTREE_VALUE_LEN];
+    sc_uint32 refs = 0;
+    sc_result result = SC_RESULT_ERROR_NOT_FOUND;
+
+    g_assert(data);
+
+    _sc_btree_make_key(SC_BTREE_KEY_ADDR, check_sum, &addr, key);
+
+    g_mutex_lock(&data->mutex);
+    if (_sc_btree_get(data, key, value) == SC_TRUE)
+    {
+        memcpy(&refs, value, sizeof(refs));
+        if (refs > 1)
+        {
+            refs--;
+            memcpy(value, &refs, sizeof(refs));
+            _sc_btree_put(data, key, value);
+        }else
+            _sc_btree_remove(data, key);
+
+        result = (_sc_btree_commit_if_needed(data) == SC_TRUE) ? SC_RESULT_OK : SC_RESULT_ERROR_IO;
+    }
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_btree_engine_find(const sc_fm_engine *engine, const sc_check_sum *check_sum, sc_addr **result, sc_uint32 *result_count)
+{
+    sc_btree_data *data = (sc_btree_data*)engine->storage_info;
+    sc_uint8 key[SC_BTREE_KEY_LEN];
+    GArray *addrs = 0;
+
+    g_assert(data);
+    g_assert(*result == 0);
+
+    *result_count = 0;
+    _sc_btree_make_key(SC_BTREE_KEY_ADDR, check_sum, 0, key);
+    addrs = g_array_new(FALSE, FALSE, sizeof(sc_addr));
+
+    g_mutex_lock(&data->mutex);
+    if (data->root != 0)
+        _sc_btree_scan_addrs(data, data->root, key, addrs);
+    g_mutex_unlock(&data->mutex);
+
+    if (addrs->len > 0)
+    {
+        *result_count = addrs->len;
+        *result = (sc_addr*)g_array_free(addrs, FALSE);
+    }else
+        g_array_free(addrs, TRUE);
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_btree_engine_clear(const sc_fm_engine *engine)
+{
+    sc_btree_data *data = (sc_btree_data*)engine->storage_info;
+    sc_result result = SC_RESULT_OK;
+
+    g_assert(data);
+
+    g_mutex_lock(&data->mutex);
+
+    _sc_btree_close(data);
+    if (g_file_test(data->path, G_FILE_TEST_EXISTS) && g_remove(data->path) == -1)
+    {
+        g_critical("Can't remove file: %s", data->path);
+        result = SC_RESULT_ERROR;
+    }
+
+    if (_sc_btree_open(data) == SC_FALSE)
+        result = SC_RESULT_ERROR_IO;
+
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_btree_engine_save(const sc_fm_engine *engine)
+{
+    sc_btree_data *data = (sc_btree_data*)engine->storage_info;
+    sc_result result = SC_RESULT_OK;
+
+    g_assert(data);
+
+    g_mutex_lock(&data->mutex);
+    if (data->file == 0 || _sc_btree_commit(data) == SC_FALSE)
+    {
+        g_critical("Can't commit changes into %s", data->path);
+        result = SC_RESULT_ERROR_IO;
+    }
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_btree_engine_destroy_data(const sc_fm_engine *engine)
+{
+    sc_btree_data *data = (sc_btree_data*)engine->storage_info;
+    g_assert(data);
+
+    if (data->file != 0 && _sc_btree_commit(data) == SC_FALSE)
+        g_critical("Can't commit changes into %s", data->path);
+
+    _sc_btree_close(data);
+    g_hash_table_destroy(data->dirty);
+    g_array_free(data->free_pages, TRUE);
+    g_array_free(data->pending_pages, TRUE);
+    g_mutex_clear(&data->mutex);
+    g_free(data);
+
+    return SC_RESULT_OK;
+}
+
+
+// --- extension interface ---
+sc_fm_engine* initialize(const sc_char* repo_path)
+{
+    sc_btree_data *data = 0;
+    sc_fm_engine *engine = 0;
+
+    data = g_new0(sc_btree_data, 1);
+    g_snprintf(data->path, MAX_PATH_LENGTH, "%s/%s", repo_path, db_file_name);
+    g_mutex_init(&data->mutex);
+
+    if (!g_file_test(repo_path, G_FILE_TEST_IS_DIR))
+    {
+        if (g_mkdir_with_parents(repo_path, -1) < 0)
+            g_error("Can't create '%s' directory.", repo_path);
+    }
+
+    data->dirty = g_hash_table_new_full(g_direct_hash, g_direct_equal, 0, g_free);
+    data->free_pages = g_array_new(FALSE, FALSE, sizeof(sc_uint32));
+    data->pending_pages = g_array_new(FALSE, FALSE, sizeof(sc_uint32));
+
+    if (_sc_btree_open(data) == SC_FALSE)
+    {
+        g_critical("Can't open database file: %s", data->path);
+        sc_fm_engine tmp;
+        tmp.storage_info = data;
+        sc_btree_engine_destroy_data(&tmp);
+        return 0;
+    }
+
+    g_message("\tDatabase: %u pages (%u free)", data->page_count, data->free_pages->len);
+
+    engine = g_new0(sc_fm_engine, 1);
+
+    engine->storage_info = data;
+    engine->funcStreamCreate = &sc_btree_engine_create_stream;
+    engine->funcAddrRefAppend = &sc_btree_engine_addr_ref_append;
+    engine->funcAddrRefRemove = &sc_btree_engine_addr_ref_remove;
+    engine->funcFind = &sc_btree_engine_find;
+    engine->funcClear = &sc_btree_engine_clear;
+    engine->funcSave = &sc_btree_engine_save;
+    engine->funcDestroyData = &sc_btree_engine_destroy_data;
+    engine->funcStreamCreateTemp = &sc_btree_engine_create_temp_stream;
+    engine->funcStreamCommit = &sc_btree_engine_commit_stream;
+
+    return engine;
+}
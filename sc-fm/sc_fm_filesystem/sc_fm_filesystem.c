@@ -23,9 +23,19 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include "sc_fm_engine_private.h"
 #include "sc_stream_file.h"
 #include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+
+#ifdef WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
 
 gchar contents_path[MAX_PATH_LENGTH + 1];
+gchar temp_path[MAX_PATH_LENGTH + 1];
 const gchar *content_dir = "contents";
+const gchar *temp_dir = "tmp";
 
 
 sc_uint8* sc_fs_engine_make_checksum_path(const sc_check_sum *check_sum)
@@ -80,79 +90,236 @@ sc_result sc_fs_engine_create_stream(const sc_fm_engine *engine, const sc_check_
         }
     }
 
+    free(path);
+
     // write content into file
     *stream = sc_stream_file_new(data_path, flags);
 
-    return stream != 0 ? SC_RESULT_OK : SC_RESULT_ERROR_IO;
+    return *stream != 0 ? SC_RESULT_OK : SC_RESULT_ERROR_IO;
 }
 
-sc_result sc_fs_engine_addr_ref_append(const sc_fm_engine *engine, sc_addr addr, const sc_check_sum *check_sum)
+sc_result sc_fs_engine_create_temp_stream(const sc_fm_engine *engine, sc_stream **stream, void **temp_handle)
+{
+    gchar *file_path = 0;
+    gint fd = -1;
+
+    // temporary files are stored in the same file system with contents, so commit is just a rename
+    if (g_mkdir_with_parents(temp_path, -1) < 0)
+    {
+        g_message("Error while creating '%s' directory", temp_path);
+        return SC_RESULT_ERROR_IO;
+    }
+
+    file_path = g_strdup_printf("%s/contentXXXXXX", temp_path);
+    fd = g_mkstemp(file_path);
+    if (fd == -1)
+    {
+        g_free(file_path);
+        return SC_RESULT_ERROR_IO;
+    }
+    close(fd);
+
+    *stream = sc_stream_file_new(file_path, SC_STREAM_WRITE);
+    if (*stream == 0)
+    {
+        g_remove(file_path);
+        g_free(file_path);
+        return SC_RESULT_ERROR_IO;
+    }
+
+    *temp_handle = file_path;
+    return SC_RESULT_OK;
+}
+
+sc_result sc_fs_engine_commit_stream(const sc_fm_engine *engine, void *temp_handle, const sc_check_sum *check_sum)
+{
+    gchar *file_path = (gchar*)temp_handle;
+    sc_uint8 *path = 0;
+    gchar abs_path[MAX_PATH_LENGTH];
+    gchar data_path[MAX_PATH_LENGTH];
+    sc_result res = SC_RESULT_OK;
+
+    g_assert(file_path != 0);
+
+    if (check_sum == 0)
+    {
+        g_remove(file_path);
+        g_free(file_path);
+        return SC_RESULT_OK;
+    }
+
+    path = sc_fs_engine_make_checksum_path(check_sum);
+    g_snprintf(abs_path, MAX_PATH_LENGTH, "%s/%s", contents_path, path);
+    g_snprintf(data_path, MAX_PATH_LENGTH, "%sdata", abs_path);
+    free(path);
+
+    if (g_file_test(data_path, G_FILE_TEST_EXISTS) == TRUE)
+    {
+        // the same content already stored
+        g_remove(file_path);
+    }else
+    {
+        if (g_mkdir_with_parents(abs_path, -1) < 0 || g_rename(file_path, data_path) != 0)
+        {
+            g_message("Error while moving '%s' to '%s'", file_path, data_path);
+            g_remove(file_path);
+            res = SC_RESULT_ERROR_IO;
+        }
+    }
+
+    g_free(file_path);
+    return res;
+}
+
+/*! References to sc-links are stored in append-only log (addrs_log file). Each record
+ * appends or removes one sc-addr, so reference update is O(1). Repositories created before
+ * contain addrs file (number of sc-addrs and sc-addrs), it's read before log.
+ * When log becomes much longer than the number of references, find rewrites it with the
+ * records, that are needed to get the same references.
+ */
+enum _sc_fs_addr_op
+{
+    SC_FS_ADDR_APPEND = 0,
+    SC_FS_ADDR_REMOVE
+};
+
+struct _sc_fs_addr_record
+{
+    sc_addr addr;
+    sc_uint32 op;   // one of _sc_fs_addr_op values
+};
+
+typedef struct _sc_fs_addr_record sc_fs_addr_record;
+
+//! Log is compacted, when it has more records than this factor multiplied by number of references
+#define SC_FS_ADDR_LOG_COMPACT_FACTOR 4
+//! Minimal number of records in log to compact it
+#define SC_FS_ADDR_LOG_COMPACT_MIN 32
+
+//! Protects logs from compaction, while records are appended into them
+GMutex addrs_log_mutex; // statically allocated GMutex doesn't need initialization
+
+sc_result _sc_fs_engine_addr_log_append(const sc_check_sum *check_sum, sc_addr addr, sc_uint32 op, sc_bool create)
 {
     sc_uint8 *path = sc_fs_engine_make_checksum_path(check_sum);
     gchar abs_path[MAX_PATH_LENGTH];
-    gchar addr_path[MAX_PATH_LENGTH];
-    gchar *content = 0;
-    gchar *content2 = 0;
-    gsize content_len = 0;
-    sc_uint32 addrs_num = 0;
+    gchar log_path[MAX_PATH_LENGTH];
+    sc_fs_addr_record record;
+    FILE *file = 0;
+    sc_result result = SC_RESULT_OK;
 
     // make absolute path to content directory
     g_snprintf(abs_path, MAX_PATH_LENGTH, "%s/%s", contents_path, path);
-    g_snprintf(addr_path, MAX_PATH_LENGTH, "%saddrs", abs_path);
+    g_snprintf(log_path, MAX_PATH_LENGTH, "%saddrs_log", abs_path);
+    free(path);
 
-    // try to load existing file
-    if (g_file_test(addr_path, G_FILE_TEST_EXISTS))
+    if (g_file_test(abs_path, G_FILE_TEST_IS_DIR) == FALSE)
     {
-        if (g_file_get_contents(addr_path, &content, &content_len, 0) == FALSE)
+        if (create == SC_FALSE)
+            return SC_RESULT_ERROR_NOT_FOUND;
+
+        // content data can be stored out of file memory (inline contents), so directory may not exist
+        if (g_mkdir_with_parents(abs_path, -1) < 0)
         {
-            if (content != 0)
-                free(content);
-            free(path);
+            g_message("Error while creating '%s' directory", abs_path);
             return SC_RESULT_ERROR_IO;
         }
     }
 
-    // append addr into content
-    if (content == 0)
+    memset(&record, 0, sizeof(record));
+    record.addr = addr;
+    record.op = op;
+
+    g_mutex_lock(&addrs_log_mutex);
+
+    file = fopen(log_path, "ab");
+    if (file == 0)
     {
-        content_len = sizeof(sc_addr) + sizeof(sc_uint32);
-        content = g_new0(gchar, content_len);
+        g_mutex_unlock(&addrs_log_mutex);
+        return SC_RESULT_ERROR_IO;
+    }
 
-        addrs_num = 1;
-        memcpy(content, &addrs_num, sizeof(addrs_num));
-        memcpy(content + sizeof(addrs_num), &addr, sizeof(addr));
-    }else
+    if (fwrite(&record, sizeof(record), 1, file) != 1)
+        result = SC_RESULT_ERROR_IO;
+
+    if (fclose(file) != 0)
+        result = SC_RESULT_ERROR_IO;
+
+    g_mutex_unlock(&addrs_log_mutex);
+
+    return result;
+}
+
+/*! Rewrites log with records, that turn \p legacy sc-addrs (from addrs file) into \p addrs.
+ * New log is written into temporary file and replaces old one, so log is valid at any moment.
+ */
+void _sc_fs_engine_addr_log_compact(const gchar *log_path, const GArray *legacy, const GArray *addrs)
+{
+    gchar tmp_path[MAX_PATH_LENGTH];
+    GArray *records = g_array_new(FALSE, FALSE, sizeof(sc_fs_addr_record));
+    GArray *removed = g_array_sized_new(FALSE, FALSE, sizeof(sc_addr), legacy->len);
+    sc_fs_addr_record record;
+    sc_bool written = SC_FALSE;
+    FILE *file = 0;
+    guint i, j;
+
+    memset(&record, 0, sizeof(record));
+
+    // legacy sc-addrs, that aren't in result, are removed, and other result sc-addrs are appended
+    g_array_append_vals(removed, legacy->data, legacy->len);
+    for (i = 0; i < addrs->len; ++i)
     {
-        content2 = content;
-        (*(sc_uint32*)content2)++;
+        record.addr = g_array_index(addrs, sc_addr, i);
+        for (j = 0; j < removed->len; ++j)
+        {
+            if (SC_ADDR_IS_EQUAL(g_array_index(removed, sc_addr, j), record.addr))
+                break;
+        }
 
-        content = g_new0(gchar, content_len + sizeof(addr));
-        memcpy(content, content2, content_len);
-        memcpy(content + content_len, &addr, sizeof(addr));
-        content_len += sizeof(addr);
+        if (j < removed->len)
+            g_array_remove_index_fast(removed, j);
+        else
+        {
+            record.op = SC_FS_ADDR_APPEND;
+            g_array_append_val(records, record);
+        }
+    }
 
-        // old content doesn't need
-        g_free(content2);
+    for (i = 0; i < removed->len; ++i)
+    {
+        record.addr = g_array_index(removed, sc_addr, i);
+        record.op = SC_FS_ADDR_REMOVE;
+        g_array_append_val(records, record);
     }
 
-    // write content to file
-    if (g_file_set_contents(addr_path, content, content_len, 0) == TRUE)
+    g_snprintf(tmp_path, MAX_PATH_LENGTH, "%s.tmp", log_path);
+    file = fopen(tmp_path, "wb");
+    if (file != 0)
     {
-        g_free(content);
-        free(path);
+        written = (records->len == 0 || fwrite(records->data, sizeof(sc_fs_addr_record), records->len, file) == records->len) ? SC_TRUE : SC_FALSE;
+        if (fclose(file) != 0)
+            written = SC_FALSE;
 
-        return SC_RESULT_OK;
+        // old log is still valid, if it can't be replaced
+        if (written == SC_FALSE || g_rename(tmp_path, log_path) != 0)
+        {
+            g_message("Error while compacting '%s'", log_path);
+            g_remove(tmp_path);
+        }
     }
 
-    g_free(content);
-    free(path);
+    g_array_free(removed, TRUE);
+    g_array_free(records, TRUE);
+}
 
-    return SC_RESULT_ERROR;
+sc_result sc_fs_engine_addr_ref_append(const sc_fm_engine *engine, sc_addr addr, const sc_check_sum *check_sum)
+{
+    return _sc_fs_engine_addr_log_append(check_sum, addr, SC_FS_ADDR_APPEND, SC_TRUE);
 }
 
 sc_result sc_fs_engine_addr_ref_remove(const sc_fm_engine *engine, sc_addr addr, const sc_check_sum *check_sum)
 {
-    return g_rmdir(contents_path) != -1 ? SC_RESULT_OK : SC_RESULT_ERROR;
+    return _sc_fs_engine_addr_log_append(check_sum, addr, SC_FS_ADDR_REMOVE, SC_FALSE);
 }
 
 sc_result sc_fs_engine_find(const sc_fm_engine *engine, const sc_check_sum *check_sum, sc_addr **result, sc_uint32 *result_count)
@@ -160,49 +327,96 @@ sc_result sc_fs_engine_find(const sc_fm_engine *engine, const sc_check_sum *chec
     sc_uint8 *path = sc_fs_engine_make_checksum_path(check_sum);
     gchar abs_path[MAX_PATH_LENGTH];
     gchar addr_path[MAX_PATH_LENGTH];
-    gchar *content = 0, *content2 = 0;
-    gsize content_len = 0;
+    gchar *content = 0;
+    gsize content_len = 0, i;
+    GArray *legacy = g_array_new(FALSE, FALSE, sizeof(sc_addr));
+    GArray *addrs = 0;
+    sc_uint32 count = 0, records_count = 0, removes_count = 0;
+    guint j;
 
     // make absolute path to content directory
     g_snprintf(abs_path, MAX_PATH_LENGTH, "%s/%s", contents_path, path);
-    g_snprintf(addr_path, MAX_PATH_LENGTH, "%saddrs", abs_path);
+    free(path);
 
     // must be a null pointer
     g_assert(*result == 0);
 
+    *result = 0;
     *result_count = 0;
 
-    // try to load existing file
+    // addrs stored by old versions
+    g_snprintf(addr_path, MAX_PATH_LENGTH, "%saddrs", abs_path);
     if (g_file_test(addr_path, G_FILE_TEST_EXISTS))
     {
         if (g_file_get_contents(addr_path, &content, &content_len, 0) == FALSE)
         {
-            if (content != 0)
-                free(content);
-            free(path);
+            g_array_free(legacy, TRUE);
+            return SC_RESULT_ERROR_IO;
+        }
+
+        if (content_len >= sizeof(sc_uint32))
+        {
+            count = MIN(*((sc_uint32*)content), (content_len - sizeof(sc_uint32)) / sizeof(sc_addr));
+            g_array_append_vals(legacy, content + sizeof(sc_uint32), count);
+        }
+        g_free(content);
+        content = 0;
+    }
+
+    addrs = g_array_sized_new(FALSE, FALSE, sizeof(sc_addr), legacy->len);
+    g_array_append_vals(addrs, legacy->data, legacy->len);
+
+    // apply log
+    g_snprintf(addr_path, MAX_PATH_LENGTH, "%saddrs_log", abs_path);
+    g_mutex_lock(&addrs_log_mutex);
+    if (g_file_test(addr_path, G_FILE_TEST_EXISTS))
+    {
+        if (g_file_get_contents(addr_path, &content, &content_len, 0) == FALSE)
+        {
+            g_mutex_unlock(&addrs_log_mutex);
+            g_array_free(legacy, TRUE);
+            g_array_free(addrs, TRUE);
             return SC_RESULT_ERROR_IO;
         }
 
+        for (i = 0; i + sizeof(sc_fs_addr_record) <= content_len; i += sizeof(sc_fs_addr_record))
+        {
+            sc_fs_addr_record *record = (sc_fs_addr_record*)(content + i);
+            ++records_count;
+            if (record->op == SC_FS_ADDR_APPEND)
+            {
+                g_array_append_val(addrs, record->addr);
+                continue;
+            }
+
+            ++removes_count;
+            for (j = 0; j < addrs->len; ++j)
+            {
+                if (SC_ADDR_IS_EQUAL(g_array_index(addrs, sc_addr, j), record->addr))
+                {
+                    g_array_remove_index(addrs, j);
+                    break;
+                }
+            }
+        }
+        g_free(content);
+
+        // removed references are kept in log, so it's rewritten, when they are the most part of it
+        if (removes_count > 0 && records_count >= SC_FS_ADDR_LOG_COMPACT_MIN &&
+            records_count > SC_FS_ADDR_LOG_COMPACT_FACTOR * (addrs->len + legacy->len))
+            _sc_fs_engine_addr_log_compact(addr_path, legacy, addrs);
     }
+    g_mutex_unlock(&addrs_log_mutex);
 
     // store result
-    if (content == 0)
-    {
-        *result = 0;
-        *result_count = 0;
-    }else
+    if (addrs->len > 0)
     {
-        *result_count = *((sc_uint32*)content);
-        content2 = content;
-        content2 += sizeof(sc_uint32);
-
+        *result_count = addrs->len;
         *result = g_new0(sc_addr, *result_count);
-        memcpy(*result, content2, sizeof(sc_addr) * (*result_count));
+        memcpy(*result, addrs->data, sizeof(sc_addr) * (*result_count));
     }
-
-    if (content != 0)
-        g_free(content);
-    free(path);
+    g_array_free(addrs, TRUE);
+    g_array_free(legacy, TRUE);
 
     return SC_RESULT_OK;
 }
@@ -273,6 +487,7 @@ sc_fm_engine* initialize(const sc_char* repo_path)
 {
     // initialize file system storage
     g_snprintf(contents_path, MAX_PATH_LENGTH, "%s/%s", repo_path, content_dir);
+    g_snprintf(temp_path, MAX_PATH_LENGTH, "%s/%s", contents_path, temp_dir);
 
     if (!g_file_test(contents_path, G_FILE_TEST_IS_DIR))
     {
@@ -291,6 +506,8 @@ sc_fm_engine* initialize(const sc_char* repo_path)
     engine->funcClear = &sc_fs_engine_clear;
     engine->funcSave = &sc_fs_save;
     engine->funcDestroyData = &sc_fs_engine_destroy_data;
+    engine->funcStreamCreateTemp = &sc_fs_engine_create_temp_stream;
+    engine->funcStreamCommit = &sc_fs_engine_commit_stream;
 
     return engine;
 }
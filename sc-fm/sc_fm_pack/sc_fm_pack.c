@@ -0,0 +1,955 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#include "sc_fm_engine_private.h"
+#include "sc_stream_private.h"
+#include "sc_stream_memory.h"
+#include "sc_fm_pack_config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <memory.h>
+
+#ifdef WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+/* Contents are appended into large pack files (packs/<id>.pack). Location of each content
+ * is stored in append-only index log (packs/index) and references to sc-links are stored
+ * in append-only addrs log (packs/addrs). Both logs are loaded into hash table on
+ * initialization, so any lookup doesn't touch file system. Contents are read from memory
+ * mapped pack files. Pack files are rewritten without garbage on state save, when
+ * garbage size exceeds compaction ratio.
+ */
+
+const gchar *packs_dir = "packs";
+const gchar *index_file_name = "index";
+const gchar *addrs_file_name = "addrs";
+const gchar *pack_file_suffix = ".pack";
+
+//! Record of index log
+struct _sc_pack_index_record
+{
+    char check_sum[SC_MAX_CHECKSUM_LEN];
+    sc_uint8 check_sum_len;
+    sc_uint32 pack;         // identifier of pack file
+    sc_uint64 offset;       // offset of content in pack file
+    sc_uint64 size;         // size of content
+};
+
+enum _sc_pack_addrs_op
+{
+    SC_PACK_ADDR_APPEND = 0,
+    SC_PACK_ADDR_REMOVE
+};
+
+//! Record of addrs log
+struct _sc_pack_addrs_record
+{
+    char check_sum[SC_MAX_CHECKSUM_LEN];
+    sc_uint8 check_sum_len;
+    sc_uint8 op;            // one of _sc_pack_addrs_op values
+    sc_addr addr;
+};
+
+//! Information about one content
+struct _sc_pack_entry
+{
+    sc_bool has_data;       // content stored in pack (contents can be stored out of file memory)
+    sc_uint32 pack;
+    sc_uint64 offset;
+    sc_uint64 size;
+    GArray *addrs;          // sc-addrs of sc-links with this content
+};
+
+//! Information about content, that is written now
+struct _sc_pack_write
+{
+    struct _sc_pack_data *data;
+    sc_uint32 pack;
+    sc_uint64 offset;
+    sc_uint64 size;
+    sc_bool temp;           // checksum will be known on commit
+    sc_check_sum check_sum;
+};
+
+struct _sc_pack_data
+{
+    gchar path[MAX_PATH_LENGTH + 1];
+    GHashTable *entries;    // checksum string -> sc_pack_entry
+    GHashTable *maps;       // pack identifier -> GMappedFile
+
+    FILE *pack_file;        // pack file, that used for writing
+    sc_uint32 pack_id;      // identifier of pack file, that used for writing
+    sc_uint64 pack_size;    // size of committed data in pack file, that used for writing
+
+    FILE *index_file;
+    FILE *addrs_file;
+
+    sc_uint64 live_bytes;   // size of referenced contents
+    sc_uint64 total_bytes;  // size of all pack files
+
+    struct _sc_pack_write *write; // content, that is written now
+    GMutex mutex;
+};
+
+typedef struct _sc_pack_index_record sc_pack_index_record;
+typedef struct _sc_pack_addrs_record sc_pack_addrs_record;
+typedef struct _sc_pack_entry sc_pack_entry;
+typedef struct _sc_pack_write sc_pack_write;
+typedef struct _sc_pack_data sc_pack_data;
+
+
+// --- helpers ---
+void _sc_pack_make_pack_path(const sc_pack_data *data, sc_uint32 id, gchar *path)
+{
+    g_snprintf(path, MAX_PATH_LENGTH, "%s/%.10u%s", data->path, id, pack_file_suffix);
+}
+
+void _sc_pack_make_path(const sc_pack_data *data, const gchar *name, gchar *path)
+{
+    g_snprintf(path, MAX_PATH_LENGTH, "%s/%s", data->path, name);
+}
+
+void _sc_pack_entry_free(gpointer value)
+{
+    sc_pack_entry *entry = (sc_pack_entry*)value;
+    g_array_free(entry->addrs, TRUE);
+    g_free(entry);
+}
+
+sc_pack_entry* _sc_pack_entry_get(sc_pack_data *data, const char *check_sum, sc_uint8 check_sum_len, sc_bool create)
+{
+    gchar *key = g_strndup(check_sum, check_sum_len);
+    sc_pack_entry *entry = (sc_pack_entry*)g_hash_table_lookup(data->entries, key);
+
+    if (entry == 0 && create == SC_TRUE)
+    {
+        entry = g_new0(sc_pack_entry, 1);
+        entry->addrs = g_array_new(FALSE, FALSE, sizeof(sc_addr));
+        g_hash_table_insert(data->entries, key, entry);
+        return entry;
+    }
+
+    g_free(key);
+    return entry;
+}
+
+sc_bool _sc_pack_entry_is_live(const sc_pack_entry *entry)
+{
+    return (entry->has_data == SC_TRUE && entry->addrs->len > 0) ? SC_TRUE : SC_FALSE;
+}
+
+/*! Returns mapped pack file, that contains at least \p required_size bytes.
+ * Pack, that used for writing, grows, so it's remapped when needed.
+ */
+GMappedFile* _sc_pack_map(sc_pack_data *data, sc_uint32 id, sc_uint64 required_size)
+{
+    gchar path[MAX_PATH_LENGTH + 1];
+    GMappedFile *file = (GMappedFile*)g_hash_table_lookup(data->maps, GUINT_TO_POINTER(id));
+
+    if (file != 0 && g_mapped_file_get_length(file) >= required_size)
+        return file;
+
+    // remove old mapping (streams hold own references)
+    if (file != 0)
+        g_hash_table_remove(data->maps, GUINT_TO_POINTER(id));
+
+    _sc_pack_make_pack_path(data, id, path);
+    file = g_mapped_file_new(path, FALSE, 0);
+    if (file == 0)
+        return 0;
+
+    g_hash_table_insert(data->maps, GUINT_TO_POINTER(id), file);
+    return file;
+}
+
+sc_bool _sc_pack_log_append(FILE *file, const void *record, gsize size)
+{
+    if (fwrite(record, size, 1, file) != 1)
+        return SC_FALSE;
+
+    return fflush(file) == 0 ? SC_TRUE : SC_FALSE;
+}
+
+sc_bool _sc_pack_index_append(FILE *file, const gchar *check_sum, const sc_pack_entry *entry)
+{
+    sc_pack_index_record record;
+
+    memset(&record, 0, sizeof(record));
+    record.check_sum_len = strlen(check_sum);
+    memcpy(record.check_sum, check_sum, record.check_sum_len);
+    record.pack = entry->pack;
+    record.offset = entry->offset;
+    record.size = entry->size;
+
+    return _sc_pack_log_append(file, &record, sizeof(record));
+}
+
+sc_bool _sc_pack_addrs_append(FILE *file, const char *check_sum, sc_uint8 check_sum_len, sc_uint8 op, sc_addr addr)
+{
+    sc_pack_addrs_record record;
+
+    memset(&record, 0, sizeof(record));
+    record.check_sum_len = check_sum_len;
+    memcpy(record.check_sum, check_sum, check_sum_len);
+    record.op = op;
+    record.addr = addr;
+
+    return _sc_pack_log_append(file, &record, sizeof(record));
+}
+
+sc_bool _sc_pack_open_pack(sc_pack_data *data, sc_uint32 id)
+{
+    gchar path[MAX_PATH_LENGTH + 1];
+
+    if (data->pack_file != 0)
+        fclose(data->pack_file);
+    data->pack_file = 0;
+
+    _sc_pack_make_pack_path(data, id, path);
+
+    // data is written from committed size, so uncommitted tail of previous writes is reused
+    data->pack_file = fopen(path, "r+b");
+    if (data->pack_file == 0)
+        data->pack_file = fopen(path, "w+b");
+    if (data->pack_file == 0)
+        return SC_FALSE;
+
+    fseek(data->pack_file, 0, SEEK_END);
+    data->pack_id = id;
+    data->pack_size = ftell(data->pack_file);
+
+    return SC_TRUE;
+}
+
+sc_bool _sc_pack_sync_file(FILE *file)
+{
+    return (fflush(file) == 0 && fsync(fileno(file)) == 0) ? SC_TRUE : SC_FALSE;
+}
+
+sc_bool _sc_pack_open_logs(sc_pack_data *data)
+{
+    gchar path[MAX_PATH_LENGTH + 1];
+
+    _sc_pack_make_path(data, index_file_name, path);
+    data->index_file = fopen(path, "ab");
+
+    _sc_pack_make_path(data, addrs_file_name, path);
+    data->addrs_file = fopen(path, "ab");
+
+    return (data->index_file != 0 && data->addrs_file != 0) ? SC_TRUE : SC_FALSE;
+}
+
+void _sc_pack_close_files(sc_pack_data *data)
+{
+    if (data->pack_file != 0)
+        fclose(data->pack_file);
+    if (data->index_file != 0)
+        fclose(data->index_file);
+    if (data->addrs_file != 0)
+        fclose(data->addrs_file);
+
+    data->pack_file = data->index_file = data->addrs_file = 0;
+}
+
+sc_bool _sc_pack_parse_pack_name(const gchar *name, sc_uint32 *id)
+{
+    gchar *end = 0;
+
+    if (g_str_has_suffix(name, pack_file_suffix) == FALSE)
+        return SC_FALSE;
+
+    *id = (sc_uint32)g_ascii_strtoull(name, &end, 10);
+    return (end != name && g_str_equal(end, pack_file_suffix)) ? SC_TRUE : SC_FALSE;
+}
+
+// --- loading ---
+sc_bool _sc_pack_load(sc_pack_data *data)
+{
+    gchar path[MAX_PATH_LENGTH + 1];
+    gchar *content = 0;
+    gsize length = 0, i;
+    GHashTable *used_packs = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GHashTableIter iter;
+    gpointer key, value;
+    GDir *dir = 0;
+    const gchar *name = 0;
+    sc_uint32 id = 0, last_id = 0;
+    sc_bool has_packs = SC_FALSE;
+    sc_pack_entry *entry = 0;
+
+    // index log (incomplete last record is ignored)
+    _sc_pack_make_path(data, index_file_name, path);
+    if (g_file_get_contents(path, &content, &length, 0) == TRUE)
+    {
+        for (i = 0; i + sizeof(sc_pack_index_record) <= length; i += sizeof(sc_pack_index_record))
+        {
+            sc_pack_index_record *record = (sc_pack_index_record*)(content + i);
+            entry = _sc_pack_entry_get(data, record->check_sum, record->check_sum_len, SC_TRUE);
+            entry->has_data = SC_TRUE;
+            entry->pack = record->pack;
+            entry->offset = record->offset;
+            entry->size = record->size;
+        }
+        g_free(content);
+    }
+
+    // addrs log
+    _sc_pack_make_path(data, addrs_file_name, path);
+    if (g_file_get_contents(path, &content, &length, 0) == TRUE)
+    {
+        for (i = 0; i + sizeof(sc_pack_addrs_record) <= length; i += sizeof(sc_pack_addrs_record))
+        {
+            sc_pack_addrs_record *record = (sc_pack_addrs_record*)(content + i);
+            entry = _sc_pack_entry_get(data, record->check_sum, record->check_sum_len, SC_TRUE);
+
+            if (record->op == SC_PACK_ADDR_APPEND)
+                g_array_append_val(entry->addrs, record->addr);
+            else
+            {
+                guint j;
+                for (j = 0; j < entry->addrs->len; ++j)
+                {
+                    if (SC_ADDR_IS_EQUAL(g_array_index(entry->addrs, sc_addr, j), record->addr))
+                    {
+                        g_array_remove_index_fast(entry->addrs, j);
+                        break;
+                    }
+                }
+            }
+        }
+        g_free(content);
+    }
+
+    g_hash_table_iter_init(&iter, data->entries);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        entry = (sc_pack_entry*)value;
+        if (entry->has_data == SC_TRUE)
+            g_hash_table_insert(used_packs, GUINT_TO_POINTER(entry->pack), GUINT_TO_POINTER(1));
+        if (_sc_pack_entry_is_live(entry) == SC_TRUE)
+            data->live_bytes += entry->size;
+    }
+
+    // find pack for writing and remove packs, that aren't used (interrupted compaction)
+    dir = g_dir_open(data->path, 0, 0);
+    if (dir != 0)
+    {
+        while ((name = g_dir_read_name(dir)) != 0)
+        {
+            if (_sc_pack_parse_pack_name(name, &id) == SC_TRUE && (has_packs == SC_FALSE || id > last_id))
+            {
+                last_id = id;
+                has_packs = SC_TRUE;
+            }
+        }
+        g_dir_close(dir);
+    }
+
+    dir = g_dir_open(data->path, 0, 0);
+    if (dir != 0)
+    {
+        while ((name = g_dir_read_name(dir)) != 0)
+        {
+            if (_sc_pack_parse_pack_name(name, &id) == SC_FALSE)
+                continue;
+
+            _sc_pack_make_pack_path(data, id, path);
+            if (id != last_id && g_hash_table_lookup(used_packs, GUINT_TO_POINTER(id)) == 0)
+                g_remove(path);
+        }
+        g_dir_close(dir);
+    }
+    g_hash_table_destroy(used_packs);
+
+    if (_sc_pack_open_pack(data, last_id) == SC_FALSE || _sc_pack_open_logs(data) == SC_FALSE)
+        return SC_FALSE;
+
+    // calculate size of packs
+    dir = g_dir_open(data->path, 0, 0);
+    if (dir != 0)
+    {
+        while ((name = g_dir_read_name(dir)) != 0)
+        {
+            GMappedFile *file = 0;
+            if (_sc_pack_parse_pack_name(name, &id) == SC_FALSE)
+                continue;
+
+            if (id == data->pack_id)
+            {
+                data->total_bytes += data->pack_size;
+                continue;
+            }
+
+            file = _sc_pack_map(data, id, 0);
+            if (file != 0)
+                data->total_bytes += g_mapped_file_get_length(file);
+        }
+        g_dir_close(dir);
+    }
+
+    return SC_TRUE;
+}
+
+// --- writing ---
+sc_result sc_pack_stream_write(const sc_stream *stream, sc_char *data, sc_uint32 length, sc_uint32 *bytes_written)
+{
+    sc_pack_write *write = (sc_pack_write*)stream->handler;
+    g_assert(write != 0);
+
+    *bytes_written = fwrite(data, 1, length, write->data->pack_file);
+    write->size += *bytes_written;
+
+    return (*bytes_written == length) ? SC_RESULT_OK : SC_RESULT_ERROR_IO;
+}
+
+sc_result sc_pack_stream_read(const sc_stream *stream, sc_char *data, sc_uint32 length, sc_uint32 *bytes_read)
+{
+    return SC_RESULT_ERROR;
+}
+
+sc_result sc_pack_stream_seek(const sc_stream *stream, sc_stream_seek_origin origin, sc_uint32 offset)
+{
+    return SC_RESULT_ERROR;
+}
+
+sc_result sc_pack_stream_tell(const sc_stream *stream, sc_uint32 *position)
+{
+    sc_pack_write *write = (sc_pack_write*)stream->handler;
+    g_assert(write != 0);
+
+    *position = (sc_uint32)write->size;
+    return SC_RESULT_OK;
+}
+
+sc_bool sc_pack_stream_eof(const sc_stream *stream)
+{
+    return SC_TRUE;
+}
+
+sc_result _sc_pack_commit(sc_pack_data *data, sc_pack_write *write, const sc_check_sum *check_sum);
+
+sc_result sc_pack_stream_free_handler(const sc_stream *stream)
+{
+    sc_pack_write *write = (sc_pack_write*)stream->handler;
+    g_assert(write != 0);
+
+    // content with known checksum is committed on stream close, temporary content - by engine commit
+    if (write->temp == SC_FALSE)
+        return _sc_pack_commit(write->data, write, &write->check_sum);
+
+    return SC_RESULT_OK;
+}
+
+sc_stream* _sc_pack_write_begin(sc_pack_data *data, const sc_check_sum *check_sum)
+{
+    sc_pack_write *write = 0;
+    sc_stream *stream = 0;
+
+    g_mutex_lock(&data->mutex);
+
+    // data is appended to the end of pack, so just one content can be written at one moment
+    g_assert(data->write == 0);
+    if (data->write != 0)
+    {
+        g_mutex_unlock(&data->mutex);
+        return 0;
+    }
+
+    // pack could stay closed after failed compaction
+    if (data->pack_file == 0 || data->pack_size >= sc_pack_config_max_pack_size())
+    {
+        if (_sc_pack_open_pack(data, data->pack_file == 0 ? data->pack_id : data->pack_id + 1) == SC_FALSE)
+        {
+            g_mutex_unlock(&data->mutex);
+            return 0;
+        }
+    }
+
+    fseek(data->pack_file, data->pack_size, SEEK_SET);
+
+    write = g_new0(sc_pack_write, 1);
+    write->data = data;
+    write->pack = data->pack_id;
+    write->offset = data->pack_size;
+    write->size = 0;
+    write->temp = (check_sum == 0) ? SC_TRUE : SC_FALSE;
+    if (check_sum != 0)
+        write->check_sum = *check_sum;
+
+    data->write = write;
+    g_mutex_unlock(&data->mutex);
+
+    stream = g_new0(sc_stream, 1);
+    stream->flags = SC_STREAM_WRITE | SC_STREAM_TELL;
+    stream->handler = write;
+
+    stream->read_func = &sc_pack_stream_read;
+    stream->write_func = &sc_pack_stream_write;
+    stream->seek_func = &sc_pack_stream_seek;
+    stream->tell_func = &sc_pack_stream_tell;
+    stream->free_func = &sc_pack_stream_free_handler;
+    stream->eof_func = &sc_pack_stream_eof;
+
+    return stream;
+}
+
+sc_result _sc_pack_commit(sc_pack_data *data, sc_pack_write *write, const sc_check_sum *check_sum)
+{
+    sc_pack_entry *entry = 0;
+    gchar *key = 0;
+    sc_result result = SC_RESULT_OK;
+
+    g_mutex_lock(&data->mutex);
+    g_assert(data->write == write);
+
+    if (fflush(data->pack_file) != 0)
+        result = SC_RESULT_ERROR_IO;
+
+    if (check_sum != 0 && result == SC_RESULT_OK)
+    {
+        entry = _sc_pack_entry_get(data, check_sum->data, check_sum->len, SC_TRUE);
+
+        // the same content is already stored, so new data is left in uncommitted tail of pack
+        if (entry->has_data == SC_FALSE || write->temp == SC_FALSE)
+        {
+            if (entry->has_data == SC_TRUE && entry->addrs->len > 0)
+                data->live_bytes -= entry->size;
+
+            entry->has_data = SC_TRUE;
+            entry->pack = write->pack;
+            entry->offset = write->offset;
+            entry->size = write->size;
+
+            key = g_strndup(check_sum->data, check_sum->len);
+            if (_sc_pack_index_append(data->index_file, key, entry) == SC_FALSE)
+                result = SC_RESULT_ERROR_IO;
+            g_free(key);
+
+            data->pack_size = write->offset + write->size;
+            data->total_bytes += write->size;
+            if (entry->addrs->len > 0)
+                data->live_bytes += entry->size;
+        }
+    }
+
+    data->write = 0;
+    g_free(write);
+
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+// --- compaction ---
+sc_bool _sc_pack_compact(sc_pack_data *data)
+{
+    gchar path[MAX_PATH_LENGTH + 1], tmp_path[MAX_PATH_LENGTH + 1];
+    sc_uint32 first_id = data->pack_id + 1, last_old_id = data->pack_id, id;
+    GHashTableIter iter;
+    gpointer key, value;
+    sc_pack_entry *entry = 0;
+    GMappedFile *file = 0;
+    FILE *index_file = 0, *addrs_file = 0;
+    guint i;
+
+    g_message("Compact packs (live: %llu bytes, total: %llu bytes)", data->live_bytes, data->total_bytes);
+
+    if (_sc_pack_open_pack(data, first_id) == SC_FALSE)
+        return SC_FALSE;
+
+    _sc_pack_make_path(data, "index.tmp", tmp_path);
+    index_file = fopen(tmp_path, "wb");
+    _sc_pack_make_path(data, "addrs.tmp", path);
+    addrs_file = fopen(path, "wb");
+
+    if (index_file == 0 || addrs_file == 0)
+    {
+        if (index_file != 0)
+            fclose(index_file);
+        if (addrs_file != 0)
+            fclose(addrs_file);
+        return SC_FALSE;
+    }
+
+    // copy live contents into new packs
+    data->live_bytes = 0;
+    g_hash_table_iter_init(&iter, data->entries);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        entry = (sc_pack_entry*)value;
+
+        if (entry->addrs->len == 0)
+        {
+            g_hash_table_iter_remove(&iter);
+            continue;
+        }
+
+        for (i = 0; i < entry->addrs->len; ++i)
+            _sc_pack_addrs_append(addrs_file, (const char*)key, strlen((const char*)key), SC_PACK_ADDR_APPEND, g_array_index(entry->addrs, sc_addr, i));
+
+        if (entry->has_data == SC_FALSE)
+            continue;
+
+        // filled pack is synced before the next one, because old packs are removed after compaction
+        if (data->pack_size >= sc_pack_config_max_pack_size() &&
+                (_sc_pack_sync_file(data->pack_file) == SC_FALSE || _sc_pack_open_pack(data, data->pack_id + 1) == SC_FALSE))
+        {
+            g_critical("Can't open pack %u", data->pack_id + 1);
+            fclose(index_file);
+            fclose(addrs_file);
+            return SC_FALSE;
+        }
+
+        file = (entry->size > 0) ? _sc_pack_map(data, entry->pack, entry->offset + entry->size) : 0;
+        if (entry->size > 0 && (file == 0 || fwrite(g_mapped_file_get_contents(file) + entry->offset, entry->size, 1, data->pack_file) != 1))
+        {
+            g_critical("Can't copy content into pack %u", data->pack_id);
+            fclose(index_file);
+            fclose(addrs_file);
+            return SC_FALSE;
+        }
+
+        entry->pack = data->pack_id;
+        entry->offset = data->pack_size;
+        data->pack_size += entry->size;
+        data->live_bytes += entry->size;
+
+        _sc_pack_index_append(index_file, (const gchar*)key, entry);
+    }
+
+    // new packs and logs have to be on disk before logs replacing
+    if (_sc_pack_sync_file(data->pack_file) == SC_FALSE || _sc_pack_sync_file(index_file) == SC_FALSE || _sc_pack_sync_file(addrs_file) == SC_FALSE)
+    {
+        g_critical("Can't write compacted packs");
+        fclose(index_file);
+        fclose(addrs_file);
+        return SC_FALSE;
+    }
+    fclose(index_file);
+    fclose(addrs_file);
+
+    // replace logs: rename replaces file atomically, so there is always complete index on disk
+    fclose(data->index_file);
+    fclose(data->addrs_file);
+    data->index_file = data->addrs_file = 0;
+
+    _sc_pack_make_path(data, index_file_name, path);
+    if (g_rename(tmp_path, path) != 0)
+    {
+        g_critical("Can't replace index log");
+        _sc_pack_open_logs(data);
+        return SC_FALSE;
+    }
+
+    _sc_pack_make_path(data, addrs_file_name, path);
+    _sc_pack_make_path(data, "addrs.tmp", tmp_path);
+    if (g_rename(tmp_path, path) != 0)
+    {
+        g_critical("Can't replace addrs log");
+        _sc_pack_open_logs(data);
+        return SC_FALSE;
+    }
+
+    // old packs aren't used any more
+    for (id = 0; id <= last_old_id; ++id)
+    {
+        g_hash_table_remove(data->maps, GUINT_TO_POINTER(id));
+        _sc_pack_make_pack_path(data, id, path);
+        if (g_file_test(path, G_FILE_TEST_EXISTS))
+            g_remove(path);
+    }
+
+    data->total_bytes = data->live_bytes;
+
+    return _sc_pack_open_logs(data);
+}
+
+// --- implementation of interface ---
+sc_result sc_pack_engine_create_stream(const sc_fm_engine *engine, const sc_check_sum *check_sum, sc_uint8 flags, sc_stream **stream)
+{
+    sc_pack_data *data = (sc_pack_data*)engine->storage_info;
+    sc_pack_entry *entry = 0;
+    GMappedFile *file = 0;
+    sc_result result = SC_RESULT_ERROR_NOT_FOUND;
+
+    g_assert(data);
+    *stream = 0;
+
+    if (flags & SC_STREAM_WRITE)
+    {
+        *stream = _sc_pack_write_begin(data, check_sum);
+        return *stream != 0 ? SC_RESULT_OK : SC_RESULT_ERROR_IO;
+    }
+
+    g_mutex_lock(&data->mutex);
+    entry = _sc_pack_entry_get(data, check_sum->data, check_sum->len, SC_FALSE);
+    if (entry != 0 && entry->has_data == SC_TRUE)
+    {
+        file = (entry->size > 0) ? _sc_pack_map(data, entry->pack, entry->offset + entry->size) : 0;
+        *stream = sc_stream_memory_new_mapped(file, entry->offset, (sc_uint32)entry->size);
+        result = (*stream != 0) ? SC_RESULT_OK : SC_RESULT_ERROR_IO;
+    }
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_pack_engine_create_temp_stream(const sc_fm_engine *engine, sc_stream **stream, void **temp_handle)
+{
+    sc_pack_data *data = (sc_pack_data*)engine->storage_info;
+    g_assert(data);
+
+    *stream = _sc_pack_write_begin(data, 0);
+    if (*stream == 0)
+        return SC_RESULT_ERROR_IO;
+
+    *temp_handle = (*stream)->handler;
+    return SC_RESULT_OK;
+}
+
+sc_result sc_pack_engine_commit_stream(const sc_fm_engine *engine, void *temp_handle, const sc_check_sum *check_sum)
+{
+    sc_pack_data *data = (sc_pack_data*)engine->storage_info;
+    g_assert(data);
+
+    return _sc_pack_commit(data, (sc_pack_write*)temp_handle, check_sum);
+}
+
+sc_result sc_pack_engine_addr_ref_append(const sc_fm_engine *engine, sc_addr addr, const sc_check_sum *check_sum)
+{
+    sc_pack_data *data = (sc_pack_data*)engine->storage_info;
+    sc_pack_entry *entry = 0;
+    sc_result result = SC_RESULT_OK;
+
+    g_assert(data);
+
+    g_mutex_lock(&data->mutex);
+    entry = _sc_pack_entry_get(data, check_sum->data, check_sum->len, SC_TRUE);
+    if (_sc_pack_addrs_append(data->addrs_file, check_sum->data, check_sum->len, SC_PACK_ADDR_APPEND, addr) == SC_TRUE)
+    {
+        if (entry->addrs->len == 0 && entry->has_data == SC_TRUE)
+            data->live_bytes += entry->size;
+        g_array_append_val(entry->addrs, addr);
+    }else
+        result = SC_RESULT_ERROR_IO;
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_pack_engine_addr_ref_remove(const sc_fm_engine *engine, sc_addr addr, const sc_check_sum *check_sum)
+{
+    sc_pack_data *data = (sc_pack_data*)engine->storage_info;
+    sc_pack_entry *entry = 0;
+    sc_result result = SC_RESULT_ERROR_NOT_FOUND;
+    guint i;
+
+    g_assert(data);
+
+    g_mutex_lock(&data->mutex);
+    entry = _sc_pack_entry_get(data, check_sum->data, check_sum->len, SC_FALSE);
+    for (i = 0; entry != 0 && i < entry->addrs->len; ++i)
+    {
+        if (!SC_ADDR_IS_EQUAL(g_array_index(entry->addrs, sc_addr, i), addr))
+            continue;
+
+        if (_sc_pack_addrs_append(data->addrs_file, check_sum->data, check_sum->len, SC_PACK_ADDR_REMOVE, addr) == SC_FALSE)
+        {
+            result = SC_RESULT_ERROR_IO;
+            break;
+        }
+
+        g_array_remove_index_fast(entry->addrs, i);
+        // content without references becomes garbage
+        if (entry->addrs->len == 0 && entry->has_data == SC_TRUE)
+            data->live_bytes -= entry->size;
+
+        result = SC_RESULT_OK;
+        break;
+    }
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_pack_engine_find(const sc_fm_engine *engine, const sc_check_sum *check_sum, sc_addr **result, sc_uint32 *result_count)
+{
+    sc_pack_data *data = (sc_pack_data*)engine->storage_info;
+    sc_pack_entry *entry = 0;
+
+    g_assert(data);
+    g_assert(*result == 0);
+
+    *result_count = 0;
+
+    g_mutex_lock(&data->mutex);
+    entry = _sc_pack_entry_get(data, check_sum->data, check_sum->len, SC_FALSE);
+    if (entry != 0 && entry->addrs->len > 0)
+    {
+        *result_count = entry->addrs->len;
+        *result = g_new0(sc_addr, *result_count);
+        memcpy(*result, entry->addrs->data, sizeof(sc_addr) * (*result_count));
+    }
+    g_mutex_unlock(&data->mutex);
+
+    return SC_RESULT_OK;
+}
+
+sc_result sc_pack_engine_clear(const sc_fm_engine *engine)
+{
+    sc_pack_data *data = (sc_pack_data*)engine->storage_info;
+    gchar path[MAX_PATH_LENGTH + 1];
+    GDir *dir = 0;
+    const gchar *name = 0;
+    sc_result result = SC_RESULT_OK;
+
+    g_assert(data);
+
+    g_mutex_lock(&data->mutex);
+    g_assert(data->write == 0);
+
+    _sc_pack_close_files(data);
+    g_hash_table_remove_all(data->maps);
+    g_hash_table_remove_all(data->entries);
+    data->live_bytes = data->total_bytes = 0;
+
+    dir = g_dir_open(data->path, 0, 0);
+    if (dir != 0)
+    {
+        while ((name = g_dir_read_name(dir)) != 0)
+        {
+            _sc_pack_make_path(data, name, path);
+            if (g_file_test(path, G_FILE_TEST_IS_REGULAR) && g_remove(path) == -1)
+            {
+                g_critical("Can't remove file: %s", path);
+                result = SC_RESULT_ERROR;
+            }
+        }
+        g_dir_close(dir);
+    }
+
+    if (_sc_pack_open_pack(data, 0) == SC_FALSE || _sc_pack_open_logs(data) == SC_FALSE)
+        result = SC_RESULT_ERROR_IO;
+
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_pack_engine_save(const sc_fm_engine *engine)
+{
+    sc_pack_data *data = (sc_pack_data*)engine->storage_info;
+    sc_result result = SC_RESULT_OK;
+    sc_uint64 garbage = 0;
+
+    g_assert(data);
+
+    g_mutex_lock(&data->mutex);
+
+    garbage = data->total_bytes - MIN(data->total_bytes, data->live_bytes);
+    if (data->write == 0 && garbage > 0 && garbage > data->live_bytes * sc_pack_config_compaction_ratio())
+    {
+        if (_sc_pack_compact(data) == SC_FALSE)
+        {
+            g_critical("Error while compacting packs");
+            result = SC_RESULT_ERROR;
+        }
+    }
+
+    if (data->pack_file != 0 && fflush(data->pack_file) != 0)
+        result = SC_RESULT_ERROR_IO;
+
+    g_mutex_unlock(&data->mutex);
+
+    return result;
+}
+
+sc_result sc_pack_engine_destroy_data(const sc_fm_engine *engine)
+{
+    sc_pack_data *data = (sc_pack_data*)engine->storage_info;
+    g_assert(data);
+
+    _sc_pack_close_files(data);
+    g_hash_table_destroy(data->maps);
+    g_hash_table_destroy(data->entries);
+    g_mutex_clear(&data->mutex);
+    g_free(data);
+
+    sc_pack_config_shutdown();
+
+    return SC_RESULT_OK;
+}
+
+
+// --- extension interface ---
+sc_fm_engine* initialize(const sc_char* repo_path)
+{
+    sc_pack_data *data = 0;
+    sc_fm_engine *engine = 0;
+
+    sc_pack_config_initialize();
+
+    data = g_new0(sc_pack_data, 1);
+    g_snprintf(data->path, MAX_PATH_LENGTH, "%s/%s", repo_path, packs_dir);
+    g_mutex_init(&data->mutex);
+
+    if (!g_file_test(data->path, G_FILE_TEST_IS_DIR))
+    {
+        if (g_mkdir_with_parents(data->path, -1) < 0)
+            g_error("Can't create '%s' directory.", data->path);
+    }
+
+    data->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, _sc_pack_entry_free);
+    data->maps = g_hash_table_new_full(g_direct_hash, g_direct_equal, 0, (GDestroyNotify)g_mapped_file_unref);
+
+    if (_sc_pack_load(data) == SC_FALSE)
+    {
+        g_critical("Can't load packs from: %s", data->path);
+        sc_fm_engine tmp;
+        tmp.storage_info = data;
+        sc_pack_engine_destroy_data(&tmp);
+        return 0;
+    }
+
+    g_message("\tPacks: %llu bytes (%llu bytes used)", data->total_bytes, data->live_bytes);
+
+    engine = g_new0(sc_fm_engine, 1);
+
+    engine->storage_info = data;
+    engine->funcStreamCreate = &sc_pack_engine_create_stream;
+    engine->funcAddrRefAppend = &sc_pack_engine_addr_ref_append;
+    engine->funcAddrRefRemove = &sc_pack_engine_addr_ref_remove;
+    engine->funcFind = &sc_pack_engine_find;
+    engine->funcClear = &sc_pack_engine_clear;
+    engine->funcSave = &sc_pack_engine_save;
+    engine->funcDestroyData = &sc_pack_engine_destroy_data;
+    engine->funcStreamCreateTemp = &sc_pack_engine_create_temp_stream;
+    engine->funcStreamCommit = &sc_pack_engine_commit_stream;
+
+    return engine;
+}
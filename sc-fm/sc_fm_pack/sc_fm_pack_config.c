@@ -0,0 +1,59 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#include "sc_fm_pack_config.h"
+#include <glib.h>
+
+const char str_group_pack[] = "pack";
+const char str_key_pack_max_size[] = "max_size";
+const char str_key_pack_compaction_ratio[] = "compaction_ratio";
+
+sc_uint64 config_pack_max_size = 256 * 1024 * 1024;
+float config_pack_compaction_ratio = 0.5f;
+
+
+void sc_pack_config_initialize()
+{
+    // size in megabytes
+    int max_size = sc_config_get_value_int(str_group_pack, str_key_pack_max_size);
+    if (max_size > 0)
+        config_pack_max_size = (sc_uint64)max_size * 1024 * 1024;
+
+    config_pack_compaction_ratio = sc_config_get_value_float(str_group_pack, str_key_pack_compaction_ratio);
+    if (config_pack_compaction_ratio <= 0.f)
+        config_pack_compaction_ratio = 0.5f;
+}
+
+void sc_pack_config_shutdown()
+{
+
+}
+
+sc_uint64 sc_pack_config_max_pack_size()
+{
+    return config_pack_max_size;
+}
+
+float sc_pack_config_compaction_ratio()
+{
+    return config_pack_compaction_ratio;
+}
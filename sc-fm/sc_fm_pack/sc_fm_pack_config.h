@@ -0,0 +1,43 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _sc_fm_pack_config_h_
+#define _sc_fm_pack_config_h_
+
+#include "sc_config.h"
+
+
+//! Initialize pack file memory configuration
+void sc_pack_config_initialize();
+
+//! Shutting down pack file memory configuration
+void sc_pack_config_shutdown();
+
+//! Returns size in bytes, after reaching which new pack file will be started
+sc_uint64 sc_pack_config_max_pack_size();
+/*! Returns ratio of garbage bytes to live bytes, after reaching which packs are compacted
+ * on file memory state save
+ */
+float sc_pack_config_compaction_ratio();
+
+
+#endif
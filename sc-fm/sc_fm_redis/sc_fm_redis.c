@@ -27,37 +27,39 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include <glib.h>
 #include <memory.h>
 
-GMutex redis_mutex;
-
 GThread *ping_thread;
-gboolean ping_thread_running;
+volatile gint ping_thread_running;
 
 struct _redis_data
 {
-    redisContext *context;
+    sc_redis_pool pool;
 };
 
 typedef struct _redis_data redis_data;
 
 
 // --- ping thread ---
-gpointer ping_thread_loop(gpointer context)
+gpointer ping_thread_loop(gpointer data)
 {
-    g_mutex_lock(&redis_mutex);
-    ping_thread_running = TRUE;
-    g_mutex_unlock(&redis_mutex);
-
-    gboolean running = TRUE;
+    sc_redis_pool *pool = (sc_redis_pool*)data;
+    redisContext *context = 0;
+    sc_uint32 i;
 
-    while (ping_thread_running)
+    while (g_atomic_int_get(&ping_thread_running) == TRUE)
     {
+        // ping just connections, that aren't used now, busy ones are alive anyway
+        for (i = 0; i < pool->size; ++i)
+        {
+            context = (redisContext*)g_async_queue_try_pop(pool->free_contexts);
+            if (context == 0)
+                break;
 
-        g_mutex_lock(&redis_mutex);
-        redisReply *reply = redisCommand((redisContext*)context, "PING");
-        freeReplyObject(reply);
+            redisReply *reply = redisCommand(context, "PING");
+            freeReplyObject(reply);
 
-        running = ping_thread_running;
-        g_mutex_unlock(&redis_mutex);
+            // broken connection is restored on release
+            sc_redis_pool_release(pool, context);
+        }
 
         // wait on second
         g_usleep(1000000);
@@ -78,13 +80,13 @@ redisContext* connectToRedis()
 
     if (c == 0)
     {
-        g_error("redis: Couldn't connect to server");
+        g_critical("redis: Couldn't connect to server");
         return 0;
     }
 
     if (c != 0 && c->err)
     {
-        g_error("redis: %s", c->errstr);
+        g_critical("redis: %s", c->errstr);
         redisFree(c);
         return 0;
     }
@@ -94,44 +96,92 @@ redisContext* connectToRedis()
     redisReply *reply = redisCommand(c, "SELECT 0");
     if (reply == 0 || reply->type == REDIS_REPLY_ERROR)
     {
-        g_error("\tCan't switch database");
+        g_critical("\tCan't switch database");
         freeReplyObject(reply);
         redisFree(c);
         return 0;
     }
     freeReplyObject(reply);
 
-    // start ping thread
+    return c;
+}
 
-    ping_thread = g_thread_new("redis_ping_thread", ping_thread_loop, c);
+// --- connections pool ---
+redisContext* sc_redis_pool_acquire(sc_redis_pool *pool)
+{
+    return (redisContext*)g_async_queue_pop(pool->free_contexts);
+}
 
+void sc_redis_pool_release(sc_redis_pool *pool, redisContext *context)
+{
+    sc_uint32 i;
+    redisContext *new_context = 0;
 
+    // context with error can't be used anymore (hiredis closes it), so it's replaced with new connection
+    if (context->err)
+    {
+        g_critical("redis: connection error: %s, reconnect", context->errstr);
+        new_context = connectToRedis();
 
-    return c;
-}
+        // if server isn't available, then broken connection returns into pool and next user tries to restore it
+        if (new_context != 0)
+        {
+            for (i = 0; i < pool->size; ++i)
+            {
+                if (pool->contexts[i] == context)
+                {
+                    pool->contexts[i] = new_context;
+                    break;
+                }
+            }
+
+            redisFree(context);
+            context = new_context;
+        }
+    }
 
+    g_async_queue_push(pool->free_contexts, context);
+}
 
-redisReply* do_sync_redis_command(redisContext **context, const char *format, ...)
+redisReply* do_sync_redis_command(sc_redis_pool *pool, const char *format, ...)
 {
     va_list ap;
     void *reply = 0;
-    int tries = 0, context_tries = 0;
-    va_start(ap,format);
+    redisContext *context = sc_redis_pool_acquire(pool);
+
+    va_start(ap, format);
+    reply = redisvCommand(context, format, ap);
+    va_end(ap);
+
+    if (reply == 0)
+        g_critical("redis: %s", context->errstr);
+
+    sc_redis_pool_release(pool, context);
 
-    g_mutex_lock(&redis_mutex);
-    while (reply == 0 && tries < 5)
+    return reply;
+}
+
+sc_bool sc_redis_pipeline_replies(redisContext *context, redisReply **replies, sc_uint32 count)
+{
+    sc_uint32 i, j;
+
+    for (i = 0; i < count; ++i)
     {
-        reply = redisvCommand(*context, format, ap);
-        if (reply == 0)
-            g_error("redis: %s", (*context)->errstr);
-        tries++;
+        replies[i] = 0;
+        if (redisGetReply(context, (void**)&replies[i]) != REDIS_OK || replies[i] == 0)
+        {
+            g_critical("redis: %s", context->errstr);
+            for (j = 0; j < i; ++j)
+                freeReplyObject(replies[j]);
+
+            return SC_FALSE;
+        }
     }
-    g_mutex_unlock(&redis_mutex);
 
-    va_end(ap);
-    return reply;
+    return SC_TRUE;
 }
 
+// --- engine ---
 sc_result sc_redis_engine_create_stream(const sc_fm_engine *engine, const sc_check_sum *check_sum, sc_uint8 flags, sc_stream **stream)
 {
     redis_data *data = (redis_data*)engine->storage_info;
@@ -143,7 +193,7 @@ sc_result sc_redis_engine_create_stream(const sc_fm_engine *engine, const sc_che
     g_free(check_sum_str);
 
     *stream = 0;
-    *stream = sc_stream_redis_new(data->context, key, flags, &redis_mutex);
+    *stream = sc_stream_redis_new(&data->pool, key, flags);
 
     return *stream == 0 ? SC_RESULT_ERROR : SC_RESULT_OK;
 }
@@ -153,20 +203,13 @@ sc_result sc_redis_engine_addr_ref_append(const sc_fm_engine *engine, sc_addr ad
     redis_data *data = (redis_data*)engine->storage_info;
     g_assert(data);
 
-    redisReply *reply = do_sync_redis_command(&data->context, "LLEN link:%b:addrs", check_sum->data, check_sum->len);
-    if (reply == 0 || reply->type == REDIS_REPLY_ERROR)
-    {
-        freeReplyObject(reply);
-        return SC_RESULT_ERROR;
-    }
-
-    int old_size = reply->integer;
-    reply = do_sync_redis_command(&data->context, "LPUSH link:%b:addrs %b", check_sum->data, check_sum->len, &addr, sizeof(addr));
+    // LPUSH returns new length of list, so there is no need to request it before
+    redisReply *reply = do_sync_redis_command(&data->pool, "LPUSH link:%b:addrs %b", check_sum->data, check_sum->len, &addr, sizeof(addr));
 
     if (reply == 0)
         return SC_RESULT_ERROR;
 
-    if ((reply->type == REDIS_REPLY_INTEGER) && (old_size < reply->integer))
+    if ((reply->type == REDIS_REPLY_INTEGER) && (reply->integer > 0))
     {
         freeReplyObject(reply);
         return SC_RESULT_OK;
@@ -182,19 +225,15 @@ sc_result sc_redis_engine_addr_ref_remove(const sc_fm_engine *engine, sc_addr ad
     redis_data *data = (redis_data*)engine->storage_info;
     g_assert(data);
 
-    redisReply *reply = do_sync_redis_command(&data->context, "LREM link:%b:addrs 0 %b", check_sum->data, check_sum->len, &addr, sizeof(addr));
+    redisReply *reply = do_sync_redis_command(&data->pool, "LREM link:%b:addrs 1 %b", check_sum->data, check_sum->len, &addr, sizeof(addr));
 
     if (reply == 0)
         return SC_RESULT_ERROR;
 
-    if (reply->type == REDIS_REPLY_INTEGER)
-    {
-        freeReplyObject(reply);
-        return SC_RESULT_OK;
-    }
+    sc_result result = (reply->type == REDIS_REPLY_INTEGER) ? SC_RESULT_OK : SC_RESULT_ERROR;
     freeReplyObject(reply);
 
-    return (reply->type != REDIS_REPLY_INTEGER) ? SC_RESULT_ERROR : SC_RESULT_OK;
+    return result;
 }
 
 sc_result sc_redis_engine_find(const sc_fm_engine *engine, const sc_check_sum *check_sum, sc_addr **result, sc_uint32 *result_count)
@@ -202,7 +241,7 @@ sc_result sc_redis_engine_find(const sc_fm_engine *engine, const sc_check_sum *c
     redis_data *data = (redis_data*)engine->storage_info;
     g_assert(data);
 
-    redisReply *reply = do_sync_redis_command(&data->context, "LRANGE link:%b:addrs 0 -1", check_sum->data, check_sum->len);
+    redisReply *reply = do_sync_redis_command(&data->pool, "LRANGE link:%b:addrs 0 -1", check_sum->data, check_sum->len);
     if (reply == 0)
         return SC_RESULT_ERROR;
 
@@ -233,7 +272,7 @@ sc_result sc_redis_engine_clear(const sc_fm_engine *engine)
     redis_data *data = (redis_data*)engine->storage_info;
     g_assert(data);
 
-    redisReply *reply = do_sync_redis_command(&data->context, "FLUSHDB");
+    redisReply *reply = do_sync_redis_command(&data->pool, "FLUSHDB");
 
     if (reply == 0)
         return SC_RESULT_ERROR;
@@ -248,7 +287,7 @@ sc_result sc_redis_engine_save(const sc_fm_engine *engine)
     redis_data *data = (redis_data*)engine->storage_info;
     g_assert(data);
 
-    redisReply *reply = do_sync_redis_command(&data->context, "SAVE");
+    redisReply *reply = do_sync_redis_command(&data->pool, "SAVE");
 
     sc_result result = (reply == 0 || reply->type == REDIS_REPLY_ERROR) ? SC_RESULT_ERROR : SC_RESULT_OK;
     freeReplyObject(reply);
@@ -256,19 +295,31 @@ sc_result sc_redis_engine_save(const sc_fm_engine *engine)
     return result;
 }
 
+void _sc_redis_pool_free(sc_redis_pool *pool)
+{
+    sc_uint32 i;
+
+    for (i = 0; i < pool->size; ++i)
+    {
+        if (pool->contexts[i] != 0)
+            redisFree(pool->contexts[i]);
+    }
+
+    g_async_queue_unref(pool->free_contexts);
+    g_free(pool->contexts);
+}
+
 sc_result sc_redis_engine_destroy_data(const sc_fm_engine *engine)
 {
     redis_data *data = (redis_data*)engine->storage_info;
 
     g_assert(data);
 
-    g_mutex_lock(&redis_mutex);
-    ping_thread_running = FALSE;
-    g_mutex_unlock(&redis_mutex);
+    g_atomic_int_set(&ping_thread_running, FALSE);
     g_thread_join(ping_thread);
     ping_thread = 0;
 
-    redisFree(data->context);
+    _sc_redis_pool_free(&data->pool);
     g_free(data);
 
     sc_redis_config_shutdown();
@@ -278,29 +329,41 @@ sc_result sc_redis_engine_destroy_data(const sc_fm_engine *engine)
 
 sc_fm_engine* initialize(const sc_char* repo_path)
 {
+    sc_uint32 i;
+
     sc_redis_config_initialize();
 
     redis_data *data = g_new0(redis_data, 1);
 
-    g_mutex_init(&redis_mutex);
-    data->context = connectToRedis();
+    data->pool.size = sc_redis_config_pool_size();
+    data->pool.contexts = g_new0(redisContext*, data->pool.size);
+    data->pool.free_contexts = g_async_queue_new();
 
-    if (data->context == 0 || data->context->err)
+    g_message("\tRedis connections: %u", data->pool.size);
+    for (i = 0; i < data->pool.size; ++i)
     {
-        if (data->context)
-        {
-            g_critical("Connection error: %s", data->context->errstr);
-            redisFree(data->context);
-        } else
+        data->pool.contexts[i] = connectToRedis();
+
+        if (data->pool.contexts[i] == 0 || data->pool.contexts[i]->err)
         {
-            g_critical("Connection error: can't allocate redis context");
-        }
+            if (data->pool.contexts[i])
+                g_critical("Connection error: %s", data->pool.contexts[i]->errstr);
+            else
+                g_critical("Connection error: can't allocate redis context");
 
-        g_free(data);
+            _sc_redis_pool_free(&data->pool);
+            g_free(data);
 
-        return 0;
+            return 0;
+        }
+
+        g_async_queue_push(data->pool.free_contexts, data->pool.contexts[i]);
     }
 
+    // start ping thread
+    g_atomic_int_set(&ping_thread_running, TRUE);
+    ping_thread = g_thread_new("redis_ping_thread", ping_thread_loop, &data->pool);
+
     sc_fm_engine *engine = g_new0(sc_fm_engine, 1);
 
     engine->storage_info = data;
@@ -23,8 +23,35 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef _sc_fm_redis_h_
 #define _sc_fm_redis_h_
 
+#include "sc_types.h"
 #include <hiredis/hiredis.h>
-
-redisReply* do_sync_redis_command(redisContext **context, const char *format, ...);
+#include <glib.h>
+
+//! Pool of connections to redis server. Each connection is used by one thread at the moment
+struct _sc_redis_pool
+{
+    redisContext **contexts;    // all connections
+    sc_uint32 size;             // number of connections
+    GAsyncQueue *free_contexts; // connections, that aren't used now
+};
+
+typedef struct _sc_redis_pool sc_redis_pool;
+
+/*! Takes connection from pool. If all connections are used, then waits until one of them would be released
+ */
+redisContext* sc_redis_pool_acquire(sc_redis_pool *pool);
+
+//! Returns connection into pool. If connection has error, then it's replaced with new one
+void sc_redis_pool_release(sc_redis_pool *pool, redisContext *context);
+
+//! Runs one command on any free connection from pool
+redisReply* do_sync_redis_command(sc_redis_pool *pool, const char *format, ...);
+
+/*! Sends all commands, that was appended with redisAppendCommand into \p context, and reads their replies.
+ * So commands are done with one round trip to server.
+ * @param replies Array to store \p count replies. Each of them should be freed with freeReplyObject
+ * @return If all replies received, then returns SC_TRUE; otherwise returns SC_FALSE and free received replies
+ */
+sc_bool sc_redis_pipeline_replies(redisContext *context, redisReply **replies, sc_uint32 count);
 
 #endif
@@ -27,10 +27,12 @@ const char str_group_redis[] = "redis";
 const char str_key_redis_host[] = "host";
 const char str_key_redis_port[] = "port";
 const char str_key_redis_timeout[] = "timeout";
+const char str_key_redis_pool_size[] = "pool_size";
 
 const char *config_redis_host = 0;
 sc_uint32 config_redis_port = 6379;
 sc_uint32 config_redis_timeout = 1500;
+sc_uint32 config_redis_pool_size = 4;
 
 
 void sc_redis_config_initialize()
@@ -48,6 +50,10 @@ void sc_redis_config_initialize()
     config_redis_timeout = sc_config_get_value_int(str_group_redis, str_key_redis_timeout);
     if (config_redis_timeout == 0)
         config_redis_timeout = 1500;
+
+    config_redis_pool_size = sc_config_get_value_int(str_group_redis, str_key_redis_pool_size);
+    if (config_redis_pool_size == 0)
+        config_redis_pool_size = 4;
 }
 
 void sc_redis_config_shutdown()
@@ -69,3 +75,8 @@ sc_uint32 sc_redis_config_timeout()
 {
     return config_redis_timeout;
 }
+
+sc_uint32 sc_redis_config_pool_size()
+{
+    return config_redis_pool_size;
+}
@@ -38,6 +38,8 @@ const sc_uint8* sc_redis_config_host();
 sc_uint32 sc_redis_config_port();
 //! Returns milliseconds for commands timeout
 sc_uint32 sc_redis_config_timeout();
+//! Returns number of connections to redis server
+sc_uint32 sc_redis_config_pool_size();
 
 
 #endif
@@ -25,14 +25,20 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include "sc_fm_redis.h"
 
 #include <glib.h>
+#include <memory.h>
+
+//! Number of bytes, that read with size of value in one round trip
+#define SC_REDIS_PREFETCH_SIZE SC_LINK_CONTENT_BUFFER_SIZE
 
 struct _sc_redis_handler
 {
-    redisContext *context;  // pointer to redis context
+    sc_redis_pool *pool;  // pool of redis connections
     char *key;  // key to read/write value
     sc_uint32 pos;  // current seek position
     sc_uint32 size;  // size of value in bytes
-    GMutex *mutex;
+    sc_char *buffer;  // prefetched beginning of value
+    sc_uint32 buffer_len;  // size of prefetched data
+    sc_bool clear_pending;  // value should be deleted before the first write
 };
 
 typedef struct _sc_redis_handler sc_redis_handler;
@@ -46,7 +52,20 @@ sc_result sc_stream_redis_read(const sc_stream *stream, sc_char *data, sc_uint32
     if (handler->size == 0)
         return SC_RESULT_ERROR;
 
-    redisReply *reply = do_sync_redis_command(&handler->context, "GETRANGE %s %d %d", handler->key, handler->pos, handler->pos + length - 1);
+    // read prefetched data without request
+    if (handler->pos < handler->buffer_len)
+    {
+        *bytes_read = MIN(length, handler->buffer_len - handler->pos);
+        memcpy(data, handler->buffer + handler->pos, *bytes_read);
+        handler->pos += *bytes_read;
+
+        return SC_RESULT_OK;
+    }
+
+    redisReply *reply = do_sync_redis_command(handler->pool, "GETRANGE %s %d %d", handler->key, handler->pos, handler->pos + length - 1);
+    if (reply == 0)
+        return SC_RESULT_ERROR_IO;
+
     if (reply->type != REDIS_REPLY_STRING)
     {
         freeReplyObject(reply);
@@ -68,9 +87,31 @@ sc_result sc_stream_redis_read(const sc_stream *stream, sc_char *data, sc_uint32
 sc_result sc_stream_redis_write(const sc_stream *stream, sc_char *data, sc_uint32 length, sc_uint32 *bytes_written)
 {
     sc_redis_handler *handler = (sc_redis_handler*)stream->handler;
+    redisReply *replies[2];
+    redisReply *reply = 0;
     g_assert(handler != 0);
 
-    redisReply *reply = do_sync_redis_command(&handler->context, "APPEND %s %b", handler->key, data, length);
+    if (handler->clear_pending == SC_TRUE)
+    {
+        // remove old value and append the first part of new one in one round trip
+        redisContext *context = sc_redis_pool_acquire(handler->pool);
+        redisAppendCommand(context, "DEL %s", handler->key);
+        redisAppendCommand(context, "APPEND %s %b", handler->key, data, (size_t)length);
+        sc_bool received = sc_redis_pipeline_replies(context, replies, 2);
+        sc_redis_pool_release(handler->pool, context);
+
+        if (received == SC_FALSE)
+            return SC_RESULT_ERROR_IO;
+
+        freeReplyObject(replies[0]);
+        reply = replies[1];
+        handler->clear_pending = SC_FALSE;
+    }else
+        reply = do_sync_redis_command(handler->pool, "APPEND %s %b", handler->key, data, (size_t)length);
+
+    if (reply == 0)
+        return SC_RESULT_ERROR_IO;
+
     if (reply->type != REDIS_REPLY_INTEGER)
     {
         freeReplyObject(reply);
@@ -131,6 +172,11 @@ sc_result sc_stream_redis_free_handler(const sc_stream *stream)
     sc_redis_handler *handler = (sc_redis_handler*)stream->handler;
     g_assert(handler != 0);
 
+    // nothing was written, so value should be empty
+    if (handler->clear_pending == SC_TRUE)
+        freeReplyObject(do_sync_redis_command(handler->pool, "DEL %s", handler->key));
+
+    g_free(handler->buffer);
     g_free(handler->key);
 
     g_free(handler);
@@ -149,38 +195,61 @@ sc_bool sc_stream_redis_eof(const sc_stream *stream)
     return SC_FALSE;
 }
 
+//! Requests size and the beginning of value in one round trip
+sc_bool _sc_stream_redis_prefetch(sc_redis_handler *handler)
+{
+    redisReply *replies[2];
+    sc_bool result = SC_FALSE;
+
+    redisContext *context = sc_redis_pool_acquire(handler->pool);
+    redisAppendCommand(context, "STRLEN %s", handler->key);
+    redisAppendCommand(context, "GETRANGE %s 0 %d", handler->key, SC_REDIS_PREFETCH_SIZE - 1);
+    sc_bool received = sc_redis_pipeline_replies(context, replies, 2);
+    sc_redis_pool_release(handler->pool, context);
 
-sc_stream* sc_stream_redis_new(redisContext *context, const sc_char *key, sc_uint8 flags, GMutex *mutex)
+    if (received == SC_FALSE)
+        return SC_FALSE;
+
+    if (replies[0]->type == REDIS_REPLY_INTEGER && replies[0]->integer > 0 && replies[1]->type == REDIS_REPLY_STRING)
+    {
+        handler->size = replies[0]->integer;
+        handler->buffer_len = replies[1]->len;
+        handler->buffer = g_new(sc_char, MAX(handler->buffer_len, 1));
+        memcpy(handler->buffer, replies[1]->str, handler->buffer_len);
+        result = SC_TRUE;
+    }
+
+    freeReplyObject(replies[0]);
+    freeReplyObject(replies[1]);
+
+    return result;
+}
+
+
+sc_stream* sc_stream_redis_new(sc_redis_pool *pool, const sc_char *key, sc_uint8 flags)
 {
     sc_stream *stream = 0;
     sc_redis_handler *handler = g_new0(sc_redis_handler, 1);
 
-    handler->context = context;
+    handler->pool = pool;
     handler->key = g_strdup(key);
     handler->pos = 0;
     handler->size = 0;
-    handler->mutex = mutex;
 
     // determine size
     if (flags & SC_STREAM_READ)
     {
-        redisReply *reply = do_sync_redis_command(&handler->context, "STRLEN %s", key);
-        if (reply->type != REDIS_REPLY_INTEGER || (reply->type == REDIS_REPLY_INTEGER && reply->integer == 0))
+        if (_sc_stream_redis_prefetch(handler) == SC_FALSE)
         {
-            freeReplyObject(reply);
+            g_free(handler->key);
             g_free(handler);
             return 0;
         }
-
-        handler->size = reply->integer;
-        freeReplyObject(reply);
     } else
     {
+        // old value is removed with the first write
         if (flags & SC_STREAM_WRITE)
-        {
-            redisReply *reply = do_sync_redis_command(&handler->context, "DEL %s", key);
-            freeReplyObject(reply);
-        }
+            handler->clear_pending = SC_TRUE;
     }
 
     stream = g_new0(sc_stream, 1);
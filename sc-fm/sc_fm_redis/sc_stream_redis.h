@@ -25,19 +25,19 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 
 
 #include "sc_stream.h"
+#include "sc_fm_redis.h"
 #include <hiredis/hiredis.h>
 #include <glib.h>
 
 /*! Create redis value data stream
- * @param context Pointer to used redis context
+ * @param pool Pool of redis connections
  * @param key Redis key for streaming
  * @param flags Data stream flags
- * @param mutex Pointer to synchronization mutex
  * @remarks Allocate and create redis value data stream. The returned stream pointer should be freed
  * with sc_stream_free function, when done using it.
  * @return Returns stream pointer if the stream was successfully created, or NULL if an error occurred
  */
-sc_stream* sc_stream_redis_new(redisContext *context, const sc_char *key, sc_uint8 flags, GMutex *mutex);
+sc_stream* sc_stream_redis_new(sc_redis_pool *pool, const sc_char *key, sc_uint8 flags);
 
 
 #endif // _sc_stream_redis_h_
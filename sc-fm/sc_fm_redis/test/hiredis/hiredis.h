@@ -0,0 +1,72 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+/*! Part of hiredis interface, that is used by redis file memory engine. It's implemented
+ * by hiredis_shim.c, so engine can be tested without redis server
+ */
+#ifndef _hiredis_shim_hiredis_h_
+#define _hiredis_shim_hiredis_h_
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <sys/time.h>
+
+#define REDIS_ERR -1
+#define REDIS_OK 0
+
+#define REDIS_ERR_IO 1
+#define REDIS_ERR_OTHER 2
+
+#define REDIS_REPLY_STRING 1
+#define REDIS_REPLY_ARRAY 2
+#define REDIS_REPLY_INTEGER 3
+#define REDIS_REPLY_NIL 4
+#define REDIS_REPLY_STATUS 5
+#define REDIS_REPLY_ERROR 6
+
+typedef struct redisReply
+{
+    int type;
+    long long integer;
+    size_t len;
+    char *str;
+    size_t elements;
+    struct redisReply **element;
+} redisReply;
+
+typedef struct redisContext
+{
+    int err;
+    char errstr[128];
+} redisContext;
+
+redisContext* redisConnectWithTimeout(const char *ip, int port, const struct timeval tv);
+void redisFree(redisContext *c);
+
+void* redisCommand(redisContext *c, const char *format, ...);
+void* redisvCommand(redisContext *c, const char *format, va_list ap);
+int redisAppendCommand(redisContext *c, const char *format, ...);
+int redisGetReply(redisContext *c, void **reply);
+
+void freeReplyObject(void *reply);
+
+#endif
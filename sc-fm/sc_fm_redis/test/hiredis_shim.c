@@ -0,0 +1,591 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#include "hiredis_shim.h"
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+//! Value of key in server database: string or list of strings
+struct _shim_value
+{
+    GByteArray *str;    // string value (0 for list)
+    GQueue *list;       // list value, that contains GByteArray items (0 for string)
+};
+
+typedef struct _shim_value shim_value;
+
+//! Connection state, that isn't visible to engine
+struct _shim_context
+{
+    redisContext context;   // should be the first member
+    GQueue *replies;        // replies of appended commands
+    sc_uint32 unsent;       // number of appended commands, that weren't sent yet
+    sc_bool broken;         // next command fails with I/O error
+    sc_bool connected;      // connection was opened successfully
+    volatile gint users;    // number of threads, that use connection now (hiredis context isn't thread safe)
+};
+
+typedef struct _shim_context shim_context;
+
+GMutex shim_mutex;
+GHashTable *shim_database = 0;
+sc_bool shim_available = SC_TRUE;
+volatile gint shim_connections = 0;
+volatile gint shim_round_trips = 0;
+volatile gint shim_commands = 0;
+
+
+void _shim_value_free(gpointer data)
+{
+    shim_value *value = (shim_value*)data;
+
+    if (value->str != 0)
+        g_byte_array_free(value->str, TRUE);
+
+    if (value->list != 0)
+    {
+        while (g_queue_get_length(value->list) > 0)
+            g_byte_array_free((GByteArray*)g_queue_pop_head(value->list), TRUE);
+        g_queue_free(value->list);
+    }
+
+    g_free(value);
+}
+
+GHashTable* _shim_database()
+{
+    if (shim_database == 0)
+        shim_database = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, _shim_value_free);
+
+    return shim_database;
+}
+
+// --- replies ---
+redisReply* _shim_reply_new(int type)
+{
+    redisReply *reply = g_new0(redisReply, 1);
+    reply->type = type;
+    return reply;
+}
+
+redisReply* _shim_reply_string(int type, const char *data, size_t len)
+{
+    redisReply *reply = _shim_reply_new(type);
+    reply->len = len;
+    reply->str = g_new0(char, len + 1);
+    memcpy(reply->str, data, len);
+    return reply;
+}
+
+redisReply* _shim_reply_integer(long long value)
+{
+    redisReply *reply = _shim_reply_new(REDIS_REPLY_INTEGER);
+    reply->integer = value;
+    return reply;
+}
+
+redisReply* _shim_reply_status(int type, const char *text)
+{
+    return _shim_reply_string(type, text, strlen(text));
+}
+
+void freeReplyObject(void *reply)
+{
+    redisReply *r = (redisReply*)reply;
+    size_t i;
+
+    if (r == 0)
+        return;
+
+    for (i = 0; i < r->elements; ++i)
+        freeReplyObject(r->element[i]);
+
+    g_free(r->element);
+    g_free(r->str);
+    g_free(r);
+}
+
+// --- command parsing ---
+void _shim_args_free(GPtrArray *args)
+{
+    guint i;
+
+    for (i = 0; i < args->len; ++i)
+        g_byte_array_free((GByteArray*)args->pdata[i], TRUE);
+
+    g_ptr_array_free(args, TRUE);
+}
+
+//! Splits command into arguments. Supports %s, %b, %d and %u specifiers, that are used by engine
+GPtrArray* _shim_format_command(const char *format, va_list ap)
+{
+    GPtrArray *args = g_ptr_array_new();
+    GByteArray *arg = 0;
+    const char *c;
+    char number[32];
+
+    for (c = format; *c != 0; ++c)
+    {
+        if (*c == ' ')
+        {
+            if (arg != 0)
+                g_ptr_array_add(args, arg);
+            arg = 0;
+            continue;
+        }
+
+        if (arg == 0)
+            arg = g_byte_array_new();
+
+        if (*c != '%')
+        {
+            g_byte_array_append(arg, (const guint8*)c, 1);
+            continue;
+        }
+
+        ++c;
+        switch (*c)
+        {
+        case 's':
+        {
+            const char *str = va_arg(ap, const char*);
+            g_byte_array_append(arg, (const guint8*)str, (guint)strlen(str));
+            break;
+        }
+
+        case 'b':
+        {
+            const void *data = va_arg(ap, const void*);
+            size_t len = va_arg(ap, size_t);
+            g_byte_array_append(arg, (const guint8*)data, (guint)len);
+            break;
+        }
+
+        case 'd':
+            g_snprintf(number, sizeof(number), "%d", va_arg(ap, int));
+            g_byte_array_append(arg, (const guint8*)number, (guint)strlen(number));
+            break;
+
+        case 'u':
+            g_snprintf(number, sizeof(number), "%u", va_arg(ap, unsigned int));
+            g_byte_array_append(arg, (const guint8*)number, (guint)strlen(number));
+            break;
+
+        default:
+            g_error("hiredis shim: unsupported format specifier %%%c", *c);
+        }
+    }
+
+    if (arg != 0)
+        g_ptr_array_add(args, arg);
+
+    return args;
+}
+
+gchar* _shim_arg_string(GPtrArray *args, guint index)
+{
+    GByteArray *arg = (GByteArray*)args->pdata[index];
+    return g_strndup((const gchar*)arg->data, arg->len);
+}
+
+long long _shim_arg_integer(GPtrArray *args, guint index)
+{
+    gchar *str = _shim_arg_string(args, index);
+    long long value = atoll(str);
+    g_free(str);
+    return value;
+}
+
+sc_bool _shim_arg_is(GPtrArray *args, guint index, const char *str)
+{
+    GByteArray *arg = (GByteArray*)args->pdata[index];
+    return (arg->len == strlen(str) && g_ascii_strncasecmp((const gchar*)arg->data, str, arg->len) == 0) ? SC_TRUE : SC_FALSE;
+}
+
+//! Converts redis range (negative indices count from the end) into [start, end), that is clamped to length
+void _shim_range(long long start, long long stop, size_t length, size_t *from, size_t *to)
+{
+    if (start < 0)
+        start += (long long)length;
+    if (stop < 0)
+        stop += (long long)length;
+    if (start < 0)
+        start = 0;
+    if (stop >= (long long)length)
+        stop = (long long)length - 1;
+
+    if (start > stop)
+    {
+        *from = *to = 0;
+        return;
+    }
+
+    *from = (size_t)start;
+    *to = (size_t)stop + 1;
+}
+
+// --- commands ---
+shim_value* _shim_lookup(GPtrArray *args, sc_bool create_list, sc_bool create_string)
+{
+    gchar *key = _shim_arg_string(args, 1);
+    shim_value *value = (shim_value*)g_hash_table_lookup(_shim_database(), key);
+
+    if (value == 0 && (create_list == SC_TRUE || create_string == SC_TRUE))
+    {
+        value = g_new0(shim_value, 1);
+        if (create_list == SC_TRUE)
+            value->list = g_queue_new();
+        else
+            value->str = g_byte_array_new();
+
+        g_hash_table_insert(_shim_database(), key, value);
+        return value;
+    }
+
+    g_free(key);
+    return value;
+}
+
+redisReply* _shim_execute(GPtrArray *args)
+{
+    shim_value *value = 0;
+    redisReply *reply = 0;
+    size_t from, to, i;
+    GList *item;
+
+    g_atomic_int_inc(&shim_commands);
+
+    if (args->len == 0)
+        return _shim_reply_status(REDIS_REPLY_ERROR, "ERR empty command");
+
+    if (_shim_arg_is(args, 0, "PING"))
+        return _shim_reply_status(REDIS_REPLY_STATUS, "PONG");
+
+    if (_shim_arg_is(args, 0, "SELECT") || _shim_arg_is(args, 0, "SAVE"))
+        return _shim_reply_status(REDIS_REPLY_STATUS, "OK");
+
+    if (_shim_arg_is(args, 0, "FLUSHDB"))
+    {
+        g_hash_table_remove_all(_shim_database());
+        return _shim_reply_status(REDIS_REPLY_STATUS, "OK");
+    }
+
+    if (args->len < 2)
+        return _shim_reply_status(REDIS_REPLY_ERROR, "ERR wrong number of arguments");
+
+    if (_shim_arg_is(args, 0, "DEL"))
+    {
+        gchar *key = _shim_arg_string(args, 1);
+        reply = _shim_reply_integer(g_hash_table_remove(_shim_database(), key) ? 1 : 0);
+        g_free(key);
+        return reply;
+    }
+
+    if (_shim_arg_is(args, 0, "STRLEN"))
+    {
+        value = _shim_lookup(args, SC_FALSE, SC_FALSE);
+        if (value != 0 && value->str == 0)
+            return _shim_reply_status(REDIS_REPLY_ERROR, "WRONGTYPE");
+        return _shim_reply_integer(value != 0 ? value->str->len : 0);
+    }
+
+    if (_shim_arg_is(args, 0, "APPEND") && args->len == 3)
+    {
+        GByteArray *data = (GByteArray*)args->pdata[2];
+        value = _shim_lookup(args, SC_FALSE, SC_TRUE);
+        if (value->str == 0)
+            return _shim_reply_status(REDIS_REPLY_ERROR, "WRONGTYPE");
+        g_byte_array_append(value->str, data->data, data->len);
+        return _shim_reply_integer(value->str->len);
+    }
+
+    if (_shim_arg_is(args, 0, "GETRANGE") && args->len == 4)
+    {
+        value = _shim_lookup(args, SC_FALSE, SC_FALSE);
+        if (value != 0 && value->str == 0)
+            return _shim_reply_status(REDIS_REPLY_ERROR, "WRONGTYPE");
+        if (value == 0)
+            return _shim_reply_string(REDIS_REPLY_STRING, "", 0);
+
+        _shim_range(_shim_arg_integer(args, 2), _shim_arg_integer(args, 3), value->str->len, &from, &to);
+        return _shim_reply_string(REDIS_REPLY_STRING, (const char*)value->str->data + from, to - from);
+    }
+
+    if (_shim_arg_is(args, 0, "LPUSH") && args->len == 3)
+    {
+        GByteArray *data = (GByteArray*)args->pdata[2];
+        value = _shim_lookup(args, SC_TRUE, SC_FALSE);
+        if (value->list == 0)
+            return _shim_reply_status(REDIS_REPLY_ERROR, "WRONGTYPE");
+        g_queue_push_head(value->list, g_byte_array_append(g_byte_array_new(), data->data, data->len));
+        return _shim_reply_integer(g_queue_get_length(value->list));
+    }
+
+    if (_shim_arg_is(args, 0, "LREM") && args->len == 4)
+    {
+        GByteArray *data = (GByteArray*)args->pdata[3];
+        long long count = _shim_arg_integer(args, 2), removed = 0;
+
+        g_assert(count > 0);
+        value = _shim_lookup(args, SC_FALSE, SC_FALSE);
+        if (value != 0 && value->list == 0)
+            return _shim_reply_status(REDIS_REPLY_ERROR, "WRONGTYPE");
+
+        item = (value != 0) ? g_queue_peek_head_link(value->list) : 0;
+        while (item != 0 && removed < count)
+        {
+            GByteArray *element = (GByteArray*)item->data;
+            GList *next = item->next;
+            if (element->len == data->len && memcmp(element->data, data->data, data->len) == 0)
+            {
+                g_byte_array_free(element, TRUE);
+                g_queue_delete_link(value->list, item);
+                ++removed;
+            }
+            item = next;
+        }
+
+        return _shim_reply_integer(removed);
+    }
+
+    if (_shim_arg_is(args, 0, "LRANGE") && args->len == 4)
+    {
+        value = _shim_lookup(args, SC_FALSE, SC_FALSE);
+        if (value != 0 && value->list == 0)
+            return _shim_reply_status(REDIS_REPLY_ERROR, "WRONGTYPE");
+
+        reply = _shim_reply_new(REDIS_REPLY_ARRAY);
+        if (value == 0)
+            return reply;
+
+        _shim_range(_shim_arg_integer(args, 2), _shim_arg_integer(args, 3), g_queue_get_length(value->list), &from, &to);
+        reply->elements = to - from;
+        reply->element = g_new0(redisReply*, MAX(reply->elements, 1));
+
+        item = g_queue_peek_head_link(value->list);
+        for (i = 0; item != 0 && i < to; ++i, item = item->next)
+        {
+            GByteArray *element = (GByteArray*)item->data;
+            if (i >= from)
+                reply->element[i - from] = _shim_reply_string(REDIS_REPLY_STRING, (const char*)element->data, element->len);
+        }
+
+        return reply;
+    }
+
+    return _shim_reply_status(REDIS_REPLY_ERROR, "ERR unknown command");
+}
+
+redisReply* _shim_execute_format(const char *format, va_list ap)
+{
+    GPtrArray *args = _shim_format_command(format, ap);
+    redisReply *reply = 0;
+
+    g_mutex_lock(&shim_mutex);
+    reply = _shim_execute(args);
+    g_mutex_unlock(&shim_mutex);
+
+    _shim_args_free(args);
+
+    return reply;
+}
+
+// --- connection ---
+void _shim_context_enter(shim_context *context)
+{
+    if (g_atomic_int_add(&context->users, 1) != 0)
+        g_error("hiredis shim: connection is used by several threads at the same time");
+}
+
+void _shim_context_leave(shim_context *context)
+{
+    g_atomic_int_add(&context->users, -1);
+}
+
+void _shim_context_set_error(shim_context *context, int err, const char *errstr)
+{
+    context->context.err = err;
+    g_strlcpy(context->context.errstr, errstr, sizeof(context->context.errstr));
+}
+
+//! Fails command, if connection was broken. Returns SC_TRUE, if command can be processed
+sc_bool _shim_context_check(shim_context *context)
+{
+    if (context->context.err != 0)
+        return SC_FALSE;
+
+    if (context->broken == SC_TRUE)
+    {
+        _shim_context_set_error(context, REDIS_ERR_IO, "Connection reset by peer");
+        return SC_FALSE;
+    }
+
+    return SC_TRUE;
+}
+
+redisContext* redisConnectWithTimeout(const char *ip, int port, const struct timeval tv)
+{
+    shim_context *context = g_new0(shim_context, 1);
+
+    context->replies = g_queue_new();
+
+    g_mutex_lock(&shim_mutex);
+    context->connected = shim_available;
+    g_mutex_unlock(&shim_mutex);
+
+    if (context->connected == SC_TRUE)
+        g_atomic_int_inc(&shim_connections);
+    else
+        _shim_context_set_error(context, REDIS_ERR_IO, "Connection refused");
+
+    return &context->context;
+}
+
+void redisFree(redisContext *c)
+{
+    shim_context *context = (shim_context*)c;
+
+    if (context == 0)
+        return;
+
+    while (g_queue_get_length(context->replies) > 0)
+        freeReplyObject(g_queue_pop_head(context->replies));
+    g_queue_free(context->replies);
+
+    if (context->connected == SC_TRUE)
+        g_atomic_int_add(&shim_connections, -1);
+
+    g_free(context);
+}
+
+void* redisvCommand(redisContext *c, const char *format, va_list ap)
+{
+    shim_context *context = (shim_context*)c;
+    redisReply *reply = 0;
+
+    _shim_context_enter(context);
+
+    if (_shim_context_check(context) == SC_TRUE)
+    {
+        g_atomic_int_inc(&shim_round_trips);
+        reply = _shim_execute_format(format, ap);
+    }
+
+    _shim_context_leave(context);
+
+    return reply;
+}
+
+void* redisCommand(redisContext *c, const char *format, ...)
+{
+    va_list ap;
+    void *reply = 0;
+
+    va_start(ap, format);
+    reply = redisvCommand(c, format, ap);
+    va_end(ap);
+
+    return reply;
+}
+
+int redisAppendCommand(redisContext *c, const char *format, ...)
+{
+    shim_context *context = (shim_context*)c;
+    va_list ap;
+
+    _shim_context_enter(context);
+
+    // command is buffered until reply is requested, so broken connection is detected later
+    if (context->context.err != 0)
+    {
+        _shim_context_leave(context);
+        return REDIS_ERR;
+    }
+
+    va_start(ap, format);
+    if (context->broken == SC_FALSE)
+        g_queue_push_tail(context->replies, _shim_execute_format(format, ap));
+    va_end(ap);
+
+    ++context->unsent;
+
+    _shim_context_leave(context);
+
+    return REDIS_OK;
+}
+
+int redisGetReply(redisContext *c, void **reply)
+{
+    shim_context *context = (shim_context*)c;
+
+    *reply = 0;
+    _shim_context_enter(context);
+
+    if (_shim_context_check(context) == SC_FALSE || g_queue_get_length(context->replies) == 0)
+    {
+        _shim_context_leave(context);
+        return REDIS_ERR;
+    }
+
+    // all appended commands are sent with one write
+    if (context->unsent > 0)
+    {
+        g_atomic_int_inc(&shim_round_trips);
+        context->unsent = 0;
+    }
+
+    *reply = g_queue_pop_head(context->replies);
+
+    _shim_context_leave(context);
+
+    return REDIS_OK;
+}
+
+// --- test control ---
+void hiredis_shim_set_available(sc_bool available)
+{
+    g_mutex_lock(&shim_mutex);
+    shim_available = available;
+    g_mutex_unlock(&shim_mutex);
+}
+
+void hiredis_shim_break(redisContext *c)
+{
+    ((shim_context*)c)->broken = SC_TRUE;
+}
+
+sc_uint32 hiredis_shim_connections_count()
+{
+    return (sc_uint32)g_atomic_int_get(&shim_connections);
+}
+
+sc_uint32 hiredis_shim_round_trips()
+{
+    return (sc_uint32)g_atomic_int_get(&shim_round_trips);
+}
+
+sc_uint32 hiredis_shim_commands()
+{
+    return (sc_uint32)g_atomic_int_get(&shim_commands);
+}
@@ -0,0 +1,44 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _hiredis_shim_h_
+#define _hiredis_shim_h_
+
+#include "hiredis/hiredis.h"
+#include "sc_types.h"
+
+//! Makes server (un)available for new connections. Opened connections aren't changed
+void hiredis_shim_set_available(sc_bool available);
+
+//! Breaks connection: the next command on \p c fails with I/O error, like on closed socket
+void hiredis_shim_break(redisContext *c);
+
+//! Returns number of successful connections, that weren't freed
+sc_uint32 hiredis_shim_connections_count();
+
+//! Returns number of round trips to server: each redisCommand and each sending of appended commands
+sc_uint32 hiredis_shim_round_trips();
+
+//! Returns number of commands, that were processed by server
+sc_uint32 hiredis_shim_commands();
+
+#endif
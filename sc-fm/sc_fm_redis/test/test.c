@@ -0,0 +1,400 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#include "hiredis_shim.h"
+#include "sc_fm_redis.h"
+#include "sc_fm_redis_config.h"
+#include "sc_stream_redis.h"
+#include "sc_fm_engine_private.h"
+#include "sc_stream.h"
+#include "sc_config.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define concurrent_threads_count 8
+#define concurrent_iterations_count 200
+#define large_content_size (SC_LINK_CONTENT_BUFFER_SIZE * 3 / 2)
+
+sc_fm_engine* initialize(const sc_char* repo_path);
+
+
+// --- helpers ---
+sc_redis_pool* pool_new(sc_uint32 size)
+{
+    sc_uint32 i;
+    struct timeval timeout = {1, 0};
+    sc_redis_pool *pool = g_new0(sc_redis_pool, 1);
+
+    pool->size = size;
+    pool->contexts = g_new0(redisContext*, size);
+    pool->free_contexts = g_async_queue_new();
+
+    for (i = 0; i < size; ++i)
+    {
+        pool->contexts[i] = redisConnectWithTimeout("127.0.0.1", 6379, timeout);
+        g_assert(pool->contexts[i]->err == 0);
+        g_async_queue_push(pool->free_contexts, pool->contexts[i]);
+    }
+
+    return pool;
+}
+
+void pool_free(sc_redis_pool *pool)
+{
+    sc_uint32 i;
+
+    g_assert(g_async_queue_length(pool->free_contexts) == (gint)pool->size);
+
+    for (i = 0; i < pool->size; ++i)
+        redisFree(pool->contexts[i]);
+
+    g_async_queue_unref(pool->free_contexts);
+    g_free(pool->contexts);
+    g_free(pool);
+}
+
+sc_bool pool_contains(sc_redis_pool *pool, redisContext *context)
+{
+    sc_uint32 i;
+
+    for (i = 0; i < pool->size; ++i)
+    {
+        if (pool->contexts[i] == context)
+            return SC_TRUE;
+    }
+
+    return SC_FALSE;
+}
+
+sc_bool pool_is_valid(sc_redis_pool *pool)
+{
+    sc_uint32 i;
+
+    for (i = 0; i < pool->size; ++i)
+    {
+        if (pool->contexts[i] == 0 || pool->contexts[i]->err != 0)
+            return SC_FALSE;
+    }
+
+    return SC_TRUE;
+}
+
+void fill_content(sc_char *data, sc_uint32 size, sc_uint32 seed)
+{
+    sc_uint32 i;
+
+    for (i = 0; i < size; ++i)
+        data[i] = (sc_char)(seed * 31 + i * 7);
+}
+
+sc_bool write_stream(sc_stream *stream, const sc_char *data, sc_uint32 size)
+{
+    sc_uint32 written = 0;
+
+    if (stream == 0)
+        return SC_FALSE;
+
+    if (sc_stream_write_data(stream, (sc_char*)data, size, &written) != SC_RESULT_OK || written != size)
+        return SC_FALSE;
+
+    return SC_TRUE;
+}
+
+//! Reads whole stream and compares it with \p data. Stream is freed
+sc_bool check_stream(sc_stream *stream, const sc_char *data, sc_uint32 size)
+{
+    sc_char buffer[4096];
+    sc_uint32 read = 0, pos = 0;
+    sc_bool result = SC_TRUE;
+
+    if (stream == 0)
+        return SC_FALSE;
+
+    while (sc_stream_eof(stream) == SC_FALSE)
+    {
+        if (sc_stream_read_data(stream, buffer, sizeof(buffer), &read) != SC_RESULT_OK || read == 0 ||
+            pos + read > size || memcmp(buffer, data + pos, read) != 0)
+        {
+            result = SC_FALSE;
+            break;
+        }
+        pos += read;
+    }
+
+    sc_stream_free(stream);
+
+    return (result == SC_TRUE && pos == size) ? SC_TRUE : SC_FALSE;
+}
+
+sc_check_sum make_check_sum(const char *format, sc_uint32 a, sc_uint32 b)
+{
+    sc_check_sum check_sum;
+
+    memset(&check_sum, 0, sizeof(check_sum));
+    check_sum.len = (sc_uint8)g_snprintf(check_sum.data, sizeof(check_sum.data), format, a, b);
+
+    return check_sum;
+}
+
+sc_bool find_addr(sc_fm_engine *engine, const sc_check_sum *check_sum, sc_addr addr, sc_uint32 *count)
+{
+    sc_addr *result = 0;
+    sc_uint32 result_count = 0, i;
+    sc_bool found = SC_FALSE;
+
+    *count = 0;
+    if (engine->funcFind(engine, check_sum, &result, &result_count) != SC_RESULT_OK)
+        return SC_FALSE;
+
+    for (i = 0; i < result_count; ++i)
+    {
+        if (result[i].seg == addr.seg && result[i].offset == addr.offset)
+            found = SC_TRUE;
+    }
+
+    *count = result_count;
+    g_free(result);
+
+    return found;
+}
+
+// --- tests ---
+void test_stream_pipelines()
+{
+    sc_redis_pool *pool = pool_new(1);
+    sc_char *data = g_new(sc_char, large_content_size);
+    sc_uint32 round_trips;
+    sc_stream *stream;
+
+    printf("Test pipelined stream commands\n");
+    fill_content(data, large_content_size, 1);
+
+    // old value is deleted together with the first append
+    round_trips = hiredis_shim_round_trips();
+    stream = sc_stream_redis_new(pool, "link:a:data", SC_STREAM_WRITE);
+    g_assert(write_stream(stream, data, 100) == SC_TRUE);
+    g_assert(hiredis_shim_round_trips() == round_trips + 1);
+    g_assert(write_stream(stream, data + 100, 100) == SC_TRUE);
+    g_assert(hiredis_shim_round_trips() == round_trips + 2);
+    sc_stream_free(stream);
+
+    // size and short value are received with one round trip
+    round_trips = hiredis_shim_round_trips();
+    g_assert(check_stream(sc_stream_redis_new(pool, "link:a:data", SC_STREAM_READ), data, 200) == SC_TRUE);
+    g_assert(hiredis_shim_round_trips() == round_trips + 1);
+
+    // rewrite with shorter value
+    stream = sc_stream_redis_new(pool, "link:a:data", SC_STREAM_WRITE);
+    g_assert(write_stream(stream, data + 10, 50) == SC_TRUE);
+    sc_stream_free(stream);
+    g_assert(check_stream(sc_stream_redis_new(pool, "link:a:data", SC_STREAM_READ), data + 10, 50) == SC_TRUE);
+
+    // value, that is larger than prefetched part
+    stream = sc_stream_redis_new(pool, "link:b:data", SC_STREAM_WRITE);
+    g_assert(write_stream(stream, data, large_content_size) == SC_TRUE);
+    sc_stream_free(stream);
+    g_assert(check_stream(sc_stream_redis_new(pool, "link:b:data", SC_STREAM_READ), data, large_content_size) == SC_TRUE);
+
+    // write stream without data makes value empty
+    stream = sc_stream_redis_new(pool, "link:b:data", SC_STREAM_WRITE);
+    g_assert(stream != 0);
+    sc_stream_free(stream);
+    g_assert(sc_stream_redis_new(pool, "link:b:data", SC_STREAM_READ) == 0);
+
+    g_assert(pool_is_valid(pool) == SC_TRUE);
+    pool_free(pool);
+    g_free(data);
+}
+
+void test_pool_reconnect()
+{
+    sc_redis_pool *pool = pool_new(2);
+    sc_uint32 connections = hiredis_shim_connections_count();
+    redisContext *context, *other;
+    redisReply *reply;
+    sc_char data[100];
+    sc_stream *stream;
+
+    printf("Test reconnection of broken connections\n");
+    fill_content(data, sizeof(data), 2);
+
+    // failed command sets error, so connection is replaced on release
+    context = sc_redis_pool_acquire(pool);
+    hiredis_shim_break(context);
+    g_assert(redisCommand(context, "PING") == 0);
+    g_assert(context->err != 0);
+    sc_redis_pool_release(pool, context);
+    g_assert(pool_contains(pool, context) == SC_FALSE);
+    g_assert(pool_is_valid(pool) == SC_TRUE);
+    g_assert(hiredis_shim_connections_count() == connections);
+
+    // if server isn't available, then broken connection stays in pool and it's restored by the next user
+    hiredis_shim_set_available(SC_FALSE);
+    context = sc_redis_pool_acquire(pool);
+    hiredis_shim_break(context);
+    g_assert(do_sync_redis_command(pool, "PING") != 0);
+    g_assert(redisCommand(context, "PING") == 0);
+    sc_redis_pool_release(pool, context);
+    g_assert(pool_contains(pool, context) == SC_TRUE);
+    g_assert(pool_is_valid(pool) == SC_FALSE);
+
+    hiredis_shim_set_available(SC_TRUE);
+    other = sc_redis_pool_acquire(pool);
+    g_assert(other != context);
+    context = sc_redis_pool_acquire(pool);
+    g_assert(context->err != 0);
+    g_assert(redisCommand(context, "PING") == 0);
+    sc_redis_pool_release(pool, context);
+    sc_redis_pool_release(pool, other);
+    g_assert(pool_contains(pool, context) == SC_FALSE);
+    g_assert(pool_is_valid(pool) == SC_TRUE);
+    g_assert(hiredis_shim_connections_count() == connections);
+
+    // pipelined commands fail on broken connection, and the next ones use restored connection
+    stream = sc_stream_redis_new(pool, "link:c:data", SC_STREAM_WRITE);
+    g_assert(write_stream(stream, data, sizeof(data)) == SC_TRUE);
+    sc_stream_free(stream);
+
+    context = sc_redis_pool_acquire(pool);
+    other = sc_redis_pool_acquire(pool);
+    hiredis_shim_break(context);
+    hiredis_shim_break(other);
+    sc_redis_pool_release(pool, context);
+    sc_redis_pool_release(pool, other);
+
+    g_assert(sc_stream_redis_new(pool, "link:c:data", SC_STREAM_READ) == 0);
+    stream = sc_stream_redis_new(pool, "link:c:data", SC_STREAM_WRITE);
+    g_assert(write_stream(stream, data, sizeof(data)) == SC_FALSE);
+    sc_stream_free(stream);
+    g_assert(pool_contains(pool, context) == SC_FALSE);
+    g_assert(pool_contains(pool, other) == SC_FALSE);
+    g_assert(pool_is_valid(pool) == SC_TRUE);
+
+    stream = sc_stream_redis_new(pool, "link:c:data", SC_STREAM_WRITE);
+    g_assert(write_stream(stream, data, sizeof(data)) == SC_TRUE);
+    sc_stream_free(stream);
+    g_assert(check_stream(sc_stream_redis_new(pool, "link:c:data", SC_STREAM_READ), data, sizeof(data)) == SC_TRUE);
+
+    reply = do_sync_redis_command(pool, "PING");
+    g_assert(reply != 0 && reply->type == REDIS_REPLY_STATUS);
+    freeReplyObject(reply);
+
+    pool_free(pool);
+}
+
+gpointer concurrent_thread(gpointer data)
+{
+    sc_fm_engine *engine = (sc_fm_engine*)data;
+    static volatile gint next_thread = 0;
+    sc_uint32 thread = (sc_uint32)g_atomic_int_add(&next_thread, 1);
+    sc_uint32 i, size, count;
+    sc_char content[5000];
+    sc_check_sum check_sum, shared = make_check_sum("shared%u%u", 0, 0);
+    sc_stream *stream = 0;
+    sc_addr addr;
+
+    for (i = 0; i < concurrent_iterations_count; ++i)
+    {
+        check_sum = make_check_sum("t%u-%u", thread, i);
+        addr.seg = thread;
+        addr.offset = i;
+
+        size = 1 + (thread * 977 + i * 131) % sizeof(content);
+        fill_content(content, size, thread * concurrent_iterations_count + i);
+
+        g_assert(engine->funcStreamCreate(engine, &check_sum, SC_STREAM_WRITE, &stream) == SC_RESULT_OK);
+        g_assert(write_stream(stream, content, size) == SC_TRUE);
+        sc_stream_free(stream);
+
+        g_assert(engine->funcStreamCreate(engine, &check_sum, SC_STREAM_READ, &stream) == SC_RESULT_OK);
+        g_assert(check_stream(stream, content, size) == SC_TRUE);
+
+        g_assert(engine->funcAddrRefAppend(engine, addr, &check_sum) == SC_RESULT_OK);
+        g_assert(find_addr(engine, &check_sum, addr, &count) == SC_TRUE && count == 1);
+
+        g_assert(engine->funcAddrRefAppend(engine, addr, &shared) == SC_RESULT_OK);
+        g_assert(find_addr(engine, &shared, addr, &count) == SC_TRUE);
+    }
+
+    return 0;
+}
+
+void test_concurrent_engine()
+{
+    sc_fm_engine *engine = 0;
+    GThread *threads[concurrent_threads_count];
+    sc_check_sum shared = make_check_sum("shared%u%u", 0, 0);
+    sc_uint32 i, count;
+    sc_addr addr;
+
+    printf("Test concurrent reading, writing and finding with %d threads\n", concurrent_threads_count);
+
+    engine = initialize("");
+    g_assert(engine != 0);
+    g_assert(engine->funcClear(engine) == SC_RESULT_OK);
+
+    for (i = 0; i < concurrent_threads_count; ++i)
+        threads[i] = g_thread_new("redis_test", concurrent_thread, engine);
+    for (i = 0; i < concurrent_threads_count; ++i)
+        g_thread_join(threads[i]);
+
+    addr.seg = 0;
+    addr.offset = 0;
+    g_assert(find_addr(engine, &shared, addr, &count) == SC_TRUE);
+    g_assert(count == concurrent_threads_count * concurrent_iterations_count);
+
+    // remove references of the first thread
+    for (i = 0; i < concurrent_iterations_count; ++i)
+    {
+        addr.offset = i;
+        g_assert(engine->funcAddrRefRemove(engine, addr, &shared) == SC_RESULT_OK);
+    }
+    addr.seg = 1;
+    g_assert(find_addr(engine, &shared, addr, &count) == SC_TRUE);
+    g_assert(count == (concurrent_threads_count - 1) * concurrent_iterations_count);
+
+    g_assert(engine->funcSave(engine) == SC_RESULT_OK);
+    g_assert(engine->funcDestroyData(engine) == SC_RESULT_OK);
+    g_free(engine);
+
+    g_assert(hiredis_shim_connections_count() == 0);
+}
+
+int main(int argc, char *argv[])
+{
+    sc_config_initialize(0);
+    sc_redis_config_initialize();
+
+    test_stream_pipelines();
+    test_pool_reconnect();
+    test_concurrent_engine();
+
+    printf("Commands processed: %u, round trips: %u\n", hiredis_shim_commands(), hiredis_shim_round_trips());
+
+    sc_config_shutdown();
+
+    printf("All tests passed\n");
+
+    return 0;
+}
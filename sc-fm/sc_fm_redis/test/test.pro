@@ -0,0 +1,28 @@
+TEMPLATE = app
+TARGET = test-fm-redis
+DESTDIR = ../../../bin
+
+CONFIG -= qt
+CONFIG += console
+
+# hiredis shim from this directory is used instead of hiredis library
+INCLUDEPATH += . \
+               .. \
+               ../../../sc-memory/src/sc-store
+
+unix {
+    LIBS += $$quote(-L$$DESTDIR) -lsc_memory
+    CONFIG += link_pkgconfig
+    PKGCONFIG += glib-2.0
+}
+
+HEADERS += \
+    hiredis/hiredis.h \
+    hiredis_shim.h
+
+SOURCES += \
+    test.c \
+    hiredis_shim.c \
+    ../sc_fm_redis.c \
+    ../sc_stream_redis.c \
+    ../sc_fm_redis_config.c
@@ -27,6 +27,126 @@ extern "C"
 
 #include <stdio.h>
 #include <iostream>
+#include <algorithm>
+#include <glib.h>
+
+//! Pattern arc, that is incident to current pattern element
+struct sc_pattern_arc
+{
+    sc_addr arc;
+    sc_type arc_type;
+    //! SC_TRUE, if arc goes out from current pattern element
+    sc_bool out;
+    //! Pattern element on the other end of arc
+    sc_addr next_element;
+    sc_type next_element_type;
+    //! Value of arc from input result
+    sc_bool arc_has_value;
+    sc_addr arc_value;
+    //! Value of next element from input result
+    sc_bool next_has_value;
+    sc_addr next_value;
+    //! Estimated number of const arcs, that need to be checked for this pattern arc
+    sc_uint32 cost;
+};
+
+typedef std::vector<sc_pattern_arc> sc_pattern_arc_vector;
+
+bool sc_pattern_arc_comparator(const sc_pattern_arc &a1, const sc_pattern_arc &a2)
+{
+    return a1.cost < a2.cost;
+}
+
+/*! Returns number of output (input) arcs of element.
+ * It's cheap, because sc-memory caches arcs count for each element
+ */
+sc_uint32 get_element_arcs_count(sc_addr element, sc_bool out)
+{
+    sc_iterator_param p1, p2, p3;
+
+    p1.is_type = SC_TRUE;
+    p1.type = 0;
+    p2.is_type = SC_TRUE;
+    p2.type = 0;
+    p3.is_type = SC_TRUE;
+    p3.type = 0;
+
+    if (out == SC_TRUE)
+    {
+        p1.is_type = SC_FALSE;
+        p1.addr = element;
+        return sc_iterator3_count(sc_iterator3_f_a_a, p1, p2, p3);
+    }
+
+    p3.is_type = SC_FALSE;
+    p3.addr = element;
+    return sc_iterator3_count(sc_iterator3_a_a_f, p1, p2, p3);
+}
+
+/*! Collects pattern arcs, incident to current pattern element, and orders them by estimated
+ * selectivity: arcs with known value first, then arcs to const (or already found) elements, then
+ * arcs, that will be checked by iteration of the smallest arcs list of current const element.
+ * Values of arcs and next elements are taken from input result there, so the result isn't copied.
+ */
+void system_sys_search_plan_arcs(sc_addr sc_pattern, sc_type_hash &pattern, sc_addr curr_const_element, sc_addr curr_pattern_element,
+                                 sc_type_result *inp_result, sc_pattern_arc_vector *pattern_arc_set)
+{
+    sc_pattern_arc pattern_arc;
+    sc_iterator3 it_pattern_arc;
+    sc_uint32 out_count = get_element_arcs_count(curr_const_element, SC_TRUE);
+    sc_uint32 in_count = get_element_arcs_count(curr_const_element, SC_FALSE);
+
+    for (sc_uint dir = 0; dir < 2; dir++)
+    {
+        pattern_arc.out = (dir == 0) ? SC_TRUE : SC_FALSE;
+
+        if (pattern_arc.out == SC_TRUE)
+        {
+            if (sc_iterator3_f_a_a_init(&it_pattern_arc, curr_pattern_element, 0, 0) == SC_FALSE)
+                continue;
+        }
+        else
+        {
+            if (sc_iterator3_a_a_f_init(&it_pattern_arc, 0, 0, curr_pattern_element) == SC_FALSE)
+                continue;
+        }
+
+        while (SC_TRUE == sc_iterator3_next(&it_pattern_arc))
+        {
+            if (pattern_arc.out == SC_FALSE && SC_ADDR_IS_EQUAL(sc_iterator3_value(&it_pattern_arc, 0), sc_pattern))
+                continue;
+
+            pattern_arc.arc = sc_iterator3_value(&it_pattern_arc, 1);
+            pattern_arc.next_element = sc_iterator3_value(&it_pattern_arc, pattern_arc.out == SC_TRUE ? 2 : 0);
+            if (pattern.find(SC_ADDR_LOCAL_TO_INT(pattern_arc.arc)) == pattern.end())
+                continue;
+
+            //! const pattern arcs are skipped
+            if (sc_memory_get_element_type(pattern_arc.arc, &pattern_arc.arc_type) != SC_RESULT_OK)
+                continue;
+            if ((sc_type_const & pattern_arc.arc_type) == sc_type_const)
+                continue;
+            if (sc_memory_get_element_type(pattern_arc.next_element, &pattern_arc.next_element_type) != SC_RESULT_OK)
+                continue;
+
+            pattern_arc.arc_has_value = find_result_pair_for_var(inp_result, pattern_arc.arc, &pattern_arc.arc_value);
+            pattern_arc.next_has_value = find_result_pair_for_var(inp_result, pattern_arc.next_element, &pattern_arc.next_value);
+
+            if (pattern_arc.arc_has_value == SC_TRUE)
+                pattern_arc.cost = 0;
+            else if (pattern_arc.next_has_value == SC_TRUE || (sc_type_const & pattern_arc.next_element_type) == sc_type_const)
+                pattern_arc.cost = 1;
+            else
+                pattern_arc.cost = 2 + (pattern_arc.out == SC_TRUE ? out_count : in_count);
+
+            pattern_arc_set->push_back(pattern_arc);
+        }
+
+        sc_iterator3_done(&it_pattern_arc);
+    }
+
+    std::stable_sort(pattern_arc_set->begin(), pattern_arc_set->end(), sc_pattern_arc_comparator);
+}
 
 
 sc_bool system_sys_search_recurse(sc_addr sc_pattern, sc_type_hash pattern, sc_addr curr_const_element, sc_addr curr_pattern_element, sc_type_result *inp_result, sc_type_result_vector *out_common_result, int element_number)
@@ -88,43 +208,14 @@ sc_bool system_sys_search_recurse(sc_addr sc_pattern, sc_type_hash pattern, sc_a
     }
 
     sc_addr addr1, addr2, temp, temp1;
-    int out_arc_count = 0;
 
     sc_type_result_vector common_result;
     sc_type_result_vector del_result;
-    sc_type_result inp_result_copy = *inp_result;
     common_result.push_back(inp_result);
 
     //Pattern arcs list
-
-    sc_addr_vector pattern_arc_set;
-
-    sc_iterator3 *it_pattern_arc = sc_iterator3_f_a_a_new(curr_pattern_element, 0, 0);
-    if (it_pattern_arc == nullptr) {return SC_FALSE;}
-    while (SC_TRUE == sc_iterator3_next(it_pattern_arc))
-    {
-        addr2 = sc_iterator3_value(it_pattern_arc, 1);
-        if (pattern.find(SC_ADDR_LOCAL_TO_INT(addr2)) != pattern.end())
-        {
-            out_arc_count++;
-            pattern_arc_set.push_back(addr2);
-        }
-    }
-    sc_iterator3_free(it_pattern_arc);
-
-    it_pattern_arc = sc_iterator3_a_a_f_new(0, 0, curr_pattern_element);
-    if (it_pattern_arc == nullptr) {return SC_FALSE;}
-    while (SC_TRUE == sc_iterator3_next(it_pattern_arc))
-    {
-        addr1 = sc_iterator3_value(it_pattern_arc, 0);
-        if (SC_ADDR_IS_EQUAL(addr1, sc_pattern)) continue;
-        addr2 = sc_iterator3_value(it_pattern_arc, 1);
-        if (pattern.find(SC_ADDR_LOCAL_TO_INT(addr2)) != pattern.end())
-        {
-            pattern_arc_set.push_back(addr2);
-        }
-    }
-    sc_iterator3_free(it_pattern_arc);
+    sc_pattern_arc_vector pattern_arc_set;
+    system_sys_search_plan_arcs(sc_pattern, pattern, curr_const_element, curr_pattern_element, inp_result, &pattern_arc_set);
 
     sc_addr pattern_arc;
     sc_addr const_arc;
@@ -142,41 +233,25 @@ sc_bool system_sys_search_recurse(sc_addr sc_pattern, sc_type_hash pattern, sc_a
     //Pattern arcs loop
     for (sc_uint i = 0; i < pattern_arc_set.size(); i++)
     {
-        pattern_arc = pattern_arc_set[i];
-        out_arc_flag = SC_TRUE;
+        const sc_pattern_arc &pattern_arc_info = pattern_arc_set[i];
+        pattern_arc = pattern_arc_info.arc;
+        out_arc_flag = pattern_arc_info.out;
+        next_pattern_element = pattern_arc_info.next_element;
 
-        //!check pattern_arc type
-        sc_type pattern_arc_type;
-        if (sc_memory_get_element_type(pattern_arc, &pattern_arc_type) != SC_RESULT_OK)
-            continue;
-        if ((sc_type_const & pattern_arc_type) == sc_type_const)
-            continue;
+        sc_type pattern_arc_type = pattern_arc_info.arc_type;
+        sc_type next_pattern_element_type = pattern_arc_info.next_element_type;
 
         pattern_arc_is_const_or_has_value = SC_FALSE;
         pattern_is_const_or_has_value = SC_FALSE;
 
-        if (out_arc_count > 0)
-        {
-            if (SC_RESULT_OK != sc_memory_get_arc_end(pattern_arc, &next_pattern_element))
-                continue;
-            out_arc_count--;
-        }
-        else
-        {
-            if (SC_RESULT_OK != sc_memory_get_arc_begin(pattern_arc, &next_pattern_element))
-                continue;
-            out_arc_flag = SC_FALSE;
-        }
-
         if (pattern.find(SC_ADDR_LOCAL_TO_INT(next_pattern_element)) == pattern.end())
         {
             continue;
         }
 
-        sc_type_result::iterator arc_it = inp_result_copy.find(pattern_arc);
-        if (arc_it != inp_result_copy.end())
+        if (pattern_arc_info.arc_has_value == SC_TRUE)
         {
-            const_arc = (*arc_it).second;
+            const_arc = pattern_arc_info.arc_value;
             pattern_arc_is_const_or_has_value = SC_TRUE;
             if (out_arc_flag == SC_TRUE)
             {
@@ -191,8 +266,6 @@ sc_bool system_sys_search_recurse(sc_addr sc_pattern, sc_type_hash pattern, sc_a
         }
 
         //!check next_pattern_element type
-        sc_type next_pattern_element_type;
-        if (sc_memory_get_element_type(next_pattern_element, &next_pattern_element_type) != SC_RESULT_OK) {continue;}
         if ((sc_type_const & next_pattern_element_type) == sc_type_const)
         {
             if (pattern_arc_is_const_or_has_value == SC_TRUE)
@@ -210,22 +283,30 @@ sc_bool system_sys_search_recurse(sc_addr sc_pattern, sc_type_hash pattern, sc_a
         }
         else
         {
-            sc_type_result::iterator it = inp_result_copy.find(next_pattern_element);
-            if (it != inp_result_copy.end())
+            if (pattern_arc_info.next_has_value == SC_TRUE)
             {
                 if (pattern_arc_is_const_or_has_value == SC_TRUE)
                 {
-                    if (!SC_ADDR_IS_EQUAL(next_const_element, (*it).second))
+                    if (!SC_ADDR_IS_EQUAL(next_const_element, pattern_arc_info.next_value))
                     {
                         continue;
                     }
                 }
                 else
                 {
-                    next_const_element = (*it).second;
+                    next_const_element = pattern_arc_info.next_value;
                 }
                 pattern_is_const_or_has_value = SC_TRUE;
             }
+            else if (pattern_arc_is_const_or_has_value == SC_TRUE)
+            {
+                //!early check of const element type, iterators check it in other cases
+                sc_type next_const_element_type;
+                if (sc_memory_get_element_type(next_const_element, &next_const_element_type) != SC_RESULT_OK)
+                    continue;
+                if (sc_iterator_compare_type(next_const_element_type, (~sc_type_var & next_pattern_element_type) | sc_type_const) == SC_FALSE)
+                    continue;
+            }
         }
 
         pattern.erase(SC_ADDR_LOCAL_TO_INT(next_pattern_element));
@@ -415,59 +496,224 @@ sc_bool system_sys_search_recurse(sc_addr sc_pattern, sc_type_hash pattern, sc_a
 
 /*
  * returns SC_FALSE if element can't be found otherwise SC_TRUE
+ * If there are several const elements, then returns element with the lowest arcs count,
+ * so search starts from the most selective element
 */
 sc_bool get_const_element(sc_addr pattern, sc_addr *result)
 {
+    sc_addr element;
+    sc_uint32 count, min_count = 0;
+    sc_bool found = SC_FALSE;
+
     sc_iterator3 *it = sc_iterator3_f_a_a_new(pattern, sc_type_arc_pos_const_perm, sc_type_const);
-    if (SC_TRUE == sc_iterator3_next(it))
+    while (SC_TRUE == sc_iterator3_next(it))
     {
-        *result = sc_iterator3_value(it, 2);
-        sc_iterator3_free(it);
-        return SC_TRUE;
+        element = sc_iterator3_value(it, 2);
+        count = get_element_arcs_count(element, SC_TRUE) + get_element_arcs_count(element, SC_FALSE);
+        if (found == SC_FALSE || count < min_count)
+        {
+            *result = element;
+            min_count = count;
+            found = SC_TRUE;
+        }
     }
     sc_iterator3_free(it);
-    return SC_FALSE;
+    return found;
 }
 
-sc_result system_sys_search_only_full(sc_addr pattern, sc_type_result params, sc_type_result_vector *search_result)
+//! Top-level candidate for parallel search: value of the first pattern arc and element on it end
+struct sc_search_task
 {
-    sc_addr start_pattern_node, start_const_node;
+    sc_addr const_arc;
+    sc_addr next_const_element;
+};
 
-    if (SC_FALSE == get_const_element(pattern, &start_pattern_node))
+//! Data shared by all threads of parallel search
+struct sc_search_context
+{
+    sc_addr pattern;
+    sc_type_hash *pattern_hash;
+    sc_type_result *params;
+    sc_addr start_pattern_node;
+    sc_addr start_const_node;
+    sc_addr pattern_arc;
+    sc_addr next_pattern_element;
+    sc_bool next_is_var;
+    sc_uint var_count;
+    //! If it's SC_TRUE, then search stops after first found construction
+    sc_bool single;
+    //! Number of found constructions
+    volatile gint found;
+    //! Mutex to merge results
+    GMutex mutex;
+    sc_type_result_vector *result;
+};
+
+sc_uint32 search_threads_count = 1;
+
+void system_sys_search_set_threads_count(sc_uint32 count)
+{
+    search_threads_count = (count > 0) ? count : 1;
+}
+
+sc_uint32 system_sys_search_get_threads_count()
+{
+    return search_threads_count;
+}
+
+void system_sys_search_task(gpointer data, gpointer user_data)
+{
+    sc_search_task *task = (sc_search_task*)data;
+    sc_search_context *context = (sc_search_context*)user_data;
+
+    //! early exit, construction is already found by other thread
+    if (context->single == SC_TRUE && g_atomic_int_get(&context->found) > 0)
     {
-        if (params.empty())
-        {
-            std::cout << "ERROR: need const element to start search!" << std::endl;
-            return SC_RESULT_ERROR_INVALID_PARAMS;
-        }
+        delete task;
+        return;
+    }
+
+    sc_type_result *result = new sc_type_result();
+    *result = *context->params;
+    result->insert(sc_addr_pair(context->pattern_arc, task->const_arc));
+    if (context->next_is_var == SC_TRUE)
+        result->insert(sc_addr_pair(context->next_pattern_element, task->next_const_element));
+
+    sc_type_result_vector task_result;
+    system_sys_search_recurse(context->pattern, *context->pattern_hash, context->start_const_node, context->start_pattern_node,
+                              result, &task_result, 2);
+
+    sort_result_vector(&task_result);
+    remove_result_vector_short_results(&task_result, context->var_count);
+
+    if (!task_result.empty())
+    {
+        g_atomic_int_add(&context->found, (gint)task_result.size());
+
+        if (context->single == SC_TRUE)
+            free_result_vector(&task_result);
         else
         {
-            sc_type_result::iterator it = params.begin();
-            start_pattern_node = (*it).first;
-            start_const_node = (*it).second;
+            g_mutex_lock(&context->mutex);
+            context->result->insert(context->result->end(), task_result.begin(), task_result.end());
+            g_mutex_unlock(&context->mutex);
         }
     }
+
+    delete task;
+}
+
+/*! Runs search in several threads. Candidates for the first pattern arc of start element are
+ * distributed between threads, each thread searches constructions with it candidate.
+ * Constructions found by different threads are different, because they have different values of this arc.
+ * @return If search can't be divided between threads, then returns SC_FALSE
+ */
+sc_bool system_sys_search_parallel(sc_addr pattern, sc_type_hash &pattern_hash, sc_type_result &params, sc_addr start_pattern_node, sc_addr start_const_node,
+                                   sc_uint var_count, sc_bool single, sc_type_result_vector *search_result, sc_bool *found)
+{
+    sc_pattern_arc_vector pattern_arc_set;
+    system_sys_search_plan_arcs(pattern, pattern_hash, start_const_node, start_pattern_node, &params, &pattern_arc_set);
+
+    //! take the most selective arc, that leads to element of pattern
+    sc_uint i;
+    for (i = 0; i < pattern_arc_set.size(); i++)
+    {
+        if (pattern_hash.find(SC_ADDR_LOCAL_TO_INT(pattern_arc_set[i].next_element)) != pattern_hash.end())
+            break;
+    }
+    if (i == pattern_arc_set.size() || pattern_arc_set[i].arc_has_value == SC_TRUE)
+        return SC_FALSE;
+
+    const sc_pattern_arc &pattern_arc = pattern_arc_set[i];
+    sc_bool next_is_var = ((sc_type_const & pattern_arc.next_element_type) == sc_type_const || pattern_arc.next_has_value == SC_TRUE) ? SC_FALSE : SC_TRUE;
+    sc_addr next_const_element = pattern_arc.next_has_value == SC_TRUE ? pattern_arc.next_value : pattern_arc.next_element;
+    sc_type const_arc_type = ((~sc_type_var & pattern_arc.arc_type) | sc_type_const);
+    sc_type next_const_element_type = ((~sc_type_var & pattern_arc.next_element_type) | sc_type_const);
+
+    //! collect candidates
+    std::vector<sc_search_task> tasks;
+    sc_search_task task;
+    sc_addr temp;
+    sc_iterator3 it_const_arc;
+    sc_bool res;
+
+    if (pattern_arc.out == SC_TRUE)
+    {
+        if (next_is_var == SC_TRUE)
+            res = sc_iterator3_f_a_a_init(&it_const_arc, start_const_node, const_arc_type, next_const_element_type);
+        else
+            res = sc_iterator3_f_a_f_init(&it_const_arc, start_const_node, const_arc_type, next_const_element);
+    }
     else
     {
-        start_const_node = start_pattern_node;
+        if (next_is_var == SC_TRUE)
+            res = sc_iterator3_a_a_f_init(&it_const_arc, next_const_element_type, const_arc_type, start_const_node);
+        else
+            res = sc_iterator3_f_a_f_init(&it_const_arc, next_const_element, const_arc_type, start_const_node);
     }
-    sc_type_result *result = new sc_type_result();
-    *result = params;
+    if (res == SC_FALSE)
+        return SC_FALSE;
 
-    sc_uint var_count = 0;
-    sc_type_hash pattern_hash;
+    while (SC_TRUE == sc_iterator3_next(&it_const_arc))
+    {
+        task.const_arc = sc_iterator3_value(&it_const_arc, 1);
+        task.next_const_element = sc_iterator3_value(&it_const_arc, pattern_arc.out == SC_TRUE ? 2 : 0);
 
-    copy_set_into_hash(pattern, sc_type_arc_pos_const_perm, 0, &pattern_hash, &var_count);
-    pattern_hash.erase(SC_ADDR_LOCAL_TO_INT(start_pattern_node));
-    system_sys_search_recurse(pattern, pattern_hash, start_const_node, start_pattern_node, result, search_result, 2);
+        if (SC_ADDR_IS_EQUAL(task.next_const_element, pattern))
+            continue;
+        if (SC_TRUE == find_result_pair_for_const(&params, task.const_arc, &temp))
+            continue;
+        if (next_is_var == SC_TRUE)
+        {
+            if (pattern_hash.find(SC_ADDR_LOCAL_TO_INT(task.next_const_element)) != pattern_hash.end())
+                continue;
+            if (SC_TRUE == find_result_pair_for_const(&params, task.next_const_element, &temp))
+                continue;
+        }
+
+        tasks.push_back(task);
+    }
+    sc_iterator3_done(&it_const_arc);
+
+    if (tasks.size() < 2)
+        return SC_FALSE;
+
+    sc_search_context context;
+    context.pattern = pattern;
+    context.pattern_hash = &pattern_hash;
+    context.params = &params;
+    context.start_pattern_node = start_pattern_node;
+    context.start_const_node = start_const_node;
+    context.pattern_arc = pattern_arc.arc;
+    context.next_pattern_element = pattern_arc.next_element;
+    context.next_is_var = next_is_var;
+    context.var_count = var_count;
+    context.single = single;
+    context.found = 0;
+    context.result = search_result;
+    g_mutex_init(&context.mutex);
+
+    GThreadPool *pool = g_thread_pool_new(system_sys_search_task, &context, search_threads_count, TRUE, 0);
+    for (i = 0; i < tasks.size(); i++)
+        g_thread_pool_push(pool, new sc_search_task(tasks[i]), 0);
+
+    // wait until all tasks will be processed
+    g_thread_pool_free(pool, FALSE, TRUE);
+    g_mutex_clear(&context.mutex);
 
     sort_result_vector(search_result);
-    remove_result_vector_short_results(search_result, var_count);
+    *found = (g_atomic_int_get(&context.found) > 0) ? SC_TRUE : SC_FALSE;
 
-    return SC_RESULT_OK;
+    return SC_TRUE;
 }
 
-sc_result system_sys_search_for_variables(sc_addr pattern, sc_type_result params, sc_addr_vector requested_values, sc_type_result_vector *search_result)
+/*! Search fully isomorfic constructions. It's a common part of system_sys_search_only_full,
+ * system_sys_search_for_variables and system_sys_search_single
+ * @param single If it's SC_TRUE, then search can be stopped after first found construction
+ * (found constructions aren't stored into \p search_result in this case)
+ * @param found Pointer to flag of found construction
+ */
+sc_result system_sys_search_full(sc_addr pattern, sc_type_result &params, sc_bool single, sc_type_result_vector *search_result, sc_bool *found)
 {
     sc_addr start_pattern_node, start_const_node;
 
@@ -490,24 +736,62 @@ sc_result system_sys_search_for_variables(sc_addr pattern, sc_type_result params
         start_const_node = start_pattern_node;
     }
 
-    sc_type_result *result = new sc_type_result();
-    *result = params;
-
     sc_uint var_count = 0;
     sc_type_hash pattern_hash;
 
     copy_set_into_hash(pattern, sc_type_arc_pos_const_perm, 0, &pattern_hash, &var_count);
     pattern_hash.erase(SC_ADDR_LOCAL_TO_INT(start_pattern_node));
+
+    if (search_threads_count > 1)
+    {
+        // threads search in different parts of memory, so it mustn't be changed until all of them finished
+        sc_memory_read_lock();
+        sc_bool done = system_sys_search_parallel(pattern, pattern_hash, params, start_pattern_node, start_const_node, var_count, single, search_result, found);
+        sc_memory_read_unlock();
+
+        if (done == SC_TRUE)
+            return SC_RESULT_OK;
+    }
+
+    sc_type_result *result = new sc_type_result();
+    *result = params;
+
     system_sys_search_recurse(pattern, pattern_hash, start_const_node, start_pattern_node, result, search_result, 2);
 
     sort_result_vector(search_result);
     remove_result_vector_short_results(search_result, var_count);
-    if (!requested_values.empty())
+
+    *found = search_result->empty() ? SC_FALSE : SC_TRUE;
+    if (single == SC_TRUE)
+        free_result_vector(search_result);
+
+    return SC_RESULT_OK;
+}
+
+sc_result system_sys_search_only_full(sc_addr pattern, sc_type_result params, sc_type_result_vector *search_result)
+{
+    sc_bool found = SC_FALSE;
+    return system_sys_search_full(pattern, params, SC_FALSE, search_result, &found);
+}
+
+sc_result system_sys_search_for_variables(sc_addr pattern, sc_type_result params, sc_addr_vector requested_values, sc_type_result_vector *search_result)
+{
+    sc_bool found = SC_FALSE;
+    sc_result res = system_sys_search_full(pattern, params, SC_FALSE, search_result, &found);
+
+    if (res == SC_RESULT_OK && !requested_values.empty())
     {
         filter_result_vector_by_variables(search_result, &requested_values);
     }
 
-    return SC_RESULT_OK;
+    return res;
+}
+
+sc_result system_sys_search_single(sc_addr pattern, sc_type_result params, sc_bool *result)
+{
+    sc_type_result_vector search_result;
+    *result = SC_FALSE;
+    return system_sys_search_full(pattern, params, SC_TRUE, &search_result, result);
 }
 
 sc_result system_sys_search(sc_addr pattern, sc_type_result params, sc_type_result_vector *search_result)
@@ -69,5 +69,16 @@ sc_result system_sys_search_only_full(sc_addr pattern, sc_type_result params, sc
  */
 sc_result system_sys_search_for_variables(sc_addr pattern, sc_type_result params, sc_addr_vector requested_values, sc_type_result_vector *result);
 
+/*! Setup number of threads for search of fully isomorfic constructions (system_sys_search_only_full,
+ * system_sys_search_for_variables and system_sys_search_single). If it's more than 1, then candidates
+ * for the first pattern arc are distributed between threads. By default search runs in calling thread.
+ * Parallel search holds sc-memory read lock (sc_memory_read_lock), so changes of memory wait until it finished.
+ * @param count Number of threads
+ */
+void system_sys_search_set_threads_count(sc_uint32 count);
+
+//! Returns number of threads, that used for search
+sc_uint32 system_sys_search_get_threads_count();
+
 
 #endif // SC_SEARCH_SYSTEM_H
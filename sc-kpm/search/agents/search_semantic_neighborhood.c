@@ -32,7 +32,8 @@ along with OSTIS. If not, see <http://www.gnu.org/licenses/>.
 void search_translation(sc_addr elem, sc_addr answer, sc_bool sys_off)
 {
     sc_iterator5 *it5;
-    sc_iterator3 *it3, *it4;
+    // nested iterators are allocated on stack, to prevent allocations for each iteration result
+    sc_iterator3 it3, it4;
     sc_bool found = SC_FALSE;
 
     // iterate translations of sc-element
@@ -55,48 +56,56 @@ void search_translation(sc_addr elem, sc_addr answer, sc_bool sys_off)
         appendIntoAnswer(answer, sc_iterator5_value(it5, 3));
 
         // iterate translation sc-links
-        it3 = sc_iterator3_f_a_a_new(sc_iterator5_value(it5, 0),
-                                     sc_type_arc_pos_const_perm,
-                                     0);
-        while (sc_iterator3_next(it3) == SC_TRUE)
+        if (sc_iterator3_f_a_a_init(&it3,
+                                    sc_iterator5_value(it5, 0),
+                                    sc_type_arc_pos_const_perm,
+                                    0) == SC_FALSE)
+            continue;
+        while (sc_iterator3_next(&it3) == SC_TRUE)
         {
-            if (sys_off == SC_TRUE && (IS_SYSTEM_ELEMENT(sc_iterator3_value(it3, 1)) || IS_SYSTEM_ELEMENT(sc_iterator3_value(it3, 2))))
+            if (sys_off == SC_TRUE && (IS_SYSTEM_ELEMENT(sc_iterator3_value(&it3, 1)) || IS_SYSTEM_ELEMENT(sc_iterator3_value(&it3, 2))))
                 continue;
 
             // iterate input arcs for link
-            it4 = sc_iterator3_a_a_f_new(sc_type_node,
-                                         sc_type_arc_pos_const_perm,
-                                         sc_iterator3_value(it3, 2));
-            while (sc_iterator3_next(it4) == SC_TRUE)
+            if (sc_iterator3_a_a_f_init(&it4,
+                                        sc_type_node,
+                                        sc_type_arc_pos_const_perm,
+                                        sc_iterator3_value(&it3, 2)) == SC_TRUE)
             {
-                if (sys_off == SC_TRUE && (IS_SYSTEM_ELEMENT(sc_iterator3_value(it4, 1)) || IS_SYSTEM_ELEMENT(sc_iterator3_value(it4, 0))))
-                    continue;
-                if (sc_helper_check_arc(keynode_languages, sc_iterator3_value(it4, 0), sc_type_arc_pos_const_perm) == SC_TRUE)
+                while (sc_iterator3_next(&it4) == SC_TRUE)
                 {
-                    appendIntoAnswer(answer, sc_iterator3_value(it4, 0));
-                    appendIntoAnswer(answer, sc_iterator3_value(it4, 1));
+                    if (sys_off == SC_TRUE && (IS_SYSTEM_ELEMENT(sc_iterator3_value(&it4, 1)) || IS_SYSTEM_ELEMENT(sc_iterator3_value(&it4, 0))))
+                        continue;
+                    if (sc_helper_check_arc(keynode_languages, sc_iterator3_value(&it4, 0), sc_type_arc_pos_const_perm) == SC_TRUE)
+                    {
+                        appendIntoAnswer(answer, sc_iterator3_value(&it4, 0));
+                        appendIntoAnswer(answer, sc_iterator3_value(&it4, 1));
+                    }
                 }
+                sc_iterator3_done(&it4);
             }
-            sc_iterator3_free(it4);
 
             // iterate input arcs for arc
-            it4 = sc_iterator3_a_a_f_new(sc_type_node,
-                                         sc_type_arc_pos_const_perm,
-                                         sc_iterator3_value(it3, 1));
-            while (sc_iterator3_next(it4) == SC_TRUE)
+            if (sc_iterator3_a_a_f_init(&it4,
+                                        sc_type_node,
+                                        sc_type_arc_pos_const_perm,
+                                        sc_iterator3_value(&it3, 1)) == SC_TRUE)
             {
-                if (sys_off == SC_TRUE && (IS_SYSTEM_ELEMENT(sc_iterator3_value(it4, 0)) || IS_SYSTEM_ELEMENT(sc_iterator3_value(it4, 1))))
-                    continue;
+                while (sc_iterator3_next(&it4) == SC_TRUE)
+                {
+                    if (sys_off == SC_TRUE && (IS_SYSTEM_ELEMENT(sc_iterator3_value(&it4, 0)) || IS_SYSTEM_ELEMENT(sc_iterator3_value(&it4, 1))))
+                        continue;
 
-                appendIntoAnswer(answer, sc_iterator3_value(it4, 0));
-                appendIntoAnswer(answer, sc_iterator3_value(it4, 1));
+                    appendIntoAnswer(answer, sc_iterator3_value(&it4, 0));
+                    appendIntoAnswer(answer, sc_iterator3_value(&it4, 1));
+                }
+                sc_iterator3_done(&it4);
             }
-            sc_iterator3_free(it4);
 
-            appendIntoAnswer(answer, sc_iterator3_value(it3, 1));
-            appendIntoAnswer(answer, sc_iterator3_value(it3, 2));
+            appendIntoAnswer(answer, sc_iterator3_value(&it3, 1));
+            appendIntoAnswer(answer, sc_iterator3_value(&it3, 2));
         }
-        sc_iterator3_free(it3);
+        sc_iterator3_done(&it3);
 
     }
     sc_iterator5_free(it5);
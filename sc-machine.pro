@@ -5,5 +5,6 @@ DESTDIR = ./bin
 
 SUBDIRS = sc-memory \
           sc-fm \
-          sc-memory/test #\
+          sc-memory/test \
+          sc-fm/sc_fm_redis/test #\
           #tools/sc-store-visual
@@ -10,6 +10,8 @@ HEADERS += \
     src/sc_memory.h \
     src/sc-store/sc_link_helpers.h \
     src/sc-store/sc_fs_storage.h \
+    src/sc-store/sc_content_cache.h \
+    src/sc-store/sc_content_filter.h \
     src/sc-store/sc_element.h \
     src/sc-store/sc_defines.h \
     src/sc-store/sc_config.h \
@@ -35,6 +37,8 @@ SOURCES += \
     src/sc_memory.c \
     src/sc-store/sc_link_helpers.c \
     src/sc-store/sc_fs_storage.c \
+    src/sc-store/sc_content_cache.c \
+    src/sc-store/sc_content_filter.c \
     src/sc-store/sc_element.c \
     src/sc-store/sc_stream_file.c \
     src/sc-store/sc_stream.c \
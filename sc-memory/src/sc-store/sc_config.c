@@ -29,6 +29,8 @@ const char str_group_fm[] = "filememory";
 
 const char str_key_max_loaded_segments[] = "max_loaded_segments";
 const char str_key_fm_engine[] = "engine";
+const char str_key_fm_checksum[] = "checksum";
+const char str_key_fm_cache_size[] = "cache_size";
 
 
 // Maximum number of segments, that can be loaded into memory at one moment
@@ -44,6 +46,9 @@ GHashTable *values_table = 0;
 // --- file memory ---
 const char fm_default_engine[] = "filesystem";
 const char *config_fm_engine = fm_default_engine;
+const char fm_default_checksum[] = "sha256";
+const char *config_fm_checksum = fm_default_checksum;
+sc_uint32 config_fm_cache_size = 32;
 
 void value_table_destroy_key_value(gpointer data)
 {
@@ -69,6 +74,10 @@ void sc_config_initialize(const sc_char *file_path)
         // file memory
         if (g_key_file_has_key(key_file, str_group_fm, str_key_fm_engine, 0) == TRUE)
             config_fm_engine = g_key_file_get_string(key_file, str_group_fm, str_key_fm_engine, 0);
+        if (g_key_file_has_key(key_file, str_group_fm, str_key_fm_checksum, 0) == TRUE)
+            config_fm_checksum = g_key_file_get_string(key_file, str_group_fm, str_key_fm_checksum, 0);
+        if (g_key_file_has_key(key_file, str_group_fm, str_key_fm_cache_size, 0) == TRUE)
+            config_fm_cache_size = g_key_file_get_integer(key_file, str_group_fm, str_key_fm_cache_size, 0);
     }else
     {
         // setup default values
@@ -156,3 +165,13 @@ const sc_char* sc_config_fm_engine()
 {
     return config_fm_engine;
 }
+
+const sc_char* sc_config_fm_checksum()
+{
+    return config_fm_checksum;
+}
+
+sc_uint32 sc_config_fm_cache_size()
+{
+    return config_fm_cache_size;
+}
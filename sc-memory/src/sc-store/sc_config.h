@@ -41,6 +41,14 @@ sc_uint32 sc_config_get_max_loaded_segments();
 //! Returns file memory engine
 const sc_char* sc_config_fm_engine();
 
+/*! Returns name of checksum algorithm for new repositories ("sha256" or "fast").
+ * Existing repositories use algorithm, that stored in them
+ */
+const sc_char* sc_config_fm_checksum();
+
+//! Returns size of link contents cache in megabytes. Zero value disables cache
+sc_uint32 sc_config_fm_cache_size();
+
 
 // --- api for extensions ---
 /*!
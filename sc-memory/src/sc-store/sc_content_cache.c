@@ -0,0 +1,235 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#include "sc_content_cache.h"
+#include "sc_stream_memory.h"
+
+#include <glib.h>
+#include <memory.h>
+
+// part of cache size, that can be used by one content
+#define SC_CONTENT_CACHE_ITEM_PART 16
+
+struct _sc_content_cache_item
+{
+    sc_check_sum check_sum;   // checksum of content (key in hash table)
+    GBytes *data;             // content data, that is shared with read streams
+    GList *lru_link;          // link in list of recently used contents
+};
+
+typedef struct _sc_content_cache_item sc_content_cache_item;
+
+GHashTable *content_cache_table = 0;
+GQueue content_cache_lru = G_QUEUE_INIT; // head is the most recently used content
+sc_uint64 content_cache_max_size = 0;
+sc_uint64 content_cache_max_item_size = 0;
+sc_content_cache_stat content_cache_stat;
+
+GMutex content_cache_mutex; // statically allocated GMutex doesn't need initialization
+#define CONTENT_CACHE_LOCK g_mutex_lock(&content_cache_mutex);
+#define CONTENT_CACHE_UNLOCK g_mutex_unlock(&content_cache_mutex);
+
+// ----------------------------------------------
+
+guint _sc_content_cache_hash(gconstpointer key)
+{
+    const sc_check_sum *check_sum = (const sc_check_sum*)key;
+    guint hash = 2166136261u;
+    sc_uint8 i;
+
+    for (i = 0; i < check_sum->len; ++i)
+        hash = (hash ^ (sc_uint8)check_sum->data[i]) * 16777619u;
+
+    return hash;
+}
+
+gboolean _sc_content_cache_equal(gconstpointer a, gconstpointer b)
+{
+    const sc_check_sum *cs1 = (const sc_check_sum*)a;
+    const sc_check_sum *cs2 = (const sc_check_sum*)b;
+
+    return (cs1->len == cs2->len) && (memcmp(cs1->data, cs2->data, cs1->len) == 0);
+}
+
+void _sc_content_cache_item_free(gpointer data)
+{
+    sc_content_cache_item *item = (sc_content_cache_item*)data;
+
+    // streams, that read this content, keep their own references on data
+    g_bytes_unref(item->data);
+    g_free(item);
+}
+
+//! Removes the least recently used contents while cache size exceeds limit. Should be called under lock
+void _sc_content_cache_evict()
+{
+    sc_content_cache_item *item = 0;
+
+    while (content_cache_stat.size > content_cache_max_size && content_cache_lru.tail != 0)
+    {
+        item = (sc_content_cache_item*)g_queue_pop_tail(&content_cache_lru);
+
+        content_cache_stat.size -= g_bytes_get_size(item->data);
+        content_cache_stat.items--;
+
+        g_hash_table_remove(content_cache_table, &item->check_sum);
+    }
+}
+
+// ----------------------------------------------
+
+void sc_content_cache_initialize(sc_uint64 max_size)
+{
+    CONTENT_CACHE_LOCK
+    g_assert(content_cache_table == 0);
+
+    memset(&content_cache_stat, 0, sizeof(content_cache_stat));
+    content_cache_max_size = max_size;
+    content_cache_max_item_size = max_size / SC_CONTENT_CACHE_ITEM_PART;
+
+    if (max_size > 0)
+        content_cache_table = g_hash_table_new_full(_sc_content_cache_hash, _sc_content_cache_equal, 0, _sc_content_cache_item_free);
+    CONTENT_CACHE_UNLOCK
+}
+
+void sc_content_cache_shutdown()
+{
+    CONTENT_CACHE_LOCK
+    g_queue_clear(&content_cache_lru);
+    if (content_cache_table != 0)
+    {
+        g_hash_table_destroy(content_cache_table);
+        content_cache_table = 0;
+    }
+    content_cache_max_size = 0;
+    content_cache_max_item_size = 0;
+    CONTENT_CACHE_UNLOCK
+}
+
+void sc_content_cache_clear()
+{
+    CONTENT_CACHE_LOCK
+    g_queue_clear(&content_cache_lru);
+    if (content_cache_table != 0)
+        g_hash_table_remove_all(content_cache_table);
+    content_cache_stat.size = 0;
+    content_cache_stat.items = 0;
+    CONTENT_CACHE_UNLOCK
+}
+
+sc_bool sc_content_cache_get(const sc_check_sum *check_sum, sc_stream **stream)
+{
+    sc_content_cache_item *item = 0;
+
+    CONTENT_CACHE_LOCK
+    if (content_cache_table == 0)
+    {
+        CONTENT_CACHE_UNLOCK
+        return SC_FALSE;
+    }
+
+    item = (sc_content_cache_item*)g_hash_table_lookup(content_cache_table, check_sum);
+    if (item == 0)
+    {
+        content_cache_stat.misses++;
+        CONTENT_CACHE_UNLOCK
+        return SC_FALSE;
+    }
+
+    // move content to the head of recently used list
+    g_queue_unlink(&content_cache_lru, item->lru_link);
+    g_queue_push_head_link(&content_cache_lru, item->lru_link);
+
+    *stream = sc_stream_memory_new_bytes(item->data, SC_STREAM_READ);
+    content_cache_stat.hits++;
+    CONTENT_CACHE_UNLOCK
+
+    return SC_TRUE;
+}
+
+sc_bool sc_content_cache_append(const sc_check_sum *check_sum, sc_stream **stream)
+{
+    sc_content_cache_item *item = 0;
+    sc_uint32 length = 0, read = 0, data_read = 0;
+    sc_char *data = 0;
+    GBytes *bytes = 0;
+
+    g_assert(stream != 0 && *stream != 0);
+
+    if (content_cache_max_item_size == 0)
+        return SC_FALSE;
+
+    // read content out of lock, it can take a time
+    if (sc_stream_get_length(*stream, &length) != SC_RESULT_OK || length > content_cache_max_item_size)
+        return SC_FALSE;
+
+    data = g_new(sc_char, MAX(length, 1));
+    while (read < length)
+    {
+        if (sc_stream_read_data(*stream, data + read, length - read, &data_read) != SC_RESULT_OK || data_read == 0)
+            break;
+        read += data_read;
+    }
+
+    if (read != length)
+    {
+        g_free(data);
+        sc_stream_seek(*stream, SC_STREAM_SEEK_SET, 0);
+        return SC_FALSE;
+    }
+
+    bytes = g_bytes_new_take(data, length);
+
+    CONTENT_CACHE_LOCK
+    // cache can be disabled or content can be appended by another thread
+    if (content_cache_table != 0 && g_hash_table_lookup(content_cache_table, check_sum) == 0)
+    {
+        item = g_new0(sc_content_cache_item, 1);
+        item->check_sum = *check_sum;
+        item->data = g_bytes_ref(bytes);
+
+        g_queue_push_head(&content_cache_lru, item);
+        item->lru_link = content_cache_lru.head;
+        g_hash_table_insert(content_cache_table, &item->check_sum, item);
+
+        content_cache_stat.size += length;
+        content_cache_stat.items++;
+
+        _sc_content_cache_evict();
+    }
+    CONTENT_CACHE_UNLOCK
+
+    sc_stream_free(*stream);
+    *stream = sc_stream_memory_new_bytes(bytes, SC_STREAM_READ);
+    g_bytes_unref(bytes);
+
+    return SC_TRUE;
+}
+
+void sc_content_cache_get_stat(sc_content_cache_stat *stat)
+{
+    g_assert(stat != 0);
+
+    CONTENT_CACHE_LOCK
+    *stat = content_cache_stat;
+    CONTENT_CACHE_UNLOCK
+}
@@ -0,0 +1,70 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _sc_content_cache_h_
+#define _sc_content_cache_h_
+
+#include "sc_types.h"
+#include "sc_stream.h"
+
+//! Statistics of link contents cache
+struct _sc_content_cache_stat
+{
+    sc_uint64 hits;       // amount of content reads, that was done from cache
+    sc_uint64 misses;     // amount of content reads, that was done from file memory
+    sc_uint64 size;       // size of cached data in bytes
+    sc_uint64 items;      // amount of cached contents
+};
+
+typedef struct _sc_content_cache_stat sc_content_cache_stat;
+
+/*! Initialize cache of link contents. Contents are immutable for their checksums, so cached data
+ * never becomes invalid and cache just keeps the least recently used contents in memory.
+ * @param max_size Maximum size of cached data in bytes. Zero value disables cache
+ */
+void sc_content_cache_initialize(sc_uint64 max_size);
+
+//! Shutdown cache of link contents and free all cached data
+void sc_content_cache_shutdown();
+
+//! Removes all contents from cache
+void sc_content_cache_clear();
+
+/*! Creates stream to read cached content
+ * @param check_sum Checksum of content
+ * @param stream Pointer to created memory stream. It reads shared cached buffer without copying
+ * @return If content found in cache, then returns SC_TRUE; otherwise returns SC_FALSE
+ */
+sc_bool sc_content_cache_get(const sc_check_sum *check_sum, sc_stream **stream);
+
+/*! Reads content from \p stream into cache and replaces \p stream with memory stream over cached data.
+ * Contents, that are too large for cache, aren't read and \p stream stays unchanged
+ * @param check_sum Checksum of content
+ * @param stream Pointer to stream, that was opened to read content from file memory
+ * @return If content has been appended into cache, then returns SC_TRUE; otherwise returns SC_FALSE
+ */
+sc_bool sc_content_cache_append(const sc_check_sum *check_sum, sc_stream **stream);
+
+//! Returns statistics of cache usage
+void sc_content_cache_get_stat(sc_content_cache_stat *stat);
+
+#endif
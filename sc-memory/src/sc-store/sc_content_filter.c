@@ -0,0 +1,178 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#include "sc_content_filter.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <memory.h>
+
+#define SC_CONTENT_FILTER_WORDS (SC_CONTENT_FILTER_SIZE / 32)
+
+//! Header of filter file
+struct _sc_content_filter_header
+{
+    sc_uint32 signature;
+    sc_uint32 size;     // SC_CONTENT_FILTER_SIZE
+    sc_uint32 hashes;   // SC_CONTENT_FILTER_HASHES
+};
+
+typedef struct _sc_content_filter_header sc_content_filter_header;
+
+const sc_uint32 content_filter_signature = 0x52544c46; // FLTR
+
+// bits are changed with atomic operations, so filter can be used from different threads without locks
+volatile gint *content_filter_bits = 0;
+volatile gint content_filter_active = FALSE;
+
+// ----------------------------------------------
+
+//! Calculates bit positions with double hashing
+void _sc_content_filter_hash(const sc_check_sum *check_sum, sc_uint32 *h1, sc_uint32 *h2)
+{
+    sc_uint64 hash = 14695981039346656037ULL;
+    sc_uint8 i;
+
+    for (i = 0; i < check_sum->len; ++i)
+        hash = (hash ^ (sc_uint8)check_sum->data[i]) * 1099511628211ULL;
+
+    *h1 = (sc_uint32)hash;
+    *h2 = (sc_uint32)(hash >> 32) | 1;
+}
+
+// ----------------------------------------------
+
+void sc_content_filter_initialize()
+{
+    g_assert(content_filter_bits == 0);
+
+    content_filter_bits = g_new0(gint, SC_CONTENT_FILTER_WORDS);
+    g_atomic_int_set(&content_filter_active, FALSE);
+}
+
+void sc_content_filter_shutdown()
+{
+    g_atomic_int_set(&content_filter_active, FALSE);
+    g_free((gpointer)content_filter_bits);
+    content_filter_bits = 0;
+}
+
+sc_bool sc_content_filter_load(const sc_char *path)
+{
+    gchar *content = 0;
+    gsize size = 0;
+    sc_content_filter_header header;
+
+    g_assert(content_filter_bits != 0);
+
+    if (g_file_get_contents(path, &content, &size, 0) == FALSE)
+        return SC_FALSE;
+
+    // saved filter can't be used after next changes
+    g_remove(path);
+
+    if (size != sizeof(header) + SC_CONTENT_FILTER_WORDS * sizeof(gint))
+    {
+        g_free(content);
+        return SC_FALSE;
+    }
+
+    memcpy(&header, content, sizeof(header));
+    if (header.signature != content_filter_signature || header.size != SC_CONTENT_FILTER_SIZE || header.hashes != SC_CONTENT_FILTER_HASHES)
+    {
+        g_free(content);
+        return SC_FALSE;
+    }
+
+    memcpy((gpointer)content_filter_bits, content + sizeof(header), SC_CONTENT_FILTER_WORDS * sizeof(gint));
+    g_free(content);
+
+    g_atomic_int_set(&content_filter_active, TRUE);
+
+    return SC_TRUE;
+}
+
+sc_bool sc_content_filter_save(const sc_char *path)
+{
+    gchar *content = 0;
+    gsize size = sizeof(sc_content_filter_header) + SC_CONTENT_FILTER_WORDS * sizeof(gint);
+    sc_content_filter_header header;
+    gboolean result = FALSE;
+
+    if (sc_content_filter_is_active() == SC_FALSE)
+        return SC_FALSE;
+
+    header.signature = content_filter_signature;
+    header.size = SC_CONTENT_FILTER_SIZE;
+    header.hashes = SC_CONTENT_FILTER_HASHES;
+
+    content = g_new(gchar, size);
+    memcpy(content, &header, sizeof(header));
+    memcpy(content + sizeof(header), (gconstpointer)content_filter_bits, SC_CONTENT_FILTER_WORDS * sizeof(gint));
+
+    result = g_file_set_contents(path, content, size, 0);
+    g_free(content);
+
+    return result == TRUE ? SC_TRUE : SC_FALSE;
+}
+
+void sc_content_filter_set_active(sc_bool active)
+{
+    g_atomic_int_set(&content_filter_active, active == SC_TRUE ? TRUE : FALSE);
+}
+
+sc_bool sc_content_filter_is_active()
+{
+    return g_atomic_int_get(&content_filter_active) == TRUE ? SC_TRUE : SC_FALSE;
+}
+
+void sc_content_filter_append(const sc_check_sum *check_sum)
+{
+    sc_uint32 h1, h2, bit, i;
+
+    g_assert(content_filter_bits != 0);
+
+    _sc_content_filter_hash(check_sum, &h1, &h2);
+    for (i = 0; i < SC_CONTENT_FILTER_HASHES; ++i)
+    {
+        bit = (h1 + i * h2) % SC_CONTENT_FILTER_SIZE;
+        g_atomic_int_or((volatile guint*)&content_filter_bits[bit / 32], 1u << (bit % 32));
+    }
+}
+
+sc_bool sc_content_filter_check(const sc_check_sum *check_sum)
+{
+    sc_uint32 h1, h2, bit, i;
+
+    if (sc_content_filter_is_active() == SC_FALSE)
+        return SC_TRUE;
+
+    _sc_content_filter_hash(check_sum, &h1, &h2);
+    for (i = 0; i < SC_CONTENT_FILTER_HASHES; ++i)
+    {
+        bit = (h1 + i * h2) % SC_CONTENT_FILTER_SIZE;
+        if ((g_atomic_int_get(&content_filter_bits[bit / 32]) & (1u << (bit % 32))) == 0)
+            return SC_FALSE;
+    }
+
+    return SC_TRUE;
+}
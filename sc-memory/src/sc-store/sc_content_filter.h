@@ -0,0 +1,66 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _sc_content_filter_h_
+#define _sc_content_filter_h_
+
+#include "sc_types.h"
+
+/*! Bloom filter over checksums of stored contents. It answers "definitely not stored" without
+ * access to file memory. Filter can't remove values, so removed contents just pass through it.
+ * Filter is active only when it knows about all stored contents: it was created for empty repository,
+ * loaded from file or rebuilt from segments. Inactive filter passes any checksum.
+ */
+
+//! Initialize empty inactive filter
+void sc_content_filter_initialize();
+
+//! Shutdown filter and free its memory
+void sc_content_filter_shutdown();
+
+/*! Loads filter from file and activates it. File is removed after loading, so filter becomes
+ * invalid if process stops without sc_content_filter_save call
+ * @return If filter loaded, then returns SC_TRUE; otherwise returns SC_FALSE
+ */
+sc_bool sc_content_filter_load(const sc_char *path);
+
+/*! Saves active filter into file
+ * @return If filter saved, then returns SC_TRUE; otherwise returns SC_FALSE
+ */
+sc_bool sc_content_filter_save(const sc_char *path);
+
+//! Activates or deactivates filter
+void sc_content_filter_set_active(sc_bool active);
+
+//! Returns SC_TRUE, if filter is active
+sc_bool sc_content_filter_is_active();
+
+//! Appends checksum of stored content into filter
+void sc_content_filter_append(const sc_check_sum *check_sum);
+
+/*! Checks if content with specified checksum can be stored
+ * @return If filter is inactive or checksum could be appended, then returns SC_TRUE;
+ * otherwise returns SC_FALSE, that means content isn't stored
+ */
+sc_bool sc_content_filter_check(const sc_check_sum *check_sum);
+
+#endif
@@ -38,12 +38,24 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 //! Use two oriented arc list
 #define USE_TWO_ORIENTED_ARC_LIST 1
 
+//! Cache number of input and output arcs for each element (calculates on storage load, isn't saved into segments)
+#define USE_ELEMENT_DEGREE_CACHE 1
+
+//! Store small sc-link contents (up to CONTENT_DATA_LEN bytes) inside sc-element instead of file memory
+#define USE_INLINE_LINK_CONTENT 1
+
+//! Reject searches of contents, that aren't stored, with Bloom filter over checksums (rebuilds from segments, if it wasn't saved)
+#define USE_CONTENT_FILTER 1
+
 #define SEGMENT_EMPTY_SEARCH_LEN 1024 // number of element in two directions to search next empty slot in segment
 #define SEGMENT_EMPTY_BUFFER_SIZE 2048 // number of empty slot buffer for segment
 #define SEGMENT_EMPTY_MAX_UPDATE_THREADS 8 // number of maximum threads to update empty slots
 
 #define SEGMENT_CACHE_SIZE      8  // size of segments cache (segments with empty slots)
 #define MAX_PATH_LENGTH 1024
+#define SC_LINK_CONTENT_BUFFER_SIZE 65536 // size of buffer, that used to copy and hash sc-link content
+#define SC_CONTENT_FILTER_SIZE (1 << 24) // number of bits in filter of stored contents (2 Mb of memory)
+#define SC_CONTENT_FILTER_HASHES 4 // number of bits, that set in filter for each content
 
 #define SC_CONCURRENCY_LEVEL   32  // max number of independent threads that can work in parallel with memory
 
@@ -45,8 +45,15 @@ struct _sc_arc_info
 #endif
 
 
+/*! Flag of sc_content::len, that means that data field contains content itself (it's length
+ * stored in other bits of len). Checksum length is always less than this value.
+ */
+#define SC_CONTENT_INLINE 0x80
+#define SC_CONTENT_INLINE_LEN_MASK 0x7f
+
 /*! Structure to store content information
  * Data field store checksum for data, that stores in specified sc-link.
+ * If len contains SC_CONTENT_INLINE flag, then data field contains content of sc-link.
  */
 struct _sc_content
 {
@@ -96,6 +103,19 @@ struct _sc_element
     };
 };
 
+#if USE_ELEMENT_DEGREE_CACHE
+/*! Structure to store number of live output and input arcs of sc-element.
+ * It stores separately from segments, so repository format doesn't depend on it.
+ */
+struct _sc_element_degree
+{
+    sc_uint32 out_count; // number of output arcs, that wasn't deleted
+    sc_uint32 in_count; // number of input arcs, that wasn't deleted
+};
+
+typedef struct _sc_element_degree sc_element_degree;
+#endif
+
 void sc_element_set_type(sc_element *element,
                          sc_type type);
 
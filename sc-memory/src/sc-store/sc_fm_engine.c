@@ -67,3 +67,20 @@ sc_result sc_fm_save(const sc_fm_engine *engine)
     g_assert(engine->funcSave);
     return engine->funcSave(engine);
 }
+
+sc_bool sc_fm_support_temp_stream(const sc_fm_engine *engine)
+{
+    return (engine->funcStreamCreateTemp != 0 && engine->funcStreamCommit != 0) ? SC_TRUE : SC_FALSE;
+}
+
+sc_result sc_fm_stream_new_temp(const sc_fm_engine *engine, sc_stream **stream, void **temp_handle)
+{
+    g_assert(engine->funcStreamCreateTemp != 0);
+    return engine->funcStreamCreateTemp(engine, stream, temp_handle);
+}
+
+sc_result sc_fm_stream_commit(const sc_fm_engine *engine, void *temp_handle, const sc_check_sum *check_sum)
+{
+    g_assert(engine->funcStreamCommit != 0);
+    return engine->funcStreamCommit(engine, temp_handle, check_sum);
+}
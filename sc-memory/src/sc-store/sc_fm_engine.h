@@ -82,5 +82,29 @@ sc_result sc_fm_clear(const sc_fm_engine *engine);
  */
 sc_result sc_fm_save(const sc_fm_engine *engine);
 
+/*! Check if file memory engine supports temporary streams (data can be written before checksum calculated)
+ * @param engine Pointer to used file memory engine
+ * @returns If engine supports temporary streams, then returns SC_TRUE; otherwise returns SC_FALSE
+ */
+sc_bool sc_fm_support_temp_stream(const sc_fm_engine *engine);
+
+/*! Create stream to write data, which checksum isn't known yet
+ * @param engine Pointer to used file memory engine
+ * @param stream Pointer that will contains created stream
+ * @param temp_handle Pointer that will contains handle of temporary data
+ * @returns If stream created, then resurns SC_RESULT_OK; otherwise returns error code
+ * @attention Returned stream need to be free before \p temp_handle will be passed to sc_fm_stream_commit
+ */
+sc_result sc_fm_stream_new_temp(const sc_fm_engine *engine, sc_stream **stream, void **temp_handle);
+
+/*! Stores data of temporary stream under specified checksum
+ * @param engine Pointer to used file memory engine
+ * @param temp_handle Handle of temporary data, that returned by sc_fm_stream_new_temp
+ * @param check_sum Pointer to data checksum. If it's a null pointer, then temporary data will be discarded
+ * @returns If data stored, then resurns SC_RESULT_OK; otherwise returns error code
+ * @remarks After calling this function \p temp_handle woldn't be a valid
+ */
+sc_result sc_fm_stream_commit(const sc_fm_engine *engine, void *temp_handle, const sc_check_sum *check_sum);
+
 
 #endif // _sc_fm_engine_h_
@@ -39,6 +39,10 @@ typedef sc_result (*fEngineClear)(const sc_fm_engine *engine);
 typedef sc_result (*fEngineSave)(const sc_fm_engine *engine);
 //! Pointer to function, that destroys storage specified data
 typedef sc_result (*fEngineDestroyData)(const sc_fm_engine *engine);
+//! Pointer to function, that create stream to write data, which checksum isn't known yet
+typedef sc_result (*fEngineStreamCreateTemp)(const sc_fm_engine *engine, sc_stream **stream, void **temp_handle);
+//! Pointer to function, that stores data written into temporary stream under specified checksum (discards it if checksum is null)
+typedef sc_result (*fEngineStreamCommit)(const sc_fm_engine *engine, void *temp_handle, const sc_check_sum *check_sum);
 
 
 /*! Sturcture that provides file memory storage engine object
@@ -55,6 +59,10 @@ struct _sc_fm_engine
     fEngineClear funcClear;
     fEngineSave funcSave;
     fEngineDestroyData funcDestroyData;
+
+    // optional functions (can be null)
+    fEngineStreamCreateTemp funcStreamCreateTemp;
+    fEngineStreamCommit funcStreamCommit;
 };
 
 
@@ -25,6 +25,9 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include "sc_stream_file.h"
 #include "sc_config.h"
 #include "sc_fm_engine.h"
+#include "sc_link_helpers.h"
+#include "sc_content_cache.h"
+#include "sc_content_filter.h"
 
 #include <stdlib.h>
 #include <memory.h>
@@ -38,6 +41,10 @@ sc_fm_engine *fm_engine = 0;
 
 const gchar *seg_dir = "segments";
 const gchar *addr_key_group = "addrs";
+const gchar *checksum_file = "checksum";
+const gchar *checksum_names[] = { "sha256", "fast" };
+const gchar *content_filter_file = "contents_filter";
+gchar content_filter_path[MAX_PATH_LENGTH + 1];
 
 GModule *fm_engine_module = 0;
 gchar fm_engine_module_path[MAX_PATH_LENGTH + 1];
@@ -46,6 +53,54 @@ typedef void (*fFmEngineShutdownFunc)();
 
 // ----------------------------------------------
 
+sc_checksum_algorithm _sc_fs_storage_checksum_from_name(const gchar *name)
+{
+    if (g_str_equal(name, checksum_names[SC_CHECKSUM_FAST]))
+        return SC_CHECKSUM_FAST;
+
+    return SC_CHECKSUM_SHA256;
+}
+
+/*! Choose checksum algorithm for repository. Checksums of existing contents are used to find them,
+ * so algorithm is stored in repository on creation and config value is used just for new repositories.
+ */
+sc_bool _sc_fs_storage_setup_checksum(sc_bool clear)
+{
+    gchar path[MAX_PATH_LENGTH + 1];
+    gchar *content = 0;
+    sc_checksum_algorithm algorithm = _sc_fs_storage_checksum_from_name(sc_config_fm_checksum());
+
+    g_snprintf(path, MAX_PATH_LENGTH, "%s/%s", repo_path, checksum_file);
+
+    if (clear == SC_FALSE)
+    {
+        if (g_file_get_contents(path, &content, 0, 0) == TRUE)
+        {
+            algorithm = _sc_fs_storage_checksum_from_name(g_strstrip(content));
+            g_free(content);
+        }else if (g_file_test(segments_path, G_FILE_TEST_IS_DIR))
+        {
+            // repository was created before checksum algorithm became configurable
+            algorithm = SC_CHECKSUM_SHA256;
+        }
+
+        if (!g_str_equal(checksum_names[algorithm], sc_config_fm_checksum()))
+            g_message("\tRepository uses '%s' checksum, configured value is ignored", checksum_names[algorithm]);
+    }
+
+    g_message("\tChecksum algorithm: %s", checksum_names[algorithm]);
+    sc_link_set_checksum_algorithm(algorithm);
+
+    if (g_mkdir_with_parents(repo_path, SC_DIR_PERMISSIONS) < 0 ||
+        g_file_set_contents(path, checksum_names[algorithm], -1, 0) == FALSE)
+    {
+        g_critical("Can't write checksum algorithm into: %s", path);
+        return SC_FALSE;
+    }
+
+    return SC_TRUE;
+}
+
 sc_bool sc_fs_storage_initialize(const gchar *path, sc_bool clear)
 {
     g_message("Initialize sc-storage from path: %s", path);
@@ -131,7 +186,21 @@ sc_bool sc_fs_storage_initialize(const gchar *path, sc_bool clear)
         }
     }
 
-    return SC_TRUE;
+    if (sc_config_fm_cache_size() > 0)
+        g_message("\tContent cache size: %u Mb", sc_config_fm_cache_size());
+    sc_content_cache_initialize((sc_uint64)sc_config_fm_cache_size() * 1024 * 1024);
+
+#if USE_CONTENT_FILTER
+    sc_content_filter_initialize();
+    g_snprintf(content_filter_path, MAX_PATH_LENGTH, "%s/%s", repo_path, content_filter_file);
+    // filter of empty repository is valid, otherwise it would be rebuilt by sc-storage if wasn't saved
+    if (clear == SC_TRUE)
+        sc_content_filter_set_active(SC_TRUE);
+    else if (sc_content_filter_load(content_filter_path) == SC_TRUE)
+        g_message("\tContent filter loaded");
+#endif
+
+    return _sc_fs_storage_setup_checksum(clear);
 }
 
 sc_bool sc_fs_storage_shutdown(sc_segment **segments)
@@ -145,6 +214,13 @@ sc_bool sc_fs_storage_shutdown(sc_segment **segments)
     if (sc_fm_save(fm_engine) != SC_RESULT_OK)
         g_critical("Error while saves file memory");
 
+    sc_content_cache_shutdown();
+
+#if USE_CONTENT_FILTER
+    if (sc_content_filter_save(content_filter_path) == SC_FALSE)
+        g_message("Content filter isn't saved, it would be rebuilt on next start");
+    sc_content_filter_shutdown();
+#endif
 
     g_free(repo_path);
 
@@ -263,37 +339,40 @@ sc_bool sc_fs_storage_write_to_path(sc_segment **segments)
 sc_result sc_fs_storage_write_content(sc_addr addr, const sc_check_sum *check_sum, const sc_stream *stream)
 {
     // write content into file
-    sc_char buffer[1024];
+    sc_char *buffer = 0;
     sc_uint32 data_read, data_write;
     sc_stream *out_stream = 0;
+    sc_result res = SC_RESULT_OK;
 
     if (sc_fm_stream_new(fm_engine, check_sum, SC_STREAM_WRITE, &out_stream) == SC_RESULT_OK)
     {
         g_assert(out_stream != 0);
+        buffer = g_new(sc_char, SC_LINK_CONTENT_BUFFER_SIZE);
         // reset input stream positon to begin
         sc_stream_seek(stream, SC_STREAM_SEEK_SET, 0);
 
         while (sc_stream_eof(stream) == SC_FALSE)
         {
-            if (sc_stream_read_data(stream, buffer, 1024, &data_read) == SC_RESULT_ERROR)
+            if (sc_stream_read_data(stream, buffer, SC_LINK_CONTENT_BUFFER_SIZE, &data_read) == SC_RESULT_ERROR)
             {
-                sc_stream_free(out_stream);
-                return SC_RESULT_ERROR;
+                res = SC_RESULT_ERROR;
+                break;
             }
 
-            if (sc_stream_write_data(out_stream, buffer, data_read, &data_write) == SC_RESULT_ERROR)
-            {
-                sc_stream_free(out_stream);
-                return SC_RESULT_ERROR;
-            }
+            if (data_read == 0)
+                break;
 
-            if (data_read != data_write)
+            if (sc_stream_write_data(out_stream, buffer, data_read, &data_write) == SC_RESULT_ERROR || data_read != data_write)
             {
-                sc_stream_free(out_stream);
-                return SC_RESULT_ERROR;
+                res = SC_RESULT_ERROR;
+                break;
             }
         }
         sc_stream_free(out_stream);
+        g_free(buffer);
+
+        if (res != SC_RESULT_OK)
+            return res;
 
         return sc_fs_storage_add_content_addr(addr, check_sum);
     }
@@ -301,22 +380,87 @@ sc_result sc_fs_storage_write_content(sc_addr addr, const sc_check_sum *check_su
     return SC_RESULT_ERROR_IO;
 }
 
+sc_result sc_fs_storage_write_stream(sc_addr addr, const sc_stream *stream, sc_check_sum *check_sum)
+{
+    sc_stream *out_stream = 0;
+    void *temp_handle = 0;
+    sc_bool copied = SC_FALSE;
+
+    g_assert(fm_engine != 0);
+
+    // engine can't store data before checksum is known, so read stream twice
+    if (sc_fm_support_temp_stream(fm_engine) == SC_FALSE)
+    {
+        if (sc_link_calculate_checksum(stream, check_sum) == SC_FALSE)
+            return SC_RESULT_ERROR;
+
+        return sc_fs_storage_write_content(addr, check_sum, stream);
+    }
+
+    if (sc_fm_stream_new_temp(fm_engine, &out_stream, &temp_handle) != SC_RESULT_OK)
+        return SC_RESULT_ERROR_IO;
+
+    g_assert(out_stream != 0);
+    copied = sc_link_copy_calculate_checksum(stream, out_stream, check_sum);
+    sc_stream_free(out_stream);
+
+    if (copied == SC_FALSE)
+    {
+        sc_fm_stream_commit(fm_engine, temp_handle, nullptr);
+        return SC_RESULT_ERROR;
+    }
+
+    if (sc_fm_stream_commit(fm_engine, temp_handle, check_sum) != SC_RESULT_OK)
+        return SC_RESULT_ERROR_IO;
+
+    return sc_fs_storage_add_content_addr(addr, check_sum);
+}
+
 sc_result sc_fs_storage_add_content_addr(sc_addr addr, const sc_check_sum *check_sum)
 {
     g_assert(fm_engine != 0);
+
+#if USE_CONTENT_FILTER
+    sc_content_filter_append(check_sum);
+#endif
     return sc_fm_addr_ref_append(fm_engine, addr, check_sum);
 }
 
+sc_result sc_fs_storage_remove_content_addr(sc_addr addr, const sc_check_sum *check_sum)
+{
+    g_assert(fm_engine != 0);
+    return sc_fm_addr_ref_remove(fm_engine, addr, check_sum);
+}
+
 sc_result sc_fs_storage_find_links_with_content(const sc_check_sum *check_sum, sc_addr **result, sc_uint32 *result_count)
 {
     g_assert(fm_engine != 0);
+
+#if USE_CONTENT_FILTER
+    if (sc_content_filter_check(check_sum) == SC_FALSE)
+    {
+        *result = 0;
+        *result_count = 0;
+        return SC_RESULT_OK;
+    }
+#endif
     return sc_fm_find(fm_engine, check_sum, result, result_count);
 }
 
 sc_result sc_fs_storage_get_checksum_content(const sc_check_sum *check_sum, sc_stream **stream)
 {
+    sc_result result = SC_RESULT_ERROR;
+
     g_assert(fm_engine != 0);
-    return sc_fm_stream_new(fm_engine, check_sum, SC_STREAM_READ, stream);
+
+    if (sc_content_cache_get(check_sum, stream) == SC_TRUE)
+        return SC_RESULT_OK;
+
+    result = sc_fm_stream_new(fm_engine, check_sum, SC_STREAM_READ, stream);
+    if (result == SC_RESULT_OK)
+        sc_content_cache_append(check_sum, stream);
+
+    return result;
 }
 
 
@@ -70,6 +70,15 @@ sc_bool sc_fs_storage_write_to_path(sc_segment **segments);
  */
 sc_result sc_fs_storage_write_content(sc_addr addr, const sc_check_sum *check_sum, const sc_stream *stream);
 
+/*! Write specified stream as content and calculate its checksum. If file memory engine supports
+ * temporary streams, then data read from \p stream just once
+ * @param addr sc-addr of sc-link that contains data
+ * @param stream Pointer to stream that contains data for saving
+ * @param check_sum Pointer to structure, that will contains checksum of saved data
+ * @return If content saved, then return SC_OK; otherwise return one of error code
+ */
+sc_result sc_fs_storage_write_stream(sc_addr addr, const sc_stream *stream, sc_check_sum *check_sum);
+
 /*! Add new sc-addr to content backward links
  * @param addr sc-addr to append to backward links
  * @param check_sum Checksum of content
@@ -77,6 +86,13 @@ sc_result sc_fs_storage_write_content(sc_addr addr, const sc_check_sum *check_su
  */
 sc_result sc_fs_storage_add_content_addr(sc_addr addr, const sc_check_sum *check_sum);
 
+/*! Remove sc-addr from content backward links
+ * @param addr sc-addr to remove from backward links
+ * @param check_sum Checksum of content
+ * @return If sc-addr has been removed from backward links, then return SC_OK; otherwise return error code
+ */
+sc_result sc_fs_storage_remove_content_addr(sc_addr addr, const sc_check_sum *check_sum);
+
 /*! Search sc-link addrs by specified checksum
  * @param check_sum Checksum for search
  * @param result Pointer to result container
@@ -27,14 +27,12 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 GSList *time_stamps_list = 0;
 sc_uint32 time_stamps_count = 0; // store cached value to prevent sequence length calculation
 
-#if SC_INTERNAL_THREADS_SUPPORT
-    GStaticMutex time_stamp_list_mutex = G_STATIC_MUTEX_INIT;
-    #define TIMESTAMP_LIST_LOCK g_static_mutex_lock(&time_stamp_list_mutex);
-    #define TIMESTAMP_LIST_UNLOCK g_static_mutex_unlock(&time_stamp_list_mutex);
-#else
-    #define TIMESTAMP_LIST_LOCK
-    #define TIMESTAMP_LIST_UNLOCK
-#endif
+/* Iterators are used without memory lock, so they can be created in several threads at the same time
+ * (for example, by parallel pattern search). List of time stamps is always locked.
+ */
+GMutex time_stamp_list_mutex; // statically allocated GMutex doesn't need initialization
+#define TIMESTAMP_LIST_LOCK g_mutex_lock(&time_stamp_list_mutex);
+#define TIMESTAMP_LIST_UNLOCK g_mutex_unlock(&time_stamp_list_mutex);
 
 gint _list_compare(gconstpointer a, gconstpointer b)
 {
@@ -66,12 +64,11 @@ void sc_iterator_remove_used_timestamp(sc_uint32 time_stamp)
 sc_uint32 sc_iterator_get_oldest_timestamp()
 {
     sc_uint32 res = 0;
+
+    TIMESTAMP_LIST_LOCK;
     if (time_stamps_count > 0)
-    {
-        TIMESTAMP_LIST_LOCK;
         res = GPOINTER_TO_UINT(time_stamps_list->data);
-        TIMESTAMP_LIST_UNLOCK;
-    }
+    TIMESTAMP_LIST_UNLOCK;
 
     return res;
 }
@@ -26,92 +26,185 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <glib.h>
 
-sc_iterator3* sc_iterator3_f_a_a_new(sc_addr el, sc_type arc_type, sc_type end_type)
+void _sc_iterator3_f_a_a_params(sc_iterator_param *p, sc_addr el, sc_type arc_type, sc_type end_type)
 {
-    sc_iterator_param p1, p2, p3;
-
-    p1.is_type = SC_FALSE;
-    p1.addr = el;
+    p[0].is_type = SC_FALSE;
+    p[0].addr = el;
 
-    p2.is_type = SC_TRUE;
-    p2.type = arc_type;
+    p[1].is_type = SC_TRUE;
+    p[1].type = arc_type;
 
-    p3.is_type = SC_TRUE;
-    p3.type = end_type;
-
-    return sc_iterator3_new(sc_iterator3_f_a_a, p1, p2, p3);
+    p[2].is_type = SC_TRUE;
+    p[2].type = end_type;
 }
 
-sc_iterator3* sc_iterator3_a_a_f_new(sc_type beg_type, sc_type arc_type, sc_addr el)
+void _sc_iterator3_a_a_f_params(sc_iterator_param *p, sc_type beg_type, sc_type arc_type, sc_addr el)
 {
-    sc_iterator_param p1, p2, p3;
+    p[0].is_type = SC_TRUE;
+    p[0].type = beg_type;
 
-    p1.is_type = SC_TRUE;
-    p1.type = beg_type;
+    p[1].is_type = SC_TRUE;
+    p[1].type = arc_type;
 
-    p2.is_type = SC_TRUE;
-    p2.type = arc_type;
-
-    p3.is_type = SC_FALSE;
-    p3.addr = el;
-
-    return sc_iterator3_new(sc_iterator3_a_a_f, p1, p2, p3);
+    p[2].is_type = SC_FALSE;
+    p[2].addr = el;
 }
 
-sc_iterator3* sc_iterator3_f_a_f_new(sc_addr el_beg, sc_type arc_type, sc_addr el_end)
+void _sc_iterator3_f_a_f_params(sc_iterator_param *p, sc_addr el_beg, sc_type arc_type, sc_addr el_end)
 {
-    sc_iterator_param p1, p2, p3;
-
-    p1.is_type = SC_FALSE;
-    p1.addr = el_beg;
+    p[0].is_type = SC_FALSE;
+    p[0].addr = el_beg;
 
-    p2.is_type = SC_TRUE;
-    p2.type = arc_type;
+    p[1].is_type = SC_TRUE;
+    p[1].type = arc_type;
 
-    p3.is_type = SC_FALSE;
-    p3.addr = el_end;
-
-    return sc_iterator3_new(sc_iterator3_f_a_f, p1, p2, p3);
+    p[2].is_type = SC_FALSE;
+    p[2].addr = el_end;
 }
 
-sc_iterator3* sc_iterator3_new(sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+sc_bool _sc_iterator3_check_params(sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
 {
-    // check types
-    if (type > sc_iterator3_f_a_f) return (sc_iterator3*)0;
-
     // check params with template
     switch (type)
     {
     case sc_iterator3_f_a_a:
-        if (p1.is_type || !p2.is_type || !p3.is_type) return (sc_iterator3*)0;
+        if (p1.is_type || !p2.is_type || !p3.is_type) return SC_FALSE;
         break;
     case sc_iterator3_a_a_f:
-        if (!p1.is_type || !p2.is_type || p3.is_type) return (sc_iterator3*)0;
+        if (!p1.is_type || !p2.is_type || p3.is_type) return SC_FALSE;
         break;
     case sc_iterator3_f_a_f:
-        if (p1.is_type || !p2.is_type || p3.is_type) return (sc_iterator3*)0;
+        if (p1.is_type || !p2.is_type || p3.is_type) return SC_FALSE;
         break;
+    default:
+        return SC_FALSE;
     };
 
+    return SC_TRUE;
+}
+
+sc_iterator3* sc_iterator3_f_a_a_new(sc_addr el, sc_type arc_type, sc_type end_type)
+{
+    sc_iterator_param p[3];
+    _sc_iterator3_f_a_a_params(p, el, arc_type, end_type);
+
+    return sc_iterator3_new(sc_iterator3_f_a_a, p[0], p[1], p[2]);
+}
+
+sc_iterator3* sc_iterator3_a_a_f_new(sc_type beg_type, sc_type arc_type, sc_addr el)
+{
+    sc_iterator_param p[3];
+    _sc_iterator3_a_a_f_params(p, beg_type, arc_type, el);
+
+    return sc_iterator3_new(sc_iterator3_a_a_f, p[0], p[1], p[2]);
+}
+
+sc_iterator3* sc_iterator3_f_a_f_new(sc_addr el_beg, sc_type arc_type, sc_addr el_end)
+{
+    sc_iterator_param p[3];
+    _sc_iterator3_f_a_f_params(p, el_beg, arc_type, el_end);
+
+    return sc_iterator3_new(sc_iterator3_f_a_f, p[0], p[1], p[2]);
+}
+
+sc_iterator3* sc_iterator3_new(sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+{
+    // check types and params with template
+    if (_sc_iterator3_check_params(type, p1, p2, p3) == SC_FALSE)
+        return (sc_iterator3*)0;
+
     sc_iterator3 *it = g_new0(sc_iterator3, 1);
+    sc_iterator3_init(it, type, p1, p2, p3);
 
-    it->params[0] = p1;
-    it->params[1] = p2;
-    it->params[2] = p3;
+    return it;
+}
+
+void sc_iterator3_free(sc_iterator3 *it)
+{
+    g_assert(it != 0);
+    sc_iterator3_done(it);
+    g_free(it);
+}
+
+/*! Setup iterator without time stamp registration.
+ * Such iterator can be used just while there are no any changes in memory (for example, to check
+ * or count constructions).
+ */
+sc_bool _sc_iterator3_setup(sc_iterator3 *it, sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+{
+    g_assert(it != 0);
 
+    it->registered = SC_FALSE;
     it->type = type;
     it->time_stamp = sc_storage_get_time_stamp();
 
+    return sc_iterator3_reset(it, p1, p2, p3);
+}
+
+sc_bool sc_iterator3_init(sc_iterator3 *it, sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+{
+    if (_sc_iterator3_setup(it, type, p1, p2, p3) == SC_FALSE)
+        return SC_FALSE;
+
     sc_iterator_add_used_timestamp(it->time_stamp);
+    it->registered = SC_TRUE;
 
-    return it;
+    return SC_TRUE;
 }
 
-void sc_iterator3_free(sc_iterator3 *it)
+sc_bool sc_iterator3_f_a_a_init(sc_iterator3 *it, sc_addr el, sc_type arc_type, sc_type end_type)
+{
+    sc_iterator_param p[3];
+    _sc_iterator3_f_a_a_params(p, el, arc_type, end_type);
+
+    return sc_iterator3_init(it, sc_iterator3_f_a_a, p[0], p[1], p[2]);
+}
+
+sc_bool sc_iterator3_a_a_f_init(sc_iterator3 *it, sc_type beg_type, sc_type arc_type, sc_addr el)
+{
+    sc_iterator_param p[3];
+    _sc_iterator3_a_a_f_params(p, beg_type, arc_type, el);
+
+    return sc_iterator3_init(it, sc_iterator3_a_a_f, p[0], p[1], p[2]);
+}
+
+sc_bool sc_iterator3_f_a_f_init(sc_iterator3 *it, sc_addr el_beg, sc_type arc_type, sc_addr el_end)
+{
+    sc_iterator_param p[3];
+    _sc_iterator3_f_a_f_params(p, el_beg, arc_type, el_end);
+
+    return sc_iterator3_init(it, sc_iterator3_f_a_f, p[0], p[1], p[2]);
+}
+
+sc_bool sc_iterator3_reset(sc_iterator3 *it, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
 {
     g_assert(it != 0);
+
+    if (_sc_iterator3_check_params(it->type, p1, p2, p3) == SC_FALSE)
+        return SC_FALSE;
+
+    it->params[0] = p1;
+    it->params[1] = p2;
+    it->params[2] = p3;
+
+    // empty results means, that iteration starts from the first arc
+    SC_ADDR_MAKE_EMPTY(it->results[0]);
+    SC_ADDR_MAKE_EMPTY(it->results[1]);
+    SC_ADDR_MAKE_EMPTY(it->results[2]);
+
+    return SC_TRUE;
+}
+
+void sc_iterator3_done(sc_iterator3 *it)
+{
+    g_assert(it != 0);
+
+    // iterator, that failed to initialize, didn't register its time stamp
+    if (it->registered == SC_FALSE)
+        return;
+
     sc_iterator_remove_used_timestamp(it->time_stamp);
-    g_free(it);
+    it->registered = SC_FALSE;
 }
 
 sc_bool sc_iterator_param_compare(sc_element *el, sc_addr addr, sc_iterator_param param)
@@ -295,6 +388,96 @@ sc_bool sc_iterator3_next(sc_iterator3 *it)
     return SC_FALSE;
 }
 
+/*! Works like _sc_iterator3_f_a_f_next, but iterates output arcs of begin element.
+ * It's faster, when begin element has less output arcs, then end element has input arcs
+ */
+sc_bool _sc_iterator3_f_a_f_out_next(sc_iterator3 *it)
+{
+    sc_addr arc_addr;
+    sc_element *arc_element = 0;
+
+    it->results[0] = it->params[0].addr;
+    it->results[2] = it->params[2].addr;
+
+    if (SC_ADDR_IS_EMPTY(it->results[1]))
+        arc_addr = sc_storage_get_element(it->params[0].addr, SC_TRUE)->first_out_arc;
+    else
+        arc_addr = sc_storage_get_element(it->results[1], SC_TRUE)->arc.next_out_arc;
+
+    while (SC_ADDR_IS_NOT_EMPTY(arc_addr))
+    {
+        arc_element = sc_storage_get_element(arc_addr, SC_TRUE);
+
+        if ((arc_element->create_time_stamp <= it->time_stamp) &&
+            (arc_element->delete_time_stamp == 0 || arc_element->delete_time_stamp >= it->time_stamp) &&
+            SC_ADDR_IS_EQUAL(it->params[2].addr, arc_element->arc.end) &&
+            (sc_iterator_compare_type(arc_element->type, it->params[1].type))
+           )
+        {
+            it->results[1] = arc_addr;
+            return SC_TRUE;
+        }
+
+        arc_addr = arc_element->arc.next_out_arc;
+    }
+
+    return SC_FALSE;
+}
+
+sc_uint32 sc_iterator3_count(sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+{
+    sc_iterator3 it;
+    sc_uint32 count = 0;
+
+    if (_sc_iterator3_setup(&it, type, p1, p2, p3) == SC_FALSE)
+        return 0;
+
+#if USE_ELEMENT_DEGREE_CACHE
+    // if there are no type restrictions, then each live arc passes, so we can use cached degree
+    if (type == sc_iterator3_f_a_a && p2.type == 0 && p3.type == 0 &&
+        sc_storage_get_element_degree(p1.addr, &count, nullptr) == SC_RESULT_OK)
+        return count;
+
+    if (type == sc_iterator3_a_a_f && p1.type == 0 && p2.type == 0 &&
+        sc_storage_get_element_degree(p3.addr, nullptr, &count) == SC_RESULT_OK)
+        return count;
+
+    count = 0;
+#endif
+
+    while (sc_iterator3_next(&it) == SC_TRUE)
+        count++;
+
+    return count;
+}
+
+sc_bool sc_iterator3_exists(sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+{
+    sc_iterator3 it;
+#if USE_ELEMENT_DEGREE_CACHE
+    sc_uint32 out_count = 0, in_count = 0;
+#endif
+
+    if (_sc_iterator3_setup(&it, type, p1, p2, p3) == SC_FALSE)
+        return SC_FALSE;
+
+#if USE_ELEMENT_DEGREE_CACHE
+    // choose the shortest arcs list to iterate
+    if (type == sc_iterator3_f_a_f &&
+        sc_storage_get_element_degree(p1.addr, &out_count, nullptr) == SC_RESULT_OK &&
+        sc_storage_get_element_degree(p3.addr, nullptr, &in_count) == SC_RESULT_OK)
+    {
+        if (out_count == 0 || in_count == 0)
+            return SC_FALSE;
+
+        if (out_count < in_count)
+            return _sc_iterator3_f_a_f_out_next(&it);
+    }
+#endif
+
+    return sc_iterator3_next(&it);
+}
+
 sc_addr sc_iterator3_value(sc_iterator3 *it, sc_uint vid)
 {
     g_assert(it != 0);
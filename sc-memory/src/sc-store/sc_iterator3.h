@@ -56,6 +56,7 @@ struct _sc_iterator3
     sc_iterator_param params[3]; // parameters array
     sc_addr results[3]; // results array (same size as params)
     sc_uint32 time_stamp; // iterator creation time stamp
+    sc_bool registered; // time stamp was registered in list of used time stamps, so it should be removed on done
 };
 
 /*! Create iterator to find output arcs for specified element
@@ -96,6 +97,66 @@ sc_iterator3* sc_iterator3_new(sc_iterator_type type, sc_iterator_param p1, sc_i
  */
 void sc_iterator3_free(sc_iterator3 *it);
 
+/*! Initialize sc-iterator-3, that allocated by caller (for example on stack).
+ * It doesn't allocate any memory, so it can be used in hot loops instead of sc_iterator3_new
+ * @param it Pointer to iterator structure that need to be initialized
+ * @param type Iterator type (search template)
+ * @param p1 First iterator parameter
+ * @param p2 Second iterator parameter
+ * @param p3 Third iterator parameter
+ * @return If parameters are valid for specified iterator type, then returns SC_TRUE; otherwise returns SC_FALSE
+ * @attention Iterator initialized with this function must be released with sc_iterator3_done (not sc_iterator3_free)
+ */
+sc_bool sc_iterator3_init(sc_iterator3 *it, sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3);
+
+//! Initialize caller allocated iterator to find output arcs. @see sc_iterator3_init, sc_iterator3_f_a_a_new
+sc_bool sc_iterator3_f_a_a_init(sc_iterator3 *it, sc_addr el, sc_type arc_type, sc_type end_type);
+
+//! Initialize caller allocated iterator to find input arcs. @see sc_iterator3_init, sc_iterator3_a_a_f_new
+sc_bool sc_iterator3_a_a_f_init(sc_iterator3 *it, sc_type beg_type, sc_type arc_type, sc_addr el);
+
+//! Initialize caller allocated iterator to find arcs between two elements. @see sc_iterator3_init, sc_iterator3_f_a_f_new
+sc_bool sc_iterator3_f_a_f_init(sc_iterator3 *it, sc_addr el_beg, sc_type arc_type, sc_addr el_end);
+
+/*! Restart iterator with new parameters. Iterator type and time stamp stay the same,
+ * so there are no any allocations or time stamp registrations.
+ * @param it Pointer to initialized iterator
+ * @param p1 First iterator parameter
+ * @param p2 Second iterator parameter
+ * @param p3 Third iterator parameter
+ * @return If parameters are valid for iterator type, then returns SC_TRUE; otherwise returns SC_FALSE
+ * and iterator couldn't be used until next successful reset.
+ * example: it is useful for nested cycles, where inner iterator need to be restarted for each result of outer one
+ */
+sc_bool sc_iterator3_reset(sc_iterator3 *it, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3);
+
+/*! Release iterator, that was initialized by sc_iterator3_init. Memory of iterator structure isn't freed.
+ * @param it Pointer to sc-iterator that need to be released
+ */
+void sc_iterator3_done(sc_iterator3 *it);
+
+/*! Calculates number of constructions, that iterator with specified parameters will return.
+ * Iterator isn't allocated and it time stamp isn't registered. If arcs and elements types are not
+ * specified (0), then number of arcs returns from cached element degree without iteration.
+ * @param type Iterator type (search template)
+ * @param p1 First iterator parameter
+ * @param p2 Second iterator parameter
+ * @param p3 Third iterator parameter
+ * @return Returns number of found constructions. If parameters are invalid, then returns 0
+ */
+sc_uint32 sc_iterator3_count(sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3);
+
+/*! Check if there are any construction, that iterator with specified parameters will return.
+ * Iterator isn't allocated and it time stamp isn't registered. For sc_iterator3_f_a_f the shortest
+ * arcs list (output arcs of begin element, or input arcs of end element) will be used.
+ * @param type Iterator type (search template)
+ * @param p1 First iterator parameter
+ * @param p2 Second iterator parameter
+ * @param p3 Third iterator parameter
+ * @return If construction exists, then returns SC_TRUE; otherwise returns SC_FALSE
+ */
+sc_bool sc_iterator3_exists(sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3);
+
 /*! Go to next iterator result
  * @param it Pointer to iterator that we need to go next result
  * @return Return SC_TRUE, if iterator moved to new results; otherwise return SC_FALSE.
@@ -25,39 +25,58 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <glib.h>
 
-sc_iterator5* sc_iterator5_new(sc_iterator5_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3, sc_iterator_param p4, sc_iterator_param p5)
+void _sc_iterator5_param_addr(sc_iterator_param *p, sc_addr addr)
+{
+    p->is_type = SC_FALSE;
+    p->addr = addr;
+}
+
+void _sc_iterator5_param_type(sc_iterator_param *p, sc_type type)
 {
+    p->is_type = SC_TRUE;
+    p->type = type;
+}
+
+/*! Setup iterator without time stamp registration (see _sc_iterator3_setup)
+ */
+sc_bool _sc_iterator5_setup(sc_iterator5 *it, sc_iterator5_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3, sc_iterator_param p4, sc_iterator_param p5)
+{
+    g_assert(it != 0);
+
+    it->registered = SC_FALSE;
 
     // check params with template
     switch (type)
     {
     case sc_iterator5_f_a_a_a_f:
         if (p1.is_type || !p2.is_type || !p3.is_type || !p4.is_type || p5.is_type)
-            return (sc_iterator5*)nullptr;
+            return SC_FALSE;
         break;
     case sc_iterator5_a_a_f_a_f:
         if (!p1.is_type || !p2.is_type || p3.is_type || !p4.is_type || p5.is_type)
-            return (sc_iterator5*)nullptr;
+            return SC_FALSE;
         break;
     case sc_iterator5_f_a_f_a_f:
         if (p1.is_type || !p2.is_type || p3.is_type || !p4.is_type || p5.is_type)
-            return (sc_iterator5*)nullptr;
+            return SC_FALSE;
         break;
     case sc_iterator5_f_a_f_a_a:
         if (p1.is_type || !p2.is_type || p3.is_type || !p4.is_type || !p5.is_type)
-            return (sc_iterator5*)nullptr;
+            return SC_FALSE;
         break;
     case sc_iterator5_f_a_a_a_a:
         if (p1.is_type || !p2.is_type || !p3.is_type || !p4.is_type || !p5.is_type)
-            return (sc_iterator5*)nullptr;
+            return SC_FALSE;
         break;
     case sc_iterator5_a_a_f_a_a:
         if (!p1.is_type || !p2.is_type || p3.is_type || !p4.is_type || !p5.is_type)
-            return (sc_iterator5*)nullptr;
+            return SC_FALSE;
         break;
+    default:
+        return SC_FALSE;
     };
 
-    sc_iterator5 *it = g_new0(sc_iterator5, 1);
+    memset(it, 0, sizeof(sc_iterator5));
 
     it->params[0] = p1;
     it->params[1] = p2;
@@ -68,445 +87,287 @@ sc_iterator5* sc_iterator5_new(sc_iterator5_type type, sc_iterator_param p1, sc_
     it->type = type;
     it->time_stamp = sc_storage_get_time_stamp();
 
-    // create main cycle iterator
-    switch (type)
-    {
-    case sc_iterator5_f_a_a_a_f:
-        it->it_main = sc_iterator3_f_a_a_new(p1.addr ,p2.type, p3.type);
-        it->it_attr = nullptr;
-        it->results[0] = p1.addr;
-        it->results[4] = p5.addr;
-        break;
-    case sc_iterator5_a_a_f_a_f:
-        it->it_main = sc_iterator3_a_a_f_new(p1.type, p2.type, p3.addr);
-        it->it_attr = nullptr;
-        it->results[2] = p3.addr;
-        it->results[4] = p5.addr;
-        break;
-    case sc_iterator5_f_a_f_a_f:
-        it->it_main = sc_iterator3_f_a_f_new(p1.addr, p2.type, p3.addr);
-        it->it_attr = nullptr;
+    // setup main cycle iterator, it iterates first three elements of construction
+    if (p1.is_type)
+        it->it_main.type = sc_iterator3_a_a_f;
+    else
+        it->it_main.type = p3.is_type ? sc_iterator3_f_a_a : sc_iterator3_f_a_f;
+
+    // setup attribute cycle iterator, it will be restarted for each arc found by main cycle
+    it->it_attr.type = p5.is_type ? sc_iterator3_a_a_f : sc_iterator3_f_a_f;
+    it->attr_active = SC_FALSE;
+
+    // nested iterators use time stamp of sc-iterator5, so they don't register it again
+    it->it_main.time_stamp = it->time_stamp;
+    it->it_attr.time_stamp = it->time_stamp;
+
+    if (sc_iterator3_reset(&it->it_main, p1, p2, p3) == SC_FALSE)
+        return SC_FALSE;
+
+    // store fixed values
+    if (!p1.is_type)
         it->results[0] = p1.addr;
+    if (!p3.is_type)
         it->results[2] = p3.addr;
+    if (!p5.is_type)
         it->results[4] = p5.addr;
-        break;
-    case sc_iterator5_f_a_f_a_a:
-        it->it_main = sc_iterator3_f_a_f_new(p1.addr, p2.type, p3.addr);
-        it->it_attr = nullptr;
-        it->results[0] = p1.addr;
-        it->results[2] = p3.addr;
-        break;
-    case sc_iterator5_a_a_f_a_a:
-        it->it_main = sc_iterator3_a_a_f_new(p1.type,p2.type,p3.addr);
-        it->it_attr = nullptr;
-        it->results[2] = p3.addr;
-        break;
-    case sc_iterator5_f_a_a_a_a:
-        it->it_main = sc_iterator3_f_a_a_new(p1.addr, p2.type, p3.type);
-        it->it_attr = nullptr;
-        it->results[0] = p1.addr;
-        break;
-    };
+
+    return SC_TRUE;
+}
+
+sc_bool sc_iterator5_init(sc_iterator5 *it, sc_iterator5_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3, sc_iterator_param p4, sc_iterator_param p5)
+{
+    if (_sc_iterator5_setup(it, type, p1, p2, p3, p4, p5) == SC_FALSE)
+        return SC_FALSE;
 
     sc_iterator_add_used_timestamp(it->time_stamp);
+    it->registered = SC_TRUE;
 
-    return it;
+    return SC_TRUE;
 }
 
-sc_iterator5* sc_iterator5_f_a_a_a_f_new(sc_addr p1, sc_type p2, sc_type p3, sc_type p4, sc_addr p5)
+sc_iterator5* sc_iterator5_new(sc_iterator5_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3, sc_iterator_param p4, sc_iterator_param p5)
 {
-    sc_iterator_param _p1,_p2,_p3,_p4,_p5;
-    _p1.is_type = SC_FALSE;
-    _p1.addr = p1;
-    _p2.is_type = SC_TRUE;
-    _p2.type = p2;
-    _p3.is_type = SC_TRUE;
-    _p3.type = p3;
-    _p4.is_type = SC_TRUE;
-    _p4.type = p4;
-    _p5.is_type = SC_FALSE;
-    _p5.addr = p5;
-
-    return sc_iterator5_new(sc_iterator5_f_a_a_a_f, _p1, _p2, _p3, _p4, _p5);
+    sc_iterator5 *it = g_new0(sc_iterator5, 1);
+
+    if (sc_iterator5_init(it, type, p1, p2, p3, p4, p5) == SC_FALSE)
+    {
+        g_free(it);
+        return (sc_iterator5*)nullptr;
+    }
+
+    return it;
 }
 
-sc_iterator5* sc_iterator5_a_a_f_a_f_new(sc_type p1, sc_type p2, sc_addr p3, sc_type p4, sc_addr p5)
+sc_bool sc_iterator5_f_a_a_a_f_init(sc_iterator5 *it, sc_addr p1, sc_type p2, sc_type p3, sc_type p4, sc_addr p5)
 {
-    sc_iterator_param _p1,_p2,_p3,_p4,_p5;
-    _p1.is_type = SC_TRUE;
-    _p1.type = p1;
-    _p2.is_type = SC_TRUE;
-    _p2.type = p2;
-    _p3.is_type = SC_FALSE;
-    _p3.addr = p3;
-    _p4.is_type = SC_TRUE;
-    _p4.type = p4;
-    _p5.is_type = SC_FALSE;
-    _p5.addr = p5;
-
-    return sc_iterator5_new(sc_iterator5_a_a_f_a_f, _p1, _p2, _p3, _p4, _p5);
+    sc_iterator_param _p[5];
+    _sc_iterator5_param_addr(&_p[0], p1);
+    _sc_iterator5_param_type(&_p[1], p2);
+    _sc_iterator5_param_type(&_p[2], p3);
+    _sc_iterator5_param_type(&_p[3], p4);
+    _sc_iterator5_param_addr(&_p[4], p5);
+
+    return sc_iterator5_init(it, sc_iterator5_f_a_a_a_f, _p[0], _p[1], _p[2], _p[3], _p[4]);
 }
 
-sc_iterator5* sc_iterator5_f_a_f_a_f_new(sc_addr p1, sc_type p2, sc_addr p3, sc_type p4, sc_addr p5)
+sc_bool sc_iterator5_a_a_f_a_f_init(sc_iterator5 *it, sc_type p1, sc_type p2, sc_addr p3, sc_type p4, sc_addr p5)
 {
-    sc_iterator_param _p1,_p2,_p3,_p4,_p5;
-    _p1.is_type = SC_FALSE;
-    _p1.addr = p1;
-    _p2.is_type = SC_TRUE;
-    _p2.type = p2;
-    _p3.is_type = SC_FALSE;
-    _p3.addr = p3;
-    _p4.is_type = SC_TRUE;
-    _p4.type = p4;
-    _p5.is_type = SC_FALSE;
-    _p5.addr = p5;
-
-    return sc_iterator5_new(sc_iterator5_f_a_f_a_f, _p1, _p2, _p3, _p4, _p5);
+    sc_iterator_param _p[5];
+    _sc_iterator5_param_type(&_p[0], p1);
+    _sc_iterator5_param_type(&_p[1], p2);
+    _sc_iterator5_param_addr(&_p[2], p3);
+    _sc_iterator5_param_type(&_p[3], p4);
+    _sc_iterator5_param_addr(&_p[4], p5);
+
+    return sc_iterator5_init(it, sc_iterator5_a_a_f_a_f, _p[0], _p[1], _p[2], _p[3], _p[4]);
 }
 
-sc_iterator5* sc_iterator5_f_a_f_a_a_new(sc_addr p1, sc_type p2, sc_addr p3, sc_type p4, sc_type p5)
+sc_bool sc_iterator5_f_a_f_a_f_init(sc_iterator5 *it, sc_addr p1, sc_type p2, sc_addr p3, sc_type p4, sc_addr p5)
 {
-    sc_iterator_param _p1,_p2,_p3,_p4,_p5;
-    _p1.is_type = SC_FALSE;
-    _p1.addr = p1;
-    _p2.is_type = SC_TRUE;
-    _p2.type = p2;
-    _p3.is_type = SC_FALSE;
-    _p3.addr = p3;
-    _p4.is_type = SC_TRUE;
-    _p4.type = p4;
-    _p5.is_type = SC_TRUE;
-    _p5.type = p5;
-
-    return sc_iterator5_new(sc_iterator5_f_a_f_a_a, _p1, _p2, _p3, _p4, _p5);
+    sc_iterator_param _p[5];
+    _sc_iterator5_param_addr(&_p[0], p1);
+    _sc_iterator5_param_type(&_p[1], p2);
+    _sc_iterator5_param_addr(&_p[2], p3);
+    _sc_iterator5_param_type(&_p[3], p4);
+    _sc_iterator5_param_addr(&_p[4], p5);
+
+    return sc_iterator5_init(it, sc_iterator5_f_a_f_a_f, _p[0], _p[1], _p[2], _p[3], _p[4]);
 }
 
-sc_iterator5* sc_iterator5_f_a_a_a_a_new(sc_addr p1, sc_type p2, sc_type p3, sc_type p4, sc_type p5)
+sc_bool sc_iterator5_f_a_f_a_a_init(sc_iterator5 *it, sc_addr p1, sc_type p2, sc_addr p3, sc_type p4, sc_type p5)
 {
-    sc_iterator_param _p1,_p2,_p3,_p4,_p5;
-    _p1.is_type = SC_FALSE;
-    _p1.addr = p1;
-    _p2.is_type = SC_TRUE;
-    _p2.type = p2;
-    _p3.is_type = SC_TRUE;
-    _p3.type = p3;
-    _p4.is_type = SC_TRUE;
-    _p4.type = p4;
-    _p5.is_type = SC_TRUE;
-    _p5.type = p5;
-
-    return sc_iterator5_new(sc_iterator5_f_a_a_a_a, _p1, _p2, _p3, _p4, _p5);
+    sc_iterator_param _p[5];
+    _sc_iterator5_param_addr(&_p[0], p1);
+    _sc_iterator5_param_type(&_p[1], p2);
+    _sc_iterator5_param_addr(&_p[2], p3);
+    _sc_iterator5_param_type(&_p[3], p4);
+    _sc_iterator5_param_type(&_p[4], p5);
+
+    return sc_iterator5_init(it, sc_iterator5_f_a_f_a_a, _p[0], _p[1], _p[2], _p[3], _p[4]);
 }
 
-sc_iterator5* sc_iterator5_a_a_f_a_a_new(sc_type p1, sc_type p2, sc_addr p3, sc_type p4, sc_type p5)
+sc_bool sc_iterator5_f_a_a_a_a_init(sc_iterator5 *it, sc_addr p1, sc_type p2, sc_type p3, sc_type p4, sc_type p5)
 {
-    sc_iterator_param _p1,_p2,_p3,_p4,_p5;
-    _p1.is_type = SC_TRUE;
-    _p1.type = p1;
-    _p2.is_type = SC_TRUE;
-    _p2.type = p2;
-    _p3.is_type = SC_FALSE;
-    _p3.addr = p3;
-    _p4.is_type = SC_TRUE;
-    _p4.type = p4;
-    _p5.is_type = SC_TRUE;
-    _p5.type = p5;
-
-    return sc_iterator5_new(sc_iterator5_a_a_f_a_a, _p1, _p2, _p3, _p4, _p5);
+    sc_iterator_param _p[5];
+    _sc_iterator5_param_addr(&_p[0], p1);
+    _sc_iterator5_param_type(&_p[1], p2);
+    _sc_iterator5_param_type(&_p[2], p3);
+    _sc_iterator5_param_type(&_p[3], p4);
+    _sc_iterator5_param_type(&_p[4], p5);
+
+    return sc_iterator5_init(it, sc_iterator5_f_a_a_a_a, _p[0], _p[1], _p[2], _p[3], _p[4]);
 }
 
+sc_bool sc_iterator5_a_a_f_a_a_init(sc_iterator5 *it, sc_type p1, sc_type p2, sc_addr p3, sc_type p4, sc_type p5)
+{
+    sc_iterator_param _p[5];
+    _sc_iterator5_param_type(&_p[0], p1);
+    _sc_iterator5_param_type(&_p[1], p2);
+    _sc_iterator5_param_addr(&_p[2], p3);
+    _sc_iterator5_param_type(&_p[3], p4);
+    _sc_iterator5_param_type(&_p[4], p5);
+
+    return sc_iterator5_init(it, sc_iterator5_a_a_f_a_a, _p[0], _p[1], _p[2], _p[3], _p[4]);
+}
 
-void sc_iterator5_free(sc_iterator5 *it)
+sc_iterator5* sc_iterator5_f_a_a_a_f_new(sc_addr p1, sc_type p2, sc_type p3, sc_type p4, sc_addr p5)
 {
-    g_assert(it != 0);
-    sc_iterator_remove_used_timestamp(it->time_stamp);
+    sc_iterator5 *it = g_new0(sc_iterator5, 1);
+    if (sc_iterator5_f_a_a_a_f_init(it, p1, p2, p3, p4, p5) == SC_TRUE)
+        return it;
 
-    if (it->it_attr != nullptr)
-        sc_iterator3_free(it->it_attr);
-    if (it->it_main != nullptr)
-        sc_iterator3_free(it->it_main);
     g_free(it);
+    return (sc_iterator5*)nullptr;
 }
 
-sc_bool _sc_iterator5_a_a_f_a_f_next(sc_iterator5 *it)
+sc_iterator5* sc_iterator5_a_a_f_a_f_new(sc_type p1, sc_type p2, sc_addr p3, sc_type p4, sc_addr p5)
 {
+    sc_iterator5 *it = g_new0(sc_iterator5, 1);
+    if (sc_iterator5_a_a_f_a_f_init(it, p1, p2, p3, p4, p5) == SC_TRUE)
+        return it;
 
-    SC_ADDR_MAKE_EMPTY(it->results[0])
-    SC_ADDR_MAKE_EMPTY(it->results[1])
-    SC_ADDR_MAKE_EMPTY(it->results[3])
-
-    if (it->it_attr != nullptr && sc_iterator3_next(it->it_attr))
-    {
-        it->results[0] = it->it_main->results[0];
-        it->results[1]=it->it_main->results[1];
-        it->results[3]=it->it_attr->results[1];
-        return SC_TRUE;
-    }else
-    {
-        while( it->it_attr == nullptr || !sc_iterator3_next(it->it_attr))
-        {
-            if (it->it_attr != nullptr)
-            {
-                sc_iterator3_free(it->it_attr);
-                it->it_attr = nullptr;
-            }
-
-            if (!sc_iterator3_next(it->it_main))
-                return SC_FALSE;
-
-            it->it_attr = sc_iterator3_f_a_f_new(it->params[4].addr,
-                                                 it->params[3].type,
-                                                 it->it_main->results[1]);
-            if (it->it_attr != nullptr)
-                continue;
-        }
-        it->results[0] = it->it_main->results[0];
-        it->results[1] = it->it_main->results[1];
-        it->results[3] = it->it_attr->results[1];
-        return SC_TRUE;
-    }
-
-    return SC_FALSE;
+    g_free(it);
+    return (sc_iterator5*)nullptr;
 }
 
-sc_bool _sc_iterator5_f_a_a_a_f_next(sc_iterator5 *it)
+sc_iterator5* sc_iterator5_f_a_f_a_f_new(sc_addr p1, sc_type p2, sc_addr p3, sc_type p4, sc_addr p5)
 {
-    SC_ADDR_MAKE_EMPTY(it->results[1])
-    SC_ADDR_MAKE_EMPTY(it->results[2])
-    SC_ADDR_MAKE_EMPTY(it->results[3])
-
-    if (it->it_attr != nullptr && sc_iterator3_next(it->it_attr))
-    {
-        it->results[1] = it->it_main->results[1];
-        it->results[2] = it->it_main->results[2];
-        it->results[3] = it->it_attr->results[1];
-        return SC_TRUE;
-    }else
-    {
-        while( it->it_attr == nullptr || !sc_iterator3_next(it->it_attr))
-        {
-            if (it->it_attr != nullptr)
-            {
-                sc_iterator3_free(it->it_attr);
-                it->it_attr = nullptr;
-            }
-
-            if (!sc_iterator3_next(it->it_main))
-                return SC_FALSE;
-
-            it->it_attr = sc_iterator3_f_a_f_new(it->params[4].addr,
-                                                 it->params[3].type,
-                                                 it->it_main->results[1]);
-            if (it->it_attr != nullptr)
-                continue;
-        }
-        it->results[1] = it->it_main->results[1];
-        it->results[2] = it->it_main->results[2];
-        it->results[3] = it->it_attr->results[1];
-        return SC_TRUE;
-    }
+    sc_iterator5 *it = g_new0(sc_iterator5, 1);
+    if (sc_iterator5_f_a_f_a_f_init(it, p1, p2, p3, p4, p5) == SC_TRUE)
+        return it;
 
-    return SC_FALSE;
+    g_free(it);
+    return (sc_iterator5*)nullptr;
 }
 
-sc_bool _sc_iterator5_f_a_f_a_f_next(sc_iterator5 *it)
+sc_iterator5* sc_iterator5_f_a_f_a_a_new(sc_addr p1, sc_type p2, sc_addr p3, sc_type p4, sc_type p5)
 {
-    SC_ADDR_MAKE_EMPTY(it->results[1])
-    SC_ADDR_MAKE_EMPTY(it->results[3])
-
-    if (it->it_attr != nullptr && sc_iterator3_next(it->it_attr))
-    {
-        it->results[1] = it->it_main->results[1];
-        it->results[3] = it->it_attr->results[1];
-        return SC_TRUE;
-    }else
-    {
-        while( it->it_attr == nullptr || !sc_iterator3_next(it->it_attr))
-        {
-            if (it->it_attr != nullptr)
-            {
-                sc_iterator3_free(it->it_attr);
-                it->it_attr = nullptr;
-            }
+    sc_iterator5 *it = g_new0(sc_iterator5, 1);
+    if (sc_iterator5_f_a_f_a_a_init(it, p1, p2, p3, p4, p5) == SC_TRUE)
+        return it;
 
-            if (!sc_iterator3_next(it->it_main))
-                return SC_FALSE;
+    g_free(it);
+    return (sc_iterator5*)nullptr;
+}
 
-            it->it_attr = sc_iterator3_f_a_f_new(it->params[4].addr,
-                                                 it->params[3].type,
-                                                 it->it_main->results[1]);
-            if (it->it_attr != nullptr)
-                continue;
-        }
-        it->results[1] = it->it_main->results[1];
-        it->results[3] = it->it_attr->results[1];
-        return SC_TRUE;
-    }
+sc_iterator5* sc_iterator5_f_a_a_a_a_new(sc_addr p1, sc_type p2, sc_type p3, sc_type p4, sc_type p5)
+{
+    sc_iterator5 *it = g_new0(sc_iterator5, 1);
+    if (sc_iterator5_f_a_a_a_a_init(it, p1, p2, p3, p4, p5) == SC_TRUE)
+        return it;
 
-    return SC_FALSE;
+    g_free(it);
+    return (sc_iterator5*)nullptr;
 }
 
-sc_bool _sc_iterator5_f_a_f_a_a_next(sc_iterator5 *it)
+sc_iterator5* sc_iterator5_a_a_f_a_a_new(sc_type p1, sc_type p2, sc_addr p3, sc_type p4, sc_type p5)
 {
-    SC_ADDR_MAKE_EMPTY(it->results[1])
-    SC_ADDR_MAKE_EMPTY(it->results[3])
-    SC_ADDR_MAKE_EMPTY(it->results[4])
+    sc_iterator5 *it = g_new0(sc_iterator5, 1);
+    if (sc_iterator5_a_a_f_a_a_init(it, p1, p2, p3, p4, p5) == SC_TRUE)
+        return it;
 
-    if (it->it_attr != nullptr && sc_iterator3_next(it->it_attr))
-    {
-        it->results[1] = it->it_main->results[1];
-        it->results[3] = it->it_attr->results[1];
-        it->results[4] = it->it_attr->results[0];
-        return SC_TRUE;
-    }else
-    {
-        while( it->it_attr == nullptr || !sc_iterator3_next(it->it_attr))
-        {
-            if (it->it_attr != nullptr)
-            {
-                sc_iterator3_free(it->it_attr);
-                it->it_attr = nullptr;
-            }
+    g_free(it);
+    return (sc_iterator5*)nullptr;
+}
 
-            if (!sc_iterator3_next(it->it_main))
-                return SC_FALSE;
+void sc_iterator5_done(sc_iterator5 *it)
+{
+    g_assert(it != 0);
 
-            it->it_attr = sc_iterator3_a_a_f_new(it->params[4].type,
-                                               it->params[3].type,
-                                               it->it_main->results[1]);
-            if (it->it_attr != nullptr)
-                continue;
-        }
-        it->results[1] = it->it_main->results[1];
-        it->results[3] = it->it_attr->results[1];
-        it->results[4] = it->it_attr->results[0];
-        return SC_TRUE;
-    }
+    // iterator, that failed to initialize, didn't register its time stamp
+    if (it->registered == SC_FALSE)
+        return;
 
-    return SC_FALSE;
+    // nested iterators share time stamp with sc-iterator5, so just one time stamp need to be removed
+    sc_iterator_remove_used_timestamp(it->time_stamp);
+    it->registered = SC_FALSE;
 }
 
-sc_bool _sc_iterator5_f_a_a_a_a_next(sc_iterator5 *it)
+void sc_iterator5_free(sc_iterator5 *it)
 {
-    SC_ADDR_MAKE_EMPTY(it->results[1])
-    SC_ADDR_MAKE_EMPTY(it->results[2])
-    SC_ADDR_MAKE_EMPTY(it->results[3])
-    SC_ADDR_MAKE_EMPTY(it->results[4])
-
-    if (it->it_attr != nullptr && sc_iterator3_next(it->it_attr))
-    {
-        it->results[1] = it->it_main->results[1];
-        it->results[2] = it->it_main->results[2];
-        it->results[3] = it->it_attr->results[1];
-        it->results[4] = it->it_attr->results[0];
-        return SC_TRUE;
-    }else
-    {
-        while(it->it_attr == nullptr || !sc_iterator3_next(it->it_attr))
-        {
-            if (it->it_attr != nullptr)
-            {
-                sc_iterator3_free(it->it_attr);
-                it->it_attr = nullptr;
-            }
+    g_assert(it != 0);
+    sc_iterator5_done(it);
+    g_free(it);
+}
 
-            if (!sc_iterator3_next(it->it_main))
-                return SC_FALSE;
+/*! Restarts attribute iterator for current result of main cycle.
+ * Attribute iterator searches arcs from 5th element (or element of 5th type) to the arc,
+ * that was found by main cycle.
+ */
+sc_bool _sc_iterator5_attr_reset(sc_iterator5 *it)
+{
+    sc_iterator_param arc_param;
 
-            it->it_attr = sc_iterator3_a_a_f_new(it->params[4].type,
-                                                 it->params[3].type,
-                                                 it->it_main->results[1]);
-            if (it->it_attr != nullptr)
-                continue;
-        }
-        it->results[1] = it->it_main->results[1];
-        it->results[2] = it->it_main->results[2];
-        it->results[3] = it->it_attr->results[1];
-        it->results[4] = it->it_attr->results[0];
-        return SC_TRUE;
-    }
+    arc_param.is_type = SC_FALSE;
+    arc_param.addr = it->it_main.results[1];
 
-    return SC_FALSE;
+    return sc_iterator3_reset(&it->it_attr, it->params[4], it->params[3], arc_param);
 }
 
-sc_bool _sc_iterator5_a_a_f_a_a_next(sc_iterator5 *it)
+sc_bool sc_iterator5_next(sc_iterator5 *it)
 {
+    sc_uint32 i = 0;
 
-    SC_ADDR_MAKE_EMPTY(it->results[1])
-    SC_ADDR_MAKE_EMPTY(it->results[0])
-    SC_ADDR_MAKE_EMPTY(it->results[3])
-    SC_ADDR_MAKE_EMPTY(it->results[4])
+    g_assert(it != 0);
 
-    if (it->it_attr != nullptr && sc_iterator3_next(it->it_attr))
-    {
-        it->results[0] = it->it_main->results[0];
-        it->results[1] = it->it_main->results[1];
-        it->results[3] = it->it_attr->results[1];
-        it->results[4] = it->it_attr->results[0];
-        return SC_TRUE;
-    }else
+    while (it->attr_active == SC_FALSE || sc_iterator3_next(&it->it_attr) == SC_FALSE)
     {
-        while(it->it_attr == nullptr || !sc_iterator3_next(it->it_attr))
+        it->attr_active = SC_FALSE;
+
+        if (sc_iterator3_next(&it->it_main) == SC_FALSE)
         {
-            if (it->it_attr != nullptr)
+            // clear results, that wasn't fixed by iterator parameters
+            for (i = 0; i < 5; ++i)
             {
-                sc_iterator3_free(it->it_attr);
-                it->it_attr = nullptr;
+                if (it->params[i].is_type)
+                    SC_ADDR_MAKE_EMPTY(it->results[i]);
             }
-            if (!sc_iterator3_next(it->it_main))
-                return SC_FALSE;
-
-            it->it_attr = sc_iterator3_a_a_f_new(it->params[4].type,
-                                                 it->params[3].type,
-                                                 it->it_main->results[1]);
-            if (it->it_attr != nullptr)
-                continue;
+            return SC_FALSE;
         }
-        it->results[0] = it->it_main->results[0];
-        it->results[1] = it->it_main->results[1];
-        it->results[3] = it->it_attr->results[1];
-        it->results[4] = it->it_attr->results[0];
-        return SC_TRUE;
+
+        it->attr_active = _sc_iterator5_attr_reset(it);
     }
 
-    return SC_FALSE;
-}
+    // main cycle iterator contains fixed values too, so just copy all of them
+    it->results[0] = it->it_main.results[0];
+    it->results[1] = it->it_main.results[1];
+    it->results[2] = it->it_main.results[2];
+    it->results[3] = it->it_attr.results[1];
+    it->results[4] = it->it_attr.results[0];
 
+    return SC_TRUE;
+}
 
-sc_bool sc_iterator5_next(sc_iterator5 *it)
+sc_addr sc_iterator5_value(sc_iterator5 *it, sc_uint vid)
 {
     g_assert(it != 0);
+    g_assert(it->results != 0);
+    g_assert(vid < 5);
 
+    return it->results[vid];
+}
 
-    switch (it->type)
-    {
-    case sc_iterator5_f_a_a_a_f:
-        return _sc_iterator5_f_a_a_a_f_next(it);
-
-    case sc_iterator5_a_a_f_a_f:
-        return _sc_iterator5_a_a_f_a_f_next(it);
-
-    case sc_iterator5_f_a_f_a_f:
-        return _sc_iterator5_f_a_f_a_f_next(it);
-
-    case sc_iterator5_f_a_f_a_a:
-        return _sc_iterator5_f_a_f_a_a_next(it);
+sc_uint32 sc_iterator5_count(sc_iterator5_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3, sc_iterator_param p4, sc_iterator_param p5)
+{
+    sc_iterator5 it;
+    sc_uint32 count = 0;
 
-    case sc_iterator5_f_a_a_a_a:
-        return _sc_iterator5_f_a_a_a_a_next(it);
+    if (_sc_iterator5_setup(&it, type, p1, p2, p3, p4, p5) == SC_FALSE)
+        return 0;
 
-    case sc_iterator5_a_a_f_a_a:
-        return _sc_iterator5_a_a_f_a_a_next(it);
-    };
+    while (sc_iterator5_next(&it) == SC_TRUE)
+        count++;
 
-    return SC_FALSE;
+    return count;
 }
 
-sc_addr sc_iterator5_value(sc_iterator5 *it, sc_uint vid)
+sc_bool sc_iterator5_exists(sc_iterator5_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3, sc_iterator_param p4, sc_iterator_param p5)
 {
-    g_assert(it != 0);
-    g_assert(it->results != 0);
-    g_assert(vid < 5);
+    sc_iterator5 it;
 
-    return it->results[vid];
+    if (_sc_iterator5_setup(&it, type, p1, p2, p3, p4, p5) == SC_FALSE)
+        return SC_FALSE;
+
+    return sc_iterator5_next(&it);
 }
@@ -43,9 +43,11 @@ struct _sc_iterator5
     sc_iterator5_type type; // iterator type (search template)
     sc_iterator_param params[5]; // parameters array
     sc_addr results[5]; // results array (same size as params)
-    sc_iterator3* it_main; //iterator for main cycle
-    sc_iterator3* it_attr; //iterator for attribute cycle
+    sc_iterator3 it_main; //iterator for main cycle
+    sc_iterator3 it_attr; //iterator for attribute cycle (restarts in place for each main cycle result)
+    sc_bool attr_active; // flag, that attribute iterator started for current main cycle result
     sc_uint32 time_stamp;
+    sc_bool registered; // time stamp was registered in list of used time stamps, so it should be removed on done
 };
 
 typedef struct _sc_iterator5 sc_iterator5;
@@ -135,4 +137,39 @@ sc_addr sc_iterator5_value(sc_iterator5 *it, sc_uint vid);
  */
 void sc_iterator5_free(sc_iterator5 *it);
 
+/*! Functions to initialize sc-iterator5, that allocated by caller (for example on stack).
+ * Parameters are the same as in sc_iterator5_*_new functions. Nested iterators are stored
+ * in sc-iterator5 structure, so there are no any allocations.
+ * @param it Pointer to iterator structure that need to be initialized
+ * @return If iterator initialized, then returns SC_TRUE; otherwise returns SC_FALSE
+ * @attention Iterator initialized with these functions must be released with sc_iterator5_done (not sc_iterator5_free)
+ */
+sc_bool sc_iterator5_a_a_f_a_f_init(sc_iterator5 *it, sc_type p1, sc_type p2, sc_addr p3, sc_type p4, sc_addr p5);
+sc_bool sc_iterator5_f_a_a_a_f_init(sc_iterator5 *it, sc_addr p1, sc_type p2, sc_type p3, sc_type p4, sc_addr p5);
+sc_bool sc_iterator5_f_a_f_a_f_init(sc_iterator5 *it, sc_addr p1, sc_type p2, sc_addr p3, sc_type p4, sc_addr p5);
+sc_bool sc_iterator5_f_a_f_a_a_init(sc_iterator5 *it, sc_addr p1, sc_type p2, sc_addr p3, sc_type p4, sc_type p5);
+sc_bool sc_iterator5_f_a_a_a_a_init(sc_iterator5 *it, sc_addr p1, sc_type p2, sc_type p3, sc_type p4, sc_type p5);
+sc_bool sc_iterator5_a_a_f_a_a_init(sc_iterator5 *it, sc_type p1, sc_type p2, sc_addr p3, sc_type p4, sc_type p5);
+
+/*! Release iterator, that was initialized by one of sc_iterator5_*_init functions.
+ * Memory of iterator structure isn't freed.
+ * @param it Pointer to sc-iterator that need to be released
+ */
+void sc_iterator5_done(sc_iterator5 *it);
+
+/*! Count constructions, that iterator with specified parameters will return.
+ * Iterator isn't allocated and it time stamp isn't registered.
+ * @param type sc-iterator5 type
+ * @param p1-p5 Iterator parameters (the same as in sc_iterator5_new)
+ * @return Returns number of found constructions. If parameters are invalid, then returns 0
+ */
+sc_uint32 sc_iterator5_count(sc_iterator5_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3, sc_iterator_param p4, sc_iterator_param p5);
+
+/*! Check if there are any construction, that iterator with specified parameters will return.
+ * @param type sc-iterator5 type
+ * @param p1-p5 Iterator parameters (the same as in sc_iterator5_new)
+ * @return If construction exists, then returns SC_TRUE; otherwise returns SC_FALSE
+ */
+sc_bool sc_iterator5_exists(sc_iterator5_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3, sc_iterator_param p4, sc_iterator_param p5);
+
 #endif // SC_ITERATOR5_H
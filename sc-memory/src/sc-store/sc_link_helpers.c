@@ -21,6 +21,7 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "sc_link_helpers.h"
+#include "sc_defines.h"
 
 #include <stdlib.h>
 #include <memory.h>
@@ -28,41 +29,270 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 
 #define SC_DEFAULT_CHECKSUM G_CHECKSUM_SHA256
 
+sc_checksum_algorithm checksum_algorithm = SC_CHECKSUM_SHA256;
+
+// --- fast hash ---
+/* Four independent 64-bit lanes consume 32-byte stripes (the inner loop has no dependencies
+ * between lanes, so it pipelines well), then lanes are mixed twice to get 128 bits of result.
+ * It isn't a cryptographic hash and is used just to identify contents.
+ */
+#define SC_FAST_HASH_PRIME1 0x9E3779B185EBCA87ULL
+#define SC_FAST_HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define SC_FAST_HASH_PRIME3 0x165667B19E3779F9ULL
+#define SC_FAST_HASH_PRIME4 0x85EBCA77C2B2AE63ULL
+#define SC_FAST_HASH_PRIME5 0x27D4EB2F165667C5ULL
+#define SC_FAST_HASH_STRIPE 32
+
+typedef struct
+{
+    sc_uint64 lanes[4];
+    sc_uint8 tail[SC_FAST_HASH_STRIPE];
+    sc_uint32 tail_len;
+    sc_uint64 total_len;
+} sc_fast_hash;
+
+#define SC_FAST_HASH_ROTL(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static sc_uint64 _sc_fast_hash_read64(const sc_uint8 *p)
+{
+    // little-endian read, so checksum doesn't depend on platform
+    return (sc_uint64)p[0] | ((sc_uint64)p[1] << 8) | ((sc_uint64)p[2] << 16) | ((sc_uint64)p[3] << 24) |
+           ((sc_uint64)p[4] << 32) | ((sc_uint64)p[5] << 40) | ((sc_uint64)p[6] << 48) | ((sc_uint64)p[7] << 56);
+}
+
+static sc_uint64 _sc_fast_hash_round(sc_uint64 acc, sc_uint64 input)
+{
+    acc += input * SC_FAST_HASH_PRIME2;
+    acc = SC_FAST_HASH_ROTL(acc, 31);
+    return acc * SC_FAST_HASH_PRIME1;
+}
+
+static sc_uint64 _sc_fast_hash_merge(sc_uint64 acc, sc_uint64 lane)
+{
+    acc ^= _sc_fast_hash_round(0, lane);
+    return acc * SC_FAST_HASH_PRIME1 + SC_FAST_HASH_PRIME4;
+}
+
+static sc_uint64 _sc_fast_hash_avalanche(sc_uint64 h)
+{
+    h ^= h >> 33;
+    h *= SC_FAST_HASH_PRIME2;
+    h ^= h >> 29;
+    h *= SC_FAST_HASH_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+static void _sc_fast_hash_init(sc_fast_hash *hash)
+{
+    hash->lanes[0] = SC_FAST_HASH_PRIME1 + SC_FAST_HASH_PRIME2;
+    hash->lanes[1] = SC_FAST_HASH_PRIME2;
+    hash->lanes[2] = 0;
+    hash->lanes[3] = 0 - SC_FAST_HASH_PRIME1;
+    hash->tail_len = 0;
+    hash->total_len = 0;
+}
+
+static void _sc_fast_hash_stripes(sc_fast_hash *hash, const sc_uint8 *data, sc_uint32 count)
+{
+    sc_uint64 v0 = hash->lanes[0], v1 = hash->lanes[1], v2 = hash->lanes[2], v3 = hash->lanes[3];
+    const sc_uint8 *end = data + count * SC_FAST_HASH_STRIPE;
+
+    for (; data < end; data += SC_FAST_HASH_STRIPE)
+    {
+        v0 = _sc_fast_hash_round(v0, _sc_fast_hash_read64(data));
+        v1 = _sc_fast_hash_round(v1, _sc_fast_hash_read64(data + 8));
+        v2 = _sc_fast_hash_round(v2, _sc_fast_hash_read64(data + 16));
+        v3 = _sc_fast_hash_round(v3, _sc_fast_hash_read64(data + 24));
+    }
+
+    hash->lanes[0] = v0;
+    hash->lanes[1] = v1;
+    hash->lanes[2] = v2;
+    hash->lanes[3] = v3;
+}
+
+static void _sc_fast_hash_update(sc_fast_hash *hash, const sc_uint8 *data, sc_uint32 len)
+{
+    sc_uint32 n = 0;
+
+    hash->total_len += len;
+
+    // complete stripe from previous update
+    if (hash->tail_len > 0)
+    {
+        n = MIN(len, SC_FAST_HASH_STRIPE - hash->tail_len);
+        memcpy(hash->tail + hash->tail_len, data, n);
+        hash->tail_len += n;
+        data += n;
+        len -= n;
+
+        if (hash->tail_len < SC_FAST_HASH_STRIPE)
+            return;
+
+        _sc_fast_hash_stripes(hash, hash->tail, 1);
+        hash->tail_len = 0;
+    }
+
+    n = len / SC_FAST_HASH_STRIPE;
+    _sc_fast_hash_stripes(hash, data, n);
+
+    hash->tail_len = len - n * SC_FAST_HASH_STRIPE;
+    memcpy(hash->tail, data + n * SC_FAST_HASH_STRIPE, hash->tail_len);
+}
+
+static sc_uint64 _sc_fast_hash_finish_half(const sc_fast_hash *hash, sc_uint32 order, sc_uint64 seed)
+{
+    const sc_uint64 *v = hash->lanes;
+    sc_uint64 h;
+    sc_uint32 i = 0;
+
+    if (order == 0)
+    {
+        h = SC_FAST_HASH_ROTL(v[0], 1) + SC_FAST_HASH_ROTL(v[1], 7) + SC_FAST_HASH_ROTL(v[2], 12) + SC_FAST_HASH_ROTL(v[3], 18);
+        h = _sc_fast_hash_merge(h, v[0]);
+        h = _sc_fast_hash_merge(h, v[1]);
+        h = _sc_fast_hash_merge(h, v[2]);
+        h = _sc_fast_hash_merge(h, v[3]);
+    }else
+    {
+        h = SC_FAST_HASH_ROTL(v[3], 1) + SC_FAST_HASH_ROTL(v[2], 7) + SC_FAST_HASH_ROTL(v[1], 12) + SC_FAST_HASH_ROTL(v[0], 18);
+        h = _sc_fast_hash_merge(h, v[3] ^ v[1]);
+        h = _sc_fast_hash_merge(h, v[2] ^ v[0]);
+        h = _sc_fast_hash_merge(h, v[1]);
+        h = _sc_fast_hash_merge(h, v[0]);
+    }
+
+    h += hash->total_len ^ seed;
+
+    for (i = 0; i + 8 <= hash->tail_len; i += 8)
+    {
+        h ^= _sc_fast_hash_round(seed, _sc_fast_hash_read64(hash->tail + i));
+        h = SC_FAST_HASH_ROTL(h, 27) * SC_FAST_HASH_PRIME1 + SC_FAST_HASH_PRIME4;
+    }
+
+    for (; i < hash->tail_len; ++i)
+    {
+        h ^= (sc_uint64)hash->tail[i] * SC_FAST_HASH_PRIME5;
+        h = SC_FAST_HASH_ROTL(h, 11) * SC_FAST_HASH_PRIME1;
+    }
+
+    return _sc_fast_hash_avalanche(h);
+}
+
+static void _sc_fast_hash_finish(const sc_fast_hash *hash, sc_check_sum *check_sum)
+{
+    static const char digits[] = "0123456789abcdef";
+    sc_uint64 h[2];
+    sc_uint32 i;
+
+    h[0] = _sc_fast_hash_finish_half(hash, 0, 0);
+    h[1] = _sc_fast_hash_finish_half(hash, 1, SC_FAST_HASH_PRIME3);
+
+    // tag symbol and 31 hex digits (124 bits) of hash
+    check_sum->len = SC_MAX_CHECKSUM_LEN;
+    check_sum->data[0] = SC_CHECKSUM_FAST_TAG;
+    for (i = 1; i < SC_MAX_CHECKSUM_LEN; ++i)
+    {
+        sc_uint32 bit = (i - 1) * 4;
+        check_sum->data[i] = digits[(h[bit / 64] >> (60 - bit % 64)) & 0xf];
+    }
+}
+
+// --- checksum ---
+void sc_link_set_checksum_algorithm(sc_checksum_algorithm algorithm)
+{
+    checksum_algorithm = algorithm;
+}
+
+sc_checksum_algorithm sc_link_get_checksum_algorithm()
+{
+    return checksum_algorithm;
+}
+
+sc_checksum_algorithm sc_link_checksum_algorithm(const sc_check_sum *check_sum)
+{
+    g_assert(check_sum != 0);
+
+    if (check_sum->len > 0 && check_sum->data[0] == SC_CHECKSUM_FAST_TAG)
+        return SC_CHECKSUM_FAST;
+
+    return SC_CHECKSUM_SHA256;
+}
+
 sc_bool sc_link_calculate_checksum(const sc_stream *stream, sc_check_sum *check_sum)
 {
-    sc_char buffer[1024];
-    sc_uint32 data_read;
+    return sc_link_hash_stream(stream, nullptr, checksum_algorithm, check_sum);
+}
+
+sc_bool sc_link_copy_calculate_checksum(const sc_stream *stream, const sc_stream *out_stream, sc_check_sum *check_sum)
+{
+    return sc_link_hash_stream(stream, out_stream, checksum_algorithm, check_sum);
+}
+
+sc_bool sc_link_hash_stream(const sc_stream *stream, const sc_stream *out_stream, sc_checksum_algorithm algorithm, sc_check_sum *check_sum)
+{
+    sc_char *buffer = 0;
+    sc_uint32 data_read, data_write;
     const gchar *result = 0;
-    GChecksum *checksum = g_checksum_new(SC_DEFAULT_CHECKSUM);
+    sc_bool res = SC_TRUE;
+    GChecksum *checksum = 0;
+    sc_fast_hash fast_hash;
 
     g_assert(stream != 0);
     g_assert(check_sum != 0);
-    g_checksum_reset(checksum);
+
+    buffer = g_new(sc_char, SC_LINK_CONTENT_BUFFER_SIZE);
+    if (algorithm == SC_CHECKSUM_FAST)
+        _sc_fast_hash_init(&fast_hash);
+    else
+        checksum = g_checksum_new(SC_DEFAULT_CHECKSUM);
 
     sc_stream_seek(stream, SC_STREAM_SEEK_SET, 0);
 
     while (sc_stream_eof(stream) == SC_FALSE)
     {
-        if (sc_stream_read_data(stream, buffer, 1024, &data_read) == SC_RESULT_ERROR)
+        if (sc_stream_read_data(stream, buffer, SC_LINK_CONTENT_BUFFER_SIZE, &data_read) == SC_RESULT_ERROR)
         {
-            g_checksum_free(checksum);
-            return SC_FALSE;
+            res = SC_FALSE;
+            break;
         }
 
-        g_checksum_update(checksum, (guchar*)buffer, data_read);
+        if (data_read == 0)
+            break;
+
+        if (checksum != 0)
+            g_checksum_update(checksum, (guchar*)buffer, data_read);
+        else
+            _sc_fast_hash_update(&fast_hash, (sc_uint8*)buffer, data_read);
+
+        if (out_stream != nullptr)
+        {
+            if (sc_stream_write_data(out_stream, buffer, data_read, &data_write) == SC_RESULT_ERROR || data_read != data_write)
+            {
+                res = SC_FALSE;
+                break;
+            }
+        }
     }
 
-    // store results
-    check_sum->len = g_checksum_type_get_length(SC_DEFAULT_CHECKSUM);
-    result = g_checksum_get_string(checksum);
-    memcpy(&(check_sum->data[0]), result, check_sum->len);
+    if (res == SC_TRUE)
+    {
+        // store results
+        if (checksum != 0)
+        {
+            check_sum->len = g_checksum_type_get_length(SC_DEFAULT_CHECKSUM);
+            result = g_checksum_get_string(checksum);
+            memcpy(&(check_sum->data[0]), result, check_sum->len);
+        }else
+            _sc_fast_hash_finish(&fast_hash, check_sum);
+    }
 
-    g_checksum_free(checksum);
+    if (checksum != 0)
+        g_checksum_free(checksum);
+    g_free(buffer);
 
     sc_stream_seek(stream, SC_STREAM_SEEK_SET, 0);
 
-    return SC_TRUE;
+    return res;
 }
-
-
-
@@ -27,6 +27,21 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include "sc_stream.h"
 
 
+/*! Setup algorithm, that will be used to calculate checksums of new contents
+ * @param algorithm Checksum algorithm
+ * @remarks Algorithm is stored in repository and can't be changed for existing repository,
+ * because contents are found by checksum
+ */
+void sc_link_set_checksum_algorithm(sc_checksum_algorithm algorithm);
+
+//! Returns algorithm, that used to calculate checksums of new contents
+sc_checksum_algorithm sc_link_get_checksum_algorithm();
+
+/*! Returns algorithm, that was used to calculate specified checksum
+ * @param check_sum Pointer to checksum
+ */
+sc_checksum_algorithm sc_link_checksum_algorithm(const sc_check_sum *check_sum);
+
 /*! Caclulates checksum for data in stream
  * @param stream Pointer to data stream for checksum calculation
  * @param check_sum Pointer to stucture, that contains calculated checksum
@@ -35,5 +50,24 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
  */
 sc_bool sc_link_calculate_checksum(const sc_stream *stream, sc_check_sum *check_sum);
 
+/*! Copies data from one stream into another and calculates checksum of copied data in one pass
+ * @param stream Pointer to data stream for checksum calculation
+ * @param out_stream Pointer to stream, that will receive data. If it's a null pointer, then data just hashed
+ * @param check_sum Pointer to stucture, that contains calculated checksum
+ *
+ * @return If data copied and checksum calculated, then return SC_TRUE; otherwise return SC_FALSE
+ */
+sc_bool sc_link_copy_calculate_checksum(const sc_stream *stream, const sc_stream *out_stream, sc_check_sum *check_sum);
+
+/*! Calculates checksum for data in stream with specified algorithm
+ * @param stream Pointer to data stream for checksum calculation
+ * @param out_stream Pointer to stream, that will receive data. Can be a null pointer
+ * @param algorithm Checksum algorithm
+ * @param check_sum Pointer to stucture, that contains calculated checksum
+ *
+ * @return If checksum calculated, then return SC_TRUE; otherwise return SC_FALSE
+ */
+sc_bool sc_link_hash_stream(const sc_stream *stream, const sc_stream *out_stream, sc_checksum_algorithm algorithm, sc_check_sum *check_sum);
+
 
 #endif
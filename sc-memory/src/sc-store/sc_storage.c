@@ -27,8 +27,10 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include "sc_element.h"
 #include "sc_fs_storage.h"
 #include "sc_link_helpers.h"
+#include "sc_stream_memory.h"
 #include "sc_event.h"
 #include "sc_config.h"
+#include "sc_content_filter.h"
 #include "sc_iterator.h"
 
 #include "sc_event/sc_event_private.h"
@@ -49,6 +51,11 @@ sc_int32 seg_cache[SEGMENT_CACHE_SIZE];  // cache of segments, that has empty sl
 sc_uint storage_time_stamp = 1;
 sc_bool is_initialized = SC_FALSE;
 
+#if USE_ELEMENT_DEGREE_CACHE
+// arrays of cached element degrees (one array per segment, with SEGMENT_SIZE items)
+sc_element_degree **segments_degree = 0;
+#endif
+
 
 // ----------------------------------- SEGMENTS cache --------------------------
 void _sc_storage_segment_cache_init()
@@ -90,6 +97,80 @@ void _sc_storage_append_segment_to_cache(sc_addr_seg seg)
 }
 
 
+// ----------------------------------- DEGREE cache ---------------------------
+#if USE_ELEMENT_DEGREE_CACHE
+sc_element_degree* _sc_storage_get_degree(sc_addr addr)
+{
+    if (addr.seg >= SC_ADDR_SEG_MAX || segments_degree[addr.seg] == nullptr)
+        return (sc_element_degree*)0;
+
+    return &(segments_degree[addr.seg][addr.offset]);
+}
+
+void _sc_storage_degree_segment_new(sc_addr_seg seg)
+{
+    if (segments_degree[seg] == nullptr)
+        segments_degree[seg] = g_new0(sc_element_degree, SEGMENT_SIZE);
+}
+
+void _sc_storage_degree_arc_append(sc_addr beg, sc_addr end)
+{
+    sc_element_degree *degree = _sc_storage_get_degree(beg);
+    if (degree != nullptr)
+        degree->out_count++;
+
+    degree = _sc_storage_get_degree(end);
+    if (degree != nullptr)
+        degree->in_count++;
+}
+
+void _sc_storage_degree_arc_remove(sc_addr beg, sc_addr end)
+{
+    sc_element_degree *degree = _sc_storage_get_degree(beg);
+    if (degree != nullptr && degree->out_count > 0)
+        degree->out_count--;
+
+    degree = _sc_storage_get_degree(end);
+    if (degree != nullptr && degree->in_count > 0)
+        degree->in_count--;
+}
+
+//! Calculates degrees of all loaded elements. Degrees aren't saved, so it need to be called after segments loading
+void _sc_storage_degree_rebuild()
+{
+    sc_uint32 s_idx, e_idx;
+    sc_element *el;
+
+    for (s_idx = 0; s_idx < segments_num; ++s_idx)
+    {
+        if (segments[s_idx] == nullptr) continue; // skip segments, that are not loaded
+        _sc_storage_degree_segment_new(s_idx);
+    }
+
+    for (s_idx = 0; s_idx < segments_num; ++s_idx)
+    {
+        if (segments[s_idx] == nullptr) continue;
+        for (e_idx = 0; e_idx < SEGMENT_SIZE; ++e_idx)
+        {
+            el = &(segments[s_idx]->elements[e_idx]);
+            if ((el->type & sc_type_arc_mask) && el->delete_time_stamp == 0)
+                _sc_storage_degree_arc_append(el->arc.begin, el->arc.end);
+        }
+    }
+}
+
+void _sc_storage_degree_destroy()
+{
+    sc_uint idx;
+
+    for (idx = 0; idx < SC_ADDR_SEG_MAX; idx++)
+        g_free(segments_degree[idx]);
+
+    g_free(segments_degree);
+    segments_degree = 0;
+}
+#endif
+
 // -----------------------------------------------------------------------------
 
 /* Updates segment information:
@@ -127,6 +208,71 @@ void sc_storage_update_segments()
 // -----------------------------------------------------------------------------
 
 
+/*! Returns checksum of sc-link content
+ * @returns If sc-link has content, then returns SC_TRUE; otherwise returns SC_FALSE
+ */
+sc_bool _sc_storage_get_link_checksum(const sc_element *el, sc_check_sum *check_sum)
+{
+#if USE_INLINE_LINK_CONTENT
+    sc_stream *stream = 0;
+    sc_bool result = SC_FALSE;
+#endif
+
+    if (el->content.len == 0)
+        return SC_FALSE;
+
+#if USE_INLINE_LINK_CONTENT
+    // checksum of inline content isn't stored
+    if (el->content.len & SC_CONTENT_INLINE)
+    {
+        stream = sc_stream_memory_new(el->content.data, el->content.len & SC_CONTENT_INLINE_LEN_MASK, SC_STREAM_READ, SC_FALSE);
+        result = sc_link_calculate_checksum(stream, check_sum);
+        sc_stream_free(stream);
+        return result;
+    }
+#endif
+
+    check_sum->len = el->content.len;
+    memcpy(check_sum->data, el->content.data, check_sum->len);
+
+    return SC_TRUE;
+}
+
+#if USE_CONTENT_FILTER
+//! Appends contents of all sc-links into content filter. Filter stays inactive, if some segments aren't loaded
+void _sc_storage_content_filter_rebuild()
+{
+    sc_uint32 s_idx, e_idx, count = 0;
+    sc_element *el;
+    sc_check_sum check_sum;
+
+    for (s_idx = 0; s_idx < segments_num; ++s_idx)
+    {
+        if (segments[s_idx] == nullptr)
+        {
+            g_message("\tContent filter is disabled, because not all segments are loaded");
+            return;
+        }
+    }
+
+    for (s_idx = 0; s_idx < segments_num; ++s_idx)
+    {
+        for (e_idx = 0; e_idx < SEGMENT_SIZE; ++e_idx)
+        {
+            el = &(segments[s_idx]->elements[e_idx]);
+            if ((el->type & sc_type_link) && el->delete_time_stamp == 0 && _sc_storage_get_link_checksum(el, &check_sum) == SC_TRUE)
+            {
+                sc_content_filter_append(&check_sum);
+                count++;
+            }
+        }
+    }
+
+    sc_content_filter_set_active(SC_TRUE);
+    g_message("\tContent filter rebuilt: %u sc-links", count);
+}
+#endif
+
 sc_bool sc_storage_initialize(const char *path, sc_bool clear)
 {
     g_assert( segments == (sc_segment**)0 );
@@ -142,6 +288,16 @@ sc_bool sc_storage_initialize(const char *path, sc_bool clear)
     if (clear == SC_FALSE)
         sc_fs_storage_read_from_path(segments, &segments_num);
 
+#if USE_ELEMENT_DEGREE_CACHE
+    segments_degree = g_new0(sc_element_degree*, SC_ADDR_SEG_MAX);
+    _sc_storage_degree_rebuild();
+#endif
+
+#if USE_CONTENT_FILTER
+    if (sc_content_filter_is_active() == SC_FALSE)
+        _sc_storage_content_filter_rebuild();
+#endif
+
     storage_time_stamp = 1;
 
     is_initialized = SC_TRUE;
@@ -166,6 +322,10 @@ void sc_storage_shutdown()
 
     _sc_storage_segment_cache_destroy();
 
+#if USE_ELEMENT_DEGREE_CACHE
+    _sc_storage_degree_destroy();
+#endif
+
     g_free(segments);
     segments = (sc_segment**)0;
 
@@ -226,6 +386,7 @@ void sc_storage_update_segment_queue()
 sc_element* sc_storage_append_el_into_segments(sc_element *element, sc_addr *addr)
 {
     sc_segment *segment = 0;
+    sc_element *res = 0;
 
     g_assert( addr != 0 );
     SC_ADDR_MAKE_EMPTY(*addr);
@@ -240,21 +401,30 @@ sc_element* sc_storage_append_el_into_segments(sc_element *element, sc_addr *add
     if (_sc_storage_get_segment_from_cache(&addr->seg) == SC_TRUE)
     {
         segment = sc_storage_get_segment(addr->seg, SC_TRUE);
-        return sc_segment_append_element(segment, element, &addr->offset);
-    }
+        res = sc_segment_append_element(segment, element, &addr->offset);
+    }else
+    {
+        //! @todo maximum segments reached
+        if (segments_num >= sc_config_get_max_loaded_segments())
+            return nullptr;
 
-    //! @todo maximum segments reached
-    if (segments_num >= sc_config_get_max_loaded_segments())
-        return nullptr;
+        // if element still not added, then create new segment and append element into it
+        segment = sc_segment_new(segments_num);
+        addr->seg = segments_num;
+        segments[segments_num++] = segment;
+
+        _sc_storage_append_segment_to_cache(addr->seg);
 
-    // if element still not added, then create new segment and append element into it
-    segment = sc_segment_new(segments_num);
-    addr->seg = segments_num;
-    segments[segments_num++] = segment;
+        res = sc_segment_append_element(segment, element, &addr->offset);
+    }
 
-    _sc_storage_append_segment_to_cache(addr->seg);
+#if USE_ELEMENT_DEGREE_CACHE
+    // slot can be used by garbage element before, so reset it degree
+    _sc_storage_degree_segment_new(addr->seg);
+    memset(_sc_storage_get_degree(*addr), 0, sizeof(sc_element_degree));
+#endif
 
-    return sc_segment_append_element(segment, element, &addr->offset);
+    return res;
 }
 
 sc_addr sc_storage_element_new(sc_type type)
@@ -277,6 +447,7 @@ sc_result sc_storage_element_free(sc_addr addr)
     sc_element *el, *el2;
     sc_addr _addr;
     sc_uint addr_int;
+    sc_check_sum check_sum;
 
     GSList *remove_list = 0;
 
@@ -303,9 +474,19 @@ sc_result sc_storage_element_free(sc_addr addr)
         el = sc_storage_get_element(_addr, SC_TRUE);
         g_assert(el != 0 && el->type != 0);
 
+#if USE_ELEMENT_DEGREE_CACHE
+        // element can be appended into remove list twice (loop arc), so check if it wasn't deleted yet
+        if ((el->type & sc_type_arc_mask) && el->delete_time_stamp == 0)
+            _sc_storage_degree_arc_remove(el->arc.begin, el->arc.end);
+#endif
+
         // remove registered events before deletion
         sc_event_notify_element_deleted(_addr);
 
+        // deleted sc-link shouldn't be found by content
+        if ((el->type & sc_type_link) && el->delete_time_stamp == 0 && _sc_storage_get_link_checksum(el, &check_sum) == SC_TRUE)
+            sc_fs_storage_remove_content_addr(_addr, &check_sum);
+
         el->delete_time_stamp = storage_time_stamp;
 
         if (el->type & sc_type_arc_mask)
@@ -438,6 +619,10 @@ sc_addr sc_storage_arc_new(sc_type type,
     beg_el->first_out_arc = addr;
     end_el->first_in_arc = addr;
 
+#if USE_ELEMENT_DEGREE_CACHE
+    _sc_storage_degree_arc_append(beg, end);
+#endif
+
     return addr;
 }
 
@@ -490,11 +675,47 @@ sc_result sc_storage_get_arc_end(sc_addr addr, sc_addr *result)
     return SC_RESULT_ERROR_INVALID_TYPE;
 }
 
+#if USE_INLINE_LINK_CONTENT
+/*! Reads whole data from \p stream into \p data if it's length isn't greater than CONTENT_DATA_LEN.
+ * @returns If data fits, then returns SC_TRUE and \p len contains data length; otherwise returns SC_FALSE
+ */
+sc_bool _sc_storage_read_inline_content(const sc_stream *stream, sc_char *data, sc_uint32 *len)
+{
+    sc_char buffer[CONTENT_DATA_LEN + 1];
+    sc_uint32 data_read = 0;
+
+    *len = 0;
+    sc_stream_seek(stream, SC_STREAM_SEEK_SET, 0);
+
+    // read one byte more than can be stored to detect larger contents
+    while (sc_stream_eof(stream) == SC_FALSE && *len <= CONTENT_DATA_LEN)
+    {
+        if (sc_stream_read_data(stream, buffer + *len, CONTENT_DATA_LEN + 1 - *len, &data_read) != SC_RESULT_OK || data_read == 0)
+            break;
+        *len += data_read;
+    }
+
+    sc_stream_seek(stream, SC_STREAM_SEEK_SET, 0);
+
+    if (*len > CONTENT_DATA_LEN)
+        return SC_FALSE;
+
+    memcpy(data, buffer, *len);
+    return SC_TRUE;
+}
+#endif
+
 sc_result sc_storage_set_link_content(sc_addr addr, const sc_stream *stream)
 {
     sc_element *el = sc_storage_get_element(addr, SC_TRUE);
-    sc_check_sum check_sum;
+    sc_check_sum check_sum, old_check_sum;
+    sc_bool has_old_content = SC_FALSE;
     sc_result result = SC_RESULT_ERROR;
+#if USE_INLINE_LINK_CONTENT
+    sc_char data[CONTENT_DATA_LEN];
+    sc_uint32 data_len = 0;
+    sc_stream *data_stream = 0;
+#endif
 
     g_assert(stream != nullptr);
 
@@ -504,21 +725,46 @@ sc_result sc_storage_set_link_content(sc_addr addr, const sc_stream *stream)
     if (!(el->type & sc_type_link))
         return SC_RESULT_ERROR_INVALID_TYPE;
 
-    // calculate checksum for data
-    if (sc_link_calculate_checksum(stream, &check_sum) == SC_TRUE)
+    // reference of previous content will be removed after new content set
+    has_old_content = _sc_storage_get_link_checksum(el, &old_check_sum);
+
+#if USE_INLINE_LINK_CONTENT
+    if (_sc_storage_read_inline_content(stream, data, &data_len) == SC_TRUE)
     {
-        result = sc_fs_storage_write_content(addr, &check_sum, stream);
+        // small content stored in element, file memory keeps just a reference to find it by checksum
+        data_stream = sc_stream_memory_new(data, data_len, SC_STREAM_READ, SC_FALSE);
+        if (sc_link_calculate_checksum(data_stream, &check_sum) == SC_TRUE)
+            result = sc_fs_storage_add_content_addr(addr, &check_sum);
+        sc_stream_free(data_stream);
+
+        if (result == SC_RESULT_OK)
+        {
+            if (has_old_content == SC_TRUE)
+                sc_fs_storage_remove_content_addr(addr, &old_check_sum);
+
+            memcpy(el->content.data, data, data_len);
+            el->content.len = SC_CONTENT_INLINE | data_len;
+        }
+
+        return result;
+    }
+#endif
+
+    // write data and calculate its checksum
+    result = sc_fs_storage_write_stream(addr, stream, &check_sum);
+    if (result == SC_RESULT_OK)
+    {
+        if (has_old_content == SC_TRUE)
+            sc_fs_storage_remove_content_addr(addr, &old_check_sum);
+
         memcpy(el->content.data, check_sum.data, check_sum.len);
         el->content.len = check_sum.len;
 
         g_assert(check_sum.len > 0);
 
         //sc_event_emit(addr, SC_EVENT_CHANGE_LINK_CONTENT, addr);
-        result = SC_RESULT_OK;
     }
 
-    g_assert(result == SC_RESULT_OK);
-
     return result;
 }
 
@@ -526,6 +772,10 @@ sc_result sc_storage_get_link_content(sc_addr addr, sc_stream **stream)
 {
     sc_element *el = sc_storage_get_element(addr, SC_TRUE);
     sc_check_sum checksum;
+#if USE_INLINE_LINK_CONTENT
+    sc_char *data = 0;
+    sc_uint32 data_len = 0;
+#endif
 
     if (el == nullptr)
         return SC_RESULT_ERROR_INVALID_PARAMS;
@@ -533,6 +783,17 @@ sc_result sc_storage_get_link_content(sc_addr addr, sc_stream **stream)
     if (!(el->type & sc_type_link))
         return SC_RESULT_ERROR_INVALID_TYPE;
 
+#if USE_INLINE_LINK_CONTENT
+    if (el->content.len & SC_CONTENT_INLINE)
+    {
+        data_len = el->content.len & SC_CONTENT_INLINE_LEN_MASK;
+        data = g_new(sc_char, MAX(data_len, 1));
+        memcpy(data, el->content.data, data_len);
+        *stream = sc_stream_memory_new(data, data_len, SC_STREAM_READ, SC_TRUE);
+
+        return SC_RESULT_OK;
+    }
+#endif
 
     // prepare checksum
     checksum.len = el->content.len;
@@ -613,6 +874,29 @@ sc_result sc_storage_get_elements_stat(sc_stat *stat)
     return SC_TRUE;
 }
 
+sc_result sc_storage_get_element_degree(sc_addr addr, sc_uint32 *out_count, sc_uint32 *in_count)
+{
+#if USE_ELEMENT_DEGREE_CACHE
+    sc_element_degree *degree = 0;
+
+    if (sc_storage_is_element(addr) == SC_FALSE)
+        return SC_RESULT_ERROR_INVALID_PARAMS;
+
+    degree = _sc_storage_get_degree(addr);
+    if (degree == nullptr)
+        return SC_RESULT_ERROR;
+
+    if (out_count != nullptr)
+        *out_count = degree->out_count;
+    if (in_count != nullptr)
+        *in_count = degree->in_count;
+
+    return SC_RESULT_OK;
+#else
+    return SC_RESULT_ERROR;
+#endif
+}
+
 sc_uint sc_storage_get_time_stamp()
 {
     return storage_time_stamp;
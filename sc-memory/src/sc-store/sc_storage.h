@@ -174,6 +174,16 @@ sc_result sc_storage_get_link_content(sc_addr addr, sc_stream **stream);
  */
 sc_result sc_storage_find_links_with_content(const sc_stream *stream, sc_addr **result, sc_uint32 *result_count);
 
+/*! Returns number of output and input arcs of specified sc-element
+ * @param addr sc-addr of sc-element
+ * @param out_count Pointer to container for number of output arcs (can be null)
+ * @param in_count Pointer to container for number of input arcs (can be null)
+ * @return If element exists, then returns SC_RESULT_OK; otherwise returns SC_RESULT_ERROR_INVALID_PARAMS.
+ * If degree cache is disabled (USE_ELEMENT_DEGREE_CACHE), then returns SC_RESULT_ERROR.
+ * @note Deleted arcs aren't counted
+ */
+sc_result sc_storage_get_element_degree(sc_addr addr, sc_uint32 *out_count, sc_uint32 *in_count);
+
 //! Returns number of segments
 sc_uint sc_storage_get_segments_count();
 
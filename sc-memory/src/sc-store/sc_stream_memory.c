@@ -32,6 +32,8 @@ struct _sc_memory_buffer
     sc_uint32 size;   // size of data
     sc_uint32 pos;    // current position
     sc_bool data_owner; // ownership on data buffer
+    GBytes *bytes;    // shared data buffer, that referenced by stream
+    GMappedFile *mapped; // mapped file, that contains data and referenced by stream
 };
 
 typedef struct _sc_memory_buffer sc_memory_buffer;
@@ -113,6 +115,12 @@ sc_result sc_stream_memory_free_handler(const sc_stream *stream)
         g_free(buffer->data);
     }
 
+    if (buffer->bytes != 0)
+        g_bytes_unref(buffer->bytes);
+
+    if (buffer->mapped != 0)
+        g_mapped_file_unref(buffer->mapped);
+
     g_free(buffer);
 
     return SC_RESULT_OK;
@@ -162,3 +170,30 @@ sc_stream* sc_stream_memory_new(const sc_char *buffer, sc_uint buffer_size, sc_u
 
     return stream;
 }
+
+sc_stream* sc_stream_memory_new_bytes(GBytes *bytes, sc_uint8 flags)
+{
+    gsize size = 0;
+    const sc_char *data = (const sc_char*)g_bytes_get_data(bytes, &size);
+    sc_stream *stream = sc_stream_memory_new(data, (sc_uint)size, flags, SC_FALSE);
+
+    if (stream != 0)
+        ((sc_memory_buffer*)stream->handler)->bytes = g_bytes_ref(bytes);
+
+    return stream;
+}
+
+sc_stream* sc_stream_memory_new_mapped(GMappedFile *file, sc_uint64 offset, sc_uint32 size)
+{
+    sc_stream *stream = 0;
+
+    if (size > 0 && (file == 0 || offset + size > g_mapped_file_get_length(file)))
+        return 0;
+
+    stream = sc_stream_memory_new(size > 0 ? g_mapped_file_get_contents(file) + offset : 0, size, SC_STREAM_READ, SC_FALSE);
+
+    if (stream != 0 && size > 0)
+        ((sc_memory_buffer*)stream->handler)->mapped = g_mapped_file_ref(file);
+
+    return stream;
+}
@@ -25,6 +25,8 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "sc_stream.h"
 
+#include <glib.h>
+
 /*! Create memory data stream
  * @param buffer Pointer to memory buffer with data
  * @param buffer_size Size of data in buffer
@@ -36,4 +38,23 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
  */
 sc_stream* sc_stream_memory_new(const sc_char *buffer, sc_uint buffer_size, sc_uint8 flags, sc_bool data_owner);
 
+/*! Create memory data stream over shared buffer. Stream holds reference to \p bytes while it exists,
+ * so the same buffer can be read by any number of streams without copying
+ * @param bytes Shared data buffer
+ * @param flags Data stream flags
+ * @remarks The returned stream pointer should be freed with sc_stream_free function, when done using it.
+ * @return Returns stream pointer if the stream was successfully created, or NULL if an error occurred
+ */
+sc_stream* sc_stream_memory_new_bytes(GBytes *bytes, sc_uint8 flags);
+
+/*! Create read-only memory data stream over range of mapped file. Stream holds reference to \p file while it exists
+ * @param file Pointer to mapped file. It can be null just for empty data
+ * @param offset Offset of data in mapped file
+ * @param size Size of data in bytes
+ * @remarks The returned stream pointer should be freed with sc_stream_free function, when done using it.
+ * @return Returns stream pointer if the stream was successfully created, or NULL if an error occurred
+ * (range is out of file)
+ */
+sc_stream* sc_stream_memory_new_mapped(GMappedFile *file, sc_uint64 offset, sc_uint32 size);
+
 #endif // SC_STREAM_MEMORY_H
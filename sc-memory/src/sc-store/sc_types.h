@@ -162,6 +162,18 @@ struct _sc_check_sum
     sc_uint8 len;    // checksum length
 };
 
+//! Algorithms, that can be used to calculate checksum of sc-link content
+enum _sc_checksum_algorithm
+{
+    SC_CHECKSUM_SHA256 = 0,           // first 32 hex digits of SHA-256 (default, used by old repositories)
+    SC_CHECKSUM_FAST                  // non-cryptographic 124-bit hash (SC_CHECKSUM_FAST_TAG + 31 hex digits)
+};
+
+/*! First symbol of checksums calculated with SC_CHECKSUM_FAST. SHA-256 checksums contain
+ * just hex digits, so algorithm of any stored checksum can be determined by it's first symbol
+ */
+#define SC_CHECKSUM_FAST_TAG    'x'
+
 // events
 enum _sc_event_type
 {
@@ -198,6 +210,7 @@ typedef struct _sc_iterator_param sc_iterator_param;
 typedef struct _sc_iterator3 sc_iterator3;
 typedef struct _sc_event sc_event;
 typedef enum _sc_result sc_result;
+typedef enum _sc_checksum_algorithm sc_checksum_algorithm;
 typedef enum _sc_event_type sc_event_type;
 typedef struct _sc_stat sc_stat;
 
@@ -32,6 +32,159 @@ sc_bool sc_helper_is_initialized = SC_FALSE;
 sc_char **keynodes_str = 0;
 sc_addr *sc_keynodes = 0;
 
+// index of system identifiers: [identifier] = sc-addr of element (packed with SC_ADDR_LOCAL_TO_INT)
+GHashTable *sys_idtf_index = 0;
+gchar *sys_idtf_index_path = 0;
+const gchar *sys_idtf_index_file = "sys_idtf_index";
+
+GMutex sys_idtf_index_mutex; // statically allocated GMutex doesn't need initialization
+#define SYS_IDTF_INDEX_LOCK g_mutex_lock(&sys_idtf_index_mutex);
+#define SYS_IDTF_INDEX_UNLOCK g_mutex_unlock(&sys_idtf_index_mutex);
+
+/*! Index of system identifiers is just a hint to skip content search. Elements and their identifiers
+ * can be removed or changed without sc-helper, so every found value is checked in memory before usage
+ * and index file can be rebuilt from scratch by removing it.
+ */
+void _sys_idtf_index_append(const sc_char *data, sc_uint32 len, sc_addr addr)
+{
+    SYS_IDTF_INDEX_LOCK
+    g_hash_table_replace(sys_idtf_index, g_strndup(data, len), GUINT_TO_POINTER(SC_ADDR_LOCAL_TO_INT(addr)));
+    SYS_IDTF_INDEX_UNLOCK
+}
+
+void _sys_idtf_index_remove(const sc_char *data, sc_uint32 len)
+{
+    gchar *key = g_strndup(data, len);
+
+    SYS_IDTF_INDEX_LOCK
+    g_hash_table_remove(sys_idtf_index, key);
+    SYS_IDTF_INDEX_UNLOCK
+
+    g_free(key);
+}
+
+sc_bool _sys_idtf_index_find(const sc_char *data, sc_uint32 len, sc_addr *addr)
+{
+    gchar *key = g_strndup(data, len);
+    gpointer value = 0;
+    sc_bool found = SC_FALSE;
+
+    SYS_IDTF_INDEX_LOCK
+    found = g_hash_table_lookup_extended(sys_idtf_index, key, 0, &value) == TRUE ? SC_TRUE : SC_FALSE;
+    SYS_IDTF_INDEX_UNLOCK
+
+    g_free(key);
+
+    if (found == SC_TRUE)
+    {
+        addr->seg = SC_ADDR_LOCAL_SEG_FROM_INT(GPOINTER_TO_UINT(value));
+        addr->offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(GPOINTER_TO_UINT(value));
+    }
+
+    return found;
+}
+
+//! Checks if sc-element has specified system identifier
+sc_bool _sys_idtf_check(sc_addr addr, const sc_char *data, sc_uint32 len)
+{
+    sc_iterator5 *it = 0;
+    sc_stream *stream = 0;
+    sc_char *buffer = 0;
+    sc_uint32 length = 0, read = 0;
+    sc_bool result = SC_FALSE;
+
+    if (sc_memory_is_element(addr) == SC_FALSE)
+        return SC_FALSE;
+
+    buffer = g_new(sc_char, len + 1);
+    it = sc_iterator5_f_a_a_a_f_new(addr,
+                                    sc_type_arc_common | sc_type_const,
+                                    sc_type_link,
+                                    sc_type_arc_pos_const_perm,
+                                    sc_keynodes[SC_KEYNODE_NREL_SYSTEM_IDENTIFIER]);
+
+    while (result == SC_FALSE && sc_iterator5_next(it) == SC_TRUE)
+    {
+        if (sc_memory_get_link_content(sc_iterator5_value(it, 2), &stream) != SC_RESULT_OK)
+            continue;
+
+        if (sc_stream_get_length(stream, &length) == SC_RESULT_OK && length == len)
+        {
+            if (len == 0 || (sc_stream_read_data(stream, buffer, len, &read) == SC_RESULT_OK && read == len && memcmp(buffer, data, len) == 0))
+                result = SC_TRUE;
+        }
+
+        sc_stream_free(stream);
+    }
+
+    sc_iterator5_free(it);
+    g_free(buffer);
+
+    return result;
+}
+
+/*! Index file is a sequence of records: <sc_uint32 identifier length><identifier><sc_uint32 sc-addr>
+ */
+void _sys_idtf_index_load()
+{
+    gchar *content = 0;
+    gsize size = 0, pos = 0;
+    sc_uint32 len = 0, addr_int = 0;
+    sc_addr addr;
+
+    if (g_file_get_contents(sys_idtf_index_path, &content, &size, 0) == FALSE)
+        return;
+
+    while (pos + sizeof(len) <= size)
+    {
+        memcpy(&len, content + pos, sizeof(len));
+        pos += sizeof(len);
+
+        if (pos + len + sizeof(addr_int) > size)
+        {
+            g_warning("Index of system identifiers is corrupted, it would be rebuilt");
+            g_hash_table_remove_all(sys_idtf_index);
+            break;
+        }
+
+        memcpy(&addr_int, content + pos + len, sizeof(addr_int));
+        addr.seg = SC_ADDR_LOCAL_SEG_FROM_INT(addr_int);
+        addr.offset = SC_ADDR_LOCAL_OFFSET_FROM_INT(addr_int);
+        _sys_idtf_index_append(content + pos, len, addr);
+
+        pos += len + sizeof(addr_int);
+    }
+
+    g_free(content);
+    g_message("\tSystem identifiers in index: %u", g_hash_table_size(sys_idtf_index));
+}
+
+void _sys_idtf_index_save()
+{
+    GByteArray *data = g_byte_array_new();
+    GHashTableIter iter;
+    gpointer key, value;
+    sc_uint32 len = 0, addr_int = 0;
+
+    SYS_IDTF_INDEX_LOCK
+    g_hash_table_iter_init(&iter, sys_idtf_index);
+    while (g_hash_table_iter_next(&iter, &key, &value) == TRUE)
+    {
+        len = (sc_uint32)strlen((const gchar*)key);
+        addr_int = GPOINTER_TO_UINT(value);
+
+        g_byte_array_append(data, (const guint8*)&len, sizeof(len));
+        g_byte_array_append(data, (const guint8*)key, len);
+        g_byte_array_append(data, (const guint8*)&addr_int, sizeof(addr_int));
+    }
+    SYS_IDTF_INDEX_UNLOCK
+
+    if (g_file_set_contents(sys_idtf_index_path, (const gchar*)data->data, data->len, 0) == FALSE)
+        g_warning("Can't save index of system identifiers into %s", sys_idtf_index_path);
+
+    g_byte_array_free(data, TRUE);
+}
+
 sc_result resolve_nrel_system_identifier()
 {
     sc_addr *results = 0;
@@ -118,12 +271,17 @@ void _destroy_keynodes_str()
     g_free(keynodes_str);
 }
 
-sc_result sc_helper_init()
+sc_result sc_helper_init(const sc_char *repo_path, sc_bool clear)
 {
     g_message("Initialize sc-helper");
 
     _init_keynodes_str();
 
+    sys_idtf_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, 0);
+    sys_idtf_index_path = g_strdup_printf("%s/%s", repo_path, sys_idtf_index_file);
+    if (clear == SC_FALSE)
+        _sys_idtf_index_load();
+
     sc_keynodes = g_new0(sc_addr, SC_KEYNODE_COUNT);
 
     if (resolve_nrel_system_identifier() != SC_RESULT_OK)
@@ -152,6 +310,12 @@ void sc_helper_shutdown()
 {
     g_message("Shutdown sc-helper");
 
+    _sys_idtf_index_save();
+    g_hash_table_destroy(sys_idtf_index);
+    sys_idtf_index = 0;
+    g_free(sys_idtf_index_path);
+    sys_idtf_index_path = 0;
+
     g_free(sc_keynodes);
     _destroy_keynodes_str();
 }
@@ -168,6 +332,15 @@ sc_result sc_helper_find_element_by_system_identifier(const sc_char* data, sc_ui
     g_assert(sc_helper_is_initialized == SC_TRUE);
     g_assert(sc_keynodes != 0);
 
+    // try to use index, before search by content
+    if (_sys_idtf_index_find(data, len, result_addr) == SC_TRUE)
+    {
+        if (_sys_idtf_check(*result_addr, data, len) == SC_TRUE)
+            return SC_RESULT_OK;
+
+        _sys_idtf_index_remove(data, len);
+    }
+
     // try to find sc-links with that contains system identifier value
     stream = sc_stream_memory_new(data, sizeof(sc_char) * len, SC_STREAM_READ, SC_FALSE);
     if (sc_memory_find_links_with_content(stream, &results, &results_count) == SC_RESULT_OK)
@@ -203,6 +376,9 @@ sc_result sc_helper_find_element_by_system_identifier(const sc_char* data, sc_ui
 
     sc_stream_free(stream);
 
+    if (found == SC_TRUE)
+        _sys_idtf_index_append(data, len, *result_addr);
+
     return found == SC_TRUE ? SC_RESULT_OK : SC_RESULT_ERROR;
 }
 
@@ -218,6 +394,16 @@ sc_result sc_helper_set_system_identifier(sc_addr addr, const sc_char* data, sc_
     SC_ADDR_MAKE_EMPTY(idtf_addr)
     g_assert(sc_keynodes != 0);
 
+    // identifier from index is already used
+    if (_sys_idtf_index_find(data, len, &idtf_addr) == SC_TRUE)
+    {
+        if (_sys_idtf_check(idtf_addr, data, len) == SC_TRUE)
+            return SC_RESULT_ERROR_INVALID_PARAMS;
+
+        _sys_idtf_index_remove(data, len);
+        SC_ADDR_MAKE_EMPTY(idtf_addr)
+    }
+
     // check if specified system identifier already used
     stream = sc_stream_memory_new(data, sizeof(sc_char) * len, SC_STREAM_READ, SC_FALSE);
     if (sc_memory_find_links_with_content(stream, &results, &results_count) == SC_RESULT_OK)
@@ -264,6 +450,8 @@ sc_result sc_helper_set_system_identifier(sc_addr addr, const sc_char* data, sc_
     if (SC_ADDR_IS_EMPTY(arc_addr))
         return SC_RESULT_ERROR;
 
+    _sys_idtf_index_append(data, len, addr);
+
     return SC_RESULT_OK;
 }
 
@@ -320,18 +508,18 @@ sc_bool sc_helper_resolve_system_identifier(const char *system_idtf, sc_addr *re
 
 sc_bool sc_helper_check_arc(sc_addr beg_el, sc_addr end_el, sc_type arc_type)
 {
-    sc_iterator3 *it = 0;
-    sc_bool res = SC_FALSE;
+    sc_iterator_param p1, p2, p3;
 
-    it = sc_iterator3_f_a_f_new(beg_el, arc_type, end_el);
-    if (it == nullptr)
-        return SC_FALSE;
+    p1.is_type = SC_FALSE;
+    p1.addr = beg_el;
 
-    if (sc_iterator3_next(it) == SC_TRUE)
-        res = SC_TRUE;
+    p2.is_type = SC_TRUE;
+    p2.type = arc_type;
 
-    sc_iterator3_free(it);
-    return res;
+    p3.is_type = SC_FALSE;
+    p3.addr = end_el;
+
+    return sc_iterator3_exists(sc_iterator3_f_a_f, p1, p2, p3);
 }
 
 
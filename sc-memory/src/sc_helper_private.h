@@ -25,13 +25,15 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include "sc-store/sc_types.h"
 
 /*! Initialize helper.
+ * @param repo_path Path to repository, where index of system identifiers stored
+ * @param clear Flag to start with empty index of system identifiers
  * @remarks Need to be called once at the beginning of sc-helper usage
  * @return If sc-helper initialized without any errors, then return SC_OK;
  * otherwise returns SC_ERROR
  */
-sc_result sc_helper_init();
+sc_result sc_helper_init(const sc_char *repo_path, sc_bool clear);
 
-/*! Shuts down sc-helper.
+/*! Shuts down sc-helper and saves index of system identifiers into repository.
  * @remarks This function need to be called once at the end of sc-helper usage
  */
 void sc_helper_shutdown();
@@ -37,6 +37,84 @@ GRecMutex mutex;
 #define LOCK g_rec_mutex_lock(&mutex);
 #define UNLOCK g_rec_mutex_unlock(&mutex);
 
+//! Lock of sc-memory changes: they take it for writing, sc_memory_read_lock takes it for reading
+GRWLock changes_lock; // statically allocated GRWLock doesn't need initialization
+//! Depth of nested changes and read locks in current thread, lock is taken by the outer ones only
+GPrivate changes_depth = G_PRIVATE_INIT(0);
+GPrivate read_depth = G_PRIVATE_INIT(0);
+
+enum _sc_lock_mode
+{
+    SC_LOCK_MODE_NONE = 0,
+    SC_LOCK_MODE_READ,
+    SC_LOCK_MODE_WRITE
+};
+
+/*! Mode, that changes lock was taken with by the outermost change or read lock in current thread.
+ * Nested ones of other kind can be released after it, so lock is released in this mode, when both depths become zero
+ */
+GPrivate lock_mode = G_PRIVATE_INIT(0);
+
+// changes lock is taken before mutex, so threads, that read with read lock, don't wait for changes
+#define CHANGE_BEGIN _sc_memory_change_begin(); LOCK;
+#define CHANGE_END UNLOCK; _sc_memory_change_end();
+
+//! Takes changes lock in specified mode, if current thread doesn't hold it
+void _sc_memory_lock_acquire(enum _sc_lock_mode mode)
+{
+    switch (GPOINTER_TO_UINT(g_private_get(&lock_mode)))
+    {
+    case SC_LOCK_MODE_NONE:
+        if (mode == SC_LOCK_MODE_WRITE)
+            g_rw_lock_writer_lock(&changes_lock);
+        else
+            g_rw_lock_reader_lock(&changes_lock);
+        g_private_set(&lock_mode, GUINT_TO_POINTER(mode));
+        break;
+
+    case SC_LOCK_MODE_READ:
+        // thread can't wait for itself
+        if (mode == SC_LOCK_MODE_WRITE)
+            g_critical("sc-memory is changed by thread, that holds read lock");
+        break;
+
+    default:
+        // thread, that changes sc-memory, already excludes other changes
+        break;
+    }
+}
+
+//! Releases changes lock in mode, that it was taken with, if current thread has no more changes and read locks
+void _sc_memory_lock_release()
+{
+    if (GPOINTER_TO_UINT(g_private_get(&changes_depth)) > 0 || GPOINTER_TO_UINT(g_private_get(&read_depth)) > 0)
+        return;
+
+    if (GPOINTER_TO_UINT(g_private_get(&lock_mode)) == SC_LOCK_MODE_WRITE)
+        g_rw_lock_writer_unlock(&changes_lock);
+    else
+        g_rw_lock_reader_unlock(&changes_lock);
+
+    g_private_set(&lock_mode, GUINT_TO_POINTER(SC_LOCK_MODE_NONE));
+}
+
+void _sc_memory_change_begin()
+{
+    guint depth = GPOINTER_TO_UINT(g_private_get(&changes_depth));
+
+    _sc_memory_lock_acquire(SC_LOCK_MODE_WRITE);
+    g_private_set(&changes_depth, GUINT_TO_POINTER(depth + 1));
+}
+
+void _sc_memory_change_end()
+{
+    guint depth = GPOINTER_TO_UINT(g_private_get(&changes_depth));
+
+    g_assert(depth > 0);
+    g_private_set(&changes_depth, GUINT_TO_POINTER(depth - 1));
+    _sc_memory_lock_release();
+}
+
 void sc_memory_params_clear(sc_memory_params *params)
 {
     params->clear = SC_FALSE;
@@ -61,7 +139,7 @@ sc_bool sc_memory_initialize(const sc_memory_params *params)
     res = sc_storage_initialize(params->repo_path, params->clear);
     g_rec_mutex_init(&mutex);
 
-    if (sc_helper_init() != SC_RESULT_OK)
+    if (sc_helper_init(params->repo_path, params->clear) != SC_RESULT_OK)
         return SC_FALSE;
 
 
@@ -118,6 +196,33 @@ sc_bool sc_memory_is_initialized()
     return res;
 }
 
+void sc_memory_lock()
+{
+    CHANGE_BEGIN;
+}
+
+void sc_memory_unlock()
+{
+    CHANGE_END;
+}
+
+void sc_memory_read_lock()
+{
+    guint depth = GPOINTER_TO_UINT(g_private_get(&read_depth));
+
+    _sc_memory_lock_acquire(SC_LOCK_MODE_READ);
+    g_private_set(&read_depth, GUINT_TO_POINTER(depth + 1));
+}
+
+void sc_memory_read_unlock()
+{
+    guint depth = GPOINTER_TO_UINT(g_private_get(&read_depth));
+
+    g_assert(depth > 0);
+    g_private_set(&read_depth, GUINT_TO_POINTER(depth - 1));
+    _sc_memory_lock_release();
+}
+
 sc_bool sc_memory_is_element(sc_addr addr)
 {
     sc_bool res;
@@ -130,36 +235,36 @@ sc_bool sc_memory_is_element(sc_addr addr)
 sc_result sc_memory_element_free(sc_addr addr)
 {
     sc_result res;
-    LOCK;
+    CHANGE_BEGIN;
     res = sc_storage_element_free(addr);
-    UNLOCK;
+    CHANGE_END;
     return res;
 }
 
 sc_addr sc_memory_node_new(sc_type type)
 {
     sc_addr res;
-    LOCK;
+    CHANGE_BEGIN;
     res = sc_storage_node_new(type);
-    UNLOCK;
+    CHANGE_END;
     return res;
 }
 
 sc_addr sc_memory_link_new()
 {
     sc_addr res;
-    LOCK;
+    CHANGE_BEGIN;
     res = sc_storage_link_new();
-    UNLOCK;
+    CHANGE_END;
     return res;
 }
 
 sc_addr sc_memory_arc_new(sc_type type, sc_addr beg, sc_addr end)
 {
     sc_addr res;
-    LOCK;
+    CHANGE_BEGIN;
     res = sc_storage_arc_new(type, beg, end);
-    UNLOCK;
+    CHANGE_END;
     return res;
 }
 
@@ -175,9 +280,9 @@ sc_result sc_memory_get_element_type(sc_addr addr, sc_type *result)
 sc_result sc_memory_change_element_subtype(sc_addr addr, sc_type type)
 {
     sc_result res;
-    LOCK;
+    CHANGE_BEGIN;
     res = sc_storage_change_element_subtype(addr, type);
-    UNLOCK;
+    CHANGE_END;
     return res;
 }
 
@@ -202,9 +307,9 @@ sc_result sc_memory_get_arc_end(sc_addr addr, sc_addr *result)
 sc_result sc_memory_set_link_content(sc_addr addr, const sc_stream *stream)
 {
     sc_result res;
-    LOCK;
+    CHANGE_BEGIN;
     res = sc_storage_set_link_content(addr, stream);
-    UNLOCK;
+    CHANGE_END;
     return res;
 }
 
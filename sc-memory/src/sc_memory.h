@@ -54,6 +54,24 @@ void sc_memory_shutdown();
 //! Check if sc-memory is initialized
 sc_bool sc_memory_is_initialized();
 
+/*! Locks sc-memory, so other threads can't work with it until sc_memory_unlock call.
+ * Lock is recursive, so thread, that holds it, can call any sc-memory functions.
+ * It used to make a number of changes as one operation
+ */
+void sc_memory_lock();
+
+//! Unlocks sc-memory locked by sc_memory_lock
+void sc_memory_unlock();
+
+/*! Locks sc-memory for reading: any threads can read it, but changes wait until sc_memory_read_unlock call.
+ * It used by operations, that read sc-memory from several threads and need it unchanged.
+ * Lock is recursive. Thread, that holds it, mustn't change sc-memory
+ */
+void sc_memory_read_lock();
+
+//! Unlocks sc-memory locked by sc_memory_read_lock
+void sc_memory_read_unlock();
+
 /*! Check if sc-element with specified sc-addr exist
  * @param addr sc-addr of element
  * @return Returns SC_TRUE, if sc-element with \p addr exist; otherwise return SC_FALSE.
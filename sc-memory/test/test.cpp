@@ -6,8 +6,12 @@ extern "C"
 //#include "sc_iterator.h"
 //#include "sc_event.h"
 #include "sc_memory_headers.h"
+#include "sc_helper.h"
 #include "sc-store/sc_store.h"
+#include "sc-store/sc_link_helpers.h"
+#include "sc-store/sc_content_cache.h"
 }
+#include "sc_system_search.h"
 #include <vector>
 #include <limits>
 #include <glib.h>
@@ -17,7 +21,17 @@ extern "C"
 #define arcs_append_count  25000000
 #define arcs_remove_count  0
 #define link_append_count 20000
+#define link_large_count 16
+#define link_large_size (4 * 1024 * 1024)
+#define link_cached_count 100
+#define link_cached_size 1024
+#define link_cached_reads 100000
+#define sys_idtf_count 10000
 #define iterator_alloc_count 10000000
+#define search_nodes_count 2000
+#define search_hub_arcs_count 2000
+#define search_patterns_count 20
+#define search_threads_count 4
 
 const char* repo_path = "repo";
 GTimer *timer = 0;
@@ -340,6 +354,45 @@ void test4()
     printf("Allocated iterators: %d\n", iterator_alloc_count);
     printf("Allocation/deallocation per second: %f\n", iterator_alloc_count / g_timer_elapsed(timer, 0));
 
+    // iterators on stack
+    printf("---\nTest iterator initialization(release) speed...\n");
+    sc_iterator3 it_stack;
+
+    g_timer_reset(timer);
+    g_timer_start(timer);
+
+    for (i = 0; i < iterator_alloc_count; i++)
+    {
+        sc_iterator3_f_a_a_init(&it_stack, node[0], 0, 0);
+        sc_iterator3_done(&it_stack);
+    }
+
+    g_timer_stop(timer);
+    printf("Initialized iterators: %d\n", iterator_alloc_count);
+    printf("Initialization/release per second: %f\n", iterator_alloc_count / g_timer_elapsed(timer, 0));
+
+    // count without iteration
+    printf("---\nTest iterator count speed...\n");
+    sc_iterator_param p1, p2, p3;
+    sc_uint32 arcs_count = 0;
+
+    p1.is_type = SC_FALSE;
+    p1.addr = node[0];
+    p2.is_type = SC_TRUE;
+    p2.type = 0;
+    p3.is_type = SC_TRUE;
+    p3.type = 0;
+
+    g_timer_reset(timer);
+    g_timer_start(timer);
+
+    for (i = 0; i < iterator_alloc_count; i++)
+        arcs_count = sc_iterator3_count(sc_iterator3_f_a_a, p1, p2, p3);
+
+    g_timer_stop(timer);
+    printf("Output arcs count: %u\n", arcs_count);
+    printf("Counts per second: %f\n", iterator_alloc_count / g_timer_elapsed(timer, 0));
+
     g_timer_destroy(timer);
 
 }
@@ -349,6 +402,12 @@ void test5()
     sc_uint32 i;
     sc_addr addr;
     sc_stream *stream = 0;
+    sc_char *data = 0;
+    sc_uint32 j, value, bytes;
+    std::vector<sc_addr> links;
+    sc_check_sum check_sum;
+    sc_checksum_algorithm algorithm;
+    sc_content_cache_stat cache_stat;
 
     printf("Segments count: %d\n", sc_storage_get_segments_count());
     print_storage_statistics();
@@ -363,6 +422,7 @@ void test5()
     for (i = 0; i < link_append_count; i++)
     {
         addr = sc_memory_link_new();
+        links.push_back(addr);
 
         //printf("Created sc-link: seg=%d, offset=%d, content=%d\n", addr.seg, addr.offset, i);
 
@@ -376,6 +436,104 @@ void test5()
     printf("Created links: %d\n", link_append_count);
     printf("Links per second: %f\n", link_append_count / g_timer_elapsed(timer, 0));
 
+    g_timer_reset(timer);
+    g_timer_start(timer);
+    for (i = 0; i < link_append_count; i++)
+    {
+        value = 0;
+        if (sc_memory_get_link_content(links[i], &stream) != SC_RESULT_OK)
+        {
+            printf("Can't read content of link %d\n", i);
+            continue;
+        }
+
+        sc_stream_read_data(stream, (char*)&value, sizeof(value), &bytes);
+        sc_stream_free(stream);
+
+        if (value != i)
+            printf("Invalid content of link %d: %d\n", i, value);
+    }
+    g_timer_stop(timer);
+
+    printf("Read links per second: %f\n", link_append_count / g_timer_elapsed(timer, 0));
+
+    printf("Read %d times %d links with %d bytes content\n", link_cached_reads, link_cached_count, link_cached_size);
+
+    links.clear();
+    data = g_new(sc_char, link_cached_size);
+    for (i = 0; i < link_cached_count; i++)
+    {
+        memset(data, (int)i, link_cached_size);
+        memcpy(data, &i, sizeof(i));
+
+        addr = sc_memory_link_new();
+        links.push_back(addr);
+        stream = sc_stream_memory_new(data, link_cached_size, SC_STREAM_READ, SC_FALSE);
+        sc_memory_set_link_content(addr, stream);
+        sc_stream_free(stream);
+    }
+    g_free(data);
+
+    g_timer_reset(timer);
+    g_timer_start(timer);
+    for (i = 0; i < link_cached_reads; i++)
+    {
+        value = 0;
+        if (sc_memory_get_link_content(links[i % link_cached_count], &stream) != SC_RESULT_OK)
+        {
+            printf("Can't read content of link %d\n", i % link_cached_count);
+            continue;
+        }
+
+        sc_stream_read_data(stream, (char*)&value, sizeof(value), &bytes);
+        sc_stream_free(stream);
+
+        if (value != i % link_cached_count)
+            printf("Invalid content of link %d: %d\n", i % link_cached_count, value);
+    }
+    g_timer_stop(timer);
+
+    sc_content_cache_get_stat(&cache_stat);
+    printf("Read links per second: %f\n", link_cached_reads / g_timer_elapsed(timer, 0));
+    printf("Content cache hits: %llu, misses: %llu, size: %llu bytes\n", cache_stat.hits, cache_stat.misses, cache_stat.size);
+
+    printf("Create %d links with %d bytes content\n", link_large_count, link_large_size);
+
+    data = g_new(sc_char, link_large_size);
+    g_timer_reset(timer);
+    g_timer_start(timer);
+    for (i = 0; i < link_large_count; i++)
+    {
+        // make unique content for each link
+        memset(data, (int)i, link_large_size);
+        memcpy(data, &i, sizeof(i));
+
+        addr = sc_memory_link_new();
+        stream = sc_stream_memory_new(data, link_large_size, SC_STREAM_READ, SC_FALSE);
+        sc_memory_set_link_content(addr, stream);
+        sc_stream_free(stream);
+    }
+    g_timer_stop(timer);
+
+    printf("Megabytes per second: %f\n", (link_large_count * (link_large_size / (1024.0 * 1024.0))) / g_timer_elapsed(timer, 0));
+
+    for (j = 0; j < 2; j++)
+    {
+        algorithm = (j == 0) ? SC_CHECKSUM_SHA256 : SC_CHECKSUM_FAST;
+        stream = sc_stream_memory_new(data, link_large_size, SC_STREAM_READ, SC_FALSE);
+
+        g_timer_reset(timer);
+        g_timer_start(timer);
+        for (i = 0; i < link_large_count; i++)
+            sc_link_hash_stream(stream, 0, algorithm, &check_sum);
+        g_timer_stop(timer);
+
+        sc_stream_free(stream);
+        printf("Checksum %s, megabytes per second: %f\n", (j == 0) ? "sha256" : "fast",
+               (link_large_count * (link_large_size / (1024.0 * 1024.0))) / g_timer_elapsed(timer, 0));
+    }
+    g_free(data);
+
     printf("Segments count: %d\n", sc_storage_get_segments_count());
     print_storage_statistics();
 
@@ -390,6 +548,7 @@ void test6()
     sc_stream *stream = 0;
     sc_addr *results = 0;
     sc_uint32 results_count = 0;
+    char idtf[64];
 
     printf("Segments count: %d\n", sc_storage_get_segments_count());
     print_storage_statistics();
@@ -434,6 +593,56 @@ void test6()
     printf("Created links: %d\n", link_append_count);
     printf("Links per second: %f\n", link_append_count / g_timer_elapsed(timer, 0));
 
+    printf("Find %d missing contents\n", link_append_count);
+    g_timer_reset(timer);
+    g_timer_start(timer);
+    for (i = 0; i < link_append_count; i++)
+    {
+        g_snprintf(idtf, sizeof(idtf), "test6_missing_%u_%u", g_random_int(), i);
+        stream = sc_stream_memory_new(idtf, strlen(idtf), SC_STREAM_READ, SC_FALSE);
+        if (sc_memory_find_links_with_content(stream, &results, &results_count) == SC_RESULT_OK && results_count > 0)
+        {
+            printf("Found links with missing content %s\n", idtf);
+            g_free(results);
+            results = 0;
+        }
+        sc_stream_free(stream);
+    }
+    g_timer_stop(timer);
+
+    printf("Missing contents per second: %f\n", link_append_count / g_timer_elapsed(timer, 0));
+
+    printf("Set and find %d system identifiers\n", sys_idtf_count);
+    std::vector<sc_addr> nodes;
+    for (i = 0; i < sys_idtf_count; i++)
+    {
+        addr = sc_memory_node_new(sc_type_const);
+        nodes.push_back(addr);
+
+        g_snprintf(idtf, sizeof(idtf), "test6_idtf_%u_%u", g_random_int(), i);
+        if (sc_helper_set_system_identifier(addr, idtf, strlen(idtf)) != SC_RESULT_OK)
+            printf("Can't set system identifier %s\n", idtf);
+    }
+
+    g_timer_reset(timer);
+    g_timer_start(timer);
+    for (i = 0; i < sys_idtf_count; i++)
+    {
+        sc_addr idtf_addr;
+        if (sc_helper_get_system_identifier(nodes[i], &idtf_addr) != SC_RESULT_OK)
+            continue;
+
+        sc_memory_get_link_content(idtf_addr, &stream);
+        sc_stream_read_data(stream, idtf, sizeof(idtf), &j);
+        sc_stream_free(stream);
+
+        if (sc_helper_find_element_by_system_identifier(idtf, j, &addr) != SC_RESULT_OK || SC_ADDR_IS_NOT_EQUAL(addr, nodes[i]))
+            printf("Invalid element found by system identifier %d\n", i);
+    }
+    g_timer_stop(timer);
+
+    printf("Identifiers per second: %f\n", sys_idtf_count / g_timer_elapsed(timer, 0));
+
     printf("Segments count: %d\n", sc_storage_get_segments_count());
     print_storage_statistics();
 
@@ -611,6 +820,287 @@ void test9()
 
 }
 
+//! Counts constructions hub -> v1 => v2 <- rare; v2 => v3 by nested iteration, to check results of pattern search
+sc_uint32 count_search_constructions(sc_addr hub, sc_addr rare)
+{
+    sc_uint32 count = 0, rare_arcs, out_arcs;
+    sc_type arc_common_const = sc_type_arc_common | sc_type_const;
+    sc_iterator3 *it_hub, *it_v1, *it;
+
+    it_hub = sc_iterator3_f_a_a_new(hub, sc_type_arc_pos_const_perm, 0);
+    while (sc_iterator3_next(it_hub) == SC_TRUE)
+    {
+        it_v1 = sc_iterator3_f_a_a_new(sc_iterator3_value(it_hub, 2), arc_common_const, 0);
+        while (sc_iterator3_next(it_v1) == SC_TRUE)
+        {
+            sc_addr v2 = sc_iterator3_value(it_v1, 2);
+
+            rare_arcs = 0;
+            it = sc_iterator3_f_a_f_new(rare, sc_type_arc_pos_const_perm, v2);
+            while (sc_iterator3_next(it) == SC_TRUE)
+                rare_arcs++;
+            sc_iterator3_free(it);
+
+            out_arcs = 0;
+            it = sc_iterator3_f_a_a_new(v2, arc_common_const, 0);
+            while (sc_iterator3_next(it) == SC_TRUE)
+                out_arcs++;
+            sc_iterator3_free(it);
+
+            count += rare_arcs * out_arcs;
+        }
+        sc_iterator3_free(it_v1);
+    }
+    sc_iterator3_free(it_hub);
+
+    return count;
+}
+
+void test10()
+{
+    sc_uint32 i, j;
+    sc_uint32 results_count = 0;
+    std::vector<sc_addr> nodes;
+    sc_type arc_common_const = sc_type_arc_common | sc_type_const;
+    sc_type arc_common_var = sc_type_arc_common | sc_type_var;
+    sc_type arc_pos_var = sc_type_arc_access | sc_type_var | sc_type_arc_pos | sc_type_arc_perm;
+
+    timer = g_timer_new();
+
+    // synthetic knowledge base: one node with many output arcs, one node with a few of them
+    // and random relation between other nodes
+    printf("Create knowledge base...\n");
+    for (i = 0; i < search_nodes_count; i++)
+        nodes.push_back(sc_memory_node_new(sc_type_const));
+
+    sc_addr hub = nodes[0];
+    sc_addr rare = nodes[1];
+    for (i = 0; i < search_hub_arcs_count; i++)
+        sc_memory_arc_new(sc_type_arc_pos_const_perm, hub, nodes[2 + g_random_int() % (search_nodes_count - 2)]);
+    for (i = 0; i < 5; i++)
+        sc_memory_arc_new(sc_type_arc_pos_const_perm, rare, nodes[2 + g_random_int() % (search_nodes_count - 2)]);
+    for (i = 0; i < 3 * search_nodes_count; i++)
+        sc_memory_arc_new(arc_common_const, nodes[2 + g_random_int() % (search_nodes_count - 2)],
+                          nodes[2 + g_random_int() % (search_nodes_count - 2)]);
+
+    // patterns: hub -> v1 => v2 <- rare; v2 => v3
+    std::vector<sc_addr> patterns;
+    for (i = 0; i < search_patterns_count; i++)
+    {
+        sc_addr pattern = sc_memory_node_new(sc_type_const);
+        sc_addr v1 = sc_memory_node_new(sc_type_var);
+        sc_addr v2 = sc_memory_node_new(sc_type_var);
+        sc_addr v3 = sc_memory_node_new(sc_type_var);
+        sc_addr elements[] = {v1, v2, v3,
+                              sc_memory_arc_new(arc_pos_var, hub, v1),
+                              sc_memory_arc_new(arc_common_var, v1, v2),
+                              sc_memory_arc_new(arc_pos_var, rare, v2),
+                              sc_memory_arc_new(arc_common_var, v2, v3)};
+
+        // change order of const elements in pattern, search mustn't depend on it
+        if (i % 2 == 0)
+        {
+            sc_memory_arc_new(sc_type_arc_pos_const_perm, pattern, hub);
+            sc_memory_arc_new(sc_type_arc_pos_const_perm, pattern, rare);
+        }else
+        {
+            sc_memory_arc_new(sc_type_arc_pos_const_perm, pattern, rare);
+            sc_memory_arc_new(sc_type_arc_pos_const_perm, pattern, hub);
+        }
+        for (j = 0; j < sizeof(elements) / sizeof(sc_addr); j++)
+            sc_memory_arc_new(sc_type_arc_pos_const_perm, pattern, elements[j]);
+
+        patterns.push_back(pattern);
+    }
+
+    sc_uint32 expected_count = count_search_constructions(hub, rare);
+    printf("Constructions in knowledge base: %u\n", expected_count);
+
+    sc_uint32 threads[] = {1, search_threads_count};
+    for (sc_uint32 t = 0; t < sizeof(threads) / sizeof(sc_uint32); t++)
+    {
+        printf("Search %d patterns in %u threads...\n", search_patterns_count, threads[t]);
+        system_sys_search_set_threads_count(threads[t]);
+        results_count = 0;
+
+        g_timer_reset(timer);
+        g_timer_start(timer);
+
+        for (i = 0; i < search_patterns_count; i++)
+        {
+            sc_type_result params;
+            sc_type_result_vector result;
+            system_sys_search_only_full(patterns[i], params, &result);
+            g_assert(result.size() == expected_count);
+            results_count += result.size();
+            free_result_vector(&result);
+        }
+
+        g_timer_stop(timer);
+        printf("Found constructions: %u\n", results_count);
+        printf("Patterns per second: %f\n", search_patterns_count / g_timer_elapsed(timer, 0));
+    }
+
+    system_sys_search_set_threads_count(1);
+    g_timer_destroy(timer);
+}
+
+sc_iterator_param make_addr_param(sc_addr addr)
+{
+    sc_iterator_param p;
+    p.is_type = SC_FALSE;
+    p.addr = addr;
+    return p;
+}
+
+sc_iterator_param make_type_param(sc_type type)
+{
+    sc_iterator_param p;
+    p.is_type = SC_TRUE;
+    p.type = type;
+    return p;
+}
+
+//! Count constructions by plain iteration, to compare results of sc_iterator3_count with it
+sc_uint32 iterate3_count(sc_iterator_type type, sc_iterator_param p1, sc_iterator_param p2, sc_iterator_param p3)
+{
+    sc_uint32 count = 0;
+    sc_iterator3 *it = sc_iterator3_new(type, p1, p2, p3);
+
+    g_assert(it != 0);
+    while (sc_iterator3_next(it) == SC_TRUE)
+        count++;
+    sc_iterator3_free(it);
+
+    return count;
+}
+
+//! Count constructions by plain iteration, to compare results of sc_iterator5_count with it. Iterator is freed
+sc_uint32 iterate5_count(sc_iterator5 *it)
+{
+    sc_uint32 count = 0;
+
+    g_assert(it != 0);
+    while (sc_iterator5_next(it) == SC_TRUE)
+        count++;
+    sc_iterator5_free(it);
+
+    return count;
+}
+
+//! Checks count, existence and degree of element against plain iteration
+void check_iterator3_counts(const std::vector<sc_addr> &nodes)
+{
+    sc_type arc_types[] = {0, sc_type_arc_pos_const_perm, sc_type_arc_common | sc_type_const};
+    sc_uint32 i, j, t, count, out_count, in_count;
+
+    for (i = 0; i < nodes.size(); i++)
+    {
+        for (t = 0; t < sizeof(arc_types) / sizeof(sc_type); t++)
+        {
+            count = iterate3_count(sc_iterator3_f_a_a, make_addr_param(nodes[i]), make_type_param(arc_types[t]), make_type_param(0));
+            g_assert(sc_iterator3_count(sc_iterator3_f_a_a, make_addr_param(nodes[i]), make_type_param(arc_types[t]), make_type_param(0)) == count);
+            g_assert(sc_iterator3_exists(sc_iterator3_f_a_a, make_addr_param(nodes[i]), make_type_param(arc_types[t]), make_type_param(0)) == (count > 0));
+
+            count = iterate3_count(sc_iterator3_a_a_f, make_type_param(0), make_type_param(arc_types[t]), make_addr_param(nodes[i]));
+            g_assert(sc_iterator3_count(sc_iterator3_a_a_f, make_type_param(0), make_type_param(arc_types[t]), make_addr_param(nodes[i])) == count);
+            g_assert(sc_iterator3_exists(sc_iterator3_a_a_f, make_type_param(0), make_type_param(arc_types[t]), make_addr_param(nodes[i])) == (count > 0));
+
+            // both directions of f_a_f, so output and input arcs lists are used for existence check
+            for (j = 0; j < nodes.size(); j++)
+            {
+                count = iterate3_count(sc_iterator3_f_a_f, make_addr_param(nodes[i]), make_type_param(arc_types[t]), make_addr_param(nodes[j]));
+                g_assert(sc_iterator3_count(sc_iterator3_f_a_f, make_addr_param(nodes[i]), make_type_param(arc_types[t]), make_addr_param(nodes[j])) == count);
+                g_assert(sc_iterator3_exists(sc_iterator3_f_a_f, make_addr_param(nodes[i]), make_type_param(arc_types[t]), make_addr_param(nodes[j])) == (count > 0));
+            }
+        }
+
+        g_assert(sc_storage_get_element_degree(nodes[i], &out_count, &in_count) == SC_RESULT_OK);
+        g_assert(out_count == iterate3_count(sc_iterator3_f_a_a, make_addr_param(nodes[i]), make_type_param(0), make_type_param(0)));
+        g_assert(in_count == iterate3_count(sc_iterator3_a_a_f, make_type_param(0), make_type_param(0), make_addr_param(nodes[i])));
+    }
+}
+
+//! Checks count and existence of 5-element constructions against plain and nested sc-iterator3 iteration
+void check_iterator5_counts(const std::vector<sc_addr> &nodes, sc_addr relation)
+{
+    sc_uint32 i, count, brute_count;
+
+    for (i = 0; i < nodes.size(); i++)
+    {
+        count = iterate5_count(sc_iterator5_f_a_a_a_f_new(nodes[i], 0, 0, sc_type_arc_pos_const_perm, relation));
+
+        brute_count = 0;
+        sc_iterator3 *it = sc_iterator3_f_a_a_new(nodes[i], 0, 0);
+        g_assert(it != 0);
+        while (sc_iterator3_next(it) == SC_TRUE)
+            brute_count += iterate3_count(sc_iterator3_f_a_f, make_addr_param(relation), make_type_param(sc_type_arc_pos_const_perm),
+                                          make_addr_param(sc_iterator3_value(it, 1)));
+        sc_iterator3_free(it);
+
+        g_assert(count == brute_count);
+        g_assert(sc_iterator5_count(sc_iterator5_f_a_a_a_f, make_addr_param(nodes[i]), make_type_param(0), make_type_param(0),
+                                    make_type_param(sc_type_arc_pos_const_perm), make_addr_param(relation)) == count);
+        g_assert(sc_iterator5_exists(sc_iterator5_f_a_a_a_f, make_addr_param(nodes[i]), make_type_param(0), make_type_param(0),
+                                     make_type_param(sc_type_arc_pos_const_perm), make_addr_param(relation)) == (count > 0));
+
+        count = iterate5_count(sc_iterator5_a_a_f_a_f_new(0, 0, nodes[i], sc_type_arc_pos_const_perm, relation));
+        g_assert(sc_iterator5_count(sc_iterator5_a_a_f_a_f, make_type_param(0), make_type_param(0), make_addr_param(nodes[i]),
+                                    make_type_param(sc_type_arc_pos_const_perm), make_addr_param(relation)) == count);
+        g_assert(sc_iterator5_exists(sc_iterator5_a_a_f_a_f, make_type_param(0), make_type_param(0), make_addr_param(nodes[i]),
+                                     make_type_param(sc_type_arc_pos_const_perm), make_addr_param(relation)) == (count > 0));
+    }
+}
+
+void test11()
+{
+    sc_uint32 i;
+    std::vector<sc_addr> nodes;
+    std::vector<sc_addr> arcs;
+    sc_type arc_common_const = sc_type_arc_common | sc_type_const;
+
+    printf("Create test constructions...\n");
+    for (i = 0; i < 32; i++)
+        nodes.push_back(sc_memory_node_new(sc_type_const));
+
+    // hub has more input arcs, than output arcs of any other node, so existence of arcs from other nodes
+    // to hub is checked with output arcs list
+    sc_addr hub = nodes[0];
+    sc_addr relation = sc_memory_node_new(sc_type_const);
+    for (i = 1; i < nodes.size(); i++)
+        arcs.push_back(sc_memory_arc_new(i % 2 ? sc_type_arc_pos_const_perm : arc_common_const, nodes[i], hub));
+    for (i = 0; i < 64; i++)
+        arcs.push_back(sc_memory_arc_new(i % 3 ? sc_type_arc_pos_const_perm : arc_common_const,
+                                         nodes[1 + g_random_int() % (nodes.size() - 1)],
+                                         nodes[1 + g_random_int() % (nodes.size() - 1)]));
+
+    // attribute arcs for 5-element constructions
+    for (i = 0; i < arcs.size(); i += 3)
+        sc_memory_arc_new(sc_type_arc_pos_const_perm, relation, arcs[i]);
+
+    printf("Check counts...\n");
+    check_iterator3_counts(nodes);
+    check_iterator5_counts(nodes, relation);
+
+    printf("Delete arcs and check counts...\n");
+    for (i = 0; i < arcs.size(); i += 4)
+        sc_memory_element_free(arcs[i]);
+    sc_memory_element_free(nodes[nodes.size() - 1]);
+    nodes.pop_back();
+
+    check_iterator3_counts(nodes);
+    check_iterator5_counts(nodes, relation);
+
+    // arcs[1] (common arc from nodes[2] to hub) isn't deleted
+    g_assert(sc_iterator3_exists(sc_iterator3_f_a_f, make_addr_param(nodes[2]), make_type_param(0), make_addr_param(hub)) == SC_TRUE);
+    g_assert(sc_iterator3_exists(sc_iterator3_f_a_f, make_addr_param(nodes[2]), make_type_param(sc_type_arc_pos_const_perm), make_addr_param(hub)) == SC_FALSE);
+    g_assert(sc_iterator3_exists(sc_iterator3_f_a_f, make_addr_param(hub), make_type_param(0), make_addr_param(nodes[2])) == SC_FALSE);
+    // arcs[0] (from nodes[1] to hub) is deleted
+    g_assert(sc_iterator3_exists(sc_iterator3_f_a_f, make_addr_param(nodes[1]), make_type_param(0), make_addr_param(hub)) == SC_FALSE);
+
+    printf("Counts are equal to iteration results\n");
+}
+
 int main(int argc, char *argv[])
 {
     sc_uint item = -1;
@@ -658,6 +1148,8 @@ int main(int argc, char *argv[])
                "7 - test events\n"
                "8 - test garbage deletion\n"
                "9 - run grabage collection\n"
+               "10 - test pattern search\n"
+               "11 - test iterator counts\n"
                "\nCommand: ");
         scanf("%d", &item);
 
@@ -700,6 +1192,14 @@ int main(int argc, char *argv[])
         case 9:
             test9();
             break;
+
+        case 10:
+            test10();
+            break;
+
+        case 11:
+            test11();
+            break;
         };
 
         printf("\n----- Finished -----\n");
@@ -1,7 +1,8 @@
 TEMPLATE = app
 DESTDIR = ../../bin
 
-INCLUDEPATH += ../../sc-memory/src
+INCLUDEPATH += ../../sc-memory/src \
+               ../../sc-kpm/search/agents/search_pattern
 unix {
     LIBS += $$quote(-L$$DESTDIR) -lsc_memory
     CONFIG += link_pkgconfig
@@ -11,7 +12,9 @@ unix {
 DEFINES += QT_COMPILATION
 
 SOURCES += \
-    test.cpp
+    test.cpp \
+    ../../sc-kpm/search/agents/search_pattern/sc_system_search.cpp \
+    ../../sc-kpm/search/agents/search_pattern/sc_system_operators.cpp
 
 win32 {
     CONFIG += qt console
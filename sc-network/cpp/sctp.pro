@@ -1,4 +1,5 @@
 TEMPLATE = subdirs
 CONFIG += ordered
 
-SUBDIRS = sctp_server
+SUBDIRS = sctp_server \
+    sctp_bench
@@ -0,0 +1,210 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#include <QtCore/QCoreApplication>
+#include <QStringList>
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+#include "sctpBenchWorker.h"
+
+//! Names of commands kinds in load mix
+static const char* msCommandNames[SCTP_BENCH_COUNT] =
+{
+    "create",
+    "iterate",
+    "find_links",
+    "sys_idtf",
+    "event"
+};
+
+static void printUsage()
+{
+    printf("Usage: sctp_bench [options]\n"
+           "  --host <host>          server host (localhost)\n"
+           "  --port <port>          server port (55770)\n"
+           "  --local <name>         connect to local socket of server instead of tcp\n"
+           "  --threads <n>          number of threads (4)\n"
+           "  --connections <n>      number of connections of each thread (4)\n"
+           "  --pipeline <n>         number of commands sent to connection without waiting for results (16)\n"
+           "  --duration <seconds>   test duration (10)\n"
+           "  --mix <kind=weight,..> weights of commands: create, iterate, find_links, sys_idtf, event\n"
+           "                         (create=1,iterate=4,find_links=1,sys_idtf=2,event=1)\n");
+}
+
+//! Parses weights of commands in format: kind=weight,kind=weight
+static bool parseMix(const QString &mix, sBenchConfig &config)
+{
+    memset(config.mWeights, 0, sizeof(config.mWeights));
+
+    QStringList items = mix.split(",");
+    for (int i = 0; i < items.size(); ++i)
+    {
+        QStringList values = items[i].split("=");
+        if (values.size() != 2)
+            return false;
+
+        quint32 kind = 0;
+        while (kind < SCTP_BENCH_COUNT && values[0] != msCommandNames[kind])
+            ++kind;
+
+        bool result = false;
+        if (kind == SCTP_BENCH_COUNT)
+            return false;
+        config.mWeights[kind] = values[1].toUInt(&result);
+        if (!result)
+            return false;
+    }
+
+    quint32 total = 0;
+    for (quint32 kind = 0; kind < SCTP_BENCH_COUNT; ++kind)
+        total += config.mWeights[kind];
+
+    return total > 0;
+}
+
+//! Parses command line arguments
+static bool parseArguments(const QStringList &args, sBenchConfig &config)
+{
+    for (int i = 1; i < args.size(); i += 2)
+    {
+        if (i + 1 >= args.size())
+            return false;
+
+        const QString &name = args[i];
+        const QString &value = args[i + 1];
+        bool result = true;
+
+        if (name == "--host")
+            config.mHost = value;
+        else if (name == "--port")
+            config.mPort = value.toUShort(&result);
+        else if (name == "--local")
+            config.mLocalSocket = value;
+        else if (name == "--threads")
+            config.mThreadsCount = value.toUInt(&result);
+        else if (name == "--connections")
+            config.mConnectionsCount = value.toUInt(&result);
+        else if (name == "--pipeline")
+            config.mPipeline = value.toUInt(&result);
+        else if (name == "--duration")
+            config.mDuration = value.toUInt(&result);
+        else if (name == "--mix")
+            result = parseMix(value, config);
+        else
+            return false;
+
+        if (!result)
+            return false;
+    }
+
+    return config.mThreadsCount > 0 && config.mConnectionsCount > 0 && config.mPipeline > 0;
+}
+
+//! Returns latency percentile (in thousandths) from sorted latencies
+static quint32 percentile(const std::vector<quint32> &latencies, quint32 value)
+{
+    size_t idx = (latencies.size() * value) / 1000;
+    return latencies[qMin(idx, latencies.size() - 1)];
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    sBenchConfig config;
+    config.mHost = "localhost";
+    config.mPort = 55770;
+    config.mThreadsCount = 4;
+    config.mConnectionsCount = 4;
+    config.mPipeline = 16;
+    config.mDuration = 10;
+    parseMix("create=1,iterate=4,find_links=1,sys_idtf=2,event=1", config);
+
+    if (!parseArguments(a.arguments(), config))
+    {
+        printUsage();
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::vector<sctpBenchWorker*> workers;
+    for (quint32 i = 0; i < config.mThreadsCount; ++i)
+    {
+        workers.push_back(new sctpBenchWorker(config, i));
+        workers.back()->start();
+    }
+
+    // collect results of all threads
+    quint64 count[SCTP_BENCH_COUNT], errors[SCTP_BENCH_COUNT];
+    quint64 totalCount = 0, totalErrors = 0;
+    std::vector<quint32> latencies;
+    bool failed = false;
+
+    memset(count, 0, sizeof(count));
+    memset(errors, 0, sizeof(errors));
+    for (quint32 i = 0; i < workers.size(); ++i)
+    {
+        workers[i]->wait();
+
+        const sBenchResult &result = workers[i]->result();
+        for (quint32 kind = 0; kind < SCTP_BENCH_COUNT; ++kind)
+        {
+            count[kind] += result.mCount[kind];
+            errors[kind] += result.mErrors[kind];
+            totalCount += result.mCount[kind];
+            totalErrors += result.mErrors[kind];
+        }
+        latencies.insert(latencies.end(), result.mLatencies.begin(), result.mLatencies.end());
+        failed = failed || result.mFailed;
+
+        delete workers[i];
+    }
+
+    double seconds = timer.elapsed() / 1000.0;
+
+    if (failed)
+        printf("Some connections failed (server isn't available or closed connection)\n");
+
+    printf("Threads: %u, connections: %u, pipeline: %u\n", config.mThreadsCount, config.mThreadsCount * config.mConnectionsCount, config.mPipeline);
+    printf("Commands: %llu, failed results: %llu, time: %.2f s, throughput: %.1f commands/s\n",
+           (unsigned long long)totalCount, (unsigned long long)totalErrors, seconds, totalCount / seconds);
+
+    for (quint32 kind = 0; kind < SCTP_BENCH_COUNT; ++kind)
+    {
+        if (count[kind] > 0)
+            printf("  %-12s %12llu commands, %llu failed\n", msCommandNames[kind], (unsigned long long)count[kind], (unsigned long long)errors[kind]);
+    }
+
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        printf("Latency (microseconds): p50 %u, p90 %u, p99 %u, p99.9 %u, max %u\n",
+               percentile(latencies, 500), percentile(latencies, 900), percentile(latencies, 990),
+               percentile(latencies, 999), latencies.back());
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,433 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#include "sctpBenchWorker.h"
+
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QElapsedTimer>
+#include <QDateTime>
+
+//! Timeout of waiting for server (milliseconds)
+#define SCTP_BENCH_TIMEOUT      30000
+//! Time of waiting for data from one connection, while results of other ones can come (milliseconds)
+#define SCTP_BENCH_POLL_TIMEOUT 1
+//! Size of result header: code (1 byte), command id (4 bytes), result code (1 byte), result size (4 bytes)
+#define SCTP_RESULT_HEADER_SIZE 10
+//! Number of output arcs of connection sc-node, that are created before test
+#define SCTP_BENCH_SEED_ARCS    16
+
+//! Content of sc-links, that are found by SCTP_BENCH_FIND_LINKS commands
+static const char msFindLinksContent[] = "sctp_bench";
+//! System identifier, that is found by SCTP_BENCH_SYS_IDTF commands
+static const char msSysIdtf[] = "nrel_system_identifier";
+
+//! Appends command header (code, flags, id and parameters size) and parameters into \p data
+static void appendCommandData(QByteArray &data, quint8 cmdCode, quint32 cmdId, const QByteArray &params)
+{
+    quint8 cmdFlags = 0;
+    quint32 paramsSize = params.size();
+
+    data.append((const char*)&cmdCode, sizeof(cmdCode));
+    data.append((const char*)&cmdFlags, sizeof(cmdFlags));
+    data.append((const char*)&cmdId, sizeof(cmdId));
+    data.append((const char*)&paramsSize, sizeof(paramsSize));
+    data.append(params);
+}
+
+//! Appends sc-addr argument of batch sub-command into \p data
+static void appendBatchAddr(QByteArray &data, const sc_addr &addr)
+{
+    quint8 argType = SCTP_BATCH_ARG_ADDR;
+    data.append((const char*)&argType, sizeof(argType));
+    data.append((const char*)&addr, sizeof(addr));
+}
+
+//! Appends argument of batch sub-command, that refers to result of previous sub-command, into \p data
+static void appendBatchResult(QByteArray &data, quint32 index)
+{
+    quint8 argType = SCTP_BATCH_ARG_RESULT;
+    data.append((const char*)&argType, sizeof(argType));
+    data.append((const char*)&index, sizeof(index));
+}
+
+//! Appends batch sub-commands, that create sc-node and output arc from \p node to it, into \p data
+static void appendCreateConnected(QByteArray &data, const sc_addr &node, quint32 nodeIndex)
+{
+    quint8 code = SCTP_CMD_CREATE_NODE;
+    sc_type type = sc_type_node | sc_type_const;
+    data.append((const char*)&code, sizeof(code));
+    data.append((const char*)&type, sizeof(type));
+
+    code = SCTP_CMD_CREATE_ARC;
+    type = sc_type_arc_pos_const_perm;
+    data.append((const char*)&code, sizeof(code));
+    data.append((const char*)&type, sizeof(type));
+    appendBatchAddr(data, node);
+    appendBatchResult(data, nodeIndex);
+}
+
+//! Writes data into socket and waits until it sent
+static bool writeData(QIODevice *socket, const QByteArray &data)
+{
+    if (socket->write(data) != data.size())
+        return false;
+
+    while (socket->bytesToWrite() > 0)
+    {
+        if (!socket->waitForBytesWritten(SCTP_BENCH_TIMEOUT))
+            return false;
+    }
+
+    return true;
+}
+
+
+sctpBenchWorker::sctpBenchWorker(const sBenchConfig &config, quint32 index, QObject *parent)
+    : QThread(parent)
+    , mConfig(config)
+    , mIndex(index)
+{
+    memset(mResult.mCount, 0, sizeof(mResult.mCount));
+    memset(mResult.mErrors, 0, sizeof(mResult.mErrors));
+    mResult.mFailed = false;
+}
+
+sctpBenchWorker::~sctpBenchWorker()
+{
+}
+
+const sBenchResult& sctpBenchWorker::result() const
+{
+    return mResult;
+}
+
+void sctpBenchWorker::run()
+{
+    // random generator is separate for each thread
+    qsrand(QDateTime::currentDateTime().toTime_t() + mIndex);
+
+    std::vector<sBenchConnection> connections(mConfig.mConnectionsCount);
+    for (quint32 i = 0; i < connections.size() && !mResult.mFailed; ++i)
+    {
+        connections[i].socket = 0;
+        connections[i].kinds.resize(mConfig.mPipeline);
+        if (!openConnection(connections[i]) || !seedConnection(connections[i]))
+            mResult.mFailed = true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (!mResult.mFailed && timer.elapsed() < (qint64)mConfig.mDuration * 1000)
+    {
+        // commands are sent to all connections before waiting for results, so server processes them concurrently
+        for (quint32 i = 0; i < connections.size() && !mResult.mFailed; ++i)
+        {
+            if (!sendCommands(connections[i], timer))
+                mResult.mFailed = true;
+        }
+
+        if (!mResult.mFailed && !collectResults(connections, timer))
+            mResult.mFailed = true;
+    }
+
+    for (quint32 i = 0; i < connections.size(); ++i)
+    {
+        if (connections[i].socket)
+        {
+            connections[i].socket->close();
+            delete connections[i].socket;
+        }
+    }
+}
+
+bool sctpBenchWorker::sendCommands(sBenchConnection &connection, const QElapsedTimer &timer)
+{
+    QByteArray data;
+
+    connection.firstCmdId = connection.nextCmdId;
+    for (quint32 j = 0; j < mConfig.mPipeline; ++j)
+    {
+        connection.kinds[j] = randomCommand();
+        appendCommand(connection.kinds[j], connection.nextCmdId++, connection.node, data);
+    }
+
+    connection.pendingCount = mConfig.mPipeline;
+    connection.sendTime = timer.nsecsElapsed();
+
+    return writeData(connection.socket, data);
+}
+
+bool sctpBenchWorker::collectResults(std::vector<sBenchConnection> &connections, const QElapsedTimer &timer)
+{
+    quint32 pendingCount = connections.size() * mConfig.mPipeline;
+    QElapsedTimer idleTimer;
+    idleTimer.start();
+
+    while (pendingCount > 0)
+    {
+        bool received = false;
+        sBenchConnection *waitConnection = 0;
+
+        for (quint32 i = 0; i < connections.size(); ++i)
+        {
+            sBenchConnection &connection = connections[i];
+            quint32 cmdId = 0;
+            quint8 resCode = 0;
+            QByteArray resData;
+
+            // results of concurrently processed commands could come in any order
+            while (connection.pendingCount > 0 && takeResult(connection, cmdId, resCode, resData))
+            {
+                if (cmdId - connection.firstCmdId >= mConfig.mPipeline)
+                    return false;
+
+                eSctpBenchCommand kind = connection.kinds[cmdId - connection.firstCmdId];
+                ++mResult.mCount[kind];
+                if (resCode != SCTP_RESULT_OK)
+                    ++mResult.mErrors[kind];
+                mResult.mLatencies.push_back((timer.nsecsElapsed() - connection.sendTime) / 1000);
+
+                --connection.pendingCount;
+                --pendingCount;
+                received = true;
+            }
+
+            if (connection.pendingCount == 0)
+                continue;
+
+            // take data, that already came, without waiting
+            if (connection.socket->bytesAvailable() > 0 || connection.socket->waitForReadyRead(0))
+            {
+                connection.readBuffer.append(connection.socket->readAll());
+                received = true;
+            }else if (waitConnection == 0)
+                waitConnection = &connection;
+        }
+
+        if (received)
+        {
+            idleTimer.restart();
+            continue;
+        }
+
+        // nothing came: wait a bit for one of connections instead of busy loop
+        if (idleTimer.elapsed() > SCTP_BENCH_TIMEOUT)
+            return false;
+        if (waitConnection != 0 && waitConnection->socket->waitForReadyRead(SCTP_BENCH_POLL_TIMEOUT))
+            waitConnection->readBuffer.append(waitConnection->socket->readAll());
+    }
+
+    return true;
+}
+
+bool sctpBenchWorker::openConnection(sBenchConnection &connection)
+{
+    if (mConfig.mLocalSocket.isEmpty())
+    {
+        QTcpSocket *socket = new QTcpSocket();
+        connection.socket = socket;
+        socket->connectToHost(mConfig.mHost, mConfig.mPort);
+        if (!socket->waitForConnected(SCTP_BENCH_TIMEOUT))
+            return false;
+    }else
+    {
+        QLocalSocket *socket = new QLocalSocket();
+        connection.socket = socket;
+        socket->connectToServer(mConfig.mLocalSocket);
+        if (!socket->waitForConnected(SCTP_BENCH_TIMEOUT))
+            return false;
+    }
+
+    connection.nextCmdId = 1;
+    SC_ADDR_MAKE_EMPTY(connection.node);
+
+    // sc-node, that commands of connection iterate
+    QByteArray data, params, resData;
+    quint32 cmdId = 0;
+    quint8 resCode = 0;
+    sc_type type = sc_type_node | sc_type_const;
+
+    params.append((const char*)&type, sizeof(type));
+    appendCommandData(data, SCTP_CMD_CREATE_NODE, connection.nextCmdId++, params);
+    if (!writeData(connection.socket, data) || !readResult(connection, cmdId, resCode, resData))
+        return false;
+    if (resCode != SCTP_RESULT_OK || resData.size() != sizeof(sc_addr))
+        return false;
+    memcpy(&connection.node, resData.constData(), sizeof(sc_addr));
+
+    // subscription to events, that are polled by SCTP_BENCH_EVENT commands
+    quint8 eventType = SC_EVENT_ADD_OUTPUT_ARC;
+    data.clear();
+    params.clear();
+    params.append((const char*)&eventType, sizeof(eventType));
+    params.append((const char*)&connection.node, sizeof(connection.node));
+    appendCommandData(data, SCTP_CMD_EVENT_CREATE, connection.nextCmdId++, params);
+    if (!writeData(connection.socket, data) || !readResult(connection, cmdId, resCode, resData))
+        return false;
+
+    return resCode == SCTP_RESULT_OK;
+}
+
+bool sctpBenchWorker::seedConnection(sBenchConnection &connection)
+{
+    QByteArray data, params, resData;
+    quint32 cmdId = 0;
+    quint8 resCode = 0;
+    quint32 count = SCTP_BENCH_SEED_ARCS * 2 + 2;
+
+    // output arcs of connection sc-node are found by SCTP_BENCH_ITERATE commands
+    params.append((const char*)&count, sizeof(count));
+    for (quint32 i = 0; i < SCTP_BENCH_SEED_ARCS; ++i)
+        appendCreateConnected(params, connection.node, i * 2);
+
+    // sc-link is found by SCTP_BENCH_FIND_LINKS commands
+    quint8 code = SCTP_CMD_CREAET_LINK;
+    params.append((const char*)&code, sizeof(code));
+
+    quint32 len = sizeof(msFindLinksContent) - 1;
+    code = SCTP_CMD_SET_LINK_CONTENT;
+    params.append((const char*)&code, sizeof(code));
+    appendBatchResult(params, SCTP_BENCH_SEED_ARCS * 2);
+    params.append((const char*)&len, sizeof(len));
+    params.append(msFindLinksContent, len);
+
+    appendCommandData(data, SCTP_CMD_BATCH, connection.nextCmdId++, params);
+    if (!writeData(connection.socket, data) || !readResult(connection, cmdId, resCode, resData))
+        return false;
+
+    // result: number of sub-commands, then result code and sc-addr of each one
+    if (resCode != SCTP_RESULT_OK || (quint32)resData.size() != sizeof(count) + count * (1 + sizeof(sc_addr)))
+        return false;
+    for (quint32 i = 0; i < count; ++i)
+    {
+        if (resData.at(sizeof(count) + i * (1 + sizeof(sc_addr))) != SCTP_RESULT_OK)
+            return false;
+    }
+
+    return true;
+}
+
+eSctpBenchCommand sctpBenchWorker::randomCommand() const
+{
+    quint32 total = 0;
+    for (quint32 i = 0; i < SCTP_BENCH_COUNT; ++i)
+        total += mConfig.mWeights[i];
+
+    quint32 value = qrand() % total;
+    quint32 i = 0;
+    while (value >= mConfig.mWeights[i])
+    {
+        value -= mConfig.mWeights[i];
+        ++i;
+    }
+
+    return (eSctpBenchCommand)i;
+}
+
+void sctpBenchWorker::appendCommand(eSctpBenchCommand kind, quint32 cmdId, const sc_addr &node, QByteArray &data) const
+{
+    QByteArray params;
+
+    switch (kind)
+    {
+    case SCTP_BENCH_CREATE:
+    {
+        // new arc fires event, that is got by SCTP_BENCH_EVENT commands
+        quint32 count = 2;
+        params.append((const char*)&count, sizeof(count));
+        appendCreateConnected(params, node, 0);
+        appendCommandData(data, SCTP_CMD_BATCH, cmdId, params);
+        break;
+    }
+
+    case SCTP_BENCH_ITERATE:
+    {
+        quint8 iteratorType = SCTP_ITERATOR_3F_A_A;
+        sc_type arcType = sc_type_arc_pos_const_perm;
+        sc_type elType = 0;
+        params.append((const char*)&iteratorType, sizeof(iteratorType));
+        params.append((const char*)&node, sizeof(node));
+        params.append((const char*)&arcType, sizeof(arcType));
+        params.append((const char*)&elType, sizeof(elType));
+        appendCommandData(data, SCTP_CMD_ITERATE_ELEMENTS, cmdId, params);
+        break;
+    }
+
+    case SCTP_BENCH_FIND_LINKS:
+    {
+        quint32 len = sizeof(msFindLinksContent) - 1;
+        params.append((const char*)&len, sizeof(len));
+        params.append(msFindLinksContent, len);
+        appendCommandData(data, SCTP_CMD_FIND_LINKS, cmdId, params);
+        break;
+    }
+
+    case SCTP_BENCH_SYS_IDTF:
+    {
+        quint32 len = sizeof(msSysIdtf) - 1;
+        params.append((const char*)&len, sizeof(len));
+        params.append(msSysIdtf, len);
+        appendCommandData(data, SCTP_CMD_FIND_ELEMENT_BY_SYSITDF, cmdId, params);
+        break;
+    }
+
+    case SCTP_BENCH_EVENT:
+        appendCommandData(data, SCTP_CMD_EVENT_EMIT, cmdId, params);
+        break;
+
+    default:
+        Q_ASSERT(false);
+    }
+}
+
+bool sctpBenchWorker::readResult(sBenchConnection &connection, quint32 &cmdId, quint8 &resCode, QByteArray &resData)
+{
+    while (!takeResult(connection, cmdId, resCode, resData))
+    {
+        if (!connection.socket->waitForReadyRead(SCTP_BENCH_TIMEOUT))
+            return false;
+        connection.readBuffer.append(connection.socket->readAll());
+    }
+
+    return true;
+}
+
+bool sctpBenchWorker::takeResult(sBenchConnection &connection, quint32 &cmdId, quint8 &resCode, QByteArray &resData)
+{
+    if (connection.readBuffer.size() < SCTP_RESULT_HEADER_SIZE)
+        return false;
+
+    quint32 resSize = 0;
+    memcpy(&resSize, connection.readBuffer.constData() + SCTP_RESULT_HEADER_SIZE - sizeof(resSize), sizeof(resSize));
+
+    if ((quint32)connection.readBuffer.size() - SCTP_RESULT_HEADER_SIZE < resSize)
+        return false;
+
+    memcpy(&cmdId, connection.readBuffer.constData() + 1, sizeof(cmdId));
+    resCode = connection.readBuffer.at(1 + sizeof(cmdId));
+    resData = connection.readBuffer.mid(SCTP_RESULT_HEADER_SIZE, resSize);
+    connection.readBuffer.remove(0, SCTP_RESULT_HEADER_SIZE + resSize);
+
+    return true;
+}
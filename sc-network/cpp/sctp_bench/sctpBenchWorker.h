@@ -0,0 +1,156 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _sctpBenchWorker_h_
+#define _sctpBenchWorker_h_
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include <vector>
+
+#include "sctpTypes.h"
+
+class QIODevice;
+
+//! Kinds of commands, that load generator sends
+typedef enum
+{
+    SCTP_BENCH_CREATE = 0,      // create sc-node and output arc from sc-node of connection to it
+    SCTP_BENCH_ITERATE,         // iterate output arcs of sc-node
+    SCTP_BENCH_FIND_LINKS,      // find sc-links by content
+    SCTP_BENCH_SYS_IDTF,        // find sc-element by system identifier
+    SCTP_BENCH_EVENT,           // poll events of connection
+
+    SCTP_BENCH_COUNT
+
+} eSctpBenchCommand;
+
+//! Load generator parameters
+struct sBenchConfig
+{
+    QString mHost;
+    quint16 mPort;
+    //! Name of local socket (if it isn't empty, then it used instead of tcp)
+    QString mLocalSocket;
+    //! Number of threads
+    quint32 mThreadsCount;
+    //! Number of connections of each thread
+    quint32 mConnectionsCount;
+    //! Number of commands, that are sent to connection without waiting for results
+    quint32 mPipeline;
+    //! Test duration (seconds)
+    quint32 mDuration;
+    //! Weights of commands in load
+    quint32 mWeights[SCTP_BENCH_COUNT];
+};
+
+//! Results of one worker
+struct sBenchResult
+{
+    quint64 mCount[SCTP_BENCH_COUNT];
+    quint64 mErrors[SCTP_BENCH_COUNT];
+    //! Latencies of all commands (microseconds)
+    std::vector<quint32> mLatencies;
+    //! Flag, that connections failed
+    bool mFailed;
+};
+
+//! Connection of load generator
+struct sBenchConnection
+{
+    QIODevice *socket;
+    //! Received data, that doesn't contain complete result yet
+    QByteArray readBuffer;
+    //! sc-node, that is used by commands of this connection
+    sc_addr node;
+    quint32 nextCmdId;
+    //! Id of the first command, that was sent to connection last time
+    quint32 firstCmdId;
+    //! Number of commands, that results weren't received yet
+    quint32 pendingCount;
+    //! Kinds of sent commands (index is command id offset from the first one)
+    std::vector<eSctpBenchCommand> kinds;
+    //! Time, when commands were sent (nanoseconds from test start)
+    qint64 sendTime;
+};
+
+/*! Thread, that sends commands by its connections until test finished.
+ * Each connection gets a number of commands, then results of all connections are collected as
+ * soon as they come, so server processes commands of all connections concurrently.
+ */
+class sctpBenchWorker : public QThread
+{
+    Q_OBJECT
+public:
+    explicit sctpBenchWorker(const sBenchConfig &config, quint32 index, QObject *parent = 0);
+    virtual ~sctpBenchWorker();
+
+    const sBenchResult& result() const;
+
+protected:
+    void run();
+
+    //! Opens connection and creates sc-node and event subscription for it
+    bool openConnection(sBenchConnection &connection);
+    //! Creates sc-elements, that are found by commands of connection: output arcs of its sc-node and sc-link with content
+    bool seedConnection(sBenchConnection &connection);
+
+    /*! Sends commands to connection
+     * @param connection Reference to connection
+     * @param timer Test timer
+     * @returns If commands were sent, then returns true; otherwise returns false
+     */
+    bool sendCommands(sBenchConnection &connection, const QElapsedTimer &timer);
+    /*! Receives results of all sent commands from all connections
+     * @param connections List of connections
+     * @param timer Test timer
+     * @returns If all results received, then returns true; otherwise returns false
+     */
+    bool collectResults(std::vector<sBenchConnection> &connections, const QElapsedTimer &timer);
+
+    //! Chooses command kind by weights
+    eSctpBenchCommand randomCommand() const;
+
+    //! Appends command data of specified kind into \p data
+    void appendCommand(eSctpBenchCommand kind, quint32 cmdId, const sc_addr &node, QByteArray &data) const;
+
+    /*! Waits for next result of connection
+     * @param connection Reference to connection
+     * @param cmdId Reference to id of command, that result received
+     * @param resCode Reference to result code
+     * @param resData Reference to result data
+     * @returns If result received, then returns true; otherwise returns false
+     */
+    bool readResult(sBenchConnection &connection, quint32 &cmdId, quint8 &resCode, QByteArray &resData);
+    //! Takes the next result from read buffer of connection. Returns false, if there is no complete result
+    bool takeResult(sBenchConnection &connection, quint32 &cmdId, quint8 &resCode, QByteArray &resData);
+
+private:
+    const sBenchConfig &mConfig;
+    quint32 mIndex;
+    sBenchResult mResult;
+};
+
+#endif
@@ -0,0 +1,28 @@
+QT       += core \
+            network
+
+QT       -= gui
+
+TARGET = sctp_bench
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += main.cpp \
+    sctpBenchWorker.cpp
+
+HEADERS += \
+    sctpBenchWorker.h
+
+CONFIG (debug, debug|release) {
+    DESTDIR = ../../../bin
+} else {
+    DESTDIR = ../../../bin
+}
+
+INCLUDEPATH += ../sctp_server \
+    ../../../sc-memory/src
+
+OBJECTS_DIR = obj
+MOC_DIR = moc
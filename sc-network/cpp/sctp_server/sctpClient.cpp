@@ -25,27 +25,87 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include "sctpStatistic.h"
 
 #include <QTcpSocket>
+#include <QLocalSocket>
 #include <QHostAddress>
+#include <QThreadPool>
+#include <QBuffer>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QTimer>
 #include <QDebug>
 
-sctpClient::sctpClient(int socketDescriptor)
+//! Maximum size of data, that is read from socket, but not processed yet (client waits, when it's full)
+#define SCTP_READ_BUFFER_SIZE       (1024 * 1024)
+//! Size of results data, that is sent to client before command processing finished
+#define SCTP_RESULTS_CHUNK_SIZE     65536
+//! Period of checking for idle iteration cursors (milliseconds)
+#define SCTP_CURSORS_CHECK_PERIOD   10000
+//! Size of unsent data, when events aren't pushed to client. Events wait for client (up to limit in sctpCommand)
+#define SCTP_MAX_PUSH_PENDING_SIZE  (1024 * 1024)
+
+QMutex sctpClient::msClientsMutex;
+std::set<sctpClient*> sctpClient::msClients;
+
+sctpClient::sctpClient(quintptr socketDescriptor, bool isLocal, QThreadPool *workers, sClientLimits *limits)
     : mSocket(0)
-    , mSocketDescriptor(socketDescriptor)
     , mCommand(0)
+    , mWorkers(workers)
+    , mLimits(limits)
+    , mSocketDescriptor(socketDescriptor)
+    , mIsLocal(isLocal)
+    , mRunningCount(0)
+    , mExclusiveRunning(false)
+    , mDisconnected(false)
+    , mPushDelayed(false)
+    , mQueuedResults(0)
+    , mSocketResults(0)
+    , mResultsClosed(false)
 {
+    QMutexLocker locker(&msClientsMutex);
+    msClients.insert(this);
 }
 
 sctpClient::~sctpClient()
 {
+    {
+        QMutexLocker locker(&msClientsMutex);
+        msClients.erase(this);
+    }
+
+    // commands, that wasn't processed before disconnection
+    if (!mCommandsQueue.isEmpty())
+        sctpStatistic::getInstance()->commandsQueued(-mCommandsQueue.size());
+
+    if (mCommand)
+    {
+        mCommand->shutdown();
+        delete mCommand;
+    }
 }
 
-void sctpClient::run()
+void sctpClient::start()
 {
-    mSocket = new QTcpSocket();
-    if (!mSocket->setSocketDescriptor(mSocketDescriptor))
+    bool result = false;
+    if (mIsLocal)
+    {
+        QLocalSocket *socket = new QLocalSocket(this);
+        result = socket->setSocketDescriptor(mSocketDescriptor);
+        socket->setReadBufferSize(SCTP_READ_BUFFER_SIZE);
+        mPeerName = "local";
+        mSocket = socket;
+    }else
+    {
+        QTcpSocket *socket = new QTcpSocket(this);
+        result = socket->setSocketDescriptor((int)mSocketDescriptor);
+        socket->setReadBufferSize(SCTP_READ_BUFFER_SIZE);
+        mPeerName = socket->peerAddress().toString();
+        mSocket = socket;
+    }
+
+    if (!result)
     {
         qDebug() << "Can't process socket descriptor " << mSocketDescriptor;
-        delete mSocket;
+        deleteLater();
         return;
     }
 
@@ -54,41 +114,367 @@ void sctpClient::run()
     mCommand = new sctpCommand();
     mCommand->init();
 
-    while (mSocket->waitForReadyRead())
+    connect(mSocket, SIGNAL(readyRead()), this, SLOT(readyRead()));
+    connect(mSocket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+    connect(mSocket, SIGNAL(bytesWritten(qint64)), this, SLOT(bytesWritten(qint64)));
+    // events fire in sc-memory threads
+    connect(mCommand, SIGNAL(eventsAvailable()), this, SLOT(pushEvents()), Qt::QueuedConnection);
+
+    QTimer *cursorsTimer = new QTimer(this);
+    connect(cursorsTimer, SIGNAL(timeout()), this, SLOT(closeIdleCursors()));
+    cursorsTimer->start(SCTP_CURSORS_CHECK_PERIOD);
+
+    // data could be received before signals connected
+    if (mSocket->bytesAvailable() > 0)
+        readyRead();
+}
+
+void sctpClient::readyRead()
+{
+    // client has too many unprocessed commands, so next ones wait in socket
+    if ((quint32)mCommandsQueue.size() >= mLimits->mMaxQueuedCommands)
+        return;
+
+    // data is read by parts, so read buffer contains at most one incomplete command and one part of data
+    while (mSocket->bytesAvailable() > 0 && (quint32)mCommandsQueue.size() < mLimits->mMaxQueuedCommands)
+    {
+        QByteArray data = mSocket->read(SCTP_READ_BUFFER_SIZE);
+        sctpStatistic::getInstance()->bytesReceived(data.size());
+
+        mReadBuffer.append(data);
+        if (!processCommands())
+        {
+            closeConnection();
+            return;
+        }
+    }
+
+    runCommands();
+}
+
+void sctpClient::disconnected()
+{
+    sctpStatistic::getInstance()->clientDisconnected();
+
+    mDisconnected = true;
+
+    // workers, that wait for client, finish their commands without sending results
+    closeResults();
+
+    destroyIfFinished();
+}
+
+void sctpClient::closeResults()
+{
+    QMutexLocker locker(&mResultsMutex);
+    mResultsClosed = true;
+    mResultsRead.wakeAll();
+}
+
+void sctpClient::closeAllResults()
+{
+    // client can't be destroyed while list is locked
+    QMutexLocker locker(&msClientsMutex);
+
+    std::set<sctpClient*>::iterator it, itEnd = msClients.end();
+    for (it = msClients.begin(); it != itEnd; ++it)
+        (*it)->closeResults();
+}
+
+void sctpClient::destroyAll()
+{
+    std::set<sctpClient*> clients;
     {
-        processCommands();
+        QMutexLocker locker(&msClientsMutex);
+        clients = msClients;
     }
 
-    mCommand->shutdown();
+    // each client removes itself from list in destructor
+    std::set<sctpClient*>::iterator it, itEnd = clients.end();
+    for (it = clients.begin(); it != itEnd; ++it)
+        delete *it;
+}
+
+void sctpClient::bytesWritten(qint64 bytes)
+{
+    sctpStatistic::getInstance()->bytesSent(bytes);
+    updatePendingResults();
+
+    if (mPushDelayed && mSocket->bytesToWrite() <= SCTP_MAX_PUSH_PENDING_SIZE)
+        pushEvents();
 
-    if (mSocket->state() == QTcpSocket::ConnectedState)
+    // client read results, so its commands, that wait, can be processed
+    if (mSocket->bytesToWrite() <= mLimits->mMaxPendingResults)
+        resumeCommands();
+}
+
+bool sctpClient::processCommands()
+{
+    quint32 headerSize = sctpCommand::cmdHeaderSize();
+    quint32 offset = 0;
+
+    // command header: code (1 byte), flags (1 byte), id (4 bytes), parameters size (4 bytes)
+    while ((quint32)mReadBuffer.size() - offset >= headerSize)
     {
-        mSocket->waitForBytesWritten();
-        mSocket->waitForDisconnected();
+        quint32 paramsSize = 0;
+        memcpy(&paramsSize, mReadBuffer.constData() + offset + headerSize - sizeof(paramsSize), sizeof(paramsSize));
+
+        // there is no way to skip such command without reading it, so client is disconnected
+        if (paramsSize > mLimits->mMaxCommandSize)
+        {
+            qDebug() << "Command size " << paramsSize << " is more, than limit " << mLimits->mMaxCommandSize << "; client " << mPeerName;
+            return false;
+        }
+
+        if ((quint32)mReadBuffer.size() - offset - headerSize < paramsSize)
+            break;
+
+        mCommandsQueue.enqueue(mReadBuffer.mid(offset, headerSize + paramsSize));
+        sctpStatistic::getInstance()->commandsQueued(1);
+        offset += headerSize + paramsSize;
     }
-    mSocket->close();
 
-    delete mSocket;
-    mSocket = 0;
+    if (offset > 0)
+        mReadBuffer.remove(0, offset);
 
-    delete mCommand;
-    mCommand = 0;
+    return true;
 }
 
-void sctpClient::processCommands()
+void sctpClient::closeConnection()
 {
-    while (mSocket->bytesAvailable() >= mCommand->cmdHeaderSize())
+    // disconnected slot is called directly, so it mustn't be called by socket signal too
+    QObject::disconnect(mSocket, 0, this, 0);
+    mSocket->close();
+    mReadBuffer.clear();
+
+    disconnected();
+}
+
+void sctpClient::runCommands()
+{
+    while (!mDisconnected && !mExclusiveRunning && !mCommandsQueue.isEmpty() && mRunningCount < mLimits->mMaxRunningCommands)
     {
-        eSctpErrorCode errCode = mCommand->processCommand(mSocket, mSocket);
-        if (errCode != SCTP_NO_ERROR)
+        // server stops and waits for running commands, so new ones aren't started
+        if ((int)mLimits->mStopped != 0)
+            break;
+
+        // client doesn't read results, so new ones aren't produced
+        if (mSocket->bytesToWrite() > mLimits->mMaxPendingResults)
+            break;
+
+        // command, that changes sc-memory, waits for previous commands
+        bool exclusive = !sctpCommand::isReadOnlyCommand((quint8)mCommandsQueue.head().at(0));
+        if (exclusive && mRunningCount > 0)
+            break;
+
+        // server is overloaded: command is rejected at once, so client can retry it later instead of waiting
+        if (mLimits->mServerCommands.fetchAndAddRelaxed(1) >= (int)mLimits->mMaxServerCommands)
         {
-            qDebug() << "Error: " << errCode << "; while process request from client " << mSocket->peerAddress().toString();
-            sctpStatistic::getInstance()->commandProcessed(true);
-        }else
+            mLimits->mServerCommands.fetchAndAddRelaxed(-1);
+            sctpStatistic::getInstance()->commandsQueued(-1);
+            rejectCommand(mCommandsQueue.dequeue());
+            continue;
+        }
+
+        mExclusiveRunning = exclusive;
+        ++mRunningCount;
+        sctpStatistic::getInstance()->commandsQueued(-1);
+        sctpStatistic::getInstance()->commandsRunning(1);
+        mWorkers->start(new sctpCommandTask(this, mCommand, mCommandsQueue.dequeue()));
+    }
+}
+
+void sctpClient::resumeCommands()
+{
+    runCommands();
+
+    if (!mDisconnected && (quint32)mCommandsQueue.size() < mLimits->mMaxQueuedCommands && mSocket->bytesAvailable() > 0)
+        readyRead();
+}
+
+void sctpClient::rejectCommand(const QByteArray &command)
+{
+    quint32 cmdId = 0;
+    memcpy(&cmdId, command.constData() + 2, sizeof(cmdId));
+
+    mCommand->writeResultHeader((eSctpCommandCode)(quint8)command.at(0), cmdId, SCTP_RESULT_BUSY, 0, mSocket);
+    sctpStatistic::getInstance()->commandRejected();
+}
+
+void sctpClient::commandProcessed(QByteArray result, int errCode)
+{
+    Q_ASSERT(mRunningCount > 0);
+    if (--mRunningCount == 0)
+        mExclusiveRunning = false;
+    mLimits->mServerCommands.fetchAndAddRelaxed(-1);
+    sctpStatistic::getInstance()->commandsRunning(-1);
+
+    if (errCode != SCTP_NO_ERROR)
+        qDebug() << "Error: " << errCode << "; while process request from client " << mPeerName;
+
+    if (!mDisconnected)
+        mSocket->write(result);
+
+    resumeCommands();
+    destroyIfFinished();
+}
+
+void sctpClient::sendResults(QByteArray results)
+{
+    if (!mDisconnected)
+        mSocket->write(results);
+
+    {
+        QMutexLocker locker(&mResultsMutex);
+        mQueuedResults -= results.size();
+    }
+    updatePendingResults();
+}
+
+void sctpClient::waitResultsRead(quint32 size)
+{
+    QMutexLocker locker(&mResultsMutex);
+
+    while (!mResultsClosed && mQueuedResults + mSocketResults > mLimits->mMaxPendingResults)
+        mResultsRead.wait(&mResultsMutex);
+
+    mQueuedResults += size;
+}
+
+void sctpClient::updatePendingResults()
+{
+    QMutexLocker locker(&mResultsMutex);
+
+    mSocketResults = mDisconnected ? 0 : mSocket->bytesToWrite();
+    if (mQueuedResults + mSocketResults <= mLimits->mMaxPendingResults)
+        mResultsRead.wakeAll();
+}
+
+void sctpClient::pushEvents()
+{
+    if (mDisconnected)
+        return;
+
+    // client doesn't read data in time, so events are collected until it reads sent data
+    mPushDelayed = mSocket->bytesToWrite() > SCTP_MAX_PUSH_PENDING_SIZE;
+    if (!mPushDelayed)
+        mCommand->pushEvents(mSocket);
+}
+
+void sctpClient::closeIdleCursors()
+{
+    if (!mDisconnected)
+        mCommand->closeIdleCursors();
+}
+
+void sctpClient::destroyIfFinished()
+{
+    if (!mDisconnected || mRunningCount > 0)
+        return;
+
+    mSocket->close();
+    deleteLater();
+}
+
+// -----------------------------
+sctpResultDevice::sctpResultDevice(sctpClient *client)
+    : mClient(client)
+    , mResultStart(0)
+    , mResultEnd(0)
+    , mWrittenSize(0)
+{
+    open(QIODevice::WriteOnly);
+}
+
+QByteArray sctpResultDevice::takeData()
+{
+    QByteArray data = mData;
+    mData.clear();
+    mResultStart = mResultEnd = 0;
+
+    return data;
+}
+
+quint64 sctpResultDevice::writtenSize() const
+{
+    return mWrittenSize;
+}
+
+qint64 sctpResultDevice::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+
+    return -1;
+}
+
+qint64 sctpResultDevice::writeData(const char *data, qint64 maxSize)
+{
+    quint32 headerSize = sctpCommand::resultHeaderSize();
+
+    mData.append(data, maxSize);
+    mWrittenSize += maxSize;
+
+    // find end of the last complete result: header contains size of result data in the last 4 bytes
+    forever
+    {
+        if (mResultEnd == 0)
         {
-            sctpStatistic::getInstance()->commandProcessed(false);
+            if ((quint32)(mData.size() - mResultStart) < headerSize)
+                break;
+
+            quint32 resultSize = 0;
+            memcpy(&resultSize, mData.constData() + mResultStart + headerSize - sizeof(resultSize), sizeof(resultSize));
+            mResultEnd = mResultStart + headerSize + resultSize;
         }
 
-        mSocket->flush();
+        if (mResultEnd > mData.size())
+            break;
+
+        mResultStart = mResultEnd;
+        mResultEnd = 0;
     }
+
+    if (mResultStart >= SCTP_RESULTS_CHUNK_SIZE)
+    {
+        QByteArray results = mData.left(mResultStart);
+
+        // command waits, while client reads previous results, so they aren't collected in memory
+        mClient->waitResultsRead(results.size());
+        QMetaObject::invokeMethod(mClient, "sendResults", Qt::QueuedConnection, Q_ARG(QByteArray, results));
+
+        mData.remove(0, mResultStart);
+        if (mResultEnd > 0)
+            mResultEnd -= mResultStart;
+        mResultStart = 0;
+    }
+
+    return maxSize;
+}
+
+// -----------------------------
+sctpCommandTask::sctpCommandTask(sctpClient *client, sctpCommand *command, const QByteArray &data)
+    : mClient(client)
+    , mCommand(command)
+    , mData(data)
+{
+    setAutoDelete(true);
+    mTimer.start();
+}
+
+void sctpCommandTask::run()
+{
+    QBuffer inBuffer(&mData);
+    inBuffer.open(QIODevice::ReadOnly);
+
+    // complete results are sent while command is processing, the rest is sent with finish notification
+    sctpResultDevice outDevice(mClient);
+    int errCode = mCommand->processCommand(&inBuffer, &outDevice);
+    QByteArray result = outDevice.takeData();
+
+    // latency includes waiting for free worker thread
+    sctpStatistic::getInstance()->commandProcessed((quint8)mData.at(0), errCode != SCTP_NO_ERROR, mTimer.nsecsElapsed() / 1000, outDevice.writtenSize());
+
+    // result is written into socket in thread of client
+    QMetaObject::invokeMethod(mClient, "commandProcessed", Qt::QueuedConnection, Q_ARG(QByteArray, result), Q_ARG(int, errCode));
 }
@@ -25,30 +25,195 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QRunnable>
+#include <QIODevice>
+#include <QByteArray>
+#include <QQueue>
+#include <QString>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
 
+#include <set>
 
-class QTcpSocket;
+
+class QThreadPool;
 class sctpCommand;
 
-class sctpClient : public QRunnable
+//! Limits of commands processing. One instance is shared by all clients of server
+struct sClientLimits
+{
+    quint32 mMaxRunningCommands; // maximum number of commands of one client, that are processed at one moment
+    quint32 mMaxQueuedCommands; // maximum number of received commands of one client, that wait for processing
+    quint32 mMaxPendingResults; // maximum size of results, that client didn't read yet (bytes)
+    quint32 mMaxServerCommands; // maximum number of commands of all clients in worker threads pool
+    quint32 mMaxCommandSize; // maximum size of command parameters (bytes), connection is closed, when client sends bigger command
+    QAtomicInt mServerCommands; // number of commands of all clients in worker threads pool
+    QAtomicInt mStopped; // flag, that server stops, so new commands aren't processed
+};
+
+/*! Connection with one client. It lives in one of server I/O threads, reads commands
+ * from socket without blocking and runs them in worker threads pool, so one thread
+ * serves many connections.
+ * Client can send many commands without waiting for results. Commands, that just read sc-memory,
+ * are processed concurrently and their results are sent as soon as they are ready, so client
+ * should match results by command id. Other commands are processed after all previous commands
+ * and before all next ones.
+ */
+class sctpClient : public QObject
 {
+    Q_OBJECT
 public:
-    explicit sctpClient(int socketDescriptor);
+    /*! @param socketDescriptor Descriptor of connection socket
+     * @param isLocal Flag, that connection is local (unix domain socket), otherwise it's tcp one
+     * @param workers Pointer to worker threads pool
+     * @param limits Pointer to limits of commands processing
+     */
+    explicit sctpClient(quintptr socketDescriptor, bool isLocal, QThreadPool *workers, sClientLimits *limits);
     virtual ~sctpClient();
 
-    void run();
+    /*! Blocks worker thread, while client has too many unread results, and reserves place for results,
+     * that will be sent. It's called from worker threads before sendResults
+     * @param size Size of results data
+     */
+    void waitResultsRead(quint32 size);
+
+    /*! Wakes worker threads, that wait for client to read results, and makes them finish without sending
+     * results. It's called on disconnection and on server stop (from any thread)
+     */
+    void closeResults();
+
+    //! Calls closeResults for all clients. It's used on server stop, before waiting for worker threads
+    static void closeAllResults();
+    //! Destroys all clients. It's used on server stop, when I/O threads, where clients live, are finished
+    static void destroyAll();
+
+public slots:
+    //! Opens socket. It should be called in thread, where client object lives
+    void start();
+    //! Sends result of processed command to client (it called from worker threads with queued connection)
+    void commandProcessed(QByteArray result, int errCode);
+    //! Sends part of results, while command is processing (it called from worker threads with queued connection)
+    void sendResults(QByteArray results);
+    //! Sends fired events to client, if it enabled push mode
+    void pushEvents();
+    //! Closes iteration cursors, that client doesn't use
+    void closeIdleCursors();
+
+protected slots:
+    void readyRead();
+    void disconnected();
+    void bytesWritten(qint64 bytes);
 
 protected:
-    void processCommands();
+    /*! Extracts completely received commands from read buffer
+     * @return If client sent command, that is bigger, than limit, then returns false (connection should be closed);
+     * otherwise returns true
+     */
+    bool processCommands();
+    //! Closes connection because of client protocol violation
+    void closeConnection();
+    //! Starts processing of queued commands, that can be processed now
+    void runCommands();
+    //! Starts processing of queued commands and reads commands, that wait in socket because of limits
+    void resumeCommands();
+    //! Sends result with SCTP_RESULT_BUSY code for command, that can't be processed because of server overload
+    void rejectCommand(const QByteArray &command);
+    //! Destroys client, when connection is closed and there are no running commands
+    void destroyIfFinished();
+    //! Updates size of unread results and wakes worker threads, that wait for client
+    void updatePendingResults();
 
 private:
-    //! Pointer to client socket
-    QTcpSocket *mSocket;
+    //! Pointer to client socket (tcp or local one)
+    QIODevice *mSocket;
+    //! Client address for logging
+    QString mPeerName;
     //! Pointer to command processing class
     sctpCommand *mCommand;
+    //! Pointer to worker threads pool
+    QThreadPool *mWorkers;
+    //! Pointer to limits of commands processing
+    sClientLimits *mLimits;
+
+    quintptr mSocketDescriptor;
+    bool mIsLocal;
+
+    //! Received data, that doesn't contain complete command yet
+    QByteArray mReadBuffer;
+    //! Received commands, that wait for processing
+    QQueue<QByteArray> mCommandsQueue;
+    //! Number of commands, that are processing in worker threads now
+    quint32 mRunningCount;
+    //! Flag, that command, which changes sc-memory, is processing now (no other commands run with it)
+    bool mExclusiveRunning;
+    //! Flag, that connection closed
+    bool mDisconnected;
+    //! Flag, that events pushing waits until client reads sent data
+    bool mPushDelayed;
+
+    //! Lock for results flow control data, that is used from worker threads
+    QMutex mResultsMutex;
+    //! Condition, that client read results (or disconnected)
+    QWaitCondition mResultsRead;
+    //! Size of results, that are passed from worker threads, but not written into socket yet
+    quint64 mQueuedResults;
+    //! Size of results, that are written into socket, but not read by client yet
+    quint64 mSocketResults;
+    //! Flag, that results aren't sent anymore, because connection closed
+    bool mResultsClosed;
+
+    //! Lock of all clients list
+    static QMutex msClientsMutex;
+    //! All existing clients
+    static std::set<sctpClient*> msClients;
+};
+
+/*! Output device for command results. It sends complete results to client, when enough data
+ * collected, so long results (for example iteration pages) go to client while command is processing.
+ * Results are never split, because results of concurrent commands are mixed in connection.
+ */
+class sctpResultDevice : public QIODevice
+{
+public:
+    explicit sctpResultDevice(sctpClient *client);
+
+    //! Returns data, that wasn't sent yet
+    QByteArray takeData();
+    //! Returns size of all written data
+    quint64 writtenSize() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private:
+    sctpClient *mClient;
+    QByteArray mData;
+    //! Offset of the first incomplete result in data
+    qint32 mResultStart;
+    //! End of the first incomplete result (0, if its header isn't complete)
+    qint32 mResultEnd;
+    //! Size of all written data (it's a cost of command)
+    quint64 mWrittenSize;
+};
 
-    int mSocketDescriptor;
-    
+/*! Task to process one command in worker thread
+ */
+class sctpCommandTask : public QRunnable
+{
+public:
+    explicit sctpCommandTask(sctpClient *client, sctpCommand *command, const QByteArray &data);
+
+    void run();
+
+private:
+    sctpClient *mClient;
+    sctpCommand *mCommand;
+    //! Command data (header and parameters)
+    QByteArray mData;
+    //! Timer to measure command latency, it starts when command goes to worker threads pool
+    QElapsedTimer mTimer;
 };
 
 #endif // CLIENTTHREAD_H
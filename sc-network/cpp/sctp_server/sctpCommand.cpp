@@ -23,6 +23,7 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include "sctpCommand.h"
 #include "sctpStatistic.h"
 #include "sctpEventManager.h"
+#include "sctpConstructionSearch.h"
 
 #include <QIODevice>
 #include <QDataStream>
@@ -35,14 +36,38 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 
 #define SCTP_READ_TIMEOUT   10000
 
+//! Maximum number of results in one page of iteration results
+#define SCTP_ITERATE_MAX_PAGE_SIZE  4096
+//! Maximum number of opened iteration cursors for one client
+#define SCTP_MAX_CURSORS            64
+//! Maximum number of opened iteration cursors of all clients
+#define SCTP_MAX_SERVER_CURSORS     4096
+//! Time, after that unused cursor is closed (milliseconds)
+#define SCTP_CURSOR_IDLE_TIMEOUT    60000
+//! Size of blocks to read link content
+#define SCTP_CONTENT_READ_SIZE      (1024 * 1024)
+//! Maximum number of events, that wait for sending to one client. Next events are lost
+#define SCTP_MAX_PENDING_EVENTS     65536
+//! Maximum number of variables in construction template
+#define SCTP_CONSTRUCTION_MAX_VARIABLES     255
+//! Maximum size of constructions values, that are returned in one result (without paging)
+#define SCTP_CONSTRUCTION_MAX_RESULTS_SIZE  (16 * 1024 * 1024)
+
 #define READ_PARAM(val)  if (params->readRawData((char*)&val, sizeof(val)) != sizeof(val)) \
                             return SCTP_ERROR_CMD_READ_PARAMS;
 
 // -----------------------------
 
+QAtomicInt sctpCommand::msCursorsCount;
+
 sctpCommand::sctpCommand(QObject *parent)
     : QObject(parent)
     , mSendEventsCount(0)
+    , mSendEventsLost(false)
+    , mPushMode(false)
+    , mPushCmdId(0)
+    , mPushScheduled(false)
+    , mLastCursorId(0)
 {
 }
 
@@ -60,6 +85,12 @@ void sctpCommand::shutdown()
     for (it = mEventsSet.begin(); it != itEnd; ++it)
         sctpEventManager::getSingleton()->destroyEvent(*it);
     mEventsSet.clear();
+
+    QMutexLocker locker(&mIteratorsMutex);
+    tIteratorsMap::iterator itCursor, itCursorEnd = mIterators.end();
+    for (itCursor = mIterators.begin(); itCursor != itCursorEnd; ++itCursor)
+        freeCursor(itCursor->second);
+    mIterators.clear();
 }
 
 eSctpErrorCode sctpCommand::processCommand(QIODevice *inDevice, QIODevice *outDevice)
@@ -119,6 +150,15 @@ eSctpErrorCode sctpCommand::processCommand(QIODevice *inDevice, QIODevice *outDe
     case SCTP_CMD_ITERATE_ELEMENTS:
         return processIterateElements(cmdFlags, cmdId, &paramsStream, outDevice);
 
+    case SCTP_CMD_ITERATE_CONSTRUCTION:
+        return processIterateConstruction(cmdFlags, cmdId, &paramsStream, outDevice);
+
+    case SCTP_CMD_ITERATE_NEXT:
+        return processIterateNext(cmdFlags, cmdId, &paramsStream, outDevice);
+
+    case SCTP_CMD_ITERATE_FREE:
+        return processIterateFree(cmdFlags, cmdId, &paramsStream, outDevice);
+
     case SCTP_CMD_EVENT_CREATE:
         return processCreateEvent(cmdFlags, cmdId, &paramsStream, outDevice);
 
@@ -137,6 +177,9 @@ eSctpErrorCode sctpCommand::processCommand(QIODevice *inDevice, QIODevice *outDe
     case SCTP_CMD_STATISTICS:
         return processStatistics(cmdFlags, cmdId, &paramsStream, outDevice);
 
+    case SCTP_CMD_BATCH:
+        return processBatch(cmdFlags, cmdId, &paramsStream, outDevice);
+
     default:
         return SCTP_ERROR_UNKNOWN_CMD;
     }
@@ -175,6 +218,31 @@ quint32 sctpCommand::cmdHeaderSize()
     return 2 * sizeof(quint8) + 2 * sizeof(quint32);
 }
 
+quint32 sctpCommand::resultHeaderSize()
+{
+    return 2 * sizeof(quint8) + 2 * sizeof(quint32);
+}
+
+bool sctpCommand::isReadOnlyCommand(quint8 cmdCode)
+{
+    switch (cmdCode)
+    {
+    case SCTP_CMD_CHECK_ELEMENT:
+    case SCTP_CMD_GET_ELEMENT_TYPE:
+    case SCTP_CMD_GET_LINK_CONTENT:
+    case SCTP_CMD_FIND_LINKS:
+    case SCTP_CMD_ITERATE_ELEMENTS:
+    case SCTP_CMD_ITERATE_CONSTRUCTION:
+    case SCTP_CMD_ITERATE_NEXT:
+    case SCTP_CMD_FIND_ELEMENT_BY_SYSITDF:
+    case SCTP_CMD_STATISTICS:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
 
 // ----------- process commands -------------
 eSctpErrorCode sctpCommand::processCheckElement(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
@@ -324,72 +392,91 @@ eSctpErrorCode sctpCommand::processGetLinkContent(quint32 cmdFlags, quint32 cmdI
 {
     sc_addr addr;
     sc_stream *stream = (sc_stream*)nullptr;
-    sc_char data_buffer[512];
     sc_uint32 data_len = 0;
-    sc_uint32 data_written = 0;
-    sc_uint32 data_read = 0;
+    sc_uint32 range_offset = 0;
+    sc_uint32 range_len = 0;
+    bool isRange = (cmdFlags & SCTP_LINK_CONTENT_FLAG_RANGE) != 0;
 
-    Q_UNUSED(cmdFlags);
     Q_ASSERT(params != 0);
 
     // read sc-addr of sc-element from parameters
-    if (params->readRawData((char*)&addr, sizeof(addr)) != sizeof(addr))
-        return SCTP_ERROR_CMD_READ_PARAMS;
+    READ_PARAM(addr);
+    if (isRange)
+    {
+        READ_PARAM(range_offset);
+        READ_PARAM(range_len);
+    }
 
     eSctpResultCode resCode = (sc_memory_get_link_content(addr, &stream) == SC_RESULT_OK) ? SCTP_RESULT_OK : SCTP_RESULT_FAIL;
 
+    if (resCode == SCTP_RESULT_OK && sc_stream_get_length(stream, &data_len) != SC_RESULT_OK)
+        resCode = SCTP_RESULT_FAIL;
 
-    if (resCode == SCTP_RESULT_OK)
+    // requested range is limited by content size (zero length means up to the end)
+    range_offset = qMin(range_offset, data_len);
+    if (!isRange || range_len == 0 || range_len > data_len - range_offset)
+        range_len = data_len - range_offset;
+
+    // skip data before range: seek, if stream supports it, or read
+    if (resCode == SCTP_RESULT_OK && range_offset > 0)
     {
-        if (sc_stream_get_length(stream, &data_len) != SC_RESULT_OK)
+        if (sc_stream_check_flag(stream, SC_STREAM_SEEK) == SC_TRUE)
         {
-            resCode = SCTP_RESULT_FAIL;
-            sc_stream_free(stream);
-            stream = (sc_stream*)nullptr;
+            if (sc_stream_seek(stream, SC_STREAM_SEEK_SET, range_offset) != SC_RESULT_OK)
+                resCode = SCTP_RESULT_FAIL;
+        }else
+        {
+            QByteArray skipped(qMin(range_offset, (sc_uint32)SCTP_CONTENT_READ_SIZE), 0);
+            sc_uint32 skipped_len = 0, read_len = 0;
+            while (resCode == SCTP_RESULT_OK && skipped_len < range_offset)
+            {
+                if (sc_stream_read_data(stream, skipped.data(), qMin(range_offset - skipped_len, (sc_uint32)skipped.size()), &read_len) != SC_RESULT_OK || read_len == 0)
+                    resCode = SCTP_RESULT_FAIL;
+                skipped_len += read_len;
+            }
         }
     }
-    // send result
-    writeResultHeader(SCTP_CMD_GET_LINK_CONTENT, cmdId, resCode, data_len, outDevice);
 
-    if (resCode == SCTP_RESULT_FAIL)
+    if (resCode != SCTP_RESULT_OK)
     {
+        writeResultHeader(SCTP_CMD_GET_LINK_CONTENT, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
         if (stream != nullptr)
             sc_stream_free(stream);
 
         return SCTP_ERROR;
     }
 
-    // write content data
-    while (sc_stream_eof(stream) != SC_TRUE)
+    // range result starts with size of whole content
+    if (isRange)
     {
-        // if there are any error to read data, then
-        // write null into output
-        if (sc_stream_read_data(stream, data_buffer, 512, &data_read) != SC_RESULT_OK)
-        {
-            if (data_written < data_len)
-            {
-                quint32 len = data_len - data_written;
-                sc_char *data = new sc_char[len];
-                memset(data, 0, len);
-                outDevice->write(data, len);
-                delete []data;
+        writeResultHeader(SCTP_CMD_GET_LINK_CONTENT, cmdId, SCTP_RESULT_OK, sizeof(data_len) + range_len, outDevice);
+        outDevice->write((const char*)&data_len, sizeof(data_len));
+    }else
+        writeResultHeader(SCTP_CMD_GET_LINK_CONTENT, cmdId, SCTP_RESULT_OK, range_len, outDevice);
 
-                sc_stream_free(stream);
-                return SCTP_ERROR;
-            }
+    // content is passed to output device by blocks, so it isn't collected in separate buffer
+    QByteArray block(qMin(range_len, (sc_uint32)SCTP_CONTENT_READ_SIZE), 0);
+    sc_uint32 data_written = 0, read_len = 0;
+    eSctpErrorCode result = SCTP_NO_ERROR;
+    while (data_written < range_len)
+    {
+        // if there are any error to read data, then the rest of result is filled with zeros (size is already sent)
+        if (result == SCTP_NO_ERROR && sc_stream_read_data(stream, block.data(), qMin(range_len - data_written, (sc_uint32)block.size()), &read_len) != SC_RESULT_OK)
+            result = SCTP_ERROR;
+
+        if (result != SCTP_NO_ERROR || read_len == 0)
+        {
+            result = SCTP_ERROR;
+            read_len = qMin(range_len - data_written, (sc_uint32)block.size());
+            block.fill(0);
         }
 
-        outDevice->write(data_buffer, data_read);
-        data_written += data_read;
+        outDevice->write(block.constData(), read_len);
+        data_written += read_len;
     }
+    sc_stream_free(stream);
 
-    Q_ASSERT(data_written == data_len);
-
-    if (resCode == SCTP_RESULT_OK)
-        sc_stream_free(stream);
-
-
-    return SCTP_NO_ERROR;
+    return result;
 }
 
 eSctpErrorCode sctpCommand::processFindLinks(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
@@ -463,176 +550,570 @@ eSctpErrorCode sctpCommand::processSetLinkContent(quint32 cmdFlags, quint32 cmdI
     return SCTP_NO_ERROR;
 }
 
-eSctpErrorCode sctpCommand::processIterateElements(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+eSctpErrorCode sctpCommand::createIterator(QDataStream *params, sc_iterator3 **it3, sc_iterator5 **it5)
 {
     sc_uchar iterator_type = 0;
     sc_type type1, type2, type3, type4;
     sc_addr addr1, addr2, addr3;
 
-    Q_UNUSED(cmdFlags);
-
-    Q_ASSERT(params != nullptr);
+    *it3 = (sc_iterator3*)nullptr;
+    *it5 = (sc_iterator5*)nullptr;
 
     // read iterator type
     READ_PARAM(iterator_type);
 
-    Q_ASSERT(iterator_type < SCTP_ITERATOR_COUNT);
-
+    switch (iterator_type)
+    {
     // 3-elements iterators
-    if (iterator_type <= SCTP_ITERATOR_3F_A_F)
+    case SCTP_ITERATOR_3A_A_F:
+        READ_PARAM(type1);
+        READ_PARAM(type2);
+        READ_PARAM(addr1);
+        *it3 = sc_iterator3_a_a_f_new(type1, type2, addr1);
+        break;
+
+    case SCTP_ITERATOR_3F_A_A:
+        READ_PARAM(addr1);
+        READ_PARAM(type1);
+        READ_PARAM(type2);
+        *it3 = sc_iterator3_f_a_a_new(addr1, type1, type2);
+        break;
+
+    case SCTP_ITERATOR_3F_A_F:
+        READ_PARAM(addr1);
+        READ_PARAM(type1);
+        READ_PARAM(addr2);
+        *it3 = sc_iterator3_f_a_f_new(addr1, type1, addr2);
+        break;
+
+    // 5-elements iterators
+    case SCTP_ITERATOR_5F_A_A_A_F:
+        READ_PARAM(addr1);
+        READ_PARAM(type1);
+        READ_PARAM(type2);
+        READ_PARAM(type3);
+        READ_PARAM(addr2);
+        *it5 = sc_iterator5_f_a_a_a_f_new(addr1, type1, type2, type3, addr2);
+        break;
+
+    case SCTP_ITERATOR_5_A_A_F_A_A:
+        READ_PARAM(type1);
+        READ_PARAM(type2);
+        READ_PARAM(addr1);
+        READ_PARAM(type3);
+        READ_PARAM(type4);
+        *it5 = sc_iterator5_a_a_f_a_a_new(type1, type2, addr1, type3, type4);
+        break;
+
+    case SCTP_ITERATOR_5_A_A_F_A_F:
+        READ_PARAM(type1);
+        READ_PARAM(type2);
+        READ_PARAM(addr1);
+        READ_PARAM(type3);
+        READ_PARAM(addr2);
+        *it5 = sc_iterator5_a_a_f_a_f_new(type1, type2, addr1, type3, addr2);
+        break;
+
+    case SCTP_ITERATOR_5_F_A_A_A_A:
+        READ_PARAM(addr1);
+        READ_PARAM(type1);
+        READ_PARAM(type2);
+        READ_PARAM(type3);
+        READ_PARAM(type4);
+        *it5 = sc_iterator5_f_a_a_a_a_new(addr1, type1, type2, type3, type4);
+        break;
+
+    case SCTP_ITERATOR_5_F_A_F_A_A:
+        READ_PARAM(addr1);
+        READ_PARAM(type1);
+        READ_PARAM(addr2);
+        READ_PARAM(type2);
+        READ_PARAM(type3);
+        *it5 = sc_iterator5_f_a_f_a_a_new(addr1, type1, addr2, type2, type3);
+        break;
+
+    case SCTP_ITERATOR_5_F_A_F_A_F:
+        READ_PARAM(addr1);
+        READ_PARAM(type1);
+        READ_PARAM(addr2);
+        READ_PARAM(type2);
+        READ_PARAM(addr3);
+        *it5 = sc_iterator5_f_a_f_a_f_new(addr1, type1, addr2, type2, addr3);
+        break;
+
+    default:
+        return SCTP_ERROR;
+    }
+
+    return (*it3 != nullptr || *it5 != nullptr) ? SCTP_NO_ERROR : SCTP_ERROR;
+}
+
+bool sctpCommand::readIteratorResults(sc_iterator3 *it3, sc_iterator5 *it5, quint32 maxCount, QByteArray &results, quint32 &count)
+{
+    sc_addr addr;
+
+    count = 0;
+    while (maxCount == 0 || count < maxCount)
     {
-        sc_iterator3 *it = (sc_iterator3*)nullptr;
+        if (it3 != nullptr)
+        {
+            if (sc_iterator3_next(it3) != SC_TRUE)
+                return true;
 
-        switch (iterator_type)
+            for (sc_uint i = 0; i < 3; i++)
+            {
+                addr = sc_iterator3_value(it3, i);
+                results.append((const char*)&addr, sizeof(addr));
+            }
+        }else
         {
-        case SCTP_ITERATOR_3A_A_F:
-            READ_PARAM(type1);
-            READ_PARAM(type2);
-            READ_PARAM(addr1);
-            it = sc_iterator3_a_a_f_new(type1, type2, addr1);
-            break;
+            if (sc_iterator5_next(it5) != SC_TRUE)
+                return true;
 
-        case SCTP_ITERATOR_3F_A_A:
-            READ_PARAM(addr1);
-            READ_PARAM(type1);
-            READ_PARAM(type2);
-            it = sc_iterator3_f_a_a_new(addr1, type1, type2);
-            break;
+            for (sc_uint i = 0; i < 5; i++)
+            {
+                addr = sc_iterator5_value(it5, i);
+                results.append((const char*)&addr, sizeof(addr));
+            }
+        }
 
-        case SCTP_ITERATOR_3F_A_F:
-            READ_PARAM(addr1);
-            READ_PARAM(type1);
-            READ_PARAM(addr2);
-            it = sc_iterator3_f_a_f_new(addr1, type1, addr2);
-            break;
+        ++count;
+    }
 
-        default:
-            return SCTP_ERROR;
+    return false;
+}
+
+void sctpCommand::freeIterator(sc_iterator3 *it3, sc_iterator5 *it5)
+{
+    if (it3 != nullptr)
+        sc_iterator3_free(it3);
+    if (it5 != nullptr)
+        sc_iterator5_free(it5);
+}
+
+eSctpErrorCode sctpCommand::processIterateElements(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
+    sc_iterator3 *it3 = (sc_iterator3*)nullptr;
+    sc_iterator5 *it5 = (sc_iterator5*)nullptr;
+    quint32 pageSize = 0;
+    QByteArray results;
+    sc_uint32 results_count = 0;
+
+    Q_ASSERT(params != nullptr);
+
+    eSctpErrorCode errCode = createIterator(params, &it3, &it5);
+    if (errCode != SCTP_NO_ERROR)
+    {
+        if (errCode == SCTP_ERROR)
+            writeResultHeader(SCTP_CMD_ITERATE_ELEMENTS, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return errCode;
+    }
+
+    if (cmdFlags & (SCTP_ITERATE_FLAG_CURSOR | SCTP_ITERATE_FLAG_STREAM))
+    {
+        if (params->readRawData((char*)&pageSize, sizeof(pageSize)) != sizeof(pageSize))
+        {
+            freeIterator(it3, it5);
+            return SCTP_ERROR_CMD_READ_PARAMS;
         }
 
-        Q_ASSERT(it != nullptr);
+        if (pageSize == 0 || pageSize > SCTP_ITERATE_MAX_PAGE_SIZE)
+            pageSize = SCTP_ITERATE_MAX_PAGE_SIZE;
+    }
+
+    // results are sent by pages, while they are produced: each page in separate result
+    // with flag, that there are more pages
+    if (cmdFlags & SCTP_ITERATE_FLAG_STREAM)
+    {
+        bool finished = false;
+        while (!finished)
+        {
+            results.clear();
+            finished = readIteratorResults(it3, it5, pageSize, results, results_count);
+
+            quint32 more = finished ? 0 : 1;
+            writeResultHeader(SCTP_CMD_ITERATE_ELEMENTS, cmdId, SCTP_RESULT_OK, sizeof(more) + sizeof(results_count) + results.size(), outDevice);
+            outDevice->write((const char*)&more, sizeof(more));
+            outDevice->write((const char*)&results_count, sizeof(results_count));
+            outDevice->write(results);
+        }
 
-        // create results data
-        QByteArray results;
-        QBuffer buffer(&results);
-        sc_uint32 results_count = 0;
-        sc_addr addr;
+        freeIterator(it3, it5);
+        return SCTP_NO_ERROR;
+    }
 
-        buffer.open(QBuffer::WriteOnly);
-        while (sc_iterator3_next(it) == SC_TRUE)
+    // first page and cursor to get next pages by SCTP_CMD_ITERATE_NEXT
+    if (cmdFlags & SCTP_ITERATE_FLAG_CURSOR)
+    {
+        quint32 cursorId = 0;
+        if (!readIteratorResults(it3, it5, pageSize, results, results_count))
         {
-            results_count++;
-            for (sc_uint i = 0; i < 3; i++)
+            cursorId = appendCursor(it3, it5);
+            if (cursorId == 0)
             {
-                addr = sc_iterator3_value(it, i);
-                buffer.write((const char*)&addr, sizeof(addr));
+                freeIterator(it3, it5);
+                writeResultHeader(SCTP_CMD_ITERATE_ELEMENTS, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+                return SCTP_ERROR;
             }
-        }
-        buffer.close();
+        }else
+            freeIterator(it3, it5);
+
+        writeIteratorPage(SCTP_CMD_ITERATE_ELEMENTS, cmdId, cursorId, results_count, results, outDevice);
+        return SCTP_NO_ERROR;
+    }
+
+    readIteratorResults(it3, it5, 0, results, results_count);
+    freeIterator(it3, it5);
+
+    // write result
+    writeResultHeader(SCTP_CMD_ITERATE_ELEMENTS, cmdId, SCTP_RESULT_OK, results.size() + sizeof(results_count), outDevice);
+    outDevice->write((const char*)&results_count, sizeof(results_count));
+    if (results_count > 0)
+        outDevice->write((const char*)results.constData(), results.size());
+
+    return SCTP_NO_ERROR;
+}
+
+eSctpErrorCode sctpCommand::processIterateNext(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
+    quint32 cursorId = 0;
+    quint32 pageSize = 0;
+    sIteratorCursor cursor;
+    QByteArray results;
+    sc_uint32 results_count = 0;
+
+    Q_UNUSED(cmdFlags);
+    Q_ASSERT(params != 0);
+
+    READ_PARAM(cursorId);
+    READ_PARAM(pageSize);
 
-        // write result
-        writeResultHeader(SCTP_CMD_ITERATE_ELEMENTS, cmdId, SCTP_RESULT_OK, results.size() + sizeof(results_count), outDevice);
-        outDevice->write((const char*)&results_count, sizeof(results_count));
-        if (results_count > 0)
-            outDevice->write((const char*)results.constData(), results.size());
+    if (pageSize == 0 || pageSize > SCTP_ITERATE_MAX_PAGE_SIZE)
+        pageSize = SCTP_ITERATE_MAX_PAGE_SIZE;
 
-        sc_iterator3_free(it);
+    // cursor is taken while its page is read, so it can't be used concurrently
+    if (!takeCursor(cursorId, cursor))
+    {
+        writeResultHeader(SCTP_CMD_ITERATE_NEXT, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return SCTP_ERROR;
+    }
 
+    if (readIteratorResults(cursor.it3, cursor.it5, pageSize, results, results_count))
+    {
+        freeCursor(cursor);
+        cursorId = 0;
     }else
     {
-        // 5-elements iterators
-        sc_iterator5 *it = (sc_iterator5*)nullptr;
+        QMutexLocker locker(&mIteratorsMutex);
+        cursor.idleTimer.start();
+        mIterators[cursorId] = cursor;
+    }
 
-        switch (iterator_type)
-        {
-        case SCTP_ITERATOR_5F_A_A_A_F:
-            READ_PARAM(addr1);
-            READ_PARAM(type1);
-            READ_PARAM(type2);
-            READ_PARAM(type3);
-            READ_PARAM(addr2);
-            it = sc_iterator5_f_a_a_a_f_new(addr1, type1, type2, type3, addr2);
-            break;
+    writeIteratorPage(SCTP_CMD_ITERATE_NEXT, cmdId, cursorId, results_count, results, outDevice);
 
-        case SCTP_ITERATOR_5_A_A_F_A_A:
-            READ_PARAM(type1);
-            READ_PARAM(type2);
-            READ_PARAM(addr1);
-            READ_PARAM(type3);
-            READ_PARAM(type4);
-            it = sc_iterator5_a_a_f_a_a_new(type1, type2, addr1, type3, type4);
-            break;
+    return SCTP_NO_ERROR;
+}
 
-        case SCTP_ITERATOR_5_A_A_F_A_F:
-            READ_PARAM(type1);
-            READ_PARAM(type2);
-            READ_PARAM(addr1);
-            READ_PARAM(type3);
-            READ_PARAM(addr2);
-            it = sc_iterator5_a_a_f_a_f_new(type1, type2, addr1, type3, addr2);
-            break;
+eSctpErrorCode sctpCommand::processIterateFree(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
+    quint32 cursorId = 0;
+    sIteratorCursor cursor;
 
-        case SCTP_ITERATOR_5_F_A_A_A_A:
-            READ_PARAM(addr1);
-            READ_PARAM(type1);
-            READ_PARAM(type2);
-            READ_PARAM(type3);
-            READ_PARAM(type4);
-            it = sc_iterator5_f_a_a_a_a_new(addr1, type1, type2, type3, type4);
-            break;
+    Q_UNUSED(cmdFlags);
+    Q_ASSERT(params != 0);
 
-        case SCTP_ITERATOR_5_F_A_F_A_A:
-            READ_PARAM(addr1);
-            READ_PARAM(type1);
-            READ_PARAM(addr2);
-            READ_PARAM(type2);
-            READ_PARAM(type3);
-            it = sc_iterator5_f_a_f_a_a_new(addr1, type1, addr2, type2, type3);
-            break;
+    READ_PARAM(cursorId);
 
-        case SCTP_ITERATOR_5_F_A_F_A_F:
-            READ_PARAM(addr1);
-            READ_PARAM(type1);
-            READ_PARAM(addr2);
-            READ_PARAM(type2);
-            READ_PARAM(addr3);
-            it = sc_iterator5_f_a_f_a_f_new(addr1, type1, addr2, type2, addr3);
-            break;
+    if (!takeCursor(cursorId, cursor))
+    {
+        writeResultHeader(SCTP_CMD_ITERATE_FREE, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return SCTP_ERROR;
+    }
 
-        default:
-            return SCTP_ERROR;
+    freeCursor(cursor);
+    writeResultHeader(SCTP_CMD_ITERATE_FREE, cmdId, SCTP_RESULT_OK, 0, outDevice);
+
+    return SCTP_NO_ERROR;
+}
+
+quint32 sctpCommand::appendCursor(sc_iterator3 *it3, sc_iterator5 *it5)
+{
+    QMutexLocker locker(&mIteratorsMutex);
+
+    if (mIterators.size() >= SCTP_MAX_CURSORS)
+        return 0;
+
+    // cursors of all clients hold deleted sc-elements, so their number is limited too
+    if (msCursorsCount.fetchAndAddRelaxed(1) >= SCTP_MAX_SERVER_CURSORS)
+    {
+        msCursorsCount.fetchAndAddRelaxed(-1);
+        return 0;
+    }
+
+    // zero id means, that there are no more results
+    do
+    {
+        ++mLastCursorId;
+    } while (mLastCursorId == 0 || mIterators.find(mLastCursorId) != mIterators.end());
+
+    sIteratorCursor &cursor = mIterators[mLastCursorId];
+    cursor.it3 = it3;
+    cursor.it5 = it5;
+    cursor.idleTimer.start();
+
+    return mLastCursorId;
+}
+
+bool sctpCommand::takeCursor(quint32 cursorId, sIteratorCursor &cursor)
+{
+    QMutexLocker locker(&mIteratorsMutex);
+
+    tIteratorsMap::iterator it = mIterators.find(cursorId);
+    if (it == mIterators.end())
+        return false;
+
+    cursor = it->second;
+    mIterators.erase(it);
+
+    return true;
+}
+
+void sctpCommand::freeCursor(sIteratorCursor &cursor)
+{
+    freeIterator(cursor.it3, cursor.it5);
+    cursor.it3 = (sc_iterator3*)nullptr;
+    cursor.it5 = (sc_iterator5*)nullptr;
+
+    msCursorsCount.fetchAndAddRelaxed(-1);
+}
+
+void sctpCommand::closeIdleCursors()
+{
+    QMutexLocker locker(&mIteratorsMutex);
+
+    // cursors, that are used now, are taken from map, so they aren't closed
+    tIteratorsMap::iterator it = mIterators.begin();
+    while (it != mIterators.end())
+    {
+        if (it->second.idleTimer.elapsed() >= SCTP_CURSOR_IDLE_TIMEOUT)
+        {
+            freeCursor(it->second);
+            mIterators.erase(it++);
+        }else
+            ++it;
+    }
+}
+
+void sctpCommand::writeIteratorPage(eSctpCommandCode cmdCode, quint32 cmdId, quint32 cursorId, quint32 count, const QByteArray &results, QIODevice *outDevice)
+{
+    writeResultHeader(cmdCode, cmdId, SCTP_RESULT_OK, sizeof(cursorId) + sizeof(count) + results.size(), outDevice);
+    outDevice->write((const char*)&cursorId, sizeof(cursorId));
+    outDevice->write((const char*)&count, sizeof(count));
+    outDevice->write(results);
+}
+
+//! Collects found constructions in one buffer up to size limit
+class sctpConstructionBuffer : public sctpConstructionListener
+{
+public:
+    explicit sctpConstructionBuffer(QByteArray &data)
+        : mData(data)
+        , mOverflow(false)
+    {
+    }
+
+    bool constructionFound(const sc_addr *values, quint8 count)
+    {
+        if ((quint32)mData.size() + count * sizeof(sc_addr) > SCTP_CONSTRUCTION_MAX_RESULTS_SIZE)
+        {
+            mOverflow = true;
+            return false;
         }
 
-        Q_ASSERT(it != nullptr);
+        mData.append((const char*)values, count * sizeof(sc_addr));
+        return true;
+    }
 
-        // create results data
-        QByteArray results;
-        QBuffer buffer(&results);
-        sc_uint32 results_count = 0;
-        sc_addr addr;
+    //! Returns true, if search was stopped, because results are too large
+    bool isOverflow() const
+    {
+        return mOverflow;
+    }
+
+private:
+    QByteArray &mData;
+    bool mOverflow;
+};
+
+//! Writes found constructions by pages, each page in separate result
+class sctpConstructionPages : public sctpConstructionListener
+{
+public:
+    explicit sctpConstructionPages(sctpCommand *command, quint32 cmdId, quint32 pageSize, quint8 varsCount, QIODevice *outDevice)
+        : mCommand(command)
+        , mCmdId(cmdId)
+        , mPageSize(pageSize)
+        , mVarsCount(varsCount)
+        , mOutDevice(outDevice)
+        , mCount(0)
+    {
+    }
+
+    bool constructionFound(const sc_addr *values, quint8 count)
+    {
+        mData.append((const char*)values, count * sizeof(sc_addr));
+        if (++mCount == mPageSize)
+            writePage(true);
+
+        return true;
+    }
+
+    //! Writes collected constructions. The last page is written with \p more == false (it could be empty)
+    void writePage(bool more)
+    {
+        quint32 moreFlag = more ? 1 : 0;
+
+        mCommand->writeResultHeader(SCTP_CMD_ITERATE_CONSTRUCTION, mCmdId, SCTP_RESULT_OK,
+                                    sizeof(moreFlag) + sizeof(mCount) + sizeof(mVarsCount) + mData.size(), mOutDevice);
+        mOutDevice->write((const char*)&moreFlag, sizeof(moreFlag));
+        mOutDevice->write((const char*)&mCount, sizeof(mCount));
+        mOutDevice->write((const char*)&mVarsCount, sizeof(mVarsCount));
+        mOutDevice->write(mData);
+
+        mData.clear();
+        mCount = 0;
+    }
+
+private:
+    sctpCommand *mCommand;
+    quint32 mCmdId;
+    quint32 mPageSize;
+    quint8 mVarsCount;
+    QIODevice *mOutDevice;
+    //! Values of constructions in current page
+    QByteArray mData;
+    //! Number of constructions in current page
+    quint32 mCount;
+};
+
+eSctpErrorCode sctpCommand::processIterateConstruction(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
+    sctpConstructionSearch search;
+    quint32 pageSize = 0;
+    bool stream = (cmdFlags & SCTP_ITERATE_CONSTRUCTION_FLAG_STREAM) != 0;
+
+    Q_ASSERT(params != nullptr);
+
+    // client gets result for any error, so it doesn't wait for it
+    if (!readConstructionTemplate(params, search) ||
+            (stream && params->readRawData((char*)&pageSize, sizeof(pageSize)) != sizeof(pageSize)))
+    {
+        writeResultHeader(SCTP_CMD_ITERATE_CONSTRUCTION, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return SCTP_ERROR_CMD_READ_PARAMS;
+    }
+
+    // template is checked before search, so failure is reported before any page
+    sc_uint8 vars_count = search.variablesCount();
+    sc_uint32 results_count = 0;
+    if (!search.isBound())
+    {
+        writeResultHeader(SCTP_CMD_ITERATE_CONSTRUCTION, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return SCTP_ERROR;
+    }
+
+    // results are sent by pages, while they are found
+    if (stream)
+    {
+        if (pageSize == 0 || pageSize > SCTP_ITERATE_MAX_PAGE_SIZE)
+            pageSize = SCTP_ITERATE_MAX_PAGE_SIZE;
+
+        sctpConstructionPages pages(this, cmdId, pageSize, vars_count, outDevice);
+        search.search(&pages, results_count);
+        pages.writePage(false);
+
+        return SCTP_NO_ERROR;
+    }
+
+    QByteArray results;
+    sctpConstructionBuffer buffer(results);
+    search.search(&buffer, results_count);
+
+    if (buffer.isOverflow())
+    {
+        writeResultHeader(SCTP_CMD_ITERATE_CONSTRUCTION, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return SCTP_ERROR;
+    }
+
+    // write result: number of constructions, number of variables and values of variables for each construction
+    writeResultHeader(SCTP_CMD_ITERATE_CONSTRUCTION, cmdId, SCTP_RESULT_OK, results.size() + sizeof(results_count) + sizeof(vars_count), outDevice);
+    outDevice->write((const char*)&results_count, sizeof(results_count));
+    outDevice->write((const char*)&vars_count, sizeof(vars_count));
+    if (results_count > 0)
+        outDevice->write((const char*)results.constData(), results.size());
+
+    return SCTP_NO_ERROR;
+}
+
+bool sctpCommand::readConstructionTemplate(QDataStream *params, sctpConstructionSearch &search)
+{
+    sc_uint8 items_count = 0;
+    sc_uint8 item_type = 0;
+    sc_uint8 element_type = 0;
+    sctpConstructionSearch::sElement elements[5];
+    std::vector<bool> used;
+
+#define READ_TEMPLATE_PARAM(val) if (params->readRawData((char*)&val, sizeof(val)) != sizeof(val)) \
+                                    return false;
+
+    READ_TEMPLATE_PARAM(items_count);
+    for (sc_uint8 i = 0; i < items_count; ++i)
+    {
+        READ_TEMPLATE_PARAM(item_type);
+        if (item_type != SCTP_CONSTRUCTION_TRIPLE && item_type != SCTP_CONSTRUCTION_QUINTUPLE)
+            return false;
 
-        buffer.open(QBuffer::WriteOnly);
-        while (sc_iterator5_next(it) == SC_TRUE)
+        sc_uint8 elements_count = (item_type == SCTP_CONSTRUCTION_TRIPLE) ? 3 : 5;
+        for (sc_uint8 j = 0; j < elements_count; ++j)
         {
-            results_count++;
-            for (sc_uint i = 0; i < 5; i++)
+            sctpConstructionSearch::sElement &el = elements[j];
+            READ_TEMPLATE_PARAM(element_type);
+
+            if (element_type == SCTP_CONSTRUCTION_ELEMENT_ADDR)
             {
-                addr = sc_iterator5_value(it, i);
-                buffer.write((const char*)&addr, sizeof(addr));
-            }
+                el.isVariable = false;
+                READ_TEMPLATE_PARAM(el.addr);
+            }else if (element_type == SCTP_CONSTRUCTION_ELEMENT_VAR)
+            {
+                el.isVariable = true;
+                READ_TEMPLATE_PARAM(el.variable);
+                READ_TEMPLATE_PARAM(el.type);
+
+                // number of variables is sent in one byte
+                if (el.variable >= SCTP_CONSTRUCTION_MAX_VARIABLES)
+                    return false;
+                if (el.variable >= used.size())
+                    used.resize(el.variable + 1, false);
+                used[el.variable] = true;
+            }else
+                return false;
         }
-        buffer.close();
 
-        // write result
-        writeResultHeader(SCTP_CMD_ITERATE_ELEMENTS, cmdId, SCTP_RESULT_OK, results.size() + sizeof(results_count), outDevice);
-        outDevice->write((const char*)&results_count, sizeof(results_count));
-        if (results_count > 0)
-            outDevice->write((const char*)results.constData(), results.size());
+        if (item_type == SCTP_CONSTRUCTION_TRIPLE)
+            search.appendTriple(elements[0], elements[1], elements[2]);
+        else
+            search.appendQuintuple(elements);
+    }
+
+#undef READ_TEMPLATE_PARAM
 
-        sc_iterator5_free(it);
+    // values of all variables are returned, so unused indecies aren't allowed
+    for (quint32 i = 0; i < used.size(); ++i)
+    {
+        if (!used[i])
+            return false;
     }
 
-    return SCTP_NO_ERROR;
+    return true;
 }
 
 
@@ -688,17 +1169,65 @@ eSctpErrorCode sctpCommand::processDestroyEvent(quint32 cmdFlags, quint32 cmdId,
 
 eSctpErrorCode sctpCommand::processEmitEvent(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
 {
-    QMutexLocker locker(&mSendMutex);
+    QByteArray data;
+    quint32 count = 0;
+    bool lost = false;
+
+    Q_UNUSED(params);
 
-    quint32 resSize = sizeof(mSendEventsCount) + mSendData.size();
-    writeResultHeader(SCTP_CMD_EVENT_EMIT, cmdId, SCTP_RESULT_OK, resSize, outDevice);
-    outDevice->write((const char*)&mSendEventsCount, sizeof(mSendEventsCount));
-    outDevice->write(mSendData);
+    {
+        QMutexLocker locker(&mSendMutex);
+
+        mPushMode = (cmdFlags & SCTP_EVENT_EMIT_FLAG_PUSH) != 0;
+        mPushCmdId = cmdId;
+        mPushScheduled = false;
+
+        takeEvents(data, count, lost);
+    }
+
+    writeEventsResult(cmdId, data, count, lost, outDevice);
+
+    return SCTP_NO_ERROR;
+}
+
+void sctpCommand::pushEvents(QIODevice *outDevice)
+{
+    QByteArray data;
+    quint32 count = 0;
+    bool lost = false;
+    quint32 cmdId = 0;
+
+    {
+        QMutexLocker locker(&mSendMutex);
+
+        mPushScheduled = false;
+        if (!mPushMode || (mSendEventsCount == 0 && !mSendEventsLost))
+            return;
+
+        cmdId = mPushCmdId;
+        takeEvents(data, count, lost);
+    }
+
+    writeEventsResult(cmdId, data, count, lost, outDevice);
+}
+
+void sctpCommand::takeEvents(QByteArray &data, quint32 &count, bool &lost)
+{
+    data = mSendData; // implicitly shared, so data isn't copied
+    count = mSendEventsCount;
+    lost = mSendEventsLost;
 
     mSendData.clear();
     mSendEventsCount = 0;
+    mSendEventsLost = false;
+}
 
-    return SCTP_NO_ERROR;
+void sctpCommand::writeEventsResult(quint32 cmdId, const QByteArray &data, quint32 count, bool lost, QIODevice *outDevice)
+{
+    quint32 resSize = sizeof(count) + data.size();
+    writeResultHeader(SCTP_CMD_EVENT_EMIT, cmdId, lost ? SCTP_RESULT_FAIL : SCTP_RESULT_OK, resSize, outDevice);
+    outDevice->write((const char*)&count, sizeof(count));
+    outDevice->write(data);
 }
 
 eSctpErrorCode sctpCommand::processFindElementBySysIdtf(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
@@ -769,9 +1298,11 @@ eSctpErrorCode sctpCommand::processStatistics(quint32 cmdFlags, quint32 cmdId, Q
     quint64 begin_time;
     quint64 end_time;
 
-    Q_UNUSED(cmdFlags);
-
     Q_ASSERT(params != 0);
+
+    if (cmdFlags & SCTP_STATISTICS_FLAG_METRICS)
+        return processMetrics(cmdId, outDevice);
+
     READ_PARAM(begin_time);
     READ_PARAM(end_time);
 
@@ -788,13 +1319,269 @@ eSctpErrorCode sctpCommand::processStatistics(quint32 cmdFlags, quint32 cmdId, Q
     return SCTP_NO_ERROR;
 }
 
+eSctpErrorCode sctpCommand::processMetrics(quint32 cmdId, QIODevice *outDevice)
+{
+    sMetrics *metrics = new sMetrics();
+    sctpStatistic::getInstance()->getMetrics(*metrics);
+
+    // result: gauges, counters, latency buckets bounds and metrics of processed commands
+    QByteArray data;
+    data.append((const char*)&metrics->mActiveConnections, sizeof(metrics->mActiveConnections));
+    data.append((const char*)&metrics->mQueuedCommands, sizeof(metrics->mQueuedCommands));
+    data.append((const char*)&metrics->mRunningCommands, sizeof(metrics->mRunningCommands));
+    data.append((const char*)&metrics->mConnectionsCount, sizeof(metrics->mConnectionsCount));
+    data.append((const char*)&metrics->mBytesReceived, sizeof(metrics->mBytesReceived));
+    data.append((const char*)&metrics->mBytesSent, sizeof(metrics->mBytesSent));
+    data.append((const char*)&metrics->mRejectedCommands, sizeof(metrics->mRejectedCommands));
+
+    quint32 bucketsCount = SCTP_LATENCY_BUCKETS_COUNT;
+    data.append((const char*)&bucketsCount, sizeof(bucketsCount));
+    for (quint32 bucket = 0; bucket < bucketsCount - 1; ++bucket)
+    {
+        quint32 bound = sctpStatistic::latencyBucketBound(bucket);
+        data.append((const char*)&bound, sizeof(bound));
+    }
+
+    // code (1 byte), count, errors count, latency sum (microseconds), results size and buckets (8 bytes each)
+    QByteArray commandsData;
+    quint32 commandsCount = 0;
+    for (quint32 code = 0; code < SCTP_COMMAND_CODES_COUNT; ++code)
+    {
+        const sCommandMetrics &cmdMetrics = metrics->mCommands[code];
+        if (cmdMetrics.mCount == 0)
+            continue;
+
+        quint8 cmdCode = code;
+        commandsData.append((const char*)&cmdCode, sizeof(cmdCode));
+        commandsData.append((const char*)&cmdMetrics.mCount, sizeof(cmdMetrics.mCount));
+        commandsData.append((const char*)&cmdMetrics.mErrorsCount, sizeof(cmdMetrics.mErrorsCount));
+        commandsData.append((const char*)&cmdMetrics.mLatencySum, sizeof(cmdMetrics.mLatencySum));
+        commandsData.append((const char*)&cmdMetrics.mResultBytes, sizeof(cmdMetrics.mResultBytes));
+        commandsData.append((const char*)cmdMetrics.mBuckets, sizeof(cmdMetrics.mBuckets));
+        ++commandsCount;
+    }
+    delete metrics;
+
+    data.append((const char*)&commandsCount, sizeof(commandsCount));
+    data.append(commandsData);
+
+    writeResultHeader(SCTP_CMD_STATISTICS, cmdId, SCTP_RESULT_OK, data.size(), outDevice);
+    outDevice->write(data);
+
+    return SCTP_NO_ERROR;
+}
+
+eSctpErrorCode sctpCommand::processBatch(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice)
+{
+    std::vector<sBatchCommand> commands;
+    std::vector<sc_addr> results;
+    QByteArray resultsData;
+
+    Q_UNUSED(cmdFlags);
+    Q_ASSERT(params != 0);
+
+    // whole batch is read before processing, so malformed batch doesn't change sc-memory
+    if (!readBatch(params, commands))
+    {
+        writeResultHeader(SCTP_CMD_BATCH, cmdId, SCTP_RESULT_FAIL, 0, outDevice);
+        return SCTP_ERROR_CMD_READ_PARAMS;
+    }
+
+    // other clients don't see intermediate state of sc-memory
+    sc_memory_lock();
+
+    // sc-addr arguments can refer to results of previous sub-commands
+    for (quint32 i = 0; i < commands.size(); ++i)
+    {
+        const sBatchCommand &cmd = commands[i];
+        sc_addr addr, end_addr, res_addr;
+        eSctpResultCode resCode = SCTP_RESULT_FAIL;
+
+        SC_ADDR_MAKE_EMPTY(res_addr);
+
+        switch (cmd.code)
+        {
+        case SCTP_CMD_CHECK_ELEMENT:
+            if (resolveBatchArg(cmd.args[0], results, addr) && sc_memory_is_element(addr))
+                resCode = SCTP_RESULT_OK;
+            break;
+
+        case SCTP_CMD_ERASE_ELEMENT:
+            if (resolveBatchArg(cmd.args[0], results, addr) && sc_memory_element_free(addr) == SC_RESULT_OK)
+                resCode = SCTP_RESULT_OK;
+            break;
+
+        case SCTP_CMD_CREATE_NODE:
+            res_addr = sc_memory_node_new(cmd.type);
+            break;
+
+        case SCTP_CMD_CREAET_LINK:
+            res_addr = sc_memory_link_new();
+            break;
+
+        case SCTP_CMD_CREATE_ARC:
+            if (resolveBatchArg(cmd.args[0], results, addr) && resolveBatchArg(cmd.args[1], results, end_addr))
+                res_addr = sc_memory_arc_new(cmd.type, addr, end_addr);
+            break;
+
+        case SCTP_CMD_SET_LINK_CONTENT:
+            if (resolveBatchArg(cmd.args[0], results, addr))
+            {
+                sc_stream *stream = sc_stream_memory_new(cmd.data.constData(), cmd.data.size(), SC_STREAM_READ, SC_FALSE);
+                if (sc_memory_set_link_content(addr, stream) == SC_RESULT_OK)
+                    res_addr = addr;
+                sc_stream_free(stream);
+            }
+            break;
+
+        case SCTP_CMD_SET_SYSIDTF:
+            if (resolveBatchArg(cmd.args[0], results, addr) && sc_helper_set_system_identifier(addr, cmd.data.constData(), cmd.data.size()) == SC_RESULT_OK)
+                res_addr = addr;
+            break;
+
+        case SCTP_CMD_FIND_ELEMENT_BY_SYSITDF:
+            if (sc_helper_find_element_by_system_identifier(cmd.data.constData(), cmd.data.size(), &res_addr) != SC_RESULT_OK)
+                SC_ADDR_MAKE_EMPTY(res_addr);
+            break;
+        }
+
+        if (SC_ADDR_IS_NOT_EMPTY(res_addr))
+            resCode = SCTP_RESULT_OK;
+
+        // result of each sub-command: result code and returned sc-addr (empty if there is no one)
+        results.push_back(res_addr);
+        resultsData.append((char)resCode);
+        resultsData.append((const char*)&res_addr, sizeof(res_addr));
+    }
+
+    sc_memory_unlock();
+
+    quint32 count = commands.size();
+    writeResultHeader(SCTP_CMD_BATCH, cmdId, SCTP_RESULT_OK, sizeof(count) + resultsData.size(), outDevice);
+    outDevice->write((const char*)&count, sizeof(count));
+    outDevice->write(resultsData);
+
+    return SCTP_NO_ERROR;
+}
+
+bool sctpCommand::readBatch(QDataStream *params, std::vector<sBatchCommand> &commands)
+{
+    quint32 count = 0;
+
+    if (params->readRawData((char*)&count, sizeof(count)) != sizeof(count))
+        return false;
+
+    // each sub-command has the same parameters as single command, but sc-addr arguments
+    // are prefixed with their type
+    for (quint32 i = 0; i < count; ++i)
+    {
+        sBatchCommand cmd;
+        sc_uint32 data_len = 0;
+
+        cmd.code = 0;
+        cmd.type = 0;
+        if (params->readRawData((char*)&cmd.code, sizeof(cmd.code)) != sizeof(cmd.code))
+            return false;
+
+        switch (cmd.code)
+        {
+        case SCTP_CMD_CHECK_ELEMENT:
+        case SCTP_CMD_ERASE_ELEMENT:
+            if (!readBatchArg(params, cmd.args[0]))
+                return false;
+            break;
+
+        case SCTP_CMD_CREATE_NODE:
+            if (params->readRawData((char*)&cmd.type, sizeof(cmd.type)) != sizeof(cmd.type))
+                return false;
+            break;
+
+        case SCTP_CMD_CREAET_LINK:
+            break;
+
+        case SCTP_CMD_CREATE_ARC:
+            if (params->readRawData((char*)&cmd.type, sizeof(cmd.type)) != sizeof(cmd.type) ||
+                    !readBatchArg(params, cmd.args[0]) || !readBatchArg(params, cmd.args[1]))
+                return false;
+            break;
+
+        case SCTP_CMD_SET_LINK_CONTENT:
+        case SCTP_CMD_SET_SYSIDTF:
+        case SCTP_CMD_FIND_ELEMENT_BY_SYSITDF:
+            if (cmd.code != SCTP_CMD_FIND_ELEMENT_BY_SYSITDF && !readBatchArg(params, cmd.args[0]))
+                return false;
+            // size is checked before allocation of data
+            if (params->readRawData((char*)&data_len, sizeof(data_len)) != sizeof(data_len) || data_len > params->device()->bytesAvailable())
+                return false;
+            cmd.data.resize(data_len);
+            if (params->readRawData(cmd.data.data(), data_len) != (int)data_len)
+                return false;
+            break;
+
+        default:
+            // parameters of unknown sub-command can't be skipped
+            return false;
+        }
+
+        commands.push_back(cmd);
+    }
+
+    return true;
+}
+
+bool sctpCommand::readBatchArg(QDataStream *params, sBatchArg &arg)
+{
+    arg.index = 0;
+    SC_ADDR_MAKE_EMPTY(arg.addr);
+
+    if (params->readRawData((char*)&arg.type, sizeof(arg.type)) != sizeof(arg.type))
+        return false;
+
+    if (arg.type == SCTP_BATCH_ARG_ADDR)
+        return params->readRawData((char*)&arg.addr, sizeof(arg.addr)) == sizeof(arg.addr);
+
+    return arg.type == SCTP_BATCH_ARG_RESULT && params->readRawData((char*)&arg.index, sizeof(arg.index)) == sizeof(arg.index);
+}
+
+bool sctpCommand::resolveBatchArg(const sBatchArg &arg, const std::vector<sc_addr> &results, sc_addr &addr)
+{
+    if (arg.type == SCTP_BATCH_ARG_ADDR)
+    {
+        addr = arg.addr;
+        return true;
+    }
+
+    // sub-command can refer just to previous successful ones
+    if (arg.index >= results.size() || SC_ADDR_IS_EMPTY(results[arg.index]))
+        return false;
+
+    addr = results[arg.index];
+    return true;
+}
+
 sc_result sctpCommand::processEventEmit(quint32 eventId, sc_addr el_addr, sc_addr arg_addr)
 {    
     QMutexLocker locker(&mSendMutex);
 
+    // client doesn't get events, so don't collect them infinitely
+    if (mSendEventsCount >= SCTP_MAX_PENDING_EVENTS)
+    {
+        mSendEventsLost = true;
+        return SC_RESULT_OK;
+    }
+
     mSendData.append((char*)&eventId, sizeof(eventId));
     mSendData.append((char*)&el_addr, sizeof(el_addr));
     mSendData.append((char*)&arg_addr, sizeof(arg_addr));
 
     ++mSendEventsCount;
+
+    // events fired in a burst are sent together, so just the first one notifies client
+    if (mPushMode && !mPushScheduled)
+    {
+        mPushScheduled = true;
+        emit eventsAvailable();
+    }
+
+    return SC_RESULT_OK;
 }
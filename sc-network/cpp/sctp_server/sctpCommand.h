@@ -26,13 +26,44 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include <QObject>
 #include <QMutex>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QAtomicInt>
 
 #include <set>
+#include <map>
+#include <vector>
 
 #include "sctpTypes.h"
 
 
 class QIODevice;
+class sctpConstructionSearch;
+
+//! Iterator, that was opened by SCTP_CMD_ITERATE_ELEMENTS to get results by pages
+struct sIteratorCursor
+{
+    sc_iterator3 *it3;
+    sc_iterator5 *it5;
+    //! Time since the last use. Opened iterator holds deleted sc-elements in memory, so idle cursor is closed
+    QElapsedTimer idleTimer;
+};
+
+//! sc-addr argument of SCTP_CMD_BATCH sub-command
+struct sBatchArg
+{
+    quint8 type; // value of eSctpBatchArgType
+    sc_addr addr; // fixed sc-addr
+    quint32 index; // index of sub-command, which result is used
+};
+
+//! Parsed sub-command of SCTP_CMD_BATCH
+struct sBatchCommand
+{
+    quint8 code;
+    sc_type type;
+    sBatchArg args[2];
+    QByteArray data;
+};
 
 /*! Base class for sctp commands.
  * It provide command packing/unpacking to binary data.
@@ -77,6 +108,23 @@ public:
 
     //! Return size of command header in bytes
     static quint32 cmdHeaderSize();
+    //! Return size of result header in bytes
+    static quint32 resultHeaderSize();
+
+    /*! Check if command with specified code just reads sc-memory.
+     * Such commands from one client can be processed concurrently, other ones are processed in order of receiving
+     * @param cmdCode Code of command
+     */
+    static bool isReadOnlyCommand(quint8 cmdCode);
+
+    /*! Writes result of SCTP_CMD_EVENT_EMIT with all events, that wasn't sent to client yet.
+     * It used in push mode, when eventsAvailable signal received
+     * @param outDevice Pointer to output device
+     */
+    void pushEvents(QIODevice *outDevice);
+
+    //! Closes cursors, that weren't used too long. Next SCTP_CMD_ITERATE_NEXT with their ids fail
+    void closeIdleCursors();
     
 protected:
     //! Type of command processing function
@@ -96,6 +144,11 @@ private:
     eSctpErrorCode processFindLinks(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
     eSctpErrorCode processSetLinkContent(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
     eSctpErrorCode processIterateElements(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+    eSctpErrorCode processIterateConstruction(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+    //! Reads template of SCTP_CMD_ITERATE_CONSTRUCTION into \p search. Returns false, if it can't be read or isn't valid
+    bool readConstructionTemplate(QDataStream *params, sctpConstructionSearch &search);
+    eSctpErrorCode processIterateNext(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+    eSctpErrorCode processIterateFree(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
 
     // events
     eSctpErrorCode processCreateEvent(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
@@ -105,6 +158,59 @@ private:
     eSctpErrorCode processFindElementBySysIdtf(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
     eSctpErrorCode processSetSysIdtf(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
     eSctpErrorCode processStatistics(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+    //! Writes result of SCTP_CMD_STATISTICS with SCTP_STATISTICS_FLAG_METRICS flag
+    eSctpErrorCode processMetrics(quint32 cmdId, QIODevice *outDevice);
+
+    eSctpErrorCode processBatch(quint32 cmdFlags, quint32 cmdId, QDataStream *params, QIODevice *outDevice);
+
+    /*! Reads all sub-commands of batch
+     * @param params Pointer to parameters stream
+     * @param commands Reference to vector, that will contain read sub-commands
+     * @returns If all sub-commands were read and are valid, then returns true; otherwise returns false
+     */
+    bool readBatch(QDataStream *params, std::vector<sBatchCommand> &commands);
+    //! Reads sc-addr argument of batch sub-command. Returns false, if it can't be read
+    bool readBatchArg(QDataStream *params, sBatchArg &arg);
+    /*! Returns sc-addr, that argument of batch sub-command refers to
+     * @param arg Argument of sub-command
+     * @param results Results of previous sub-commands
+     * @param addr Reference to sc-addr
+     * @returns If argument refers to result of previous successful sub-command or contains fixed sc-addr,
+     * then returns true; otherwise returns false
+     */
+    bool resolveBatchArg(const sBatchArg &arg, const std::vector<sc_addr> &results, sc_addr &addr);
+
+    // ------- iterators ----------
+    //! Reads iterator type and parameters and creates one of iterators
+    eSctpErrorCode createIterator(QDataStream *params, sc_iterator3 **it3, sc_iterator5 **it5);
+
+    /*! Appends values of next iterator results into \p results
+     * @param maxCount Maximum number of results to read (0 - read all)
+     * @param count Reference to number of read results
+     * @returns If there are no more results, then returns true; otherwise returns false
+     */
+    bool readIteratorResults(sc_iterator3 *it3, sc_iterator5 *it5, quint32 maxCount, QByteArray &results, quint32 &count);
+    void freeIterator(sc_iterator3 *it3, sc_iterator5 *it5);
+
+    //! Stores iterator as cursor of this client. Returns id of cursor (0, if there are too many cursors)
+    quint32 appendCursor(sc_iterator3 *it3, sc_iterator5 *it5);
+    //! Removes cursor with specified id from client cursors and returns it in \p cursor
+    bool takeCursor(quint32 cursorId, sIteratorCursor &cursor);
+    //! Frees iterator of cursor, that was taken from client cursors
+    void freeCursor(sIteratorCursor &cursor);
+    //! Writes page of iteration results: cursor id (0 if there are no more results), number of results and results
+    void writeIteratorPage(eSctpCommandCode cmdCode, quint32 cmdId, quint32 cursorId, quint32 count, const QByteArray &results, QIODevice *outDevice);
+
+    /*! Takes pending events and clears them. mSendMutex should be locked
+     * @param data Reference to data of events
+     * @param count Reference to number of events
+     * @param lost Reference to flag, that some events were lost
+     */
+    void takeEvents(QByteArray &data, quint32 &count, bool &lost);
+    /*! Writes result of SCTP_CMD_EVENT_EMIT with taken events. It's called without mSendMutex, because
+     * writing can wait for client, while events are collected by sc-memory threads
+     */
+    void writeEventsResult(quint32 cmdId, const QByteArray &data, quint32 count, bool lost, QIODevice *outDevice);
 
 protected:
     sc_result processEventEmit(quint32 eventId, sc_addr el_addr, sc_addr arg_addr);
@@ -116,13 +222,32 @@ private:
     QByteArray mSendData;
     //! Number of events to send to client
     quint32 mSendEventsCount;
+    //! Flag, that events were lost since last sending, because there were too many of them
+    bool mSendEventsLost;
+    //! Flag, that events are sent to client without polling
+    bool mPushMode;
+    //! Id of command, that enabled push mode
+    quint32 mPushCmdId;
+    //! Flag, that eventsAvailable signal was emitted and events wasn't sent yet
+    bool mPushScheduled;
 
     //! List of event created by this command handler
     typedef std::set<tEventId> tEventsSet;
     tEventsSet mEventsSet;
 
+    //! Mutex to synchronize access to cursors (read commands are processed concurrently)
+    QMutex mIteratorsMutex;
+    //! Opened iteration cursors
+    typedef std::map<quint32, sIteratorCursor> tIteratorsMap;
+    tIteratorsMap mIterators;
+    quint32 mLastCursorId;
+    //! Number of opened cursors of all clients
+    static QAtomicInt msCursorsCount;
+
 signals:
-    
+    //! Emitted in push mode, when new events fired. Events, that fire until pushEvents called, are sent together
+    void eventsAvailable();
+
 public slots:
     
 };
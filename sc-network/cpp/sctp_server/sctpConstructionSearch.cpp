@@ -0,0 +1,350 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#include "sctpConstructionSearch.h"
+
+#include <limits>
+
+sctpConstructionSearch::sctpConstructionSearch()
+    : mListener(0)
+    , mResultsCount(0)
+    , mUnbound(false)
+    , mStopped(false)
+{
+}
+
+sctpConstructionSearch::~sctpConstructionSearch()
+{
+}
+
+void sctpConstructionSearch::appendTriple(const sElement &source, const sElement &arc, const sElement &target)
+{
+    sTriple triple;
+    triple.elements[0] = source;
+    triple.elements[1] = arc;
+    triple.elements[2] = target;
+
+    for (quint32 i = 0; i < 3; ++i)
+        registerElement(triple.elements[i]);
+
+    mTriples.push_back(triple);
+}
+
+void sctpConstructionSearch::appendQuintuple(const sElement *elements)
+{
+    Q_ASSERT(elements != 0);
+
+    appendTriple(elements[0], elements[1], elements[2]);
+    appendTriple(elements[4], elements[3], elements[1]);
+}
+
+quint8 sctpConstructionSearch::variablesCount() const
+{
+    return (quint8)mVariableTypes.size();
+}
+
+void sctpConstructionSearch::registerElement(const sElement &el)
+{
+    if (!el.isVariable)
+        return;
+
+    if (el.variable >= mVariableTypes.size())
+        mVariableTypes.resize(el.variable + 1, 0);
+
+    // value of variable must correspond to types of all it occurrences
+    mVariableTypes[el.variable] |= el.type;
+}
+
+bool sctpConstructionSearch::isBound() const
+{
+    std::vector<bool> tripleBound(mTriples.size(), false);
+    std::vector<bool> variableBound(mVariableTypes.size(), false);
+    bool changed = true;
+
+    // triples with fixed elements are bound, then triples connected with bound ones by variables
+    while (changed)
+    {
+        changed = false;
+        for (quint32 i = 0; i < mTriples.size(); ++i)
+        {
+            if (tripleBound[i])
+                continue;
+
+            const sTriple &triple = mTriples[i];
+            bool bound = false;
+            for (quint32 j = 0; j < 3 && !bound; ++j)
+                bound = !triple.elements[j].isVariable || variableBound[triple.elements[j].variable];
+
+            if (!bound)
+                continue;
+
+            tripleBound[i] = true;
+            changed = true;
+            for (quint32 j = 0; j < 3; ++j)
+            {
+                if (triple.elements[j].isVariable)
+                    variableBound[triple.elements[j].variable] = true;
+            }
+        }
+    }
+
+    for (quint32 i = 0; i < tripleBound.size(); ++i)
+    {
+        if (!tripleBound[i])
+            return false;
+    }
+
+    return true;
+}
+
+bool sctpConstructionSearch::search(sctpConstructionListener *listener, quint32 &resultsCount)
+{
+    Q_ASSERT(listener != 0);
+
+    sc_addr empty;
+    SC_ADDR_MAKE_EMPTY(empty);
+
+    resultsCount = 0;
+
+    // unbound template is rejected before any results are passed to listener
+    if (!isBound())
+        return false;
+
+    mListener = listener;
+    mResultsCount = 0;
+    mUnbound = false;
+    mStopped = false;
+
+    mTriplesUsed.assign(mTriples.size(), false);
+    mVariableValues.assign(mVariableTypes.size(), empty);
+    mVariableBound.assign(mVariableTypes.size(), false);
+
+    if (!mTriples.empty())
+        searchRecursive(0);
+
+    resultsCount = mResultsCount;
+    mListener = 0;
+
+    return !mUnbound;
+}
+
+void sctpConstructionSearch::searchRecursive(quint32 depth)
+{
+    if (mUnbound || mStopped)
+        return;
+
+    // all triples found, so pass variable values to listener
+    if (depth == mTriples.size())
+    {
+        mResultsCount++;
+        if (!mListener->constructionFound(mVariableValues.empty() ? 0 : &mVariableValues[0], (quint8)mVariableValues.size()))
+            mStopped = true;
+        return;
+    }
+
+    // choose the cheapest triple from remaining
+    quint32 best = 0;
+    quint32 bestCost = std::numeric_limits<quint32>::max();
+    bool found = false;
+
+    for (quint32 i = 0; i < mTriples.size(); ++i)
+    {
+        if (mTriplesUsed[i])
+            continue;
+
+        quint32 cost = estimateCost(i);
+        if (!found || cost < bestCost)
+        {
+            best = i;
+            bestCost = cost;
+            found = true;
+        }
+
+        if (bestCost == 0)
+            return; // there are no any values for this triple
+    }
+
+    Q_ASSERT(found);
+
+    // there are no any triple with known elements
+    if (bestCost == std::numeric_limits<quint32>::max())
+    {
+        mUnbound = true;
+        return;
+    }
+
+    mTriplesUsed[best] = true;
+    searchTriple(best, depth);
+    mTriplesUsed[best] = false;
+}
+
+void sctpConstructionSearch::searchTriple(quint32 idx, quint32 depth)
+{
+    const sTriple &triple = mTriples[idx];
+    sc_addr source, arc, target;
+    sc_addr values[3];
+    quint8 bound[3];
+    quint8 boundCount = 0;
+
+    bool sourceKnown = elementValue(triple.elements[0], source);
+    bool targetKnown = elementValue(triple.elements[2], target);
+
+    // arc is known, so just check it begin and end
+    if (elementValue(triple.elements[1], arc))
+    {
+        values[1] = arc;
+        if (sc_memory_get_arc_begin(arc, &values[0]) != SC_RESULT_OK ||
+            sc_memory_get_arc_end(arc, &values[2]) != SC_RESULT_OK)
+            return;
+
+        if (bindTriple(idx, values, bound, boundCount))
+            searchRecursive(depth + 1);
+
+        for (quint8 i = 0; i < boundCount; ++i)
+            mVariableBound[bound[i]] = false;
+
+        return;
+    }
+
+    sc_type arcType = triple.elements[1].isVariable ? mVariableTypes[triple.elements[1].variable] : 0;
+    sc_iterator3 it;
+    sc_bool res;
+
+    if (sourceKnown && targetKnown)
+        res = sc_iterator3_f_a_f_init(&it, source, arcType, target);
+    else if (sourceKnown)
+        res = sc_iterator3_f_a_a_init(&it, source, arcType,
+                                      triple.elements[2].isVariable ? mVariableTypes[triple.elements[2].variable] : 0);
+    else
+        res = sc_iterator3_a_a_f_init(&it, triple.elements[0].isVariable ? mVariableTypes[triple.elements[0].variable] : 0,
+                                      arcType, target);
+
+    if (res == SC_FALSE)
+        return;
+
+    while (!mUnbound && !mStopped && sc_iterator3_next(&it) == SC_TRUE)
+    {
+        for (sc_uint i = 0; i < 3; ++i)
+            values[i] = sc_iterator3_value(&it, i);
+
+        boundCount = 0;
+        if (bindTriple(idx, values, bound, boundCount))
+            searchRecursive(depth + 1);
+
+        for (quint8 i = 0; i < boundCount; ++i)
+            mVariableBound[bound[i]] = false;
+    }
+
+    sc_iterator3_done(&it);
+}
+
+quint32 sctpConstructionSearch::estimateCost(quint32 idx) const
+{
+    const sTriple &triple = mTriples[idx];
+    sc_addr source, arc, target;
+    sc_iterator_param p1, p2, p3;
+
+    if (elementValue(triple.elements[1], arc))
+        return 1;
+
+    bool sourceKnown = elementValue(triple.elements[0], source);
+    bool targetKnown = elementValue(triple.elements[2], target);
+
+    if (!sourceKnown && !targetKnown)
+        return std::numeric_limits<quint32>::max();
+
+    // number of output (input) arcs is used as estimation of candidates count
+    p2.is_type = SC_TRUE;
+    p2.type = 0;
+
+    quint32 cost = std::numeric_limits<quint32>::max() - 1;
+    if (sourceKnown)
+    {
+        p1.is_type = SC_FALSE;
+        p1.addr = source;
+        p3.is_type = SC_TRUE;
+        p3.type = 0;
+        cost = qMin(cost, (quint32)sc_iterator3_count(sc_iterator3_f_a_a, p1, p2, p3));
+    }
+
+    if (targetKnown)
+    {
+        p1.is_type = SC_TRUE;
+        p1.type = 0;
+        p3.is_type = SC_FALSE;
+        p3.addr = target;
+        cost = qMin(cost, (quint32)sc_iterator3_count(sc_iterator3_a_a_f, p1, p2, p3));
+    }
+
+    return cost;
+}
+
+bool sctpConstructionSearch::elementValue(const sElement &el, sc_addr &addr) const
+{
+    if (!el.isVariable)
+    {
+        addr = el.addr;
+        return true;
+    }
+
+    if (!mVariableBound[el.variable])
+        return false;
+
+    addr = mVariableValues[el.variable];
+    return true;
+}
+
+bool sctpConstructionSearch::bindTriple(quint32 idx, const sc_addr *values, quint8 *bound, quint8 &boundCount)
+{
+    const sTriple &triple = mTriples[idx];
+    sc_type type;
+
+    boundCount = 0;
+    for (quint32 i = 0; i < 3; ++i)
+    {
+        const sElement &el = triple.elements[i];
+
+        if (!el.isVariable)
+        {
+            if (SC_ADDR_IS_NOT_EQUAL(el.addr, values[i]))
+                return false;
+            continue;
+        }
+
+        if (mVariableBound[el.variable])
+        {
+            if (SC_ADDR_IS_NOT_EQUAL(mVariableValues[el.variable], values[i]))
+                return false;
+            continue;
+        }
+
+        if (sc_memory_get_element_type(values[i], &type) != SC_RESULT_OK ||
+            sc_iterator_compare_type(type, mVariableTypes[el.variable]) == SC_FALSE)
+            return false;
+
+        mVariableValues[el.variable] = values[i];
+        mVariableBound[el.variable] = true;
+        bound[boundCount++] = el.variable;
+    }
+
+    return true;
+}
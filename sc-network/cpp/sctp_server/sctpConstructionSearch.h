@@ -0,0 +1,151 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OSTIS (Open Semantic Technology for Intelligent Systems)
+For the latest info, see http://www.ostis.net
+
+Copyright (c) 2010-2014 OSTIS
+
+OSTIS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OSTIS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _sctpConstructionSearch_h_
+#define _sctpConstructionSearch_h_
+
+#include <QtGlobal>
+#include "sctpTypes.h"
+
+#include <vector>
+
+//! Receiver of constructions found by sctpConstructionSearch
+class sctpConstructionListener
+{
+public:
+    virtual ~sctpConstructionListener() {}
+
+    /*! Receives one found construction
+     * @param values Values of all template variables
+     * @param count Number of variables
+     * @returns If search should be continued, then returns true; otherwise returns false
+     */
+    virtual bool constructionFound(const sc_addr *values, quint8 count) = 0;
+};
+
+/*! Class that search all constructions isomorphic to specified template.
+ * Template consists of triples. Each triple element is a fixed sc-addr, or a variable,
+ * that can be used in several triples. Triples are joined by common variables.
+ * Join order isn't fixed: on each step triple with the lowest estimated number of
+ * candidates (based on arcs count of already known elements) is processed first.
+ */
+class sctpConstructionSearch
+{
+public:
+    //! Template element
+    struct sElement
+    {
+        //! Flag, that element is a variable
+        bool isVariable;
+        //! sc-addr of fixed element
+        sc_addr addr;
+        //! Index of variable
+        quint8 variable;
+        //! Type of variable values
+        sc_type type;
+    };
+
+    explicit sctpConstructionSearch();
+    virtual ~sctpConstructionSearch();
+
+    /*! Append triple into template
+     * @param source Source element of triple
+     * @param arc Arc element of triple
+     * @param target Target element of triple
+     */
+    void appendTriple(const sElement &source, const sElement &arc, const sElement &target);
+
+    /*! Append quintuple into template. It's the same as two triples: (source, arc, target) and (attr, attrArc, arc)
+     * @param elements Array of five elements in order: source, arc, target, attrArc, attr
+     */
+    void appendQuintuple(const sElement *elements);
+
+    //! Returns number of variables in template
+    quint8 variablesCount() const;
+
+    /*! Checks, that template can be searched: each triple is connected (by variables) with any fixed sc-addr
+     */
+    bool isBound() const;
+
+    /*! Search all constructions, that correspond to template. Values of all variables for each
+     * found construction are passed to \p listener, while it doesn't stop search.
+     * @param listener Pointer to receiver of results
+     * @param resultsCount Reference to container for number of found constructions
+     * @returns If template can be searched, then returns true; otherwise returns false (see isBound)
+     */
+    bool search(sctpConstructionListener *listener, quint32 &resultsCount);
+
+protected:
+    //! Recursive search of remaining triples
+    void searchRecursive(quint32 depth);
+    //! Search all values of specified triple and go to the next step for each of them
+    void searchTriple(quint32 idx, quint32 depth);
+
+    /*! Estimates number of values for specified triple
+     * @returns Returns number of candidates. If triple has no known elements, then returns std::numeric_limits<quint32>::max()
+     */
+    quint32 estimateCost(quint32 idx) const;
+
+    //! Get value of element. If element value isn't known, then returns false
+    bool elementValue(const sElement &el, sc_addr &addr) const;
+
+    /*! Bind triple elements to specified values.
+     * @param idx Index of triple
+     * @param values Array of three values
+     * @param bound Array to store indecies of bound variables
+     * @param boundCount Reference to number of bound variables
+     * @returns If values correspond to triple, then returns true; otherwise returns false
+     */
+    bool bindTriple(quint32 idx, const sc_addr *values, quint8 *bound, quint8 &boundCount);
+
+    //! Appends variable to template and merges it type
+    void registerElement(const sElement &el);
+
+private:
+    struct sTriple
+    {
+        sElement elements[3];
+    };
+
+    typedef std::vector<sTriple> tTripleVector;
+    tTripleVector mTriples;
+    //! Flags of processed triples
+    std::vector<bool> mTriplesUsed;
+
+    //! Merged types of variables
+    std::vector<sc_type> mVariableTypes;
+    //! Current values of variables
+    std::vector<sc_addr> mVariableValues;
+    //! Flags of known variable values
+    std::vector<bool> mVariableBound;
+
+    //! Receiver of results
+    sctpConstructionListener *mListener;
+    //! Number of found constructions
+    quint32 mResultsCount;
+    //! Flag, that template can't be searched
+    bool mUnbound;
+    //! Flag, that listener stopped search
+    bool mStopped;
+};
+
+#endif // _sctpConstructionSearch_h_
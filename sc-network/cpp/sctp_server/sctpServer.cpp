@@ -24,10 +24,12 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include "sctpClient.h"
 #include "sctpStatistic.h"
 #include "sctpEventManager.h"
+#include "sctpLocalServer.h"
 
 #include <QSettings>
 #include <QDebug>
 #include <QThreadPool>
+#include <QThread>
 
 extern "C"
 {
@@ -40,7 +42,11 @@ extern "C"
 sctpServer::sctpServer(QObject *parent)
   : QTcpServer(parent)
   , mPort(0)
+  , mLocalServer(0)
   , mStatistic(0)
+  , mIOThreadsCount(0)
+  , mWorkerThreadsCount(0)
+  , mNextIOThread(0)
   , mThreadPool(0)
   , mEventManager(0)
 {
@@ -83,6 +89,20 @@ bool sctpServer::start(const QString &config)
                                   .arg(ipAddress).arg(serverPort());
     printf("%s", message.toUtf8().constData());
 
+    if (!mLocalSocketName.isEmpty())
+    {
+        // socket file could stay after crash
+        QLocalServer::removeServer(mLocalSocketName);
+
+        mLocalServer = new sctpLocalServer(this);
+        if (!mLocalServer->listen(mLocalSocketName))
+        {
+            qCritical() << QObject::tr("Unable to listen local socket %1: %2").arg(mLocalSocketName).arg(mLocalServer->errorString());
+            return false;
+        }
+        printf("Local socket: %s\n", mLocalServer->fullServerName().toUtf8().constData());
+    }
+
     // initialize sc-memory
     qDebug() << "Initialize sc-memory\n";
     sc_memory_params params;
@@ -106,11 +126,19 @@ bool sctpServer::start(const QString &config)
     if (mStatUpdatePeriod > 0)
     {
         mStatistic = new sctpStatistic(this);
-        mStatistic->initialize(mStatPath, mStatUpdatePeriod);
+        mStatistic->initialize(mStatPath, mStatUpdatePeriod, mMetricsPeriod);
     }
 
     mThreadPool = new QThreadPool(this);
-    mThreadPool->setMaxThreadCount(100);
+    mThreadPool->setMaxThreadCount(mWorkerThreadsCount);
+
+    // each I/O thread runs event loop, that serves many client sockets
+    for (quint32 i = 0; i < mIOThreadsCount; ++i)
+    {
+        QThread *thread = new QThread(this);
+        thread->start();
+        mIOThreads.append(thread);
+    }
 
     return true;
 }
@@ -129,6 +157,8 @@ void sctpServer::parseConfig(const QString &config_path)
         exit(0);
     }
 
+    mLocalSocketName = settings.value("Network/LocalSocket").toString();
+
     mRepoPath = settings.value("Repo/Path").toString();
     if (mRepoPath.isEmpty())
     {
@@ -137,12 +167,46 @@ void sctpServer::parseConfig(const QString &config_path)
     }
     mExtPath = settings.value("Extensions/Directory").toString();
 
+    mIOThreadsCount = settings.value("Network/IOThreads").toUInt(&result);
+    if (!result || mIOThreadsCount == 0)
+        mIOThreadsCount = 2;
+
+    mWorkerThreadsCount = settings.value("Network/WorkerThreads").toUInt(&result);
+    if (!result || mWorkerThreadsCount == 0)
+        mWorkerThreadsCount = qMax(QThread::idealThreadCount(), 2);
+
+    // admission control: clients, that send too many commands, wait; commands over server limit are rejected
+    mClientLimits.mMaxRunningCommands = settings.value("Network/ClientMaxRunning").toUInt(&result);
+    if (!result || mClientLimits.mMaxRunningCommands == 0)
+        mClientLimits.mMaxRunningCommands = 16;
+
+    mClientLimits.mMaxQueuedCommands = settings.value("Network/ClientMaxQueued").toUInt(&result);
+    if (!result || mClientLimits.mMaxQueuedCommands == 0)
+        mClientLimits.mMaxQueuedCommands = 256;
+
+    mClientLimits.mMaxPendingResults = settings.value("Network/ClientMaxPendingResults").toUInt(&result);
+    if (!result || mClientLimits.mMaxPendingResults == 0)
+        mClientLimits.mMaxPendingResults = 4 * 1024 * 1024;
+
+    mClientLimits.mMaxServerCommands = settings.value("Network/MaxQueuedCommands").toUInt(&result);
+    if (!result || mClientLimits.mMaxServerCommands == 0)
+        mClientLimits.mMaxServerCommands = mWorkerThreadsCount * 64;
+
+    // command size is checked before command is received, so client can't make server allocate much memory
+    mClientLimits.mMaxCommandSize = settings.value("Network/MaxCommandSize").toUInt(&result);
+    if (!result || mClientLimits.mMaxCommandSize == 0)
+        mClientLimits.mMaxCommandSize = 64 * 1024 * 1024;
+
     mStatUpdatePeriod = settings.value("Stat/UpdatePeriod").toUInt(&result);
     if (!result)
         qWarning() << "Can't parse period statistic from configuration file\n";
     if (mStatUpdatePeriod > 0 && mStatUpdatePeriod < 60)
         qWarning() << "Statistics update period is very short, it would be take much processor time. Recomend to make it more long";
 
+    mMetricsPeriod = settings.value("Stat/MetricsPeriod").toUInt(&result);
+    if (!result || mMetricsPeriod == 0)
+        mMetricsPeriod = 10;
+
     mStatPath = settings.value("Stat/Path").toString();
     if (mStatPath.isEmpty() && mStatUpdatePeriod > 0)
     {
@@ -154,19 +218,46 @@ void sctpServer::parseConfig(const QString &config_path)
 
 void sctpServer::incomingConnection(int socketDescriptor)
 {
-    sctpClient *client = new sctpClient(socketDescriptor);
-    client->setAutoDelete(true);
-    mThreadPool->start(client);
+    appendClient(socketDescriptor, false);
+}
+
+void sctpServer::appendClient(quintptr socketDescriptor, bool isLocal)
+{
+    sctpClient *client = new sctpClient(socketDescriptor, isLocal, mThreadPool, &mClientLimits);
+
+    // connections are distributed between I/O threads
+    client->moveToThread(mIOThreads[mNextIOThread]);
+    mNextIOThread = (mNextIOThread + 1) % mIOThreads.size();
+
+    QMetaObject::invokeMethod(client, "start", Qt::QueuedConnection);
 }
 
 void sctpServer::stop()
 {
+    close();
+    if (mLocalServer)
+        mLocalServer->close();
+
+    // workers, that wait for clients, are woken before waiting for them, because I/O threads
+    // wake them just while they are running
+    mClientLimits.mStopped.fetchAndStoreRelaxed(1);
+    sctpClient::closeAllResults();
+    mThreadPool->waitForDone();
+
+    for (int i = 0; i < mIOThreads.size(); ++i)
+    {
+        mIOThreads[i]->quit();
+        mIOThreads[i]->wait();
+    }
+    mIOThreads.clear();
+
+    // clients of finished I/O threads can't destroy themselves
+    sctpClient::destroyAll();
+
     sc_memory_shutdown();
 
     mEventManager->shutdown();
     delete mEventManager;
     mEventManager = 0;
-
-    close();
 }
 
@@ -26,11 +26,14 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTcpServer>
 #include <QList>
 
-class sctpClient;
+#include "sctpClient.h"
+
 class sctpStatistic;
 class sctpEventManager;
+class sctpLocalServer;
 
 class QThreadPool;
+class QThread;
 
 class sctpServer : public QTcpServer
 {
@@ -42,6 +45,12 @@ public:
     //! Starts server
     bool start(const QString &config);
 
+    /*! Creates client for accepted connection and passes it to one of I/O threads
+     * @param socketDescriptor Descriptor of connection socket
+     * @param isLocal Flag, that connection is local (unix domain socket), otherwise it's tcp one
+     */
+    void appendClient(quintptr socketDescriptor, bool isLocal);
+
 protected:
     //! Parse configuration file
     void parseConfig(const QString &config_path);
@@ -53,6 +62,10 @@ protected:
 private:
     //! Port number
     quint16 mPort;
+    //! Name of local socket (empty, if local connections are not used)
+    QString mLocalSocketName;
+    //! Listener of local connections
+    sctpLocalServer *mLocalServer;
     //! Path to repository
     QString mRepoPath;
     //! Path to extensions directory
@@ -60,10 +73,21 @@ private:
 
     QString mStatPath;
     quint32 mStatUpdatePeriod;
+    quint32 mMetricsPeriod;
     sctpStatistic *mStatistic;
 
+    //! Number of threads, that process network input/output
+    quint32 mIOThreadsCount;
+    //! Number of threads, that process commands
+    quint32 mWorkerThreadsCount;
+    //! Threads with event loops, that serve client sockets
+    QList<QThread*> mIOThreads;
+    //! Index of I/O thread for the next connection
+    quint32 mNextIOThread;
     //! Worker threads pool
     QThreadPool *mThreadPool;
+    //! Limits of commands processing for all clients
+    sClientLimits mClientLimits;
     //! Event manager instance
     sctpEventManager *mEventManager;
 
@@ -26,15 +26,53 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDateTime>
 #include <QDebug>
 #include <QMutex>
+#include <QFile>
+#include <QFileInfo>
 
 extern "C"
 {
 #include "sc_memory.h"
 }
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_InterlockedExchangeAdd64, _InterlockedExchange64)
+#endif
+
+
+//! Suffix of files with statistics time series (files without it have old format with number of items in the beginning)
+#define SCTP_STAT_SERIES_SUFFIX     "series"
+//! Name of file with current metrics in text format
+#define SCTP_METRICS_FILE_NAME      "metrics.txt"
+
+//! Upper bounds of latency histogram buckets (microseconds)
+static const quint32 msLatencyBounds[SCTP_LATENCY_BUCKETS_COUNT - 1] =
+{
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000
+};
 
 sctpStatistic* sctpStatistic::mInstance = 0;
 
+//! Atomically adds \p delta to 64-bit \p value
+static inline void atomicAdd64(quint64 *value, quint64 delta)
+{
+#ifdef _MSC_VER
+    _InterlockedExchangeAdd64((volatile __int64*)value, (__int64)delta);
+#else
+    __sync_fetch_and_add(value, delta);
+#endif
+}
+
+//! Atomically resets 64-bit \p value to zero and returns its previous value
+static inline quint64 atomicTake64(quint64 *value)
+{
+#ifdef _MSC_VER
+    return (quint64)_InterlockedExchange64((volatile __int64*)value, 0);
+#else
+    return __sync_fetch_and_and(value, (quint64)0);
+#endif
+}
+
 sctpStatistic* sctpStatistic::getInstance()
 {
     Q_ASSERT(mInstance != 0);
@@ -46,9 +84,12 @@ sctpStatistic::sctpStatistic(QObject *parent)
     , mStatUpdatePeriod(0)
     , mStatUpdateTimer(0)
     , mStatInitUpdate(true)
+    , mMetricsTimer(0)
 {
     Q_ASSERT(mInstance == 0);
     mInstance = this;
+
+    memset(&mSums, 0, sizeof(mSums));
 }
 
 sctpStatistic::~sctpStatistic()
@@ -56,12 +97,14 @@ sctpStatistic::~sctpStatistic()
     mInstance = 0;
 }
 
-bool sctpStatistic::initialize(const QString &statDirPath, quint32 updatePeriod)
+bool sctpStatistic::initialize(const QString &statDirPath, quint32 updatePeriod, quint32 metricsPeriod)
 {
     mStatPath = statDirPath;
     mStatUpdatePeriod = updatePeriod;
 
     memset(&mCurrentStat, 0, sizeof(mCurrentStat));
+    memset(&mMetrics, 0, sizeof(mMetrics));
+    memset(&mLastStatMetrics, 0, sizeof(mLastStatMetrics));
 
     mDataMutex = new QMutex(QMutex::Recursive);
     mFsMutex = new QMutex(QMutex::Recursive);
@@ -88,6 +131,11 @@ bool sctpStatistic::initialize(const QString &statDirPath, quint32 updatePeriod)
 
         mStatUpdateTimer = new QTimer(this);
         update();
+
+        // counters are also collected by this timer, so they have no time to overflow
+        mMetricsTimer = new QTimer(this);
+        connect(mMetricsTimer, SIGNAL(timeout()), this, SLOT(updateMetrics()));
+        mMetricsTimer->start(qMax(metricsPeriod, (quint32)1) * 1000);
     }
 
     return true;
@@ -116,36 +164,10 @@ void sctpStatistic::update()
 
     // determine date
     QDateTime dateTime(QDateTime::currentDateTime());
-    QString statFileName = QString("%1_%2_%3").arg(dateTime.date().day()).arg(dateTime.date().month()).arg(dateTime.date().year());
+    QString statFileName = QString("%1_%2_%3.%4").arg(dateTime.date().day()).arg(dateTime.date().month()).arg(dateTime.date().year()).arg(SCTP_STAT_SERIES_SUFFIX);
     QDir statDir(mStatPath);
     QString statFilePath = statDir.filePath(statFileName);
 
-    sStat stat;
-
-    // check if stat file exist
-    QFile file(statFilePath);
-    QFileInfo fileInfo(statFilePath);
-    if (fileInfo.exists())
-    {
-        // read exist information in file
-        if (file.open(QFile::ReadOnly))
-        {
-            if (file.read((char*)&stat.mCount, sizeof(stat.mCount)) != sizeof(stat.mCount))
-                stat.mCount = 0;
-
-            if (stat.mCount > 0)
-            {
-                int bytesToRead = sizeof(sStatItem) * stat.mCount;
-                stat.mItems = new sStatItem[stat.mCount + 1];
-                if (file.read((char*)&stat.mItems[0], bytesToRead) != bytesToRead)
-                    stat.mCount = 0;
-            }
-
-            file.close();
-        }else
-            qCritical() << "Can't open statistic file: " <<  statFilePath;
-    }
-
     // collect information
     mCurrentStat.mTime = dateTime.toMSecsSinceEpoch();
     mCurrentStat.mIsInitStat = mStatInitUpdate ? 1 : 0;
@@ -164,18 +186,21 @@ void sctpStatistic::update()
         mCurrentStat.mEmptyCount = mem_stat.empty_count;
     }
 
-    // append new information
-    if (stat.mItems == 0)
-        stat.mItems = new sStatItem[stat.mCount + 1];
-    stat.mItems[stat.mCount] = mCurrentStat;
-    stat.mCount++;
-
-    // save to file
-    if (file.open(QFile::WriteOnly))
+    // network values are collected since previous update
+    collectCounters();
+    mCurrentStat.mConnectionsCount = mMetrics.mConnectionsCount - mLastStatMetrics.mConnectionsCount;
+    for (quint32 code = 0; code < SCTP_COMMAND_CODES_COUNT; ++code)
     {
-        file.write((char*)&stat.mCount, sizeof(stat.mCount));
-        file.write((char*)stat.mItems, sizeof(sStatItem) * stat.mCount);
+        mCurrentStat.mCommandsCount += mMetrics.mCommands[code].mCount - mLastStatMetrics.mCommands[code].mCount;
+        mCurrentStat.mCommandErrorsCount += mMetrics.mCommands[code].mErrorsCount - mLastStatMetrics.mCommands[code].mErrorsCount;
+    }
+    mLastStatMetrics = mMetrics;
 
+    // new item is appended to the end of file, previous ones are never rewritten
+    QFile file(statFilePath);
+    if (file.open(QFile::WriteOnly | QFile::Append))
+    {
+        file.write((char*)&mCurrentStat, sizeof(sStatItem));
         file.close();
     }else
         qCritical() << "Can't write statistic file: " << statFilePath;
@@ -202,7 +227,8 @@ void sctpStatistic::getStatisticsInTimeRange(quint64 beg_time, quint64 end_time,
     foreach (fileName, statFileNames)
     {
         // build date from file name
-        QStringList values = fileName.split("_");
+        QFileInfo fileInfo(fileName);
+        QStringList values = fileInfo.baseName().split("_");
         if (values.size() != 3) continue; //! TODO: error reports
 
         fileDate.setDate(QDate(values[2].toInt(), values[1].toInt(), values[0].toInt()));
@@ -217,7 +243,11 @@ void sctpStatistic::getStatisticsInTimeRange(quint64 beg_time, quint64 end_time,
             // read exist information in file
             if (file.open(QFile::ReadOnly))
             {
-                if (file.read((char*)&stat.mCount, sizeof(stat.mCount)) != sizeof(stat.mCount))
+                // time series file contains just items (the last one could be incomplete after crash),
+                // old files start with number of items
+                if (fileInfo.suffix() == SCTP_STAT_SERIES_SUFFIX)
+                    stat.mCount = file.size() / sizeof(sStatItem);
+                else if (file.read((char*)&stat.mCount, sizeof(stat.mCount)) != sizeof(stat.mCount))
                     stat.mCount = 0;
 
                 if (stat.mCount > 0)
@@ -251,16 +281,176 @@ void sctpStatistic::getStatisticsInTimeRange(quint64 beg_time, quint64 end_time,
     qSort(result);
 }
 
-void sctpStatistic::clientConnected()
+void sctpStatistic::getMetrics(sMetrics &metrics)
 {
     QMutexLocker locker(mDataMutex);
-    mCurrentStat.mConnectionsCount++;
+
+    collectCounters();
+    metrics = mMetrics;
 }
 
-void sctpStatistic::commandProcessed(bool error)
+quint32 sctpStatistic::latencyBucketBound(quint32 bucket)
 {
-    QMutexLocker locker(mDataMutex);
-    mCurrentStat.mCommandsCount++;
+    if (bucket < SCTP_LATENCY_BUCKETS_COUNT - 1)
+        return msLatencyBounds[bucket];
+
+    return 0xffffffff;
+}
+
+void sctpStatistic::collectCounters()
+{
+    // counters store values since previous collection, so their overflow is possible just on very high load
+    mMetrics.mConnectionsCount += (quint32)mConnectionsCounter.fetchAndStoreRelaxed(0);
+    mMetrics.mRejectedCommands += (quint32)mRejectedCounter.fetchAndStoreRelaxed(0);
+
+    mMetrics.mBytesReceived += atomicTake64(&mSums.mBytesReceived);
+    mMetrics.mBytesSent += atomicTake64(&mSums.mBytesSent);
+
+    mMetrics.mActiveConnections = qMax((int)mActiveConnections, 0);
+    mMetrics.mQueuedCommands = qMax((int)mQueuedCommands, 0);
+    mMetrics.mRunningCommands = qMax((int)mRunningCommands, 0);
+
+    for (quint32 code = 0; code < SCTP_COMMAND_CODES_COUNT; ++code)
+    {
+        sCommandCounters &counters = mCommandCounters[code];
+        sCommandMetrics &metrics = mMetrics.mCommands[code];
+
+        metrics.mCount += (quint32)counters.mCount.fetchAndStoreRelaxed(0);
+        metrics.mErrorsCount += (quint32)counters.mErrorsCount.fetchAndStoreRelaxed(0);
+        metrics.mLatencySum += atomicTake64(&mSums.mLatencySum[code]);
+        metrics.mResultBytes += atomicTake64(&mSums.mResultBytes[code]);
+        for (quint32 bucket = 0; bucket < SCTP_LATENCY_BUCKETS_COUNT; ++bucket)
+            metrics.mBuckets[bucket] += (quint32)counters.mBuckets[bucket].fetchAndStoreRelaxed(0);
+    }
+}
+
+//! Appends metric value with description in text format
+static void appendMetric(QString &text, const QString &name, const QString &type, const QString &help, quint64 value)
+{
+    text += QString("# HELP %1 %2\n# TYPE %1 %3\n%1 %4\n").arg(name).arg(help).arg(type).arg(value);
+}
+
+void sctpStatistic::writeMetrics(QIODevice *device)
+{
+    QString text;
+
+    appendMetric(text, "sctp_connections_total", "counter", "Number of accepted connections.", mMetrics.mConnectionsCount);
+    appendMetric(text, "sctp_received_bytes_total", "counter", "Number of bytes received from clients.", mMetrics.mBytesReceived);
+    appendMetric(text, "sctp_sent_bytes_total", "counter", "Number of bytes sent to clients.", mMetrics.mBytesSent);
+    appendMetric(text, "sctp_rejected_commands_total", "counter", "Number of commands rejected because of server overload.", mMetrics.mRejectedCommands);
+    appendMetric(text, "sctp_active_connections", "gauge", "Number of opened connections.", mMetrics.mActiveConnections);
+    appendMetric(text, "sctp_queued_commands", "gauge", "Number of received commands, that wait for processing.", mMetrics.mQueuedCommands);
+    appendMetric(text, "sctp_running_commands", "gauge", "Number of commands, that are processing now.", mMetrics.mRunningCommands);
+
+    text += "# HELP sctp_command_errors_total Number of commands processed with error.\n# TYPE sctp_command_errors_total counter\n";
+    for (quint32 code = 0; code < SCTP_COMMAND_CODES_COUNT; ++code)
+    {
+        if (mMetrics.mCommands[code].mCount > 0)
+            text += QString("sctp_command_errors_total{command=\"%1\"} %2\n").arg(code).arg(mMetrics.mCommands[code].mErrorsCount);
+    }
+
+    text += "# HELP sctp_command_result_bytes_total Size of commands results.\n# TYPE sctp_command_result_bytes_total counter\n";
+    for (quint32 code = 0; code < SCTP_COMMAND_CODES_COUNT; ++code)
+    {
+        if (mMetrics.mCommands[code].mCount > 0)
+            text += QString("sctp_command_result_bytes_total{command=\"%1\"} %2\n").arg(code).arg(mMetrics.mCommands[code].mResultBytes);
+    }
+
+    // histogram buckets are cumulative in text format
+    text += "# HELP sctp_command_duration_seconds Time from command start to its result.\n# TYPE sctp_command_duration_seconds histogram\n";
+    for (quint32 code = 0; code < SCTP_COMMAND_CODES_COUNT; ++code)
+    {
+        const sCommandMetrics &metrics = mMetrics.mCommands[code];
+        if (metrics.mCount == 0)
+            continue;
+
+        quint64 count = 0;
+        for (quint32 bucket = 0; bucket < SCTP_LATENCY_BUCKETS_COUNT; ++bucket)
+        {
+            count += metrics.mBuckets[bucket];
+            QString bound = (bucket < SCTP_LATENCY_BUCKETS_COUNT - 1) ? QString::number(msLatencyBounds[bucket] / 1000000.0, 'f', 6) : QString("+Inf");
+            text += QString("sctp_command_duration_seconds_bucket{command=\"%1\",le=\"%2\"} %3\n").arg(code).arg(bound).arg(count);
+        }
+        text += QString("sctp_command_duration_seconds_sum{command=\"%1\"} %2\n").arg(code).arg(QString::number(metrics.mLatencySum / 1000000.0, 'f', 6));
+        text += QString("sctp_command_duration_seconds_count{command=\"%1\"} %2\n").arg(code).arg(metrics.mCount);
+    }
+
+    device->write(text.toUtf8());
+}
+
+void sctpStatistic::updateMetrics()
+{
+    QMutexLocker dataLocker(mDataMutex);
+
+    collectCounters();
+
+    QDir statDir(mStatPath);
+    QString metricsPath = statDir.filePath(SCTP_METRICS_FILE_NAME);
+    QString tmpPath = metricsPath + ".tmp";
+
+    QFile file(tmpPath);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        qCritical() << "Can't write metrics file: " << tmpPath;
+        return;
+    }
+    writeMetrics(&file);
+    file.close();
+
+    // file is replaced, so readers always get complete metrics
+    QFile::remove(metricsPath);
+    if (!QFile::rename(tmpPath, metricsPath))
+        qCritical() << "Can't write metrics file: " << metricsPath;
+}
+
+void sctpStatistic::clientConnected()
+{
+    mConnectionsCounter.fetchAndAddRelaxed(1);
+    mActiveConnections.fetchAndAddRelaxed(1);
+}
+
+void sctpStatistic::clientDisconnected()
+{
+    mActiveConnections.fetchAndAddRelaxed(-1);
+}
+
+void sctpStatistic::commandProcessed(quint8 cmdCode, bool error, quint32 latency, quint32 resultSize)
+{
+    sCommandCounters &counters = mCommandCounters[cmdCode];
+
+    counters.mCount.fetchAndAddRelaxed(1);
     if (error)
-        mCurrentStat.mCommandErrorsCount++;
+        counters.mErrorsCount.fetchAndAddRelaxed(1);
+    atomicAdd64(&mSums.mLatencySum[cmdCode], latency);
+    atomicAdd64(&mSums.mResultBytes[cmdCode], resultSize);
+
+    quint32 bucket = 0;
+    while (bucket < SCTP_LATENCY_BUCKETS_COUNT - 1 && latency > msLatencyBounds[bucket])
+        ++bucket;
+    counters.mBuckets[bucket].fetchAndAddRelaxed(1);
+}
+
+void sctpStatistic::commandRejected()
+{
+    mRejectedCounter.fetchAndAddRelaxed(1);
+}
+
+void sctpStatistic::bytesReceived(quint32 bytes)
+{
+    atomicAdd64(&mSums.mBytesReceived, bytes);
+}
+
+void sctpStatistic::bytesSent(quint32 bytes)
+{
+    atomicAdd64(&mSums.mBytesSent, bytes);
+}
+
+void sctpStatistic::commandsQueued(qint32 delta)
+{
+    mQueuedCommands.fetchAndAddRelaxed(delta);
+}
+
+void sctpStatistic::commandsRunning(qint32 delta)
+{
+    mRunningCommands.fetchAndAddRelaxed(delta);
 }
@@ -24,10 +24,11 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 #define _sctpStatistic_h_
 
 #include <QObject>
+#include <QAtomicInt>
+#include <QMutex>
 
 
 class QTimer;
-class QMutex;
 
 //! Structure to store statistic information for on time value
 struct sStatItem
@@ -79,6 +80,55 @@ struct sStat
 };
 
 
+//! Number of command latency histogram buckets (the last one has no upper bound)
+#define SCTP_LATENCY_BUCKETS_COUNT  15
+//! Number of possible command codes
+#define SCTP_COMMAND_CODES_COUNT    256
+
+/*! Counters of processed commands with one code. They are updated without locks by worker threads
+ * and moved into sCommandMetrics periodically, so they store values just for a short time
+ */
+struct sCommandCounters
+{
+    QAtomicInt mCount; // amount of processed commands
+    QAtomicInt mErrorsCount; // amount of commands processed with error
+    QAtomicInt mBuckets[SCTP_LATENCY_BUCKETS_COUNT]; // amount of commands in each latency bucket
+};
+
+/*! Sums of latencies and sizes. Even a short time sum can exceed 32 bits, and there is no 64-bit
+ * atomic integer in Qt4, so they are updated with compiler atomic builtins and moved into sMetrics periodically
+ */
+struct sCounterSums
+{
+    quint64 mLatencySum[SCTP_COMMAND_CODES_COUNT]; // sums of latencies of commands with each code (microseconds)
+    quint64 mResultBytes[SCTP_COMMAND_CODES_COUNT]; // sizes of results of commands with each code
+    quint64 mBytesReceived; // amount of bytes received from clients
+    quint64 mBytesSent; // amount of bytes sent to clients
+};
+
+//! Collected metrics of commands with one code
+struct sCommandMetrics
+{
+    quint64 mCount;
+    quint64 mErrorsCount;
+    quint64 mLatencySum;
+    quint64 mResultBytes;
+    quint64 mBuckets[SCTP_LATENCY_BUCKETS_COUNT];
+};
+
+//! Metrics of server since start
+struct sMetrics
+{
+    quint64 mConnectionsCount; // amount of accepted connections
+    quint64 mBytesReceived; // amount of bytes received from clients
+    quint64 mBytesSent; // amount of bytes sent to clients
+    quint64 mRejectedCommands; // amount of commands rejected because of server overload
+    quint32 mActiveConnections; // amount of opened connections
+    quint32 mQueuedCommands; // amount of received commands, that wait for processing
+    quint32 mRunningCommands; // amount of commands, that are processing now
+    sCommandMetrics mCommands[SCTP_COMMAND_CODES_COUNT];
+};
+
 /*!
  * \brief Class to work with statistics information
  */
@@ -90,8 +140,12 @@ public:
     explicit sctpStatistic(QObject *parent = 0);
     virtual ~sctpStatistic();
 
-    //! Initialize statistics
-    bool initialize(const QString &statDirPath, quint32 updatePeriod);
+    /*! Initialize statistics
+     * @param statDirPath Path to directory to store statistics
+     * @param updatePeriod Period of statistics saving (seconds)
+     * @param metricsPeriod Period of metrics file update (seconds)
+     */
+    bool initialize(const QString &statDirPath, quint32 updatePeriod, quint32 metricsPeriod);
     //! Shutdown statistics
     void shutdown();
 
@@ -106,6 +160,12 @@ public:
      */
     void getStatisticsInTimeRange(quint64 beg_time, quint64 end_time, tStatItemVector &result);
 
+    //! Copies current metrics into \p metrics
+    void getMetrics(sMetrics &metrics);
+
+    //! Returns upper bound of specified latency histogram bucket (microseconds)
+    static quint32 latencyBucketBound(quint32 bucket);
+
 
 
 protected:
@@ -124,15 +184,55 @@ protected:
     //! Pointer to mutex, that used to synchronize filesystem routines
     QMutex *mFsMutex;
 
+    //! Metrics update timer
+    QTimer *mMetricsTimer;
+    //! Metrics collected from counters
+    sMetrics mMetrics;
+    //! Metrics values on the last statistics update
+    sMetrics mLastStatMetrics;
+
+    //! Counters, that are updated on the hot path without locks
+    sCommandCounters mCommandCounters[SCTP_COMMAND_CODES_COUNT];
+    QAtomicInt mConnectionsCounter;
+    QAtomicInt mRejectedCounter;
+    //! Sums, that are updated on the hot path without locks
+    sCounterSums mSums;
+    //! Gauges
+    QAtomicInt mActiveConnections;
+    QAtomicInt mQueuedCommands;
+    QAtomicInt mRunningCommands;
+
+    //! Moves values of counters into mMetrics. mDataMutex should be locked
+    void collectCounters();
+    //! Writes metrics in text format
+    void writeMetrics(QIODevice *device);
+
 public:
     void clientConnected();
-    void commandProcessed(bool error);
+    void clientDisconnected();
+    /*! Collects information about processed command
+     * @param cmdCode Code of command
+     * @param error Flag, that command was processed with error
+     * @param latency Time of command processing (microseconds)
+     * @param resultSize Size of command results (bytes)
+     */
+    void commandProcessed(quint8 cmdCode, bool error, quint32 latency, quint32 resultSize);
+    //! Collects information about command rejected because of server overload
+    void commandRejected();
+    void bytesReceived(quint32 bytes);
+    void bytesSent(quint32 bytes);
+    //! Changes number of commands waiting for processing by \p delta
+    void commandsQueued(qint32 delta);
+    //! Changes number of processing commands by \p delta
+    void commandsRunning(qint32 delta);
 
 private:
     static sctpStatistic *mInstance;
 
 protected slots:
     void update();
+    //! Updates metrics file
+    void updateMetrics();
 };
 
 #endif // _sctpStat_h_
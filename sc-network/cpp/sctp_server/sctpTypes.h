@@ -48,6 +48,9 @@ typedef enum
     SCTP_CMD_EVENT_CREATE       = 0x0e, // create subscription to specified event
     SCTP_CMD_EVENT_DESTROY      = 0x0f, // destroys specified event subscription
     SCTP_CMD_EVENT_EMIT         = 0x10, // emits events to client
+    SCTP_CMD_BATCH              = 0x11, // process list of commands in one request
+    SCTP_CMD_ITERATE_NEXT       = 0x12, // return next page of iteration results by cursor
+    SCTP_CMD_ITERATE_FREE       = 0x13, // close iteration cursor
 
     SCTP_CMD_FIND_ELEMENT_BY_SYSITDF = 0xa0, // return sc-element by it system identifier
     SCTP_CMD_SET_SYSIDTF        = 0xa1,   // setup new system identifier for sc-element
@@ -73,11 +76,77 @@ typedef enum
 
 } eSctpIteratorType;
 
+//! Flags of SCTP_CMD_ITERATE_ELEMENTS command. If any of them is set, then iterator parameters are followed by page size (4 bytes)
+typedef enum
+{
+    SCTP_ITERATE_FLAG_CURSOR    = 0x01, // return first page of results and cursor to get next pages
+    SCTP_ITERATE_FLAG_STREAM    = 0x02  // return all results by pages, each page in separate result
+
+} eSctpIterateFlags;
+
+//! Flags of SCTP_CMD_GET_LINK_CONTENT command
+typedef enum
+{
+    SCTP_LINK_CONTENT_FLAG_RANGE = 0x01 // sc-addr is followed by offset and length (4 bytes each, zero length - up to the end);
+                                        // result contains size of whole content (4 bytes) and requested part of it
+
+} eSctpLinkContentFlags;
+
+//! Flags of SCTP_CMD_EVENT_EMIT command
+typedef enum
+{
+    SCTP_EVENT_EMIT_FLAG_PUSH   = 0x01  // after result, server sends events to client as soon as they fire, in results with id of this command;
+                                        // command without this flag switches client back to polling
+
+} eSctpEventEmitFlags;
+
+//! Flags of SCTP_CMD_STATISTICS command
+typedef enum
+{
+    SCTP_STATISTICS_FLAG_METRICS = 0x01 // return current metrics instead of statistics in time range (no parameters):
+                                        // gauges, counters and latency histograms of each command code
+
+} eSctpStatisticsFlags;
+
+//! Types of items in SCTP_CMD_ITERATE_CONSTRUCTION template
+typedef enum
+{
+    SCTP_CONSTRUCTION_TRIPLE    = 0, // source, arc, target
+    SCTP_CONSTRUCTION_QUINTUPLE = 1  // source, arc, target, attribute arc, attribute
+
+} eSctpConstructionItemType;
+
+//! Types of elements in SCTP_CMD_ITERATE_CONSTRUCTION template item
+typedef enum
+{
+    SCTP_CONSTRUCTION_ELEMENT_ADDR  = 0, // fixed sc-addr
+    SCTP_CONSTRUCTION_ELEMENT_VAR   = 1  // variable: index (1 byte, indecies are from 0 without gaps, less than 255) and type
+
+} eSctpConstructionElementType;
+
+//! Flags of SCTP_CMD_ITERATE_CONSTRUCTION command
+typedef enum
+{
+    SCTP_ITERATE_CONSTRUCTION_FLAG_STREAM = 0x02  // template is followed by page size (4 bytes); results are returned by pages, each page in
+                                                  // separate result: flag of more pages (4 bytes), number of constructions and variables and values.
+                                                  // Without this flag search fails, if results are too large for one result
+
+} eSctpIterateConstructionFlags;
+
+//! Types of sc-addr arguments in SCTP_CMD_BATCH sub-commands
+typedef enum
+{
+    SCTP_BATCH_ARG_ADDR         = 0, // fixed sc-addr
+    SCTP_BATCH_ARG_RESULT       = 1  // sc-addr returned by previous sub-command: its index (4 bytes)
+
+} eSctpBatchArgType;
+
 typedef enum
 {
     SCTP_RESULT_OK              = 0x00, //
-    SCTP_RESULT_FAIL            = 0x01, //
-    SCTP_RESULT_ERROR_NO_ELEMENT= 0x02  // sc-element wasn't found
+    SCTP_RESULT_FAIL            = 0x01, // for SCTP_CMD_EVENT_EMIT: some events were lost, because client didn't get them in time
+    SCTP_RESULT_ERROR_NO_ELEMENT= 0x02, // sc-element wasn't found
+    SCTP_RESULT_BUSY            = 0x03  // server is overloaded, command wasn't processed (it can be sent again later)
 
 } eSctpResultCode;
 
@@ -18,15 +18,19 @@ TEMPLATE = app
 SOURCES += main.cpp \
     sctpClient.cpp \
     sctpServer.cpp  \
+    sctpLocalServer.cpp \
     sctpCommand.cpp \
-    sctpStatistic.cpp
+    sctpStatistic.cpp \
+    sctpConstructionSearch.cpp
 
 HEADERS += \
     sctpClient.h \
     sctpServer.h \
+    sctpLocalServer.h \
     sctpCommand.h \
     sctpTypes.h \
-    sctpStatistic.h
+    sctpStatistic.h \
+    sctpConstructionSearch.h
 
 CONFIG (debug, debug|release) {
     DESTDIR = ../../../bin
@@ -22,7 +22,7 @@ along with OSTIS.  If not, see <http://www.gnu.org/licenses/>.
 """
 from types import CommandType, ScAddr, CommandId
 import struct
-from sctp.types import CommandType
+from sctp.types import CommandType, BatchArgType
 
 
 class SctpCommand:
@@ -158,6 +158,64 @@ class SctpCommandElementFree(SctpCommandBaseOneScAddr):
     def _str_name_(self):
         return "Delete sc-element"
 
+class SctpCommandBatch(SctpCommand):
+    """Command that contains list of sub-commands, that processed by server in one request.
+    Each function that appends sub-command returns its index. Index can be passed instead
+    of ScAddr into next sub-commands to use sc-addr returned by that sub-command, so
+    whole construction can be created in one round trip.
+    """
+    def __init__(self, flags = 0, cmd_id = 0):
+        SctpCommand.__init__(self, flags, cmd_id)
+        self.commands = []
+        
+    def _pack_addr(self, addr):
+        if isinstance(addr, ScAddr):
+            return struct.pack('!B', BatchArgType.addr) + addr.pack()
+        return struct.pack('!BI', BatchArgType.result, addr)
+    
+    def _append(self, code, data = ''):
+        self.commands.append(struct.pack('!B', code) + data)
+        return len(self.commands) - 1
+    
+    def element_check(self, addr):
+        return self._append(CommandType.element_check, self._pack_addr(addr))
+    
+    def element_free(self, addr):
+        return self._append(CommandType.element_free, self._pack_addr(addr))
+    
+    def node_new(self, node_type):
+        return self._append(CommandType.node_new, struct.pack('!H', node_type))
+    
+    def link_new(self):
+        return self._append(CommandType.link_new)
+    
+    def arc_new(self, arc_type, begin, end):
+        return self._append(CommandType.arc_new, struct.pack('!H', arc_type) + self._pack_addr(begin) + self._pack_addr(end))
+    
+    def link_set_content(self, addr, content):
+        return self._append(CommandType.link_set_content, self._pack_addr(addr) + struct.pack('!I', len(content)) + content)
+    
+    def set_sys_idtf(self, addr, idtf):
+        return self._append(CommandType.set_sys_idtf, self._pack_addr(addr) + struct.pack('!I', len(idtf)) + idtf)
+    
+    def find_by_sys_idtf(self, idtf):
+        return self._append(CommandType.find_by_sys_idtf, struct.pack('!I', len(idtf)) + idtf)
+    
+    def pack_arguments(self):
+        return struct.pack('!I', len(self.commands)) + ''.join(self.commands)
+    
+    def size_arguments(self):
+        return 4 + sum(len(cmd) for cmd in self.commands)
+    
+    def code(self):
+        return CommandType.batch
+    
+    def _str_name_(self):
+        return "Batch"
+    
+    def _str_args_(self):
+        return "%d sub-commands" % len(self.commands)
+
 # map to convert command type into class that implements specified command
 code2command = {CommandType.element_check: SctpCommandElementCheck,
                 CommandType.element_get_type: SctpCommandElementGetType,
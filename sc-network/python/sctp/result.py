@@ -109,4 +109,31 @@ class SctpResultElementCheck(SctpResult):
         return "Check sc-element result (Command type: %s, Command id: %s, Result: %s)" % (str(self.code()),
                                                                                            str(self.cmd_id),
                                                                                            self.result_code)
-        
\ No newline at end of file
+
+class SctpResultBatch(SctpResult):
+    """Result of batch command. It contains result code and returned sc-addr
+    (empty, if sub-command doesn't return it) for each sub-command
+    """
+    def __init__(self, cmd_id = 0, result_code = ResultCode.No):
+        SctpResult.__init__(self, cmd_id, result_code)
+        self.results = []
+        
+    def code(self):
+        return CommandType.batch
+    
+    def unpack_values(self, data):
+        count = struct.unpack('!I', data[:4])[0]
+        self.results = []
+        for idx in xrange(count):
+            offset = 4 + idx * (1 + ScAddr.size)
+            addr = ScAddr()
+            addr.unpack(data[offset + 1:offset + 1 + ScAddr.size])
+            self.results.append((struct.unpack('!B', data[offset])[0], addr))
+    
+    def size_values(self):
+        return 4 + len(self.results) * (1 + ScAddr.size)
+        
+    def __str__(self):
+        return "Batch result (Command id: %s, Result: %s, Sub-commands: %d)" % (str(self.cmd_id),
+                                                                                  self.result_code,
+                                                                                  len(self.results))
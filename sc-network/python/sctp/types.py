@@ -51,9 +51,18 @@ class CommandType:
     arc_new             =   0x06    # create new sc-arc
     arc_get_begin       =   0x07    # get begin element of specified sc-arc
     arc_get_end         =   0x08    # get end element of specified sc-arc
+    link_set_content    =   0x0b    # set content of specified sc-link
+    batch               =   0x11    # process list of commands in one request
+    find_by_sys_idtf    =   0xa0    # find sc-element by system identifier
+    set_sys_idtf        =   0xa1    # set system identifier of sc-element
     
     close_connection    =   0xFE    # close client connection
     
+class BatchArgType:
+    
+    addr                =   0x00    # fixed sc-addr
+    result              =   0x01    # sc-addr returned by previous sub-command of batch
+    
 class ResultCode:
     
     No                  =   0x00